@@ -0,0 +1,77 @@
+#include "command_parser.h"
+
+#include <string.h>
+
+void command_parser_init(CommandParser &parser, const CommandSpec *table, uint8_t table_size,
+                         CommandErrorHandler on_unknown, CommandErrorHandler on_timeout) {
+  parser.table      = table;
+  parser.table_size = table_size;
+  parser.on_unknown = on_unknown;
+  parser.on_timeout = on_timeout;
+  parser.on_dispatch = NULL;
+
+  memset(parser.index, COMMAND_NONE, sizeof(parser.index));
+  for (uint8_t i = 0; i < table_size; i++) {
+    parser.index[table[i].cmd] = i;
+  }
+
+  command_parser_reset(parser);
+}
+
+static void dispatch(CommandParser &parser) {
+  const CommandSpec *spec = parser.pending;
+  parser.pending = NULL;
+  if (parser.on_dispatch) parser.on_dispatch(spec->cmd);
+  spec->handler(parser.payload);
+}
+
+void command_parser_feed(CommandParser &parser, uint8_t value, uint32_t now_ms) {
+  // Payload byte for the pending command
+  if (parser.pending) {
+    if (parser.received < COMMAND_MAX_PAYLOAD) {
+      parser.payload[parser.received] = value;
+    }
+    parser.received++;
+    if (parser.received >= parser.pending->payload_len) {
+      dispatch(parser);
+    }
+    return;
+  }
+
+  // New command byte
+  uint8_t entry = parser.index[value];
+  if (entry == COMMAND_NONE) {
+    if (parser.on_unknown) parser.on_unknown(value);
+    return;
+  }
+
+  parser.pending    = &parser.table[entry];
+  parser.received   = 0;
+  parser.started_ms = now_ms;
+  if (parser.pending->payload_len == 0) {
+    dispatch(parser);
+  }
+}
+
+void command_parser_poll(CommandParser &parser, uint32_t now_ms) {
+  if (parser.pending && (now_ms - parser.started_ms) > parser.pending->timeout_ms) {
+    uint8_t cmd = parser.pending->cmd;
+    parser.pending = NULL;
+    if (parser.on_timeout) parser.on_timeout(cmd);
+  }
+}
+
+void command_parser_reset(CommandParser &parser) {
+  parser.pending    = NULL;
+  parser.received   = 0;
+  parser.started_ms = 0;
+}
+
+bool command_parser_idle(const CommandParser &parser) {
+  return parser.pending == NULL;
+}
+
+const CommandSpec *command_parser_lookup(const CommandParser &parser, uint8_t cmd) {
+  uint8_t entry = parser.index[cmd];
+  return entry == COMMAND_NONE ? NULL : &parser.table[entry];
+}
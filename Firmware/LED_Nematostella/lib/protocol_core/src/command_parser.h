@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================================
+// COMMAND PARSER - Incremental, table-driven command reception
+// ========================================================================
+// Bytes are fed one at a time. The command byte selects a CommandSpec
+// (payload length + handler); the payload accumulates across loop()
+// iterations, so a slow or fragmented transfer never blocks the firmware.
+// An incomplete payload is dropped after the command's timeout.
+// on_dispatch (optional, NULL after init) sees every command right before
+// its handler runs.
+// ========================================================================
+
+const uint8_t COMMAND_MAX_PAYLOAD = 32;
+const uint8_t COMMAND_NONE        = 0xFF;  // Index marker: byte is not a command
+
+typedef void (*CommandHandler)(const uint8_t *payload);
+typedef void (*CommandErrorHandler)(uint8_t cmd);
+
+struct CommandSpec {
+  uint8_t        cmd;
+  uint8_t        payload_len;
+  uint16_t       timeout_ms;  // Max time to receive the full payload
+  CommandHandler handler;
+};
+
+struct CommandParser {
+  const CommandSpec  *table;
+  uint8_t             table_size;
+  uint8_t             index[256];  // Command byte -> table entry (O(1) lookup)
+  CommandErrorHandler on_unknown;
+  CommandErrorHandler on_timeout;
+  CommandErrorHandler on_dispatch;
+
+  const CommandSpec  *pending;     // Command waiting for payload bytes
+  uint8_t             payload[COMMAND_MAX_PAYLOAD];
+  uint8_t             received;
+  uint32_t            started_ms;
+};
+
+void command_parser_init(CommandParser &parser, const CommandSpec *table, uint8_t table_size,
+                         CommandErrorHandler on_unknown, CommandErrorHandler on_timeout);
+void command_parser_feed(CommandParser &parser, uint8_t value, uint32_t now_ms);
+void command_parser_poll(CommandParser &parser, uint32_t now_ms);
+void command_parser_reset(CommandParser &parser);
+bool command_parser_idle(const CommandParser &parser);
+const CommandSpec *command_parser_lookup(const CommandParser &parser, uint8_t cmd);
@@ -0,0 +1,44 @@
+#include "device_config.h"
+
+#include "frame_codec.h"
+
+void device_config_encode(const DeviceConfig &config, uint8_t out[DEVICE_CONFIG_SIZE]) {
+  uint8_t i = 0;
+  out[i++] = DEVICE_CONFIG_VERSION;
+  out[i++] = config.stabilization_ms >> 8;
+  out[i++] = config.stabilization_ms & 0xFF;
+  out[i++] = config.exposure_ms >> 8;
+  out[i++] = config.exposure_ms & 0xFF;
+  out[i++] = config.ir_power;
+  out[i++] = config.white_power;
+  out[i++] = config.camera_type;
+  out[i++] = config.led_type;
+  out[i++] = config.trigger_enabled;
+  out[i++] = config.trigger_width_us >> 8;
+  out[i++] = config.trigger_width_us & 0xFF;
+  out[i++] = config.sync_format;
+
+  uint16_t crc = frame_crc16(out, i);
+  out[i++] = crc >> 8;
+  out[i++] = crc & 0xFF;
+}
+
+bool device_config_decode(DeviceConfig &config, const uint8_t *data, uint8_t len) {
+  if (len != DEVICE_CONFIG_SIZE || data[0] != DEVICE_CONFIG_VERSION) return false;
+  if (device_config_hash(data) != frame_crc16(data, DEVICE_CONFIG_SIZE - 2)) return false;
+
+  config.stabilization_ms = ((uint16_t)data[1] << 8) | data[2];
+  config.exposure_ms      = ((uint16_t)data[3] << 8) | data[4];
+  config.ir_power         = data[5];
+  config.white_power      = data[6];
+  config.camera_type      = data[7];
+  config.led_type         = data[8];
+  config.trigger_enabled  = data[9];
+  config.trigger_width_us = ((uint16_t)data[10] << 8) | data[11];
+  config.sync_format      = data[12];
+  return true;
+}
+
+uint16_t device_config_hash(const uint8_t blob[DEVICE_CONFIG_SIZE]) {
+  return ((uint16_t)blob[DEVICE_CONFIG_SIZE - 2] << 8) | blob[DEVICE_CONFIG_SIZE - 1];
+}
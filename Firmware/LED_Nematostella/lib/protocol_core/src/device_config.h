@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================================
+// DEVICE CONFIG - Host settings that survive a reset (stored in NVS)
+// ========================================================================
+// Serialized big-endian as [version][fields...][crc16 hi][crc16 lo]. The
+// CRC-16 (same as the v3 frames) doubles as the config hash: the host can
+// compute it over the settings it wants and compare it with CMD_GET_CONFIG
+// instead of re-sending every SET command after a brownout or USB reset.
+// A blob with another version or a bad CRC is rejected, so the firmware
+// falls back to its defaults.
+// ========================================================================
+
+const uint8_t DEVICE_CONFIG_VERSION = 1;
+const uint8_t DEVICE_CONFIG_FIELDS  = 12;  // Bytes between version and CRC
+const uint8_t DEVICE_CONFIG_SIZE    = DEVICE_CONFIG_FIELDS + 3;
+
+struct DeviceConfig {
+  uint16_t stabilization_ms;
+  uint16_t exposure_ms;
+  uint8_t  ir_power;        // 0-100 %
+  uint8_t  white_power;     // 0-100 %
+  uint8_t  camera_type;
+  uint8_t  led_type;        // Selected LED
+  uint8_t  trigger_enabled;
+  uint16_t trigger_width_us;
+  uint8_t  sync_format;
+};
+
+void     device_config_encode(const DeviceConfig &config, uint8_t out[DEVICE_CONFIG_SIZE]);
+bool     device_config_decode(DeviceConfig &config, const uint8_t *data, uint8_t len);
+uint16_t device_config_hash(const uint8_t blob[DEVICE_CONFIG_SIZE]);
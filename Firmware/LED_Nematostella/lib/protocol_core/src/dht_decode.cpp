@@ -0,0 +1,19 @@
+#include "dht_decode.h"
+
+DhtStatus dht_decode(const uint16_t *high_us, uint8_t count, float &temperature, float &humidity) {
+  if (count < DHT_FRAME_BITS) return DHT_BAD_FRAME;
+
+  uint8_t bytes[DHT_FRAME_BITS / 8] = { 0 };
+  const uint16_t *bits = high_us + (count - DHT_FRAME_BITS);
+  for (uint8_t i = 0; i < DHT_FRAME_BITS; i++) {
+    bytes[i / 8] = (uint8_t)((bytes[i / 8] << 1) | (bits[i] > DHT_BIT_THRESHOLD_US ? 1 : 0));
+  }
+
+  if ((uint8_t)(bytes[0] + bytes[1] + bytes[2] + bytes[3]) != bytes[4]) return DHT_CHECKSUM;
+
+  // Humidity and temperature in 0.1 units, temperature sign in bit 15
+  humidity    = ((bytes[0] << 8) | bytes[1]) * 0.1f;
+  temperature = (((bytes[2] & 0x7F) << 8) | bytes[3]) * 0.1f;
+  if (bytes[2] & 0x80) temperature = -temperature;
+  return DHT_OK;
+}
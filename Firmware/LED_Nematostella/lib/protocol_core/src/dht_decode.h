@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================================
+// DHT DECODE - DHT22 single-wire reply -> temperature / humidity
+// ========================================================================
+// The sensor answers a start pulse with 80 us low / 80 us high, then 40
+// bits: 50 us low followed by 26-28 us high for a 0 or 70 us high for a 1.
+// Only the high times carry data, so the decoder takes the last 40 high
+// pulses of a capture (leading edges of the start pulse and the response
+// preamble are ignored) and checks the byte sum.
+// ========================================================================
+
+const uint8_t  DHT_FRAME_BITS       = 40;
+const uint16_t DHT_BIT_THRESHOLD_US = 48;  // High time above = 1
+
+enum DhtStatus : uint8_t {
+  DHT_PENDING,    // Read in progress
+  DHT_OK,
+  DHT_TIMEOUT,    // No complete reply
+  DHT_BAD_FRAME,  // Fewer than 40 bits
+  DHT_CHECKSUM
+};
+
+DhtStatus dht_decode(const uint16_t *high_us, uint8_t count, float &temperature, float &humidity);
@@ -0,0 +1,43 @@
+#include "duty_lut.h"
+
+// Percent steps between two curve points
+const uint8_t DUTY_CURVE_STEP = (DUTY_LUT_SIZE - 1) / (DUTY_CURVE_POINTS - 1);
+
+void duty_curve_identity(uint16_t points[DUTY_CURVE_POINTS]) {
+  for (uint8_t i = 0; i < DUTY_CURVE_POINTS; i++) {
+    points[i] = (uint16_t)(((uint32_t)DUTY_CURVE_FULL * i + (DUTY_CURVE_POINTS - 1) / 2) / (DUTY_CURVE_POINTS - 1));
+  }
+}
+
+bool duty_curve_valid(const uint16_t points[DUTY_CURVE_POINTS]) {
+  for (uint8_t i = 1; i < DUTY_CURVE_POINTS; i++) {
+    if (points[i] < points[i - 1]) return false;
+  }
+  return true;
+}
+
+void duty_lut_build(DutyLut &lut, const uint16_t points[DUTY_CURVE_POINTS], uint16_t max_duty) {
+  for (uint8_t power = 0; power < DUTY_LUT_SIZE; power++) {
+    uint8_t segment = power / DUTY_CURVE_STEP;
+    uint8_t offset  = power % DUTY_CURVE_STEP;
+    if (segment == DUTY_CURVE_POINTS - 1) {
+      segment--;
+      offset = DUTY_CURVE_STEP;
+    }
+
+    // Interpolated level scaled by DUTY_CURVE_STEP, then mapped onto the duty range
+    uint32_t level = (uint32_t)points[segment] * (DUTY_CURVE_STEP - offset) +
+                     (uint32_t)points[segment + 1] * offset;
+    uint64_t duty  = (uint64_t)level * max_duty / ((uint32_t)DUTY_CURVE_FULL * DUTY_CURVE_STEP);
+    lut.duty[power] = (uint16_t)duty;
+  }
+}
+
+uint16_t duty_lut_get_fine(const DutyLut &lut, uint16_t centi_power) {
+  uint8_t  power = centi_power / 100;
+  uint8_t  frac  = centi_power % 100;
+  if (power >= DUTY_LUT_SIZE - 1) return lut.duty[DUTY_LUT_SIZE - 1];
+  uint32_t low   = lut.duty[power];
+  uint32_t high  = lut.duty[power + 1];
+  return (uint16_t)((low * (100 - frac) + high * frac + 50) / 100);
+}
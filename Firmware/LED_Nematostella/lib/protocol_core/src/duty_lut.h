@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================================
+// DUTY LUT - Power percent -> LEDC duty, precomputed per LED channel
+// ========================================================================
+// A calibration curve is DUTY_CURVE_POINTS output levels at 0, 10, ...
+// 100 % power, each as a fraction of full duty (0-65535). The LUT is
+// interpolated linearly between the points once, when the curve changes,
+// so switching an LED is a table lookup. At 10-bit resolution the
+// identity curve reproduces map(power, 0, 100, 0, 1023) exactly.
+// ========================================================================
+
+const uint8_t  DUTY_LUT_SIZE     = 101;  // 0-100 %
+const uint8_t  DUTY_CURVE_POINTS = 11;   // Every 10 %
+const uint16_t DUTY_CURVE_FULL   = 0xFFFF;
+
+struct DutyLut {
+  uint16_t duty[DUTY_LUT_SIZE];
+};
+
+void duty_curve_identity(uint16_t points[DUTY_CURVE_POINTS]);
+bool duty_curve_valid(const uint16_t points[DUTY_CURVE_POINTS]);  // Non-decreasing
+void duty_lut_build(DutyLut &lut, const uint16_t points[DUTY_CURVE_POINTS], uint16_t max_duty);
+
+inline uint16_t duty_lut_get(const DutyLut &lut, uint8_t power) {
+  return lut.duty[power < DUTY_LUT_SIZE ? power : DUTY_LUT_SIZE - 1];
+}
+
+// Between two LUT entries, power in 1/100 % (0-10000): the in-between
+// levels of a ramp (CMD_RAMP_CHANNEL) follow the calibrated curve too
+uint16_t duty_lut_get_fine(const DutyLut &lut, uint16_t centi_power);
@@ -0,0 +1,110 @@
+#include "event_log.h"
+
+static bool slot_matches(const EventLog &log, uint16_t position, uint32_t stamp) {
+  return stamp != 0 && (stamp - 1) % log.capacity == position;
+}
+
+static void slot_wipe(EventSlot &slot) {
+  slot.stamp   = 0;
+  slot.info    = 0;
+  slot.arg32   = 0;
+  slot.time_lo = 0;
+  slot.time_hi = 0;
+}
+
+void event_log_init(EventLog &log, EventSlot *slots, uint16_t capacity, bool keep) {
+  log.slots    = slots;
+  log.capacity = capacity;
+  log.head     = 0;
+  log.first    = 0;
+
+  if (!keep) {
+    for (uint16_t i = 0; i < capacity; i++) slot_wipe(slots[i]);
+    return;
+  }
+
+  // The newest valid stamp is the head; anything older than one ring
+  // behind it, or in the wrong slot, is left over from before
+  uint32_t head = 0;
+  for (uint16_t i = 0; i < capacity; i++) {
+    uint32_t stamp = slots[i].stamp;
+    if (slot_matches(log, i, stamp) && stamp > head) head = stamp;
+  }
+  uint32_t low   = head > capacity ? head - capacity : 0;
+  uint32_t first = head;
+  for (uint16_t i = 0; i < capacity; i++) {
+    uint32_t stamp = slots[i].stamp;
+    if (!slot_matches(log, i, stamp) || stamp - 1 < low) {
+      slot_wipe(slots[i]);
+    } else if (stamp - 1 < first) {
+      first = stamp - 1;
+    }
+  }
+  log.head  = head;
+  log.first = first;
+}
+
+uint32_t event_log_add(EventLog &log, const EventRecord &record) {
+  uint32_t index = __atomic_fetch_add(&log.head, 1, __ATOMIC_RELAXED);
+  EventSlot &slot = log.slots[index % log.capacity];
+
+  // Stamp 0 first: a reader that sees the old stamp before and after its
+  // copy cannot have copied any of the new words
+  __atomic_store_n(&slot.stamp, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  slot.info    = record.type | ((uint32_t)record.arg8 << 8) | ((uint32_t)record.arg16 << 16);
+  slot.arg32   = record.arg32;
+  slot.time_lo = (uint32_t)record.time_us;
+  slot.time_hi = (uint32_t)(record.time_us >> 32);
+  __atomic_store_n(&slot.stamp, index + 1, __ATOMIC_RELEASE);
+  return index;
+}
+
+bool event_log_read(const EventLog &log, uint32_t index, EventRecord &record) {
+  if (index >= event_log_head(log) || index < event_log_oldest(log)) return false;
+  const EventSlot &slot = log.slots[index % log.capacity];
+
+  uint32_t stamp = __atomic_load_n(&slot.stamp, __ATOMIC_ACQUIRE);
+  if (stamp != index + 1) return false;
+  uint32_t info    = slot.info;
+  uint32_t arg32   = slot.arg32;
+  uint32_t time_lo = slot.time_lo;
+  uint32_t time_hi = slot.time_hi;
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if (__atomic_load_n(&slot.stamp, __ATOMIC_RELAXED) != stamp) return false;
+
+  record.type    = info & 0xFF;
+  record.arg8    = (info >> 8) & 0xFF;
+  record.arg16   = info >> 16;
+  record.arg32   = arg32;
+  record.time_us = ((uint64_t)time_hi << 32) | time_lo;
+  return true;
+}
+
+uint32_t event_log_head(const EventLog &log) {
+  return __atomic_load_n(&log.head, __ATOMIC_ACQUIRE);
+}
+
+uint32_t event_log_oldest(const EventLog &log) {
+  uint32_t head  = event_log_head(log);
+  uint32_t low   = head > log.capacity ? head - log.capacity : 0;
+  uint32_t first = __atomic_load_n(&log.first, __ATOMIC_RELAXED);
+  return first > low ? first : low;
+}
+
+void event_log_clear(EventLog &log, uint32_t before) {
+  uint32_t head = event_log_head(log);
+  if (before > head) before = head;
+  if (before > __atomic_load_n(&log.first, __ATOMIC_RELAXED)) {
+    __atomic_store_n(&log.first, before, __ATOMIC_RELAXED);
+  }
+
+  // Unstamp the dropped slots so a reset does not bring them back. Plain
+  // stores, no compare-exchange (not available on RTC memory): a slot is
+  // only rewritten once the head has lapped it, and then it holds a
+  // stamp >= before and is left alone
+  for (uint16_t i = 0; i < log.capacity; i++) {
+    uint32_t stamp = log.slots[i].stamp;
+    if (stamp != 0 && stamp - 1 < before) log.slots[i].stamp = 0;
+  }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================================
+// EVENT LOG - Lock-free ring of fixed-size binary event records
+// ========================================================================
+// Any task may add: a writer claims the next index with one atomic add,
+// then fills the slot under a stamp (index + 1, 0 while written), so
+// writers never wait and readers detect torn or overwritten slots instead
+// of locking. Slots are plain 32-bit words - they can live in RTC slow
+// memory, which keeps them across soft and watchdog resets; the head
+// counter stays in normal RAM (atomics need it) and is rebuilt from the
+// stamps by event_log_init(keep = true).
+//
+// Indexes count every event since the log was started and do not wrap
+// with the ring, so a reader resumes from the index after its last record.
+// ========================================================================
+
+enum EventType : uint8_t {
+  EVENT_NONE         = 0,  // Slot overwritten or being written
+  EVENT_BOOT         = 1,  // arg8 = reset reason (esp_reset_reason_t)
+  EVENT_COMMAND      = 2,  // arg8 = command byte, arg16 = frame seq (0 = legacy)
+  EVENT_PULSE_START  = 3,  // time = LED-on edge, arg8 = source, arg16 = tag
+  EVENT_PULSE_END    = 4,  // time = LED-off edge, arg8 = source, arg32 = duration us
+  EVENT_SENSOR_FAIL  = 5,  // arg16 = consecutive failures
+  EVENT_BUFFER_CLEAR = 6,  // arg32 = bytes discarded
+  EVENT_ERROR        = 7,  // arg8 = EVENT_ERROR_*, arg16 / arg32 = detail
+  EVENT_RESUME       = 8,  // arg8 = RESET_INFO flags, arg32 = first resumed schedule frame
+};
+
+// EVENT_ERROR sub-codes
+const uint8_t EVENT_ERROR_UNKNOWN_COMMAND = 1;  // arg16 = command byte
+const uint8_t EVENT_ERROR_PAYLOAD_TIMEOUT = 2;  // arg16 = command byte
+const uint8_t EVENT_ERROR_FRAME           = 3;  // arg16 = frame error reason
+const uint8_t EVENT_ERROR_TX_DROPPED      = 4;  // arg16 = response code
+const uint8_t EVENT_ERROR_QUEUE_FULL      = 5;  // arg16 = capture seq
+const uint8_t EVENT_ERROR_LATE_CAPTURE    = 6;  // arg16 = capture seq, arg32 = late us
+const uint8_t EVENT_ERROR_LATE_FRAME      = 7;  // arg16 = frame index (low bits), arg32 = late us
+const uint8_t EVENT_ERROR_SYNC_MISSED     = 8;  // Sync line edge, nothing armed; arg32 = total missed
+const uint8_t EVENT_ERROR_SYNC_NO_EDGE    = 9;  // Master drove the line, its own edge never came
+
+struct EventRecord {
+  uint64_t time_us;  // esp_timer time
+  uint8_t  type;     // EventType
+  uint8_t  arg8;
+  uint16_t arg16;
+  uint32_t arg32;
+};
+
+struct EventSlot {
+  volatile uint32_t stamp;  // Index + 1 of the record held, 0 = empty / being written
+  uint32_t info;            // type | arg8 << 8 | arg16 << 16
+  uint32_t arg32;
+  uint32_t time_lo;
+  uint32_t time_hi;
+};
+
+struct EventLog {
+  EventSlot *slots;
+  uint16_t   capacity;
+  uint32_t   head;   // Index of the next record
+  uint32_t   first;  // Oldest index not cleared
+};
+
+// keep = the slots survived a reset: valid records stay, the rest is wiped
+void     event_log_init(EventLog &log, EventSlot *slots, uint16_t capacity, bool keep);
+uint32_t event_log_add(EventLog &log, const EventRecord &record);  // Returns the index
+bool     event_log_read(const EventLog &log, uint32_t index, EventRecord &record);
+uint32_t event_log_head(const EventLog &log);
+uint32_t event_log_oldest(const EventLog &log);  // Oldest index still in the ring
+void     event_log_clear(EventLog &log, uint32_t before);  // Drop records < before
@@ -0,0 +1,112 @@
+#include "frame_codec.h"
+
+#include <string.h>
+
+uint16_t frame_crc16(const uint8_t *data, uint8_t len) {
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+uint8_t frame_encode(uint8_t *out, uint8_t id, uint8_t seq, const uint8_t *payload, uint8_t len) {
+  // out must hold len + FRAME_OVERHEAD bytes, len <= FRAME_MAX_PAYLOAD
+  out[0] = FRAME_SYNC;
+  out[1] = len;
+  out[2] = id;
+  out[3] = seq;
+  if (len) memcpy(&out[4], payload, len);
+  uint16_t crc = frame_crc16(&out[1], len + 3);
+  out[len + 4] = crc >> 8;
+  out[len + 5] = crc & 0xFF;
+  return len + FRAME_OVERHEAD;
+}
+
+void frame_decoder_init(FrameDecoder &decoder, uint16_t timeout_ms) {
+  decoder.timeout_ms = timeout_ms;
+  decoder.dropped    = 0;
+  frame_decoder_reset(decoder);
+}
+
+void frame_decoder_reset(FrameDecoder &decoder) {
+  decoder.count        = 0;
+  decoder.last_byte_ms = 0;
+  decoder.id           = 0;
+  decoder.seq          = 0;
+  decoder.len          = 0;
+}
+
+static void consume(FrameDecoder &decoder, uint8_t count) {
+  if (count >= decoder.count) {
+    decoder.count = 0;
+    return;
+  }
+  memmove(decoder.buf, &decoder.buf[count], decoder.count - count);
+  decoder.count -= count;
+}
+
+static void reject(FrameDecoder &decoder) {
+  // Drop the sync byte only - the next frame may start inside this one
+  decoder.seq = decoder.count > 3 ? decoder.buf[3] : 0;
+  consume(decoder, 1);
+}
+
+void frame_decoder_push(FrameDecoder &decoder, uint8_t value, uint32_t now_ms) {
+  if (decoder.count == 0 && value != FRAME_SYNC) {
+    decoder.dropped++;
+    return;
+  }
+  // frame_decoder_next() runs after every push, so a full buffer always
+  // holds a complete frame candidate and this never truncates
+  if (decoder.count < FRAME_MAX_SIZE) decoder.buf[decoder.count++] = value;
+  decoder.last_byte_ms = now_ms;
+}
+
+FrameStatus frame_decoder_next(FrameDecoder &decoder, uint32_t now_ms) {
+  // Call until it returns FRAME_NONE - one status per call
+  uint8_t skip = 0;
+  while (skip < decoder.count && decoder.buf[skip] != FRAME_SYNC) skip++;
+  if (skip) {
+    decoder.dropped += skip;
+    consume(decoder, skip);
+  }
+
+  if (decoder.count >= 2) {
+    uint8_t len = decoder.buf[1];
+    if (len > FRAME_MAX_PAYLOAD) {
+      reject(decoder);
+      return FRAME_ERROR_LENGTH;
+    }
+
+    uint8_t size = len + FRAME_OVERHEAD;
+    if (decoder.count >= size) {
+      uint16_t crc = ((uint16_t)decoder.buf[size - 2] << 8) | decoder.buf[size - 1];
+      if (frame_crc16(&decoder.buf[1], len + 3) != crc) {
+        reject(decoder);
+        return FRAME_ERROR_CRC;
+      }
+      decoder.id  = decoder.buf[2];
+      decoder.seq = decoder.buf[3];
+      decoder.len = len;
+      memcpy(decoder.payload, &decoder.buf[4], len);
+      consume(decoder, size);
+      return FRAME_READY;
+    }
+  }
+
+  if (decoder.count > 0 && (now_ms - decoder.last_byte_ms) > decoder.timeout_ms) {
+    // Nothing more is coming - any sync byte left in here is incomplete too
+    decoder.seq   = decoder.count > 3 ? decoder.buf[3] : 0;
+    decoder.count = 0;
+    return FRAME_ERROR_TIMEOUT;
+  }
+  return FRAME_NONE;
+}
+
+bool frame_decoder_idle(const FrameDecoder &decoder) {
+  return decoder.count == 0;
+}
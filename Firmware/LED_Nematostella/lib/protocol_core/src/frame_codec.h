@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================================
+// FRAME CODEC - Protocol v3 framing (opt-in via CMD_GET_CAPABILITIES)
+// ========================================================================
+// [0x7E][len][id][seq][payload: len bytes][crc16 hi][crc16 lo]
+// id is the command byte (host -> device) or response code (device -> host),
+// so the payload keeps the legacy layout. seq is echoed in every reply.
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over len, id, seq, payload.
+//
+// The decoder keeps the bytes of the frame candidate: after a CRC or length
+// error it rescans them for the next sync byte, so a corrupted or dropped
+// byte costs the damaged frame only.
+// ========================================================================
+
+const uint8_t FRAME_SYNC        = 0x7E;
+const uint8_t FRAME_MAX_PAYLOAD = 64;
+const uint8_t FRAME_OVERHEAD    = 6;  // sync, len, id, seq, crc16
+const uint8_t FRAME_MAX_SIZE    = FRAME_MAX_PAYLOAD + FRAME_OVERHEAD;
+
+enum FrameStatus : uint8_t {
+  FRAME_NONE,           // Need more bytes
+  FRAME_READY,          // id/seq/len/payload hold a valid frame
+  FRAME_ERROR_CRC,
+  FRAME_ERROR_LENGTH,   // len byte above FRAME_MAX_PAYLOAD
+  FRAME_ERROR_TIMEOUT   // Frame incomplete after timeout_ms without a byte
+};
+
+struct FrameDecoder {
+  uint8_t  buf[FRAME_MAX_SIZE];  // Candidate frame, buf[0] == FRAME_SYNC
+  uint8_t  count;
+  uint32_t last_byte_ms;
+  uint16_t timeout_ms;
+
+  // Decoded frame (FRAME_READY), or best-effort seq of a rejected one
+  uint8_t  id;
+  uint8_t  seq;
+  uint8_t  len;
+  uint8_t  payload[FRAME_MAX_PAYLOAD];
+
+  uint32_t dropped;  // Bytes discarded while hunting for FRAME_SYNC
+};
+
+uint16_t frame_crc16(const uint8_t *data, uint8_t len);
+uint8_t  frame_encode(uint8_t *out, uint8_t id, uint8_t seq, const uint8_t *payload, uint8_t len);
+
+void        frame_decoder_init(FrameDecoder &decoder, uint16_t timeout_ms);
+void        frame_decoder_reset(FrameDecoder &decoder);
+void        frame_decoder_push(FrameDecoder &decoder, uint8_t value, uint32_t now_ms);
+FrameStatus frame_decoder_next(FrameDecoder &decoder, uint32_t now_ms);
+bool        frame_decoder_idle(const FrameDecoder &decoder);
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================================
+// HAL - Hardware services used by the protocol core
+// ========================================================================
+// The core modules in this library build for the ESP32 and for the host
+// ([env:native]). Time always comes in as an argument (now_ms), so the
+// only service they call is the serial write below. The firmware
+// implements it in src/hal_arduino.cpp, native tests with a capture
+// buffer. LEDC, timer and DHT access stay in the firmware drivers.
+// ========================================================================
+
+// Write one response and block until it has left the TX buffer
+void hal_serial_write(const uint8_t *data, uint8_t len);
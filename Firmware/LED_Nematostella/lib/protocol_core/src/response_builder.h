@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+
+// ========================================================================
+// RESPONSE BUILDER - One write + one flush per multi-byte response
+// ========================================================================
+// Responses are assembled in a stack buffer and sent with a single
+// hal_serial_write(buf, len). Byte order follows the existing protocol:
+// integers big-endian, floats little-endian IEEE 754 (native ESP32 order).
+// ========================================================================
+
+const uint8_t RESPONSE_BUILDER_CAPACITY = 64;
+
+struct ResponseBuilder {
+  uint8_t buf[RESPONSE_BUILDER_CAPACITY];
+  uint8_t len;
+  bool    overflow;  // Set if a put did not fit - send() then drops the response
+  uint8_t seq;       // Frame seq in protocol v3, stamped by queueResponse()
+
+  ResponseBuilder() : len(0), overflow(false), seq(0) {}
+
+  void put_u8(uint8_t value) {
+    if (!reserve(1)) return;
+    buf[len++] = value;
+  }
+
+  void put_u16_be(uint16_t value) {
+    if (!reserve(2)) return;
+    buf[len++] = (value >> 8) & 0xFF;
+    buf[len++] = value & 0xFF;
+  }
+
+  void put_i16_be(int16_t value) {
+    put_u16_be((uint16_t)value);
+  }
+
+  void put_u32_be(uint32_t value) {
+    if (!reserve(4)) return;
+    buf[len++] = (value >> 24) & 0xFF;
+    buf[len++] = (value >> 16) & 0xFF;
+    buf[len++] = (value >> 8) & 0xFF;
+    buf[len++] = value & 0xFF;
+  }
+
+  void put_u64_be(uint64_t value) {
+    put_u32_be((uint32_t)(value >> 32));
+    put_u32_be((uint32_t)value);
+  }
+
+  void put_f32_le(float value) {
+    if (!reserve(4)) return;
+    memcpy(&buf[len], &value, 4);
+    len += 4;
+  }
+
+  void send() const {
+    if (overflow || len == 0) return;
+    hal_serial_write(buf, len);
+  }
+
+private:
+  bool reserve(uint8_t count) {
+    if (overflow || len + count > RESPONSE_BUILDER_CAPACITY) {
+      overflow = true;
+      return false;
+    }
+    return true;
+  }
+};
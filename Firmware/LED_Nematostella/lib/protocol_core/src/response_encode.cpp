@@ -0,0 +1,117 @@
+#include "response_encode.h"
+
+#include <string.h>
+
+static void put_sensor_x10(ResponseBuilder &response, float temperature, float humidity) {
+  // Scaled by 10 for 1 decimal, clamped to the DHT22 range
+  int16_t temp_scaled = (int16_t)(temperature * 10.0f);
+  uint16_t hum_scaled = (uint16_t)(humidity * 10.0f);
+  if (temp_scaled < -400) temp_scaled = -400;  // -40.0°C
+  if (temp_scaled > 850) temp_scaled = 850;     // 85.0°C
+  if (hum_scaled > 1000) hum_scaled = 1000;     // 100.0%
+
+  response.put_i16_be(temp_scaled);
+  response.put_u16_be(hum_scaled);
+}
+
+static void put_u16_saturated(ResponseBuilder &response, uint32_t value) {
+  response.put_u16_be(value < 0xFFFF ? value : 0xFFFF);
+}
+
+void encode_status(ResponseBuilder &response, uint8_t code, float temperature, float humidity) {
+  response.put_u8(code);
+  put_sensor_x10(response, temperature, humidity);
+}
+
+void encode_status_age(ResponseBuilder &response, uint32_t age_ms) {
+  // Saturates at 0xFFFE so a very old reading never reads as "none"
+  if (age_ms == UINT32_MAX) {
+    response.put_u16_be(STATUS_AGE_NONE);
+    return;
+  }
+  uint32_t age_ds = age_ms / 100;
+  response.put_u16_be(age_ds < STATUS_AGE_NONE ? age_ds : STATUS_AGE_NONE - 1);
+}
+
+void encode_sync(ResponseBuilder &response, uint8_t code, float temperature, float humidity,
+                 uint16_t duration_ms, uint8_t led_type, uint8_t power) {
+  response.put_u8(code);
+  response.put_u16_be(duration_ms);
+  response.put_f32_le(temperature);
+  response.put_f32_le(humidity);
+  response.put_u8(led_type);
+  response.put_u16_be(duration_ms);
+  response.put_u8(power);
+}
+
+void encode_sync_edges(ResponseBuilder &response, int64_t on_us, int64_t off_us) {
+  response.put_u64_be((uint64_t)on_us);
+  response.put_u64_be((uint64_t)off_us);
+}
+
+void encode_sync_settle(ResponseBuilder &response, uint16_t stabilization_ms, uint32_t settle_us) {
+  response.put_u16_be(stabilization_ms);
+  response.put_u32_be(settle_us);
+}
+
+uint8_t telemetry_record_size(uint8_t fields) {
+  uint8_t size = 4;
+  if (fields & TELEMETRY_FIELD_LEDS)   size += 4;
+  if (fields & TELEMETRY_FIELD_SENSOR) size += 6;
+  if (fields & TELEMETRY_FIELD_TIMING) size += 12;
+  if (fields & TELEMETRY_FIELD_UPTIME) size += 4;
+  return size;
+}
+
+void encode_telemetry(ResponseBuilder &response, uint8_t code, const TelemetryRecord &record) {
+  uint8_t fields = record.fields & TELEMETRY_FIELDS_ALL;
+  response.put_u8(code);
+  response.put_u16_be(record.seq);
+  response.put_u8(fields);
+
+  if (fields & TELEMETRY_FIELD_LEDS) {
+    response.put_u8(record.led_on_mask);
+    response.put_u8(record.led_type);
+    response.put_u8(record.ir_power);
+    response.put_u8(record.white_power);
+  }
+  if (fields & TELEMETRY_FIELD_SENSOR) {
+    put_sensor_x10(response, record.temperature, record.humidity);
+    encode_status_age(response, record.sensor_age_ms);
+  }
+  if (fields & TELEMETRY_FIELD_TIMING) {
+    response.put_u32_be(record.pulse_count);
+    put_u16_saturated(response, record.cmd_to_led_on_max_us);
+    put_u16_saturated(response, record.led_on_error_max_us);
+    put_u16_saturated(response, record.rt_iteration_max_us);
+    put_u16_saturated(response, record.comms_iteration_max_us);
+  }
+  if (fields & TELEMETRY_FIELD_UPTIME) {
+    response.put_u32_be(record.uptime_ms);
+  }
+}
+
+uint8_t encode_event_chunk(ResponseBuilder &response, uint8_t code, const EventLog &log,
+                           uint32_t first, uint32_t end) {
+  uint32_t remaining = end > first ? end - first : 0;
+  uint8_t  count     = remaining < EVENT_CHUNK_RECORDS ? remaining : EVENT_CHUNK_RECORDS;
+
+  response.put_u8(code);
+  response.put_u32_be(first);
+  response.put_u32_be(event_log_head(log));
+  response.put_u8(count);
+  response.put_u8(count == remaining ? EVENT_CHUNK_FLAG_LAST : 0);
+
+  for (uint8_t i = 0; i < count; i++) {
+    EventRecord record;
+    if (!event_log_read(log, first + i, record)) {
+      memset(&record, 0, sizeof(record));
+    }
+    response.put_u8(record.type);
+    response.put_u8(record.arg8);
+    response.put_u16_be(record.arg16);
+    response.put_u32_be(record.arg32);
+    response.put_u64_be(record.time_us);
+  }
+  return count;
+}
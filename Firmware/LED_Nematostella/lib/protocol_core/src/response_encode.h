@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "event_log.h"
+#include "response_builder.h"
+
+// ========================================================================
+// RESPONSE ENCODE - Wire layouts of the status, sync, telemetry and event responses
+// ========================================================================
+// Status: [code][temp x10 i16][hum x10 u16] (+ [age u16] in 100 ms steps).
+// Sync:   [code][duration_ms u16][temp f32][hum f32][led_type]
+//         [duration_ms u16][power] (15 bytes), the extended response
+//         appends the LED-on / LED-off edges as u64 (31 bytes), the settle
+//         response then [stabilization_ms u16][settle_us u32] (37 bytes).
+// The response code comes from the caller, so the same layout serves
+// RESPONSE_SYNC_COMPLETE, _EXT and _SETTLE.
+//
+// Telemetry: [code][seq u16][fields], then the groups selected in fields
+// in bit order, so the record size only depends on the mask:
+//   LEDS   [on mask][led type][ir power][white power]                   4
+//   SENSOR [temp x10 i16][hum x10 u16][age u16, 100 ms steps]            6
+//   TIMING [pulses u32][max us u16: cmd -> LED-on, LED-on error,
+//           rtTask pass, commsTask pass]                                 12
+//   UPTIME [ms since boot u32]                                           4
+//
+// Event log chunk: [code][first index u32][head u32][count][flags], then
+// count records of [type][arg8][arg16][arg32][time_us u64] (16 bytes) for
+// the indexes first, first + 1, ... Flags bit0 = last chunk of the range.
+// Records no longer (or not yet) readable go out as EVENT_NONE.
+// ========================================================================
+
+const uint16_t STATUS_AGE_NONE = 0xFFFF;  // No valid reading yet
+
+void encode_status(ResponseBuilder &response, uint8_t code, float temperature, float humidity);
+void encode_status_age(ResponseBuilder &response, uint32_t age_ms);  // UINT32_MAX = none
+void encode_sync(ResponseBuilder &response, uint8_t code, float temperature, float humidity,
+                 uint16_t duration_ms, uint8_t led_type, uint8_t power);
+void encode_sync_edges(ResponseBuilder &response, int64_t on_us, int64_t off_us);
+void encode_sync_settle(ResponseBuilder &response, uint16_t stabilization_ms, uint32_t settle_us);
+
+const uint8_t TELEMETRY_FIELD_LEDS   = 0x01;
+const uint8_t TELEMETRY_FIELD_SENSOR = 0x02;
+const uint8_t TELEMETRY_FIELD_TIMING = 0x04;
+const uint8_t TELEMETRY_FIELD_UPTIME = 0x08;
+const uint8_t TELEMETRY_FIELDS_ALL   = 0x0F;
+
+struct TelemetryRecord {
+  uint16_t seq;
+  uint8_t  fields;  // TELEMETRY_FIELD_* to encode
+  uint8_t  led_on_mask;
+  uint8_t  led_type;
+  uint8_t  ir_power;
+  uint8_t  white_power;
+  float    temperature;
+  float    humidity;
+  uint32_t sensor_age_ms;  // UINT32_MAX = no reading yet
+  uint32_t pulse_count;
+  uint32_t cmd_to_led_on_max_us;  // Maxima saturate at 0xFFFF on the wire
+  uint32_t led_on_error_max_us;
+  uint32_t rt_iteration_max_us;
+  uint32_t comms_iteration_max_us;
+  uint32_t uptime_ms;
+};
+
+uint8_t telemetry_record_size(uint8_t fields);
+void encode_telemetry(ResponseBuilder &response, uint8_t code, const TelemetryRecord &record);
+
+const uint8_t EVENT_RECORD_SIZE       = 16;
+const uint8_t EVENT_CHUNK_HEADER_SIZE = 11;
+const uint8_t EVENT_CHUNK_RECORDS     = 3;  // 59 bytes, fits one frame
+const uint8_t EVENT_CHUNK_FLAG_LAST   = 0x01;
+
+// Records [first, end) up to EVENT_CHUNK_RECORDS; returns how many went in
+uint8_t encode_event_chunk(ResponseBuilder &response, uint8_t code, const EventLog &log,
+                           uint32_t first, uint32_t end);
@@ -0,0 +1,44 @@
+#include "resume_state.h"
+
+#include <string.h>
+
+#include "frame_codec.h"
+
+static uint16_t state_crc(const ResumeState &state) {
+  const uint8_t *bytes = (const uint8_t *)&state;
+  return frame_crc16(bytes + sizeof(state.crc), sizeof(ResumeState) - sizeof(state.crc));
+}
+
+void resume_state_write(ResumeSlot &slot, ResumeState &state) {
+  state.version = RESUME_STATE_VERSION;
+  state.crc     = state_crc(state);
+
+  uint32_t words[RESUME_SLOT_WORDS] = {};
+  memcpy(words, &state, sizeof(state));
+  for (uint8_t i = 0; i < RESUME_SLOT_WORDS; i++) slot.words[i] = words[i];
+}
+
+int8_t resume_state_read(const ResumeSlot slots[RESUME_SLOTS], ResumeState &state) {
+  int8_t   newest     = -1;
+  uint32_t generation = 0;
+  uint32_t words[RESUME_SLOT_WORDS];
+  ResumeState candidate;
+
+  for (uint8_t s = 0; s < RESUME_SLOTS; s++) {
+    for (uint8_t i = 0; i < RESUME_SLOT_WORDS; i++) words[i] = slots[s].words[i];
+    memcpy(&candidate, words, sizeof(candidate));
+    if (candidate.version != RESUME_STATE_VERSION || candidate.crc != state_crc(candidate)) continue;
+
+    // Generations wrap, so newer means a positive distance
+    if (newest < 0 || (int32_t)(candidate.generation - generation) > 0) {
+      newest     = s;
+      generation = candidate.generation;
+      state      = candidate;
+    }
+  }
+  return newest;
+}
+
+bool resume_state_usable(const ResumeState &state) {
+  return !(state.resumed && state.uptime_ms < RESUME_MIN_UPTIME_MS);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "device_config.h"
+
+// ========================================================================
+// RESUME STATE - Host-visible runtime state carried across warm resets
+// ========================================================================
+// commsTask snapshots what the host has set up - LED outputs and ramps,
+// protocol and baud rate, sync role, telemetry, a running schedule - about
+// once a second into RTC slow memory, which panics, watchdog and software
+// resets leave alone. setup() brings the newest valid snapshot back
+// instead of the cold boot defaults, so a crash costs the reset itself
+// rather than a re-handshake and the frames of a slow boot.
+//
+// Snapshots alternate between RESUME_SLOTS slots, each with a generation
+// counter and a CRC-16 (same as the frames) over everything after it: a
+// reset in the middle of a write leaves the other slot intact, the random
+// contents after a power-on fail the check. Slots are copied as 32-bit
+// words, like the event log slots. A boot that was resumed itself and
+// crashes again within RESUME_MIN_UPTIME_MS boots cold, so state that
+// brings the firmware down cannot hold it in a reset loop.
+// ========================================================================
+
+const uint8_t  RESUME_STATE_VERSION = 1;
+const uint8_t  RESUME_SLOTS         = 2;
+const uint8_t  RESUME_MAX_CHANNELS  = 8;
+const uint32_t RESUME_MIN_UPTIME_MS = 10000;
+
+struct ResumeRamp {
+  uint8_t  active;
+  uint16_t power;         // Output at the snapshot, 1/100 %
+  uint16_t to;            // Target, 1/100 %
+  uint32_t remaining_ms;
+};
+
+struct ResumeSchedule {
+  uint8_t  running;
+  uint8_t  led_type;
+  uint8_t  power;
+  uint16_t stabilization_ms;
+  uint16_t exposure_ms;
+  uint32_t frame_count;         // 0 = until CMD_STOP_SCHEDULE
+  uint32_t next_frame;          // First frame not started at the snapshot
+  uint32_t frames_done;         // Frame events sent
+  int64_t  interval_us;
+  int64_t  next_frame_wall_us;  // Its deadline in system time, which counts through resets
+};
+
+struct ResumeState {
+  uint16_t crc;           // Over the bytes after it
+  uint8_t  version;
+  uint8_t  resumed;       // Written by a boot that was resumed itself
+  uint32_t generation;    // The newer valid slot wins
+  uint32_t warm_resets;   // Since the last cold boot
+  uint32_t uptime_ms;     // Of the boot that wrote it
+  uint8_t  config[DEVICE_CONFIG_SIZE];
+  uint8_t  power[RESUME_MAX_CHANNELS];  // 0-100 %
+  uint8_t  on_mask;
+  uint8_t  capture_mask;
+  uint8_t  framed;
+  uint8_t  power_mode;
+  uint8_t  sync_role;
+  uint8_t  sync_dual;
+  uint8_t  sensor_flags;
+  uint8_t  telemetry_fields;
+  uint16_t telemetry_period_ms;
+  uint32_t sensor_max_age_ms;
+  uint32_t baud;
+  ResumeRamp     ramps[RESUME_MAX_CHANNELS];
+  ResumeSchedule schedule;
+};
+
+const uint8_t RESUME_SLOT_WORDS = (sizeof(ResumeState) + 3) / 4;
+static_assert(sizeof(ResumeState) - 2 <= 255, "Resume state too large for frame_crc16");
+
+struct ResumeSlot {
+  uint32_t words[RESUME_SLOT_WORDS];
+};
+
+// Sets version and CRC, then copies the state into the slot
+void resume_state_write(ResumeSlot &slot, ResumeState &state);
+// Newest valid slot into state; returns its index, -1 if none is valid
+int8_t resume_state_read(const ResumeSlot slots[RESUME_SLOTS], ResumeState &state);
+// A read state may be brought back: not from a resumed boot that crashed early
+bool   resume_state_usable(const ResumeState &state);
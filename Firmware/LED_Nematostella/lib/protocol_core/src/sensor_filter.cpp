@@ -0,0 +1,53 @@
+#include "sensor_filter.h"
+
+#include <string.h>
+
+void sensor_filter_reset(SensorFilter &filter) {
+  memset(&filter, 0, sizeof(filter));
+}
+
+void sensor_filter_add(SensorFilter &filter, float temperature, float humidity, uint32_t now_ms) {
+  if (!filter.initialized) {
+    for (uint8_t i = 0; i < SENSOR_FILTER_SIZE; i++) {
+      filter.temp_values[i] = temperature;
+      filter.hum_values[i] = humidity;
+    }
+    filter.count = SENSOR_FILTER_SIZE;
+    filter.initialized = true;
+  } else {
+    filter.temp_values[filter.index] = temperature;
+    filter.hum_values[filter.index] = humidity;
+    filter.index = (filter.index + 1) % SENSOR_FILTER_SIZE;
+    if (filter.count < SENSOR_FILTER_SIZE) filter.count++;
+  }
+  filter.last_valid_ms = now_ms;
+}
+
+static float average(const float *values, uint8_t count) {
+  float sum = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    sum += values[i];
+  }
+  return sum / count;
+}
+
+float sensor_filter_temperature(const SensorFilter &filter) {
+  if (!filter.initialized) return SENSOR_FILTER_DEFAULT_TEMP;
+  return average(filter.temp_values, filter.count);
+}
+
+float sensor_filter_humidity(const SensorFilter &filter) {
+  if (!filter.initialized) return SENSOR_FILTER_DEFAULT_HUM;
+  return average(filter.hum_values, filter.count);
+}
+
+void sensor_filter_newest(const SensorFilter &filter, float &temperature, float &humidity) {
+  if (!filter.initialized) {
+    temperature = SENSOR_FILTER_DEFAULT_TEMP;
+    humidity = SENSOR_FILTER_DEFAULT_HUM;
+    return;
+  }
+  uint8_t newest = (filter.index + SENSOR_FILTER_SIZE - 1) % SENSOR_FILTER_SIZE;
+  temperature = filter.temp_values[newest];
+  humidity = filter.hum_values[newest];
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================================
+// SENSOR FILTER - Moving average over the last valid DHT22 samples
+// ========================================================================
+// The first sample fills the whole window, so the average is defined from
+// the first reading on. Before that the filter reports room defaults.
+// Only valid readings go in - range checks are the caller's job.
+// ========================================================================
+
+const uint8_t SENSOR_FILTER_SIZE         = 5;
+const float   SENSOR_FILTER_DEFAULT_TEMP = 25.0f;
+const float   SENSOR_FILTER_DEFAULT_HUM  = 50.0f;
+
+struct SensorFilter {
+  float    temp_values[SENSOR_FILTER_SIZE];
+  float    hum_values[SENSOR_FILTER_SIZE];
+  uint8_t  index;          // Slot of the next sample
+  uint8_t  count;
+  bool     initialized;
+  uint32_t last_valid_ms;  // now_ms of the newest sample
+};
+
+void  sensor_filter_reset(SensorFilter &filter);
+void  sensor_filter_add(SensorFilter &filter, float temperature, float humidity, uint32_t now_ms);
+float sensor_filter_temperature(const SensorFilter &filter);
+float sensor_filter_humidity(const SensorFilter &filter);
+void  sensor_filter_newest(const SensorFilter &filter, float &temperature, float &humidity);
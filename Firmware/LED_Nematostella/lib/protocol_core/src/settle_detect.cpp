@@ -0,0 +1,26 @@
+#include "settle_detect.h"
+
+uint32_t settle_detect(const SettleSample *samples, uint16_t count, uint16_t dark,
+                       const SettleParams &params) {
+  if (count <= SETTLE_FINAL_SAMPLES) return SETTLE_NONE;
+
+  uint32_t sum = 0;
+  for (uint16_t i = count - SETTLE_FINAL_SAMPLES; i < count; i++) sum += samples[i].value;
+  int32_t final_level = (int32_t)(sum / SETTLE_FINAL_SAMPLES);
+  int32_t step        = final_level - dark;
+  if (step < (int32_t)params.min_signal) return SETTLE_NO_SIGNAL;
+
+  int32_t band = (int32_t)((uint32_t)step * params.tolerance_permille / 1000);
+  if (band < (int32_t)params.noise) band = params.noise;
+
+  // Walk back to the last sample outside the band
+  uint16_t first_stable = count;
+  while (first_stable > 0) {
+    int32_t offset = (int32_t)samples[first_stable - 1].value - final_level;
+    if (offset > band || offset < -band) break;
+    first_stable--;
+  }
+  // Stable for less than the averaging window: still moving
+  if (first_stable > count - SETTLE_FINAL_SAMPLES) return SETTLE_NONE;
+  return samples[first_stable].t_us;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================================
+// SETTLE DETECT - LED rise-to-stable time from photodiode samples
+// ========================================================================
+// Input is one switch-on recorded by CMD_CALIBRATE_SETTLE: (time since
+// the LED-on edge, ADC reading) pairs in time order, plus the dark level
+// read just before. The final level is the mean of the last
+// SETTLE_FINAL_SAMPLES readings; the band around it is tolerance_permille
+// of the step above the dark level, at least noise counts. The LED has
+// settled at the first sample after the last one outside the band, if it
+// stays inside for at least the averaging window.
+// ========================================================================
+
+const uint32_t SETTLE_NONE      = 0xFFFFFFFF;  // Still outside the band at the end
+const uint32_t SETTLE_NO_SIGNAL = 0xFFFFFFFE;  // Step below min_signal (no photodiode, LED off)
+const uint8_t  SETTLE_FINAL_SAMPLES = 16;
+
+struct SettleSample {
+  uint32_t t_us;
+  uint16_t value;
+};
+
+struct SettleParams {
+  uint16_t tolerance_permille;
+  uint16_t noise;       // Smallest band half-width, ADC counts
+  uint16_t min_signal;  // Smallest final - dark step, ADC counts
+};
+
+uint32_t settle_detect(const SettleSample *samples, uint16_t count, uint16_t dark,
+                       const SettleParams &params);
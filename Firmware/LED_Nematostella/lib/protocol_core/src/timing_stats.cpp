@@ -0,0 +1,29 @@
+#include "timing_stats.h"
+
+#include <string.h>
+
+void timing_stat_reset(TimingStat &stat) {
+  memset(&stat, 0, sizeof(stat));
+  stat.min_us = UINT32_MAX;
+}
+
+void timing_stat_record(TimingStat &stat, uint32_t us) {
+  if (stat.count == UINT32_MAX) return;
+  stat.count++;
+  stat.sum_us += us;
+  if (us < stat.min_us) stat.min_us = us;
+  if (us > stat.max_us) stat.max_us = us;
+
+  uint16_t &bucket = stat.buckets[timing_bucket(us)];
+  if (bucket < UINT16_MAX) bucket++;
+}
+
+uint32_t timing_stat_mean(const TimingStat &stat) {
+  return stat.count ? (uint32_t)(stat.sum_us / stat.count) : 0;
+}
+
+uint8_t timing_bucket(uint32_t us) {
+  if (us < 2) return 0;
+  uint8_t log2 = 31 - __builtin_clz(us);
+  return log2 < TIMING_BUCKETS ? log2 : TIMING_BUCKETS - 1;
+}
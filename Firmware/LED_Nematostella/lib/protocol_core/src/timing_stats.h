@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================================
+// TIMING STATS - Fixed-size latency statistics in microseconds
+// ========================================================================
+// Each TimingStat keeps count, min, max, sum and a log2 histogram:
+// bucket 0 holds 0-1 us, bucket n holds [2^n, 2^(n+1)) us and the last
+// bucket everything from 2^(TIMING_BUCKETS-1) us (~524 ms) up. Counters
+// saturate instead of wrapping. No locking - callers serialize access.
+// ========================================================================
+
+const uint8_t TIMING_BUCKETS = 20;
+
+struct TimingStat {
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t sum_us;
+  uint16_t buckets[TIMING_BUCKETS];
+};
+
+void     timing_stat_reset(TimingStat &stat);
+void     timing_stat_record(TimingStat &stat, uint32_t us);
+uint32_t timing_stat_mean(const TimingStat &stat);
+uint8_t  timing_bucket(uint32_t us);
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stdint.h>
+
+// ========================================================================
+// BOARD CONFIG - Compile-time board and feature selection
+// ========================================================================
+// Every supported board is a struct of constexpr pins and properties, and
+// Board aliases the one the build targets. Features collects the optional
+// parts of the firmware from build flags. Both are compile-time constants:
+// `if (Features::...)` drops the disabled branch from the binary and pin
+// numbers fold into the code that uses them - no run-time board checks.
+// Unlike #ifdef blocks, every branch is still compiled in every build, so
+// a disabled feature cannot rot. Plain C++11 (the Arduino-ESP32 default).
+//
+// Adding a board: one more struct with the same members and a branch in
+// the Board selection below.
+// ========================================================================
+
+struct BoardEsp32DevKit {
+  static constexpr const char *name = "ESP32-DevKit";
+  static constexpr uint8_t id       = 0;      // Board byte of CMD_GET_CAPABILITIES
+  static constexpr int led_ir_pin    = 4;
+  static constexpr int led_white_pin = 15;
+  static constexpr int dht_pin       = 14;
+  static constexpr int trigger_pin   = 27;    // Camera trigger out
+  static constexpr int sync_pin      = 26;    // Shared sync line between boards
+  static constexpr int photodiode_pin = 34;   // ADC1, input only - LED settle calibration
+  static constexpr uint8_t ledc_channels = 16;  // 8 high-speed + 8 low-speed
+  static constexpr bool native_usb   = false;   // Serial over a USB-UART bridge
+};
+
+struct BoardEsp32S3Box {
+  static constexpr const char *name = "ESP32-S3-BOX-3";
+  static constexpr uint8_t id       = 1;
+  static constexpr int led_ir_pin    = 10;    // Pmod header
+  static constexpr int led_white_pin = 11;    // Pmod header
+  static constexpr int dht_pin       = 12;    // Pmod header
+  static constexpr int trigger_pin   = 13;    // Pmod header - camera trigger out
+  static constexpr int sync_pin      = 14;    // Pmod header - shared sync line
+  static constexpr int photodiode_pin = 9;    // Pmod header - ADC1, LED settle calibration
+  static constexpr uint8_t ledc_channels = 8;   // Low-speed only
+  static constexpr bool native_usb   = true;    // USB-CDC, host may open late
+};
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(ESP32S3)
+  using Board = BoardEsp32S3Box;
+#elif defined(CONFIG_IDF_TARGET_ESP32) || defined(ESP32)
+  using Board = BoardEsp32DevKit;
+#else
+  #error "Unsupported board! Only ESP32 and ESP32-S3 are supported."
+#endif
+
+// FEATURES
+// Build flags, all optional:
+//   -D FIRMWARE_DEBUG=1          debug text on Serial (breaks the binary protocol)
+//   -D CAMERA_TRIGGER_OUTPUT=0   no trigger pin; CMD_SET_TRIGGER is rejected
+//   -D DIRECT_IO_REGISTERS=0     LED/trigger edges through ledcWrite() and
+//                                digitalWrite() instead of the registers (led_io.h)
+//   -D SYNC_LINE=0               no shared sync line; CMD_SET_SYNC_ROLE is rejected
+//   -D NETWORK_TRANSPORT=1       protocol over Wi-Fi UDP as well (net_transport.h),
+//                                with -D WIFI_SSID=\"...\" -D WIFI_PASSWORD=\"...\"
+//                                and optionally NETWORK_UDP_PORT / NETWORK_MULTICAST_GROUP
+//   -D PHOTODIODE=1              photodiode on Board::photodiode_pin for
+//                                CMD_CALIBRATE_SETTLE (otherwise rejected)
+#ifndef FIRMWARE_DEBUG
+  #define FIRMWARE_DEBUG 0
+#endif
+#ifndef CAMERA_TRIGGER_OUTPUT
+  #define CAMERA_TRIGGER_OUTPUT 1
+#endif
+#ifndef DIRECT_IO_REGISTERS
+  #define DIRECT_IO_REGISTERS 1
+#endif
+#ifndef SYNC_LINE
+  #define SYNC_LINE 1
+#endif
+#ifndef NETWORK_TRANSPORT
+  #define NETWORK_TRANSPORT 0
+#endif
+#ifndef PHOTODIODE
+  #define PHOTODIODE 0
+#endif
+#ifndef WIFI_SSID
+  #define WIFI_SSID ""
+#endif
+#ifndef WIFI_PASSWORD
+  #define WIFI_PASSWORD ""
+#endif
+#ifndef NETWORK_UDP_PORT
+  #define NETWORK_UDP_PORT 4210  // Group commands on NETWORK_UDP_PORT + 1
+#endif
+#ifndef NETWORK_MULTICAST_GROUP
+  #define NETWORK_MULTICAST_GROUP "239.255.42.10"
+#endif
+
+template <bool Debug, bool CameraTrigger, bool DirectIo, bool Network, bool SyncLine,
+          bool Photodiode>
+struct FeatureSet {
+  static constexpr bool debug          = Debug;
+  static constexpr bool camera_trigger = CameraTrigger;
+  static constexpr bool direct_io      = DirectIo;
+  static constexpr bool network        = Network;
+  static constexpr bool sync_line      = SyncLine;
+  static constexpr bool photodiode     = Photodiode;
+};
+
+using Features = FeatureSet<FIRMWARE_DEBUG != 0, CAMERA_TRIGGER_OUTPUT != 0,
+                            DIRECT_IO_REGISTERS != 0, NETWORK_TRANSPORT != 0,
+                            SYNC_LINE != 0, PHOTODIODE != 0>;
+
+// Trigger output, sync line and photodiode pins, -1 when compiled out
+constexpr int TRIGGER_OUTPUT_PIN   = Features::camera_trigger ? Board::trigger_pin : -1;
+constexpr int SYNC_LINE_PIN        = Features::sync_line ? Board::sync_pin : -1;
+constexpr int PHOTODIODE_INPUT_PIN = Features::photodiode ? Board::photodiode_pin : -1;
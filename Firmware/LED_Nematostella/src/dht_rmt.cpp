@@ -0,0 +1,116 @@
+#include "dht_rmt.h"
+
+#include "driver/gpio.h"
+#include "driver/rmt.h"
+
+// RX-capable channel: any on the ESP32, 4-7 on the ESP32-S3
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+  const rmt_channel_t DHT_RMT_CHANNEL = RMT_CHANNEL_4;
+#else
+  const rmt_channel_t DHT_RMT_CHANNEL = RMT_CHANNEL_0;
+#endif
+const uint8_t  DHT_RMT_CLK_DIV     = 80;   // 80 MHz APB -> 1 us ticks
+const uint8_t  DHT_RMT_MEM_BLOCKS  = 2;    // 96-128 items, a reply needs ~43
+const uint8_t  DHT_RMT_FILTER      = 100;  // APB cycles, drops glitches < 1.25 us
+const uint16_t DHT_RMT_IDLE_US     = 200;  // Line high this long = reply complete
+const size_t   DHT_RMT_RINGBUF     = 512;
+const uint8_t  DHT_MAX_PULSES      = 64;
+
+enum DhtRmtState : uint8_t {
+  DHT_STATE_IDLE,
+  DHT_STATE_START_LOW,  // Start pulse on the line
+  DHT_STATE_RECEIVING   // Line released, RMT capturing
+};
+
+static gpio_num_t      dhtGpio    = GPIO_NUM_NC;
+static RingbufHandle_t dhtRingbuf = NULL;
+static DhtRmtState     dhtState   = DHT_STATE_IDLE;
+static int64_t         dhtStateUs = 0;
+
+bool dht_rmt_init(int pin) {
+  dhtGpio = (gpio_num_t)pin;
+
+  rmt_config_t config = {};
+  config.rmt_mode                      = RMT_MODE_RX;
+  config.channel                       = DHT_RMT_CHANNEL;
+  config.gpio_num                      = dhtGpio;
+  config.clk_div                       = DHT_RMT_CLK_DIV;
+  config.mem_block_num                 = DHT_RMT_MEM_BLOCKS;
+  config.rx_config.filter_en           = true;
+  config.rx_config.filter_ticks_thresh = DHT_RMT_FILTER;
+  config.rx_config.idle_threshold      = DHT_RMT_IDLE_US;
+  if (rmt_config(&config) != ESP_OK ||
+      rmt_driver_install(DHT_RMT_CHANNEL, DHT_RMT_RINGBUF, 0) != ESP_OK ||
+      rmt_get_ringbuf_handle(DHT_RMT_CHANNEL, &dhtRingbuf) != ESP_OK) {
+    dhtRingbuf = NULL;
+    return false;
+  }
+
+  // Open drain on top of the RMT input: the start pulse is driven through
+  // the same pad the RMT listens on
+  gpio_set_direction(dhtGpio, GPIO_MODE_INPUT_OUTPUT_OD);
+  gpio_pullup_en(dhtGpio);
+  gpio_set_level(dhtGpio, 1);
+  return true;
+}
+
+bool dht_rmt_start() {
+  if (!dhtRingbuf || dhtState != DHT_STATE_IDLE) return false;
+  gpio_set_level(dhtGpio, 0);
+  dhtState   = DHT_STATE_START_LOW;
+  dhtStateUs = esp_timer_get_time();
+  return true;
+}
+
+static DhtStatus decodeItems(const rmt_item32_t *items, size_t count, float &temperature,
+                             float &humidity) {
+  // High times only; a zero or idle-length duration ends the capture
+  uint16_t high_us[DHT_MAX_PULSES];
+  uint8_t  pulses = 0;
+  for (size_t i = 0; i < count && pulses < DHT_MAX_PULSES; i++) {
+    if (items[i].level0 && items[i].duration0 > 0 && items[i].duration0 < DHT_RMT_IDLE_US) {
+      high_us[pulses++] = items[i].duration0;
+    }
+    if (pulses < DHT_MAX_PULSES && items[i].level1 && items[i].duration1 > 0 &&
+        items[i].duration1 < DHT_RMT_IDLE_US) {
+      high_us[pulses++] = items[i].duration1;
+    }
+  }
+  return dht_decode(high_us, pulses, temperature, humidity);
+}
+
+DhtStatus dht_rmt_poll(float &temperature, float &humidity) {
+  int64_t elapsed_us = esp_timer_get_time() - dhtStateUs;
+
+  switch (dhtState) {
+    case DHT_STATE_IDLE:
+      return DHT_TIMEOUT;  // Nothing started
+
+    case DHT_STATE_START_LOW:
+      if (elapsed_us < DHT_START_LOW_US) return DHT_PENDING;
+      // Arm the receiver first: the sensor answers 20-40 us after release
+      rmt_rx_start(DHT_RMT_CHANNEL, true);
+      gpio_set_level(dhtGpio, 1);
+      dhtState   = DHT_STATE_RECEIVING;
+      dhtStateUs = esp_timer_get_time();
+      return DHT_PENDING;
+
+    case DHT_STATE_RECEIVING: {
+      size_t size = 0;
+      rmt_item32_t *items = (rmt_item32_t *)xRingbufferReceive(dhtRingbuf, &size, 0);
+      if (!items) {
+        if (elapsed_us < DHT_REPLY_TIMEOUT_US) return DHT_PENDING;
+        rmt_rx_stop(DHT_RMT_CHANNEL);
+        dhtState = DHT_STATE_IDLE;
+        return DHT_TIMEOUT;
+      }
+
+      DhtStatus status = decodeItems(items, size / sizeof(rmt_item32_t), temperature, humidity);
+      vRingbufferReturnItem(dhtRingbuf, items);
+      rmt_rx_stop(DHT_RMT_CHANNEL);
+      dhtState = DHT_STATE_IDLE;
+      return status;
+    }
+  }
+  return DHT_TIMEOUT;
+}
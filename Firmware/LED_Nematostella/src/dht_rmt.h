@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Arduino.h>
+#include "dht_decode.h"
+
+// ========================================================================
+// DHT RMT - DHT22 reads captured by the RMT peripheral
+// ========================================================================
+// dht_rmt_start() pulls the data line low; the first dht_rmt_poll() at
+// least DHT_START_LOW_US later releases it and arms RMT receive, which
+// timestamps every edge of the reply in hardware (1 us ticks). Later polls
+// decode the capture once the line has gone idle. No interrupts are masked
+// and the CPU is free between polls, unlike the bit-banged Adafruit read
+// (~5 ms with interrupts off).
+//
+// Needs a caller that polls every few ms (the sensor task sleeps between
+// polls) and the usual 10k pull-up on the data line.
+// ========================================================================
+
+const uint32_t DHT_START_LOW_US     = 1100;   // DHT22 needs >= 1 ms
+const uint32_t DHT_REPLY_TIMEOUT_US = 10000;  // Full reply takes ~5 ms
+
+bool      dht_rmt_init(int pin);
+bool      dht_rmt_start();  // false while a read is in progress
+DhtStatus dht_rmt_poll(float &temperature, float &humidity);  // Non-blocking
@@ -0,0 +1,8 @@
+#include <Arduino.h>
+
+#include "hal.h"
+
+void hal_serial_write(const uint8_t *data, uint8_t len) {
+  Serial.write(data, len);
+  Serial.flush();
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Arduino.h>
+#include "hal/gpio_ll.h"
+#include "hal/ledc_ll.h"
+#include "soc/gpio_struct.h"
+#include "soc/ledc_struct.h"
+#include "board_config.h"
+
+// ========================================================================
+// LED IO - Output writes on the pulse path
+// ========================================================================
+// ledcWrite() goes through the LEDC driver: argument checks, a spinlock
+// and a function call per register, several microseconds per channel and
+// not IRAM-safe. With Features::direct_io the LED edges write the duty
+// straight into the channel registers instead - the same register
+// sequence the driver uses, inlined into the caller (including the timer
+// ISR). Channels still have to be set up with ledcSetup()/ledcAttachPin().
+//
+// Arduino channel n is LEDC speed mode n / 8, channel n % 8, like ledcWrite.
+// ========================================================================
+
+const int PWM_FREQUENCY  = 15000;
+const int PWM_RESOLUTION = 10;
+
+static inline void IRAM_ATTR led_channel_write(uint8_t channel, uint32_t duty) {
+  if (Features::direct_io) {
+    ledc_mode_t    mode = (ledc_mode_t)(channel / 8);
+    ledc_channel_t ch   = (ledc_channel_t)(channel % 8);
+    // Same as ledcWrite: full scale means always on, not one tick short
+    if (duty == (1u << PWM_RESOLUTION) - 1) duty = 1u << PWM_RESOLUTION;
+
+    ledc_ll_set_hpoint(&LEDC, mode, ch, 0);
+    ledc_ll_set_duty_int_part(&LEDC, mode, ch, duty);
+    ledc_ll_set_duty_direction(&LEDC, mode, ch, LEDC_DUTY_DIR_INCREASE);
+    ledc_ll_set_duty_num(&LEDC, mode, ch, 1);
+    ledc_ll_set_duty_cycle(&LEDC, mode, ch, 1);
+    ledc_ll_set_duty_scale(&LEDC, mode, ch, 0);
+    ledc_ll_set_sig_out_en(&LEDC, mode, ch, true);
+    ledc_ll_set_duty_start(&LEDC, mode, ch, true);
+    if (mode == LEDC_LOW_SPEED_MODE) ledc_ll_ls_channel_update(&LEDC, mode, ch);
+  } else {
+    ledcWrite(channel, duty);
+  }
+}
+
+// Hardware fade (CMD_RAMP_CHANNEL): from `from` to `to` in steps of one
+// duty unit, `cycles` PWM periods per step. The channel counts the steps
+// itself and holds `to` afterwards - no ISR, no CPU. Programmed like
+// led_channel_write rather than through ledc_set_fade_with_time(): the
+// driver holds a fade lock until its fade-end ISR, so every ledcWrite()
+// on the channel would block behind the fade, and IDF 4.4 cannot stop
+// one. Here the next led_channel_write() simply replaces it.
+const uint32_t LED_FADE_MAX_STEPS  = 1023;  // duty_num field
+const uint32_t LED_FADE_MAX_CYCLES = 1023;  // duty_cycle field
+
+static inline void led_channel_fade(uint8_t channel, uint32_t from, uint32_t to,
+                                    uint32_t cycles) {
+  ledc_mode_t    mode  = (ledc_mode_t)(channel / 8);
+  ledc_channel_t ch    = (ledc_channel_t)(channel % 8);
+  uint32_t       steps = to > from ? to - from : from - to;
+  if (steps > LED_FADE_MAX_STEPS) steps = LED_FADE_MAX_STEPS;
+  if (cycles < 1) cycles = 1;
+  if (cycles > LED_FADE_MAX_CYCLES) cycles = LED_FADE_MAX_CYCLES;
+
+  ledc_ll_set_hpoint(&LEDC, mode, ch, 0);
+  ledc_ll_set_duty_int_part(&LEDC, mode, ch, from);
+  ledc_ll_set_duty_direction(&LEDC, mode, ch,
+                             to > from ? LEDC_DUTY_DIR_INCREASE : LEDC_DUTY_DIR_DECREASE);
+  ledc_ll_set_duty_num(&LEDC, mode, ch, steps ? steps : 1);
+  ledc_ll_set_duty_cycle(&LEDC, mode, ch, cycles);
+  ledc_ll_set_duty_scale(&LEDC, mode, ch, steps ? 1 : 0);
+  ledc_ll_set_sig_out_en(&LEDC, mode, ch, true);
+  ledc_ll_set_duty_start(&LEDC, mode, ch, true);
+  if (mode == LEDC_LOW_SPEED_MODE) ledc_ll_ls_channel_update(&LEDC, mode, ch);
+}
+
+// Camera trigger edge - one set/clear register write
+static inline void IRAM_ATTR trigger_write(int pin, bool level) {
+  if (Features::direct_io) {
+    gpio_ll_set_level(&GPIO, (gpio_num_t)pin, level);
+  } else {
+    digitalWrite(pin, level ? HIGH : LOW);
+  }
+}
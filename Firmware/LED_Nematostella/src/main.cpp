@@ -1,6 +1,26 @@
 #include <Arduino.h>
 #include "esp_task_wdt.h"
-#include <DHT.h>
+#include "esp_system.h"
+#include <Preferences.h>
+#include <sys/time.h>
+#include "board_config.h"
+#include "led_io.h"
+#include "net_transport.h"
+#include "pulse_engine.h"
+#include "sync_line.h"
+#include "response_builder.h"
+#include "command_parser.h"
+#include "device_config.h"
+#include "dht_rmt.h"
+#include "duty_lut.h"
+#include "event_log.h"
+#include "frame_codec.h"
+#include "power_mode.h"
+#include "response_encode.h"
+#include "resume_state.h"
+#include "sensor_filter.h"
+#include "settle_detect.h"
+#include "timing_stats.h"
 
 #ifdef USE_DISPLAY
   #include "display_ui.h"
@@ -9,9 +29,45 @@
 // ========================================================================
 // NEMATOSTELLA ESP32 FIRMWARE - PYTHON-COMPATIBLE VERSION
 // ========================================================================
-// Version: 2.4 - Sensor improvements
-// Date: 2026-02-19
-// NEW IN v2.4:
+// Version: 2.5 - Latency improvements
+// Date: 2026-10-14
+// NEW IN v2.5:
+// - DHT22 sampled by a background FreeRTOS task on core 0
+// - Sync captures copy the latest sensor snapshot instead of reading the DHT22
+// - Sync pulses timed by a hardware timer - loop() stays responsive during exposure
+// - Multi-byte responses sent with one write + one flush (wire format unchanged)
+// - Non-blocking, table-driven command parser (no more payload wait loops)
+// - CMD_SET_BAUD / CMD_BAUD_CONFIRM: negotiated high baud rate (up to 2 Mbaud)
+// - CMD_SYNC_CAPTURE_QUEUED: pipelined captures with sequence-tagged completions
+// - CMD_START_SCHEDULE / CMD_STOP_SCHEDULE: on-device interval timelapse
+// - Camera trigger output timed with the LED pulse (CMD_SET_TRIGGER)
+// - Real-time task (pulses, queue, schedule) and comms task on separate cores
+// - us-resolution latency statistics (CMD_GET_TIMING_STATS)
+// - CMD_TIME_SYNC clock ping-pong + extended sync response with 64-bit edge times
+// - Opt-in protocol v3: CRC-16 framed commands/responses (CMD_GET_CAPABILITIES)
+// - Event-driven serial reception: commsTask sleeps until UART/USB-CDC RX events
+// - CMD_SET_POWER_MODE: esp_pm DFS / automatic light sleep between frames
+// - CMD_SET_DUTY_CURVE: per-LED calibration curves -> precomputed duty LUTs (NVS)
+// - Settings persisted in NVS (CMD_GET_CONFIG), non-blocking DHT/USB startup
+// - Table-driven LED channels: up to 8 LEDC outputs (CMD_SET_CHANNEL_MASK/POWER)
+// - Uploadable multi-step illumination sequences (CMD_SET_SEQUENCE_STEP/RUN_SEQUENCE)
+// - DHT22 reply captured by the RMT peripheral instead of bit-banging
+// - CMD_STATUS serves the cached sensor snapshot, no more LED blanking for
+//   reads; staleness limit and sample age via CMD_SET_SENSOR_POLICY
+// - Hardware-independent protocol core in lib/protocol_core ([env:native] tests)
+// - Compile-time board/feature config (board_config.h), LED and trigger edges
+//   written straight to the LEDC/GPIO registers
+// - CMD_STREAM_TELEMETRY: periodic packed status records instead of polling
+// - Binary event log in RTC memory, kept across resets (CMD_GET_EVENT_LOG)
+// - Optional Wi-Fi UDP link with the same framed command set, multicast
+//   group commands for multi-rig triggering (NETWORK_TRANSPORT=1)
+// - Shared sync line: master/slave boards start their pulses on one GPIO
+//   edge, phase-aligned within a few us (CMD_SET_SYNC_ROLE)
+// - Hardware LED ramps for dawn/dusk transitions, LUT-exact (CMD_RAMP_CHANNEL)
+// - Photodiode-calibrated settle table, adaptive stabilization (CMD_CALIBRATE_SETTLE)
+// - Task watchdog on all tasks, warm resets resume LED/schedule state from
+//   RTC memory; reset reason over the protocol (CMD_GET_RESET_INFO)
+// PREVIOUS (v2.4):
 // - CMD_STATUS now reads fresh sensor values directly (not cached averages)
 // - Filtered values used only as fallback when sensor read fails
 // PREVIOUS (v2.3):
@@ -28,50 +84,88 @@
 // - Clarified timing: LED stays on for (stabilization_ms + exposure_ms) total
 // ========================================================================
 
-const bool DEBUG_ENABLED = false;  // Disable debug output for production (interferes with binary protocol)
+const uint8_t FIRMWARE_VERSION_MAJOR = 2;
+const uint8_t FIRMWARE_VERSION_MINOR = 5;
 
 // ========================================================================
-// AUTOMATIC BOARD DETECTION AND PIN CONFIGURATION
+// BOARD AND FEATURE CONFIGURATION
 // ========================================================================
-// The firmware automatically detects the board type at compile-time and
-// configures the correct GPIO pins accordingly.
+// Resolved at compile time from the build target and flags (board_config.h):
+// one firmware source for the ESP32 DevKit and the ESP32-S3-BOX-3, with the
+// pins folded in as constants. Debug output is off unless built with
+// -D FIRMWARE_DEBUG=1 (it interferes with the binary protocol).
 // ========================================================================
 
-#if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(ESP32S3)
-    // ESP32-S3-BOX-3 Configuration
-    #define BOARD_TYPE "ESP32-S3-BOX-3"
-    const int ledIrPin     = 10;  // GPIO 10 (Pmod header)
-    const int ledWhitePin  = 11;  // GPIO 11 (Pmod header)
-    const int dhtPin       = 12;  // GPIO 12 (Pmod header)
-#elif defined(CONFIG_IDF_TARGET_ESP32) || defined(ESP32)
-    // ESP32 DevKit Configuration
-    #define BOARD_TYPE "ESP32-DevKit"
-    const int ledIrPin     = 4;   // GPIO 4
-    const int ledWhitePin  = 15;  // GPIO 15
-    const int dhtPin       = 14;  // GPIO 14
+constexpr int ledIrPin    = Board::led_ir_pin;
+constexpr int ledWhitePin = Board::led_white_pin;
+constexpr int dhtPin      = Board::dht_pin;
+
+// SERIAL LINK
+// Hosts always connect at SERIAL_BAUD_RATE; CMD_SET_BAUD can raise the rate
+// afterwards. On USB-CDC boards (ESP32-S3) the baud rate has no effect on the
+// link speed, the larger TX/RX buffers are what matters there.
+#if defined(ARDUINO_USB_CDC_ON_BOOT) && ARDUINO_USB_CDC_ON_BOOT
+  #define SERIAL_IS_USB_CDC 1
 #else
-    #error "Unsupported board! Only ESP32 and ESP32-S3 are supported."
+  #define SERIAL_IS_USB_CDC 0
 #endif
-
-#define DHTTYPE DHT22
-
-// PWM CONFIG
-const int PWM_CHANNEL_IR     = 0;
-const int PWM_CHANNEL_WHITE  = 1;
-const int PWM_FREQUENCY      = 15000;
-const int PWM_RESOLUTION     = 10;
+#ifndef SERIAL_BAUD_RATE
+  #define SERIAL_BAUD_RATE 115200
+#endif
+#ifndef SERIAL_MAX_BAUD_RATE
+  #define SERIAL_MAX_BAUD_RATE 921600
+#endif
+#ifndef SERIAL_RX_BUFFER_SIZE
+  #define SERIAL_RX_BUFFER_SIZE 1024
+#endif
+#ifndef SERIAL_TX_BUFFER_SIZE
+  #define SERIAL_TX_BUFFER_SIZE 1024
+#endif
+const uint32_t USB_CDC_WAIT_MS = 300;  // Max. boot wait for the host to open the CDC port
+// RX wake-up: the UART driver raises its RX event after this many idle
+// symbols (or a full FIFO), so a command wakes commsTask ~1 byte time after
+// its last byte instead of on the next scheduler tick
+const uint8_t       UART_RX_TIMEOUT_SYMBOLS = 2;
+const uint32_t      SUPPORTED_BAUD_RATES[]  = {115200, 230400, 460800, 921600, 1500000, 2000000};
+const unsigned long BAUD_CONFIRM_TIMEOUT_MS = 1000;  // Revert if host does not confirm
 
 // COMMANDS
 const byte CMD_LED_ON           = 0x01;
 const byte CMD_LED_OFF          = 0x00;
 const byte CMD_STATUS           = 0x02;
 const byte CMD_SYNC_CAPTURE     = 0x0C;
+const byte CMD_SYNC_CAPTURE_QUEUED = 0x0D;
+const byte CMD_QUEUE_CLEAR      = 0x0E;
 const byte CMD_SET_LED_POWER    = 0x10;
 const byte CMD_SET_TIMING       = 0x11;
 const byte CMD_SET_CAMERA_TYPE  = 0x13;
+const byte CMD_SET_BAUD         = 0x14;
+const byte CMD_BAUD_CONFIRM     = 0x15;
+const byte CMD_SET_TRIGGER      = 0x16;
+const byte CMD_SET_POWER_MODE   = 0x17;
+const byte CMD_GET_CONFIG       = 0x18;
+const byte CMD_SET_SYNC_FORMAT  = 0x19;
+const byte CMD_SET_SENSOR_POLICY = 0x1A;
 const byte CMD_SET_IR_POWER     = 0x24;
 const byte CMD_SET_WHITE_POWER  = 0x25;
+const byte CMD_SET_DUTY_CURVE   = 0x26;
+const byte CMD_SET_CHANNEL_MASK = 0x27;
+const byte CMD_SET_CHANNEL_POWER = 0x28;
+const byte CMD_RAMP_CHANNEL     = 0x29;
+const byte CMD_CALIBRATE_SETTLE = 0x2A;
+const byte CMD_GET_CHANNELS     = 0x2B;
 const byte CMD_SYNC_CAPTURE_DUAL= 0x2C;
+const byte CMD_SET_SYNC_ROLE    = 0x2D;
+const byte CMD_GET_TIMING_STATS = 0x50;
+const byte CMD_TIME_SYNC        = 0x52;
+const byte CMD_STREAM_TELEMETRY = 0x53;
+const byte CMD_GET_EVENT_LOG    = 0x54;
+const byte CMD_GET_RESET_INFO   = 0x55;
+const byte CMD_GET_CAPABILITIES = 0x60;
+const byte CMD_START_SCHEDULE   = 0x40;
+const byte CMD_STOP_SCHEDULE    = 0x41;
+const byte CMD_SET_SEQUENCE_STEP = 0x42;
+const byte CMD_RUN_SEQUENCE     = 0x43;
 const byte CMD_SELECT_LED_IR    = 0x20;
 const byte CMD_SELECT_LED_WHITE = 0x21;
 const byte CMD_LED_DUAL_OFF     = 0x22;
@@ -79,7 +173,12 @@ const byte CMD_GET_LED_STATUS   = 0x23;
 
 // RESPONSES
 const byte RESPONSE_LED_ON_ACK      = 0xAA;  // ✅ Used for LED ON/OFF confirmation
+const byte RESPONSE_SYNC_COMPLETE_SETTLE = 0x1A;
 const byte RESPONSE_SYNC_COMPLETE   = 0x1B;
+const byte RESPONSE_QUEUED_COMPLETE = 0x1C;
+const byte RESPONSE_SCHEDULE_FRAME  = 0x1D;
+const byte RESPONSE_SYNC_COMPLETE_EXT = 0x1E;
+const byte RESPONSE_SEQUENCE_COMPLETE = 0x1F;
 const byte RESPONSE_TIMING_SET      = 0x21;
 const byte RESPONSE_ACK_ON          = 0x01;
 const byte RESPONSE_ACK_OFF         = 0x02;
@@ -89,6 +188,23 @@ const byte RESPONSE_ERROR           = 0xFF;
 const byte RESPONSE_LED_IR_SELECTED    = 0x30;
 const byte RESPONSE_LED_WHITE_SELECTED = 0x31;
 const byte RESPONSE_LED_STATUS         = 0x32;
+const byte RESPONSE_BAUD_SET           = 0x33;
+const byte RESPONSE_QUEUE_ACK          = 0x34;
+const byte RESPONSE_QUEUE_FULL         = 0x35;
+const byte RESPONSE_SCHEDULE_ACK       = 0x36;
+const byte RESPONSE_SCHEDULE_DONE      = 0x37;
+const byte RESPONSE_TIMING_STATS       = 0x38;
+const byte RESPONSE_TIME_SYNC          = 0x39;
+const byte RESPONSE_CAPABILITIES       = 0x3A;
+const byte RESPONSE_FRAME_ERROR        = 0x3B;
+const byte RESPONSE_POWER_MODE         = 0x3C;
+const byte RESPONSE_CONFIG             = 0x3D;
+const byte RESPONSE_CHANNELS           = 0x3E;
+const byte RESPONSE_TELEMETRY          = 0x3F;
+const byte RESPONSE_EVENT_LOG          = 0x40;
+const byte RESPONSE_SYNC_LINE          = 0x41;
+const byte RESPONSE_SETTLE             = 0x42;
+const byte RESPONSE_RESET_INFO         = 0x43;
 
 // CAMERA TYPES
 const byte CAMERA_TYPE_HIK_GIGE    = 1;
@@ -105,91 +221,736 @@ static uint16_t LED_STABILIZATION_MS = 400;
 static uint16_t EXPOSURE_MS          = 20;
 static uint8_t  CAMERA_TYPE          = CAMERA_TYPE_HIK_GIGE;
 
-static uint8_t  LED_POWER_PERCENT_IR    = 100;
-static uint8_t  LED_POWER_PERCENT_WHITE = 100;
-static uint8_t  LED_POWER_PERCENT       = 100;
+// SYNC RESPONSE FORMAT (CMD_SET_SYNC_FORMAT)
+const uint8_t SYNC_FORMAT_LEGACY   = 0;  // 15-byte RESPONSE_SYNC_COMPLETE
+const uint8_t SYNC_FORMAT_EXTENDED = 1;  // 31-byte RESPONSE_SYNC_COMPLETE_EXT
+const uint8_t SYNC_FORMAT_SETTLE   = 2;  // 37-byte RESPONSE_SYNC_COMPLETE_SETTLE
+static uint8_t syncResponseFormat  = SYNC_FORMAT_LEGACY;
+
+// SENSOR POLICY (CMD_SET_SENSOR_POLICY)
+const uint8_t  SENSOR_POLICY_STATUS_AGE = 0x01;    // Append sample age to CMD_STATUS
+const uint32_t SENSOR_MAX_AGE_DEFAULT_MS = 4000;
+static uint32_t sensorMaxAgeMs  = SENSOR_MAX_AGE_DEFAULT_MS;
+static bool     statusReportsAge = false;
+
+// LED CHANNELS
+// One table entry per LED output, driven by the LEDC channel of the same
+// index. Channel 0 is the IR LED and channel 1 the white LED, so LED_TYPE_IR
+// and LED_TYPE_WHITE index the table. More channels (wavelengths, well-plate
+// zones) come from the LED_EXTRA_PINS build flag, e.g. -D LED_EXTRA_PINS=16,17.
+const uint8_t LED_MAX_CHANNELS = 8;  // LEDC channels on the ESP32-S3
+#ifdef LED_EXTRA_PINS
+  const int ledChannelPins[] = { ledIrPin, ledWhitePin, LED_EXTRA_PINS };
+#else
+  const int ledChannelPins[] = { ledIrPin, ledWhitePin };
+#endif
+const uint8_t LED_CHANNEL_COUNT = sizeof(ledChannelPins) / sizeof(ledChannelPins[0]);
+static_assert(LED_CHANNEL_COUNT <= LED_MAX_CHANNELS && LED_CHANNEL_COUNT <= PULSE_MAX_CHANNELS &&
+              LED_CHANNEL_COUNT <= RESUME_MAX_CHANNELS &&
+              LED_CHANNEL_COUNT <= Board::ledc_channels, "Too many LED channels");
+
+const uint8_t CHANNEL_MASK_FLAG_CAPTURE = 0x01;  // Mask selects the sync capture LEDs
+const uint8_t LED_TYPE_CHANNELS         = 0x80;  // Reported LED type for a custom capture mask
+
+// DUTY LUTS (CMD_SET_DUTY_CURVE, see duty_lut.h)
+// Each channel caches the LUT entry for its power, so switching an LED is
+// a single register write (led_channel_write).
+const uint16_t PWM_MAX_DUTY             = (1 << PWM_RESOLUTION) - 1;
+const uint8_t  DUTY_CURVE_FLAG_PERSIST  = 0x01;  // Store the curve in NVS
+const uint8_t  DUTY_CURVE_FLAG_RESET    = 0x02;  // Back to the linear curve (points ignored)
+const char    *DUTY_CURVE_NVS_NAMESPACE = "ledcal";
+const char    *DUTY_CURVE_NVS_KEYS[LED_MAX_CHANNELS] = {
+  "ir", "white", "ch2", "ch3", "ch4", "ch5", "ch6", "ch7"
+};
+
+struct LedChannel {
+  uint8_t  ledc_channel;
+  uint8_t  power;  // 0-100 %
+  bool     on;
+  uint16_t duty;   // lut entry for power
+  DutyLut  lut;
+};
+static LedChannel ledChannels[LED_CHANNEL_COUNT];
+static uint8_t    captureMask = 0;  // CMD_SET_CHANNEL_MASK capture set, 0 = selected LED
+
+// LED RAMPS (CMD_RAMP_CHANNEL)
+// Dawn/dusk transitions run on the LEDC fade hardware (led_channel_fade),
+// one linear fade per RAMP_SEGMENT_MS segment. The segment ends follow the
+// channel's duty LUT at fractional power, so a calibrated curve holds
+// through the ramp; the CPU only wakes once per segment (an esp_timer
+// marks a segment due, commsTask programs the next one), the host not at
+// all. The channel's power is the target from the start (GET_CHANNELS,
+// stored config); a ramp to 0 fades out and switches off but keeps the
+// power. Any other write to the channel (LED on/off, power, duty curve,
+// a pulse) ends the ramp at the channel's steady output. rampMux guards
+// the active flag against rtTask taking a channel over for a pulse while
+// commsTask programs a segment.
+const uint32_t RAMP_SEGMENT_MS = 1000;
+
+struct LedRamp {
+  bool     active;
+  uint16_t from;            // Power in 1/100 %
+  uint16_t to;
+  int64_t  start_us;
+  int64_t  duration_us;
+  int64_t  segment_end_us;  // The running hardware fade ends here
+  uint16_t duty;            // ... at this duty
+};
+static LedRamp            ledRamps[LED_CHANNEL_COUNT];
+static portMUX_TYPE       rampMux   = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t rampTimer = NULL;
+static volatile bool      rampDue   = false;
+
+// LED SETTLE (CMD_CALIBRATE_SETTLE, see settle_detect.h)
+// The photodiode records a channel's switch-on at SETTLE_LEVELS powers
+// (10, 20, ... 100 %), the rise-to-stable time of each goes into settleUs
+// and NVS. With adaptive stabilization on, sync captures (direct, queued
+// and sync line) expose once their LEDs have settled: the slowest lit
+// channel's settle at the levels around its power, plus
+// SETTLE_MARGIN_PERCENT, at most LED_STABILIZATION_MS. A lit channel
+// without a usable entry keeps the capture at LED_STABILIZATION_MS.
+// Schedules and sequences keep their own timing. rtTask owns the table;
+// a calibration blocks it for SETTLE_LEVELS x (dark + window), ~7 s.
+const uint8_t      SETTLE_LEVELS          = 10;
+const uint8_t      SETTLE_MARGIN_PERCENT  = 25;
+const uint16_t     SETTLE_DARK_MS         = 100;  // LED off before each level
+const uint8_t      SETTLE_DARK_SAMPLES    = 16;
+const uint16_t     SETTLE_WINDOW_MS       = 600;  // Recorded after each switch-on
+const uint16_t     SETTLE_BURST_SAMPLES   = 128;  // Back-to-back reads, then one per tick
+const uint16_t     SETTLE_MAX_SAMPLES     = 768;
+const SettleParams SETTLE_PARAMS          = { 20, 8, 40 };  // 2 % band, 12-bit ADC counts
+const uint8_t      SETTLE_OP_QUERY        = 0;
+const uint8_t      SETTLE_OP_CALIBRATE    = 1;
+const uint8_t      SETTLE_OP_ADAPTIVE_ON  = 2;
+const uint8_t      SETTLE_OP_ADAPTIVE_OFF = 3;
+const uint8_t      SETTLE_OP_CLEAR        = 4;
+const uint8_t      SETTLE_FLAG_ADAPTIVE   = 0x01;
+const uint8_t      SETTLE_STATUS_OK            = 0;
+const uint8_t      SETTLE_STATUS_INVALID       = 1;
+const uint8_t      SETTLE_STATUS_NOT_SUPPORTED = 2;  // Built without PHOTODIODE
+const uint8_t      SETTLE_STATUS_BUSY          = 3;  // Pulse, queue, schedule or sync role active
+const uint8_t      SETTLE_STATUS_NO_SIGNAL     = 4;  // Photodiode saw no level, table kept
+const char        *SETTLE_NVS_NAMESPACE    = "settle";  // Keys as DUTY_CURVE_NVS_KEYS
+const char        *SETTLE_NVS_KEY_ADAPTIVE = "adaptive";
+static uint32_t     settleUs[LED_CHANNEL_COUNT][SETTLE_LEVELS];  // 0 = not calibrated
+static bool         settleAdaptive = false;
+static SettleSample settleSamples[SETTLE_MAX_SAMPLES];
+
+// PERSISTENT CONFIG (CMD_GET_CONFIG, see device_config.h)
+// SET commands mark the config dirty. commsTask writes it to NVS once it
+// has been stable for CONFIG_SAVE_DELAY_MS and no pulse is running or
+// imminent - the flash write stalls both cores for a few ms.
+const uint32_t CONFIG_SAVE_DELAY_MS     = 2000;
+const char    *CONFIG_NVS_NAMESPACE     = "config";
+const char    *CONFIG_NVS_KEY           = "blob";
+const uint8_t  CONFIG_FLAG_RESTORED     = 0x01;  // Loaded from NVS at boot
+const uint8_t  CONFIG_FLAG_SAVE_PENDING = 0x02;  // Changed, not written yet
+static bool                   configRestored   = false;
+static volatile bool          configDirty      = false;
+static volatile unsigned long configChangedMs  = 0;
+static bool                   configStored     = false;  // NVS holds configSavedHash
+static uint16_t               configSavedHash  = 0;
+
+// CAMERA TRIGGER
+// TTL pulse on Board::trigger_pin, LED_STABILIZATION_MS after LED-on. Off by default;
+// cameras in hardware-trigger mode (e.g. CAMERA_TYPE_HIK_GIGE line 0) then
+// start exposing when the light is stable, independent of host latency.
+const uint16_t TRIGGER_MIN_WIDTH_US = 10;
+static bool     triggerEnabled  = false;
+static uint16_t triggerWidthUs  = 1000;
 
-static bool     ledIrState       = false;
-static bool     ledWhiteState    = false;
 static uint8_t  currentLedType   = LED_TYPE_IR;
 
-DHT dht(dhtPin, DHTTYPE);
+
+// PROTOCOL (CMD_GET_CAPABILITIES)
+// Legacy hosts send bare command bytes and never see a frame. A host that
+// asks for PROTOCOL_FRAMED gets the reply in the current protocol, then
+// every command and response is a frame_codec.h frame until it asks for
+// PROTOCOL_LEGACY again or the ESP32 reboots. Replies echo the command's
+// seq; unsolicited events (queued completions, schedule frames) use
+// FRAME_SEQ_EVENT and are told apart by their response code.
+const uint8_t  PROTOCOL_QUERY   = 0;  // Report only, keep the active protocol
+const uint8_t  PROTOCOL_LEGACY  = 2;
+const uint8_t  PROTOCOL_FRAMED  = 3;
+const uint8_t  FRAME_SEQ_EVENT  = 0;
+const uint16_t FRAME_TIMEOUT_MS = 50;  // Max gap between bytes of one frame
+const uint8_t  FRAME_ERROR_REASON_CRC     = 1;
+const uint8_t  FRAME_ERROR_REASON_LENGTH  = 2;
+const uint8_t  FRAME_ERROR_REASON_TIMEOUT = 3;
+
+// Capability bits reported in RESPONSE_CAPABILITIES
+const uint32_t FEATURE_CAPTURE_QUEUE  = 1UL << 0;
+const uint32_t FEATURE_SCHEDULE       = 1UL << 1;
+const uint32_t FEATURE_CAMERA_TRIGGER = 1UL << 2;
+const uint32_t FEATURE_TIMING_STATS   = 1UL << 3;
+const uint32_t FEATURE_TIME_SYNC      = 1UL << 4;
+const uint32_t FEATURE_BAUD_SWITCH    = 1UL << 5;
+const uint32_t FEATURE_POWER_MODES    = 1UL << 6;  // esp_pm available in this build
+const uint32_t FEATURE_LED_CHANNELS   = 1UL << 7;
+const uint32_t FEATURE_SEQUENCES      = 1UL << 8;
+const uint32_t FEATURE_SENSOR_POLICY  = 1UL << 9;
+const uint32_t FEATURE_TELEMETRY      = 1UL << 10;
+const uint32_t FEATURE_EVENT_LOG      = 1UL << 11;
+const uint32_t FEATURE_NETWORK        = 1UL << 12;  // Built with the Wi-Fi UDP link
+const uint32_t FEATURE_SYNC_LINE      = 1UL << 13;  // Board has the shared sync line pin
+const uint32_t FEATURE_LED_RAMP       = 1UL << 14;
+const uint32_t FEATURE_LED_SETTLE     = 1UL << 15;  // Photodiode for CMD_CALIBRATE_SETTLE
+const uint32_t FEATURE_RECOVERY       = 1UL << 16;
+#if CONFIG_PM_ENABLE
+  const uint32_t FEATURE_BUILD_OPTIONS = FEATURE_POWER_MODES;
+#else
+  const uint32_t FEATURE_BUILD_OPTIONS = 0;
+#endif
+const uint32_t FEATURE_BOARD_OPTIONS = (Features::camera_trigger ? FEATURE_CAMERA_TRIGGER : 0) |
+                                       (Features::network ? FEATURE_NETWORK : 0) |
+                                       (Features::sync_line ? FEATURE_SYNC_LINE : 0) |
+                                       (Features::photodiode ? FEATURE_LED_SETTLE : 0);
+const uint32_t FIRMWARE_FEATURES = FEATURE_CAPTURE_QUEUE | FEATURE_SCHEDULE |
+                                   FEATURE_BOARD_OPTIONS | FEATURE_TIMING_STATS |
+                                   FEATURE_TIME_SYNC | FEATURE_BAUD_SWITCH |
+                                   FEATURE_LED_CHANNELS | FEATURE_SEQUENCES |
+                                   FEATURE_SENSOR_POLICY | FEATURE_TELEMETRY |
+                                   FEATURE_EVENT_LOG | FEATURE_LED_RAMP |
+                                   FEATURE_RECOVERY | FEATURE_BUILD_OPTIONS;
+
+static bool         protocolFramed  = false;             // commsTask only
+static FrameDecoder frameDecoder;
+static uint8_t      commandFrameSeq = FRAME_SEQ_EVENT;   // Frame being dispatched (commsTask)
+static uint8_t      rtFrameSeq      = FRAME_SEQ_EVENT;   // Request being served (rtTask)
+
+// NETWORK LINK (Features::network, see net_transport.h)
+// The UDP link always speaks the framed protocol. Replies and events go to
+// the link the last command came from - one host drives a rig at a time.
+// Group (multicast) commands run like any other but leave the reply link
+// alone, so each rig answers its own host on its own link, serial or UDP.
+enum HostLink : uint8_t {
+  LINK_SERIAL,
+  LINK_UDP,
+  LINK_UDP_GROUP  // Command source only, never a reply link
+};
+static HostLink     hostLink    = LINK_SERIAL;  // Where replies go (commsTask)
+static HostLink     commandLink = LINK_SERIAL;  // Where the command being dispatched came from
+static NetPeer      udpPeer     = {};           // Host of the last unicast datagram
+static FrameDecoder udpDecoder;
+
+// POWER MODE (CMD_SET_POWER_MODE, see power_mode.h)
+// Light sleep loses the bytes that wake the UART, so it needs the framed
+// protocol (junk outside frames is ignored) and a UART console. After RX
+// activity the ESP32 stays awake for COMMS_AWAKE_MS.
+const uint8_t  POWER_STATUS_OK            = 0;
+const uint8_t  POWER_STATUS_INVALID       = 1;
+const uint8_t  POWER_STATUS_NOT_SUPPORTED = 2;  // Build without esp_pm, or USB-CDC console
+const uint8_t  POWER_STATUS_NEEDS_FRAMING = 3;
+const uint32_t COMMS_AWAKE_MS             = 2000;
+static unsigned long lastRxMs = 0;
+
+static uint32_t      serialBaud         = SERIAL_BAUD_RATE;
+static uint32_t      previousBaud       = SERIAL_BAUD_RATE;
+static bool          baudConfirmPending = false;
+static unsigned long baudSwitchTime     = 0;
+
+// SYNC CAPTURE STATE (pulse in flight)
+static bool     syncDual    = false;
+static uint8_t  syncLedType = LED_TYPE_IR;  // Reported LED type (LED_TYPE_CHANNELS for a custom mask)
+static uint8_t  syncMask    = 0;            // Channels lit by the pending capture
+static volatile bool syncPending = false;  // Started, completion not yet processed
+static bool     syncQueued  = false;  // Started from the capture queue
+static uint16_t syncSeq     = 0;
+static uint8_t  syncFlags   = 0;
+static int64_t  syncReceivedUs = 0;  // Command received (0 = started from the queue)
+static uint8_t  syncFrameSeq = FRAME_SEQ_EVENT;  // seq for the completion frame
+static uint32_t syncRequestedUs = 0;  // Requested LED-on time
+static uint16_t syncStabilizationMs = 0;  // LED-on -> exposure start
+static uint32_t syncSettleUs = 0;  // Calibrated settle behind it, 0 = fixed stabilization
+
+// SYNC LINE (CMD_SET_SYNC_ROLE, see sync_line.h)
+// On the master, sync captures (direct and queued) drive the line instead
+// of starting locally. A slave keeps a pulse armed with its own LED and
+// timing settings whenever it is idle and reports every edge-started pulse
+// as an unsolicited sync response; rtTask re-arms it after settings change.
+// The role is not persisted - a rebooted board is a plain board again.
+const uint8_t SYNC_ROLE_QUERY                = 0xFF;
+const uint8_t SYNC_ROLE_FLAG_DUAL            = 0x01;  // Slave: IR + white on every edge
+const uint8_t SYNC_LINE_STATUS_OK            = 0;
+const uint8_t SYNC_LINE_STATUS_INVALID       = 1;
+const uint8_t SYNC_LINE_STATUS_NOT_SUPPORTED = 2;     // Built with SYNC_LINE=0
+const uint8_t SYNC_LINE_STATUS_BUSY          = 3;     // Pulse, queue or schedule active
+static bool         lineDual         = false;
+static PulseRequest linePulse;                  // Armed slave pulse
+static uint32_t     lineSettleUs     = 0;       // ... and its syncSettleUs
+static uint8_t      lineLedType      = LED_TYPE_IR;
+static uint32_t     lineMissedLogged = 0;
+
+// CAPTURE QUEUE
+const uint8_t  CAPTURE_QUEUE_SIZE      = 16;
+const uint8_t  QUEUE_FLAG_DUAL         = 0x01;  // Both LEDs instead of the selected one
+const uint8_t  QUEUE_FLAG_TIMED        = 0x02;  // Wait for start_us before starting
+const uint8_t  QUEUE_STATUS_LATE       = 0x01;  // Started after start_us + tolerance
+const uint8_t  QUEUE_STATUS_SKIPPED    = 0x02;  // Not started (schedule, no sync edge), times 0
+const uint8_t  QUEUE_LED_TYPE_DUAL     = 2;
+const uint32_t QUEUE_LATE_TOLERANCE_US = 1000;
+
+struct QueuedCapture {
+  uint16_t seq;
+  uint8_t  flags;
+  uint32_t start_us;  // esp_timer time (low 32 bits) when QUEUE_FLAG_TIMED is set
+};
+static QueuedCapture    captureQueue[CAPTURE_QUEUE_SIZE];
+static uint8_t          captureQueueHead  = 0;
+static volatile uint8_t captureQueueCount = 0;
+
+// ACQUISITION SCHEDULE
+const int64_t  SCHEDULE_MIN_GAP_US        = 5000;    // LED-off time required between frames
+const int64_t  SCHEDULE_MAX_INTERVAL_MS   = 86400000UL;  // 24 h
+const int64_t  SCHEDULE_START_DELAY_US    = 10000;   // Frame 0 after the ACK is on the wire
+const int64_t  SCHEDULE_SENSOR_GUARD_US   = 300000;  // No DHT reads this close to a frame
+const int64_t  SCHEDULE_LATE_TOLERANCE_US = 1000;
+const uint8_t  SCHEDULE_STATUS_LATE       = 0x01;    // LED-on edge more than 1 ms late
+const uint8_t  SCHEDULE_STATUS_LAST       = 0x02;    // Final frame of a counted schedule
+const uint8_t  SCHEDULE_STATUS_SKIPPED    = 0x04;    // Previous frame still lit, times 0
+
+struct AcquisitionSchedule {
+  int64_t      start_us;      // esp_timer time of frame 0
+  int64_t      interval_us;
+  uint32_t     frame_count;   // 0 = run until CMD_STOP_SCHEDULE
+  uint8_t      led_type;      // LED_TYPE_IR, LED_TYPE_WHITE or QUEUE_LED_TYPE_DUAL
+  uint8_t      power;
+  uint16_t     stabilization_ms;
+  uint16_t     exposure_ms;
+  PulseRequest pulse;         // Built once, started from the timer callback
+};
+static AcquisitionSchedule schedule;
+static esp_timer_handle_t  scheduleTimer      = NULL;
+static portMUX_TYPE        scheduleMux        = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool       scheduleActive     = false;  // Timer callback may start frames
+static volatile uint32_t   scheduleNextFrame  = 0;      // Advanced by the timer callback
+static volatile bool       scheduleRunning    = false;  // Accepted, DONE not yet sent
+static uint32_t            scheduleFramesDone = 0;      // Frame events sent
+static volatile uint32_t   scheduleSkipFirst  = 0;      // Frames the timer could not start,
+static volatile uint32_t   scheduleSkipCount  = 0;      // ... reported by rtTask (scheduleMux)
+
+// ILLUMINATION SEQUENCE
+// Steps are uploaded one by one with CMD_SET_SEQUENCE_STEP and run back to
+// back as one pulse engine sequence by CMD_RUN_SEQUENCE. rtTask owns all of it.
+const uint8_t  SEQUENCE_POWER_OWN         = 0xFF;  // Each channel at its own power
+const uint8_t  SEQUENCE_STEP_FLAG_TRIGGER = 0x01;  // Camera trigger pulse in this step
+const uint32_t SEQUENCE_MAX_STEP_US       = 30000000UL;  // 30 s, as EXPOSURE_MS
+
+struct SequenceStep {
+  uint8_t  mask;   // LED channels, 0 = dark step
+  uint8_t  power;  // 0-100 or SEQUENCE_POWER_OWN
+  uint8_t  flags;  // SEQUENCE_STEP_FLAG_*
+  uint32_t duration_us;
+};
+static SequenceStep sequenceSteps[PULSE_MAX_STEPS];
+static PulseRequest sequencePulses[PULSE_MAX_STEPS];
+static PulseResult  sequenceResults[PULSE_MAX_STEPS];  // Filled by the pulse ISR
+static uint8_t      sequenceLength     = 0;
+static bool         sequencePending    = false;  // Started, completion not yet processed
+static uint16_t     sequenceSeq        = 0;
+static uint8_t      sequenceMask       = 0;  // Channels lit by any step
+static int64_t      sequenceReceivedUs = 0;
+static uint8_t      sequenceFrameSeq   = FRAME_SEQ_EVENT;
+
+// TELEMETRY STREAM (CMD_STREAM_TELEMETRY)
+// A periodic esp_timer marks a record due and wakes commsTask, which builds
+// it from the state STATUS / GET_LED_STATUS / GET_TIMING_STATS report and
+// sends it as an event frame - the host stops polling. Framed protocol
+// only: in the legacy byte stream records could not be told from replies.
+const uint16_t TELEMETRY_MIN_PERIOD_MS = 20;
+static esp_timer_handle_t telemetryTimer  = NULL;
+static volatile bool      telemetryDue    = false;
+static uint8_t            telemetryFields = 0;  // 0 = stream off (commsTask)
+static uint16_t           telemetryPeriodMs = 0;
+static uint16_t           telemetrySeq    = 0;
+
+// EVENT LOG (CMD_GET_EVENT_LOG)
+// Commands, pulse edges, sensor failures, buffer clears and errors as
+// 16-byte records (event_log.h) - the trace debug text cannot give with
+// the binary protocol on the port. The slots are RTC slow memory that no
+// reset but power-on clears, so the events leading up to a crash or
+// watchdog reset can still be read after it.
+const uint16_t EVENT_LOG_SLOTS          = 256;  // 20 bytes each, 5 of the 8 KB RTC slow memory
+const uint8_t  EVENT_LOG_MAX_RECORDS    = 48;   // Per request, 16 chunks
+const uint8_t  EVENT_LOG_FLAG_CLEAR     = 0x01;
+static RTC_NOINIT_ATTR EventSlot eventSlots[EVENT_LOG_SLOTS];
+static EventLog eventLog;
+
+// RESUME STATE (CMD_GET_RESET_INFO, see resume_state.h)
+// commsTask snapshots the host's setup every pass - at least every
+// COMMS_IDLE_WAKE_MS - except while a sync capture or sequence holds its
+// LEDs lit, which would come back as steady outputs. After a panic,
+// watchdog or software reset setup() takes the fast path: no USB wait,
+// banner or DHT warm-up, LEDs relit right after LEDC setup, and a running
+// schedule back on its frame grid - frames whose deadline passed during
+// the reset are skipped, the rest keep their index and timing. Power-on,
+// brownout and the EN pin boot cold. The slots take 2 x 200 bytes of
+// RTC slow memory next to the event log.
+const uint8_t RESET_INFO_FLAG_RESUMED  = 0x01;  // State brought back from RTC memory
+const uint8_t RESET_INFO_FLAG_SCHEDULE = 0x02;  // A running schedule went on at resumeFrame
+const uint8_t RESET_INFO_FLAG_REFUSED  = 0x04;  // Valid state refused: resumed boot crashed early
+static RTC_NOINIT_ATTR ResumeSlot resumeSlots[RESUME_SLOTS];
+static uint8_t            resumeNextSlot   = 0;
+static uint32_t           resumeGeneration = 0;
+static bool               bootResumed      = false;
+static esp_reset_reason_t resetReason      = ESP_RST_UNKNOWN;
+static uint8_t            resetInfoFlags   = 0;
+static uint32_t           warmResets       = 0;  // Since the last cold boot
+static uint32_t           previousUptimeMs = 0;  // Of the crashed boot, at its last snapshot
+static uint32_t           resumeFrame      = 0;  // First frame of the resumed schedule
+
+// ========================================================================
+// TASK LAYOUT
+// ========================================================================
+// rtTask (core 1, high priority) owns everything that decides pulse timing:
+// sync captures, the capture queue, schedule bookkeeping and completion
+// events. commsTask (core 0) owns the serial port: command parsing and all
+// writes. They only talk through two FreeRTOS queues, so a DHT read, a
+// slow handler or a display redraw never delays an LED edge or its start.
+//
+//   commsTask --RtRequest-------> rtRequestQueue --> rtTask
+//   rtTask / handlers --Response--> txQueue -------> commsTask --> Serial
+//
+// commsTask blocks on its task notification, given by the serial RX event
+// callback and by queueResponse(). It only wakes on a timer while a payload,
+// frame or baud confirmation can time out. loop() is left with the optional
+// display UI; without it the Arduino loop task deletes itself.
+//
+// The task watchdog supervises rtTask, commsTask and sensorTask: each one
+// subscribes when it starts and feeds it every pass, and no wait is
+// longer than WATCHDOG_FEED_MS. Only a task stuck inside a call - a hung
+// sensor read, a blocked serial write, a deadlock - misses
+// WATCHDOG_TIMEOUT_S; the panic that follows warm-resets into the resume
+// path (see RESUME STATE).
+// ========================================================================
+const BaseType_t  RT_TASK_CORE         = 1;   // Pulse timer ISR is attached here too
+const UBaseType_t RT_TASK_PRIORITY     = 20;
+const uint32_t    RT_TASK_STACK        = 4096;
+const BaseType_t  COMMS_TASK_CORE      = 0;
+const UBaseType_t COMMS_TASK_PRIORITY  = 5;   // Above the sensor task
+const uint32_t    COMMS_TASK_STACK     = 6144;
+const uint8_t     RT_REQUEST_QUEUE_LENGTH = 8;
+const uint8_t     TX_QUEUE_LENGTH      = 32;
+const int32_t     RT_SPIN_THRESHOLD_US = 2000;  // Busy-wait the last tick before a timed start
+const uint32_t    LOOP_INTERVAL_MS     = 10;
+const uint32_t    COMMS_TIMEOUT_POLL_MS = 10;   // Pending payload / frame / baud confirm
+const uint32_t    COMMS_IDLE_WAKE_MS   = 1000;  // Safety net if an RX event is missed
+const uint32_t    WATCHDOG_TIMEOUT_S   = 5;     // The IDF default, with panic (reset) on expiry
+const uint32_t    WATCHDOG_FEED_MS     = 1000;  // Longest wait of a supervised task
+
+enum RtRequestType : uint8_t {
+  RT_SYNC_CAPTURE,
+  RT_SYNC_CAPTURE_DUAL,
+  RT_QUEUE_PUSH,
+  RT_QUEUE_CLEAR,
+  RT_START_SCHEDULE,
+  RT_STOP_SCHEDULE,
+  RT_SEQUENCE_STEP,
+  RT_RUN_SEQUENCE,
+  RT_SETTLE,
+  RT_RESUME_SCHEDULE
+};
+
+struct RtRequest {
+  RtRequestType       type;
+  int64_t             received_us;  // Set by postRtRequest()
+  uint8_t             seq;          // Frame seq for the replies (postRtRequest)
+  QueuedCapture       capture;   // RT_QUEUE_PUSH
+  AcquisitionSchedule schedule;  // RT_START_SCHEDULE, RT_RESUME_SCHEDULE
+  uint32_t            first_frame;  // RT_RESUME_SCHEDULE
+  uint32_t            frames_done;
+  SequenceStep        step;      // RT_SEQUENCE_STEP
+  uint8_t             step_index;
+  uint16_t            run_seq;   // RT_RUN_SEQUENCE
+  uint8_t             settle_op;  // RT_SETTLE
+  uint8_t             settle_channel;
+};
+
+static QueueHandle_t rtRequestQueue  = NULL;
+static QueueHandle_t txQueue         = NULL;
+static TaskHandle_t  rtTaskHandle    = NULL;
+static TaskHandle_t  commsTaskHandle = NULL;
+
+// ========================================================================
+// TIMING STATISTICS
+// ========================================================================
+// us latencies from esp_timer_get_time(), dumped by CMD_GET_TIMING_STATS.
+// Writers run on both cores, so every access goes through timingMux.
+// ========================================================================
+enum TimingStatId : uint8_t {
+  TIMING_CMD_TO_LED_ON,     // Command parsed -> LED-on edge (host-triggered captures)
+  TIMING_LED_ON_DURATION,   // LED-on edge -> LED-off edge
+  TIMING_LED_ON_ERROR,      // |actual - requested| LED-on time
+  TIMING_SENSOR_READ,       // DHT22 read incl. retries
+  TIMING_RESPONSE_SEND,     // Serial write + flush of one response
+  TIMING_RT_ITERATION,      // rtTask work per wake-up
+  TIMING_COMMS_ITERATION,   // commsTask work per pass
+  TIMING_SCHEDULE_WAKE,     // Frame deadline -> schedule timer callback (incl. light-sleep wake-up)
+  TIMING_STAT_COUNT
+};
+const uint8_t TIMING_STATS_FLAG_RESET = 0x01;
+
+static TimingStat   timingStats[TIMING_STAT_COUNT];
+static portMUX_TYPE timingMux = portMUX_INITIALIZER_UNLOCKED;
+
+static CommandParser commandParser;
+extern const CommandSpec COMMAND_TABLE[];
+extern const uint8_t COMMAND_TABLE_SIZE;
 
 unsigned long lastSyncTime = 0;
 unsigned long bootTime     = 0;
 unsigned long lastBufferClear = 0;
 const unsigned long BUFFER_CLEAR_INTERVAL = 30000;
 
-struct SensorHistory {
-  float temp_values[5];
-  float hum_values[5];
-  int   index;
-  int   count;
-  bool  initialized;
+static SensorFilter sensor_history = {};  // last_valid_ms is millis()
+
+// ========================================================================
+// BACKGROUND SENSOR TASK
+// ========================================================================
+// The DHT22 is sampled by its own task on core 0 (loop() runs on core 1).
+// Every read publishes a SensorSnapshot into a double buffer, so the sync
+// capture and status paths only copy the latest reading instead of waiting
+// for the sensor (up to 3 reads with 100ms retry waits). Reads happen only
+// in LED-off gaps and never touch the LED outputs. The task samples every
+// half sensorMaxAgeMs (at most at the DHT22 rate); CMD_STATUS wakes it
+// early when the snapshot is older than sensorMaxAgeMs.
+// ========================================================================
+const uint32_t    SENSOR_SAMPLE_INTERVAL_MS = 2000;  // DHT22 max rate is 0.5 Hz
+const uint32_t    SENSOR_WARMUP_MS          = 2000;  // DHT22 settle time after power-up
+const uint32_t    SENSOR_RETRY_INTERVAL_MS  = 250;   // Re-check interval while LEDs are on
+const uint32_t    DHT_POLL_INTERVAL_MS      = 2;     // Sleep between dht_rmt_poll() calls
+const BaseType_t  SENSOR_TASK_CORE          = 0;     // Other core than ARDUINO_RUNNING_CORE
+const UBaseType_t SENSOR_TASK_PRIORITY      = 1;
+const uint32_t    SENSOR_TASK_STACK         = 4096;
+
+struct SensorSnapshot {
+  float    temperature;           // Latest valid reading (defaults until first read)
+  float    humidity;
+  float    filtered_temperature;  // Moving average from sensor_history
+  float    filtered_humidity;
+  uint32_t sample_ms;             // millis() of the latest valid reading
+  uint16_t fail_count;            // Consecutive failed reads since last valid one
+  bool     valid;                 // At least one valid reading exists
+};
+
+// Single writer (holder of dhtMutex) fills the inactive slot, then publishes
+// it by flipping the index and bumping the sequence counter. Readers retry
+// only if a publish happened while they were copying.
+static SensorSnapshot     sensor_snapshots[2] = {
+  {25.0, 50.0, 25.0, 50.0, 0, 0, false},
+  {25.0, 50.0, 25.0, 50.0, 0, 0, false}
 };
-static SensorHistory sensor_history = {0};
+static volatile uint8_t   sensor_snapshot_index = 0;
+static volatile uint32_t  sensor_snapshot_seq   = 0;
+static SemaphoreHandle_t  dhtMutex              = NULL;
+static TaskHandle_t       sensorTaskHandle      = NULL;
 
 // ========================================================================
 // FUNCTION PROTOTYPES
 // ========================================================================
 void clearSerialBuffer();
+void applySerialBaud(uint32_t baud);
+void serviceBaudConfirm();
 void sendRawByte(byte b);
+void queueResponse(const ResponseBuilder &response);
+void drainTxQueue();
+void wakeCommsTask();
+void updateLedHold();
+#if SERIAL_IS_USB_CDC
+void onSerialRxEvent(void *arg, esp_event_base_t base, int32_t id, void *data);
+#else
+void onSerialReceive();
+#endif
+void writeResponse(const ResponseBuilder &response);
+void feedSerialByte(uint8_t value);
+void pollFrameDecoder(FrameDecoder &decoder, HostLink link);
+void dispatchFrame(const FrameDecoder &decoder);
+void sendFrameError(const FrameDecoder &decoder, uint8_t reason);
+bool linkFramed();
+void serviceNetwork();
+void onSerialCommand(uint8_t cmd);
+void postRtRequest(RtRequest &request);
+void runRtRequest(const RtRequest &request);
+bool rtIdle();
+uint8_t rtChannelMask();
+void rtTask(void *param);
+void commsTask(void *param);
+void recordTiming(TimingStatId id, int64_t us);
+void logEvent(uint8_t type, uint8_t arg8, uint16_t arg16, uint32_t arg32);
+void logEventAt(int64_t time_us, uint8_t type, uint8_t arg8, uint16_t arg16, uint32_t arg32);
+void logCommand(uint8_t cmd);
+void resetTimingStats();
+void sendTimingStats();
+void sendResponseTimed(const ResponseBuilder &response);
 void sendStatus(byte code);
-void sendStatusWithSensorData(byte code);
-void sendSyncResponseWithDuration(float temp, float hum, uint16_t duration_ms);
-void setLedState(bool state, uint8_t ledType);
+void sendStatusWithSensorData(byte code, float temp, float hum, uint32_t age_ms);
+void sendSyncResponseWithDuration(float temp, float hum, uint16_t duration_ms, uint8_t ledType);
+void sendSyncResponseExtended(float temp, float hum, uint16_t duration_ms, uint8_t ledType,
+                              const PulseResult &pulse);
+void sendSyncResponseSettle(float temp, float hum, uint16_t duration_ms, uint8_t ledType,
+                            const PulseResult &pulse, uint16_t stabilization_ms, uint32_t settle_us);
+void initLedChannels();
+void setLedState(bool state, uint8_t channel);
 void setCurrentLedState(bool state);
-void updateLedOutput(uint8_t ledType);
-void updateCurrentLedOutput();
-void setLedPowerCurrent(uint8_t power);
-void setIrPower(uint8_t power);
-void setWhitePower(uint8_t power);
-void performSyncCapture();
-void performSyncCaptureDual();
+void updateLedOutput(uint8_t channel);
+bool anyLedOn();
+uint8_t ledOnMask();
+void applyChannelMask(uint8_t mask);
+uint16_t ledPwmValue(uint8_t channel);
+uint16_t powerToDuty(uint8_t channel, uint8_t power);
+void updateLedDuty(uint8_t channel);
+void setPulseChannels(PulseRequest &pulse, uint8_t mask, int power);
+uint8_t reportedPower(uint8_t ledType);
+void loadDutyCurves();
+void loadSettleTables();
+void saveSettleTable(uint8_t channel);
+uint16_t settledStabilizationMs(uint8_t mask, uint32_t &settle_us);
+uint8_t calibrateSettle(uint8_t channel);
+void runSettleRequest(uint8_t op, uint8_t channel);
+DeviceConfig currentConfig();
+void applyConfig(const DeviceConfig &config);
+void loadConfig();
+void markConfigDirty();
+void serviceConfigSave();
+void applyTrigger(PulseRequest &pulse, uint16_t stabilization_ms);
+void setChannelPower(uint8_t channel, uint8_t power);
+void startRamp(uint8_t channel, uint8_t power, uint32_t duration_ms);
+uint16_t rampPower(const LedRamp &ramp, int64_t now_us);
+void serviceRamps();
+void onRampTimer(void *arg);
+void performSyncCapture(int64_t received_us);
+void performSyncCaptureDual(int64_t received_us);
+bool startSyncPulse(bool dual, int64_t received_us);
+void finishSyncCapture(const PulseResult &pulse);
+uint8_t buildSyncPulse(bool dual, uint8_t source, PulseRequest &pulse, uint32_t &settle_us);
+bool samePulse(const PulseRequest &a, const PulseRequest &b);
+void serviceSyncLine();
+void finishLinePulse(const PulseResult &pulse);
+bool captureQueuePush(const QueuedCapture &capture);
+void captureQueueClear();
+int32_t serviceCaptureQueue();
+void enqueueCapture(const QueuedCapture &capture);
+void sendQueuedCaptureRecord(uint16_t seq, uint8_t status, const PulseResult &pulse,
+                             const SensorSnapshot &snapshot);
+bool startSchedule(const AcquisitionSchedule &request);
+void resumeSchedule(const AcquisitionSchedule &request, uint32_t first_frame, uint32_t frames_done);
+void armSchedule(uint32_t first_frame);
+void stopSchedule();
+void onScheduleTimer(void *arg);
+void finishScheduledFrame(const PulseResult &pulse);
+void serviceScheduleSkips(uint32_t before);
+void sendScheduleFrame(uint32_t index, uint8_t status, const PulseResult &pulse);
+void serviceSchedule(bool engineWasIdle);
+bool scheduleFrameImminent();
+void setSequenceStep(uint8_t index, const SequenceStep &step);
+void runSequence(uint16_t seq, int64_t received_us);
+void finishSequence(const PulseResult &pulse);
+void sendSequenceRecord(const PulseResult &pulse, const SensorSnapshot &snapshot);
+void onTelemetryTimer(void *arg);
+void stopTelemetry();
+void sendTelemetry();
 void setTiming(uint16_t stabilization_ms, uint16_t exposure_ms);
 void selectLed(uint8_t ledType);
 void turnOffAllLeds();
 void sendLedStatus();
-bool readSensorsWithValidation(float &temperature, float &humidity);
-void addToSensorHistory(float temp, float hum);
-float getFilteredTemperature();
-float getFilteredHumidity();
-
-void debugPrint(const char* msg) { if (DEBUG_ENABLED) Serial.print(msg); }
-void debugPrint(int val)         { if (DEBUG_ENABLED) Serial.print(val); }
-void debugPrintln(const char* msg){ if (DEBUG_ENABLED) Serial.println(msg); }
-void debugPrintln(int val)       { if (DEBUG_ENABLED) Serial.println(val); }
+bool readDhtValidated(float &temperature, float &humidity);
+bool readDhtOnce(float &temperature, float &humidity);
+void publishSensorSnapshot(bool readingValid);
+uint32_t getSensorSnapshot(SensorSnapshot &snapshot);
+void sensorTask(void *param);
+void sensorWait(uint32_t ms);
+int64_t systemTimeUs();
+bool loadResumeState(ResumeState &state);
+void saveResumeState();
+void resumeSettings(const ResumeState &state);
+void resumeOutputs(const ResumeState &state);
+void resumeTasks(const ResumeState &state);
+void sendResetInfo();
+void handleUnknownCommand(uint8_t cmd);
+void handlePayloadTimeout(uint8_t cmd);
+
+// Compiled out entirely unless Features::debug
+template <typename T> void debugPrint(T value)   { if (Features::debug) Serial.print(value); }
+template <typename T> void debugPrintln(T value) { if (Features::debug) Serial.println(value); }
+
+constexpr uint8_t ledTypeMask(uint8_t ledType) {
+  // LED_TYPE_IR / LED_TYPE_WHITE / QUEUE_LED_TYPE_DUAL -> channel mask
+  return ledType <= LED_TYPE_WHITE ? 1 << ledType : (1 << LED_TYPE_IR) | (1 << LED_TYPE_WHITE);
+}
 
 // ========================================================================
 // SETUP
 // ========================================================================
 void setup() {
-  Serial.begin(115200);
+  // Event log first, so the boot record precedes everything it could explain.
+  // Only a power-on leaves the RTC slots undefined.
+  resetReason = esp_reset_reason();
+  event_log_init(eventLog, eventSlots, EVENT_LOG_SLOTS, resetReason != ESP_RST_POWERON);
+  logEvent(EVENT_BOOT, resetReason, 0, 0);
+
+  // Supervision for the tasks started below (the IDF has the watchdog running already)
+  esp_task_wdt_init(WATCHDOG_TIMEOUT_S, true);
+
+  // Warm reset with a usable snapshot: the fast path (see RESUME STATE)
+  ResumeState resume;
+  bootResumed = loadResumeState(resume);
+  if (bootResumed) serialBaud = previousBaud = resume.baud;
+
+  Serial.setRxBufferSize(SERIAL_RX_BUFFER_SIZE);
+  Serial.setTxBufferSize(SERIAL_TX_BUFFER_SIZE);
+  Serial.begin(serialBaud);
   Serial.setTimeout(100);
 
-  // Board-specific startup delay
-  #if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(ESP32S3)
-    // ESP32-S3 needs time for USB CDC initialization
-    delay(2000);
+  // RX events wake commsTask (see TASK LAYOUT)
+  #if SERIAL_IS_USB_CDC
+    #if ARDUINO_USB_MODE
+      Serial.onEvent(ARDUINO_HW_CDC_RX_EVENT, onSerialRxEvent);
+    #else
+      Serial.onEvent(ARDUINO_USB_CDC_RX_EVENT, onSerialRxEvent);
+    #endif
   #else
+    Serial.setRxTimeout(UART_RX_TIMEOUT_SYMBOLS);
+    Serial.onReceive(onSerialReceive);
+  #endif
+
+  // Board-specific startup delay - none on a resume, the host has the port open
+  if (bootResumed) {
+    // Straight on to the LEDs
+  } else if (Board::native_usb) {
+    // USB CDC: give an attached host a moment to open the port for the
+    // banner, but never block startup on it (commands are buffered anyway)
+    unsigned long usb_wait_start = millis();
+    while (!Serial && millis() - usb_wait_start < USB_CDC_WAIT_MS) {
+      delay(10);
+    }
+  } else {
     // Regular ESP32 only needs minimal delay
     delay(100);
-  #endif
+  }
 
-  // Always print this first message (regardless of DEBUG_ENABLED)
-  Serial.println("\n\n========================================");
-  Serial.println("ESP32 Nematostella Controller v2.4 STARTING");
-  Serial.print("Board Type: ");
-  Serial.println(BOARD_TYPE);
-  Serial.println("========================================\n");
-  Serial.flush();
+  // Always print this first message (regardless of Features::debug), except
+  // to a host that is mid-session after a resume
+  if (!bootResumed) {
+    Serial.println("\n\n========================================");
+    Serial.print("ESP32 Nematostella Controller v");
+    Serial.print(FIRMWARE_VERSION_MAJOR);
+    Serial.print(".");
+    Serial.print(FIRMWARE_VERSION_MINOR);
+    Serial.println(" STARTING");
+    Serial.print("Board Type: ");
+    Serial.println(Board::name);
+    Serial.println("========================================\n");
+    Serial.flush();
+  }
 
   // Display board information
   debugPrintln("========================================");
-  debugPrint("ESP32 Nematostella Controller v2.4");
-  debugPrintln("");
+  debugPrint("ESP32 Nematostella Controller v");
+  debugPrint(FIRMWARE_VERSION_MAJOR);
+  debugPrint(".");
+  debugPrintln(FIRMWARE_VERSION_MINOR);
   debugPrint("Detected Board: ");
-  debugPrintln(BOARD_TYPE);
+  debugPrintln(Board::name);
   debugPrint("Pin Configuration:");
   debugPrintln("");
   debugPrint("  IR LED:    GPIO ");
@@ -198,35 +959,100 @@ void setup() {
   debugPrintln(ledWhitePin);
   debugPrint("  DHT22:     GPIO ");
   debugPrintln(dhtPin);
+  debugPrint("  Trigger:   GPIO ");
+  debugPrintln(TRIGGER_OUTPUT_PIN);
+  debugPrint("  LED channels: ");
+  debugPrintln(LED_CHANNEL_COUNT);
   debugPrintln("========================================");
 
-  // Configure PWM
-  ledcSetup(PWM_CHANNEL_IR, PWM_FREQUENCY, PWM_RESOLUTION);
-  ledcSetup(PWM_CHANNEL_WHITE, PWM_FREQUENCY, PWM_RESOLUTION);
-  ledcAttachPin(ledIrPin, PWM_CHANNEL_IR);
-  ledcAttachPin(ledWhitePin, PWM_CHANNEL_WHITE);
-
-  // Start with LEDs off
-  ledcWrite(PWM_CHANNEL_IR, 0);
-  ledcWrite(PWM_CHANNEL_WHITE, 0);
-
-  // Init DHT
-  dht.begin();
-  debugPrintln("Initializing DHT22 sensor...");
-  delay(2000);  // DHT warmup
-
-  // Read initial sensor values
-  float temp, hum;
-  if (readSensorsWithValidation(temp, hum)) {
-    debugPrint("Initial sensor reading: T=");
-    debugPrint((int)temp);
-    debugPrint("C, H=");
-    debugPrint((int)hum);
-    debugPrintln("%");
-  } else {
-    debugPrintln("Warning: Initial sensor reading failed");
+  // Settings from the last session, then the duty LUTs for those powers
+  initLedChannels();
+  loadConfig();
+  if (bootResumed) resumeSettings(resume);
+
+  // Configure PWM (duty LUTs from NVS, linear if none stored), LEDs off
+  loadDutyCurves();
+  loadSettleTables();
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    ledcSetup(ledChannels[ch].ledc_channel, PWM_FREQUENCY, PWM_RESOLUTION);
+    ledcAttachPin(ledChannelPins[ch], ledChannels[ch].ledc_channel);
+    led_channel_write(ledChannels[ch].ledc_channel, 0);
+  }
+
+  // Hardware timer for sync capture pulses (and the camera trigger output)
+  pulse_engine_init(TRIGGER_OUTPUT_PIN);
+
+  // Photodiode for CMD_CALIBRATE_SETTLE, full 0-3.1 V range
+  if (Features::photodiode) {
+    analogReadResolution(12);
+    analogSetPinAttenuation(PHOTODIODE_INPUT_PIN, ADC_11db);
+  }
+
+  // Frame clock for the on-device acquisition schedule
+  esp_timer_create_args_t scheduleTimerArgs = {};
+  scheduleTimerArgs.callback = onScheduleTimer;
+  scheduleTimerArgs.name     = "schedule";
+  esp_timer_create(&scheduleTimerArgs, &scheduleTimer);
+
+  // Record clock for the telemetry stream
+  esp_timer_create_args_t telemetryTimerArgs = {};
+  telemetryTimerArgs.callback = onTelemetryTimer;
+  telemetryTimerArgs.name     = "telemetry";
+  esp_timer_create(&telemetryTimerArgs, &telemetryTimer);
+
+  // Segment clock for LED ramps
+  esp_timer_create_args_t rampTimerArgs = {};
+  rampTimerArgs.callback = onRampTimer;
+  rampTimerArgs.name     = "ramp";
+  esp_timer_create(&rampTimerArgs, &rampTimer);
+
+  resetTimingStats();
+
+  // Power locks (modes are switched by CMD_SET_POWER_MODE); Serial is UART0
+  #if SERIAL_IS_USB_CDC
+    power_mode_init(-1);
+  #else
+    power_mode_init(0);
+  #endif
+
+  // LEDs, ramps and telemetry as they were before the reset
+  if (bootResumed) resumeOutputs(resume);
+
+  // Command dispatch table
+  command_parser_init(commandParser, COMMAND_TABLE, COMMAND_TABLE_SIZE,
+                      handleUnknownCommand, handlePayloadTimeout);
+  commandParser.on_dispatch = onSerialCommand;
+  frame_decoder_init(frameDecoder, FRAME_TIMEOUT_MS);
+  frame_decoder_init(udpDecoder, FRAME_TIMEOUT_MS);
+
+  // Init DHT - the sensor task waits out the warmup, so commands work right away
+  dhtMutex = xSemaphoreCreateMutex();
+  debugPrintln(dht_rmt_init(dhtPin) ? "Initializing DHT22 sensor (RMT)..."
+                                    : "Warning: RMT init for DHT22 failed");
+
+  // DHT sampling runs in the background task
+  xTaskCreatePinnedToCore(sensorTask, "sensor", SENSOR_TASK_STACK, NULL,
+                          SENSOR_TASK_PRIORITY, &sensorTaskHandle, SENSOR_TASK_CORE);
+
+  // Real-time and comms tasks take over from loop()
+  rtRequestQueue = xQueueCreate(RT_REQUEST_QUEUE_LENGTH, sizeof(RtRequest));
+  txQueue        = xQueueCreate(TX_QUEUE_LENGTH, sizeof(ResponseBuilder));
+  xTaskCreatePinnedToCore(rtTask, "rt", RT_TASK_STACK, NULL,
+                          RT_TASK_PRIORITY, &rtTaskHandle, RT_TASK_CORE);
+  pulse_engine_notify(rtTaskHandle);
+  sync_line_init(SYNC_LINE_PIN, rtTaskHandle);  // Edge ISR on this core, with the pulse timer
+  xTaskCreatePinnedToCore(commsTask, "comms", COMMS_TASK_STACK, NULL,
+                          COMMS_TASK_PRIORITY, &commsTaskHandle, COMMS_TASK_CORE);
+
+  // Wi-Fi link - joins the network in the background, serial works meanwhile
+  if (Features::network) {
+    net_transport_init(WIFI_SSID, WIFI_PASSWORD, NETWORK_UDP_PORT, NETWORK_MULTICAST_GROUP,
+                       wakeCommsTask);
   }
 
+  // Sync role and schedule go through the tasks, the host gets RESET_INFO
+  if (bootResumed) resumeTasks(resume);
+
   bootTime = millis();
 
   debugPrint("Default timing: ");
@@ -256,673 +1082,2920 @@ void loop() {
   #ifdef USE_DISPLAY
     display_update();
 
-    // Update sensor values on display
+    // Update sensor values on display (from the background snapshot)
     static unsigned long last_display_sensor_update = 0;
     if (millis() - last_display_sensor_update > 2000) {
-      float temp, hum;
-      if (readSensorsWithValidation(temp, hum)) {
-        display_update_sensor_values(temp, hum);
+      SensorSnapshot snapshot;
+      getSensorSnapshot(snapshot);
+      if (snapshot.valid) {
+        display_update_sensor_values(snapshot.temperature, snapshot.humidity);
       }
       last_display_sensor_update = millis();
     }
 
     // Update LED status on display
-    display_update_led_status(ledIrState, ledWhiteState,
-                               currentLedType == LED_TYPE_IR ? LED_POWER_PERCENT_IR : LED_POWER_PERCENT_WHITE);
+    display_update_led_status(ledChannels[LED_TYPE_IR].on, ledChannels[LED_TYPE_WHITE].on,
+                               ledChannels[currentLedType].power);
   #endif
 
-  // Periodic buffer clear
-  if (millis() - lastBufferClear > BUFFER_CLEAR_INTERVAL) {
-    if (Serial.available() > 10) {
-      clearSerialBuffer();
-    }
-    lastBufferClear = millis();
-  }
-
-  // Process commands
-  if (Serial.available() > 0) {
-    byte cmd = Serial.read();
-
-    switch (cmd) {
-
-      // ================================================================
-      // ✅ LED ON - PYTHON COMPATIBLE
-      // ================================================================
-      case CMD_LED_ON:
-          setCurrentLedState(true);
-          sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Send 0xAA for Python
-          debugPrintln("LED ON (ACK sent)");
-          break;
-
-      // ================================================================
-      // ✅ LED OFF - PYTHON COMPATIBLE
-      // ================================================================
-      case CMD_LED_OFF:
-          setCurrentLedState(false);
-          sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Send 0xAA for Python
-          debugPrintln("LED OFF (ACK sent)");
-          break;
-
-      // ================================================================
-      // STATUS - Returns status + sensor data (5 bytes)
-      // ================================================================
-      case CMD_STATUS:
-        {
-          // Actually read the sensor (not just cached values)
-          float temp, hum;
-          readSensorsWithValidation(temp, hum);
-
-          // Convert to int16 (scaled by 10)
-          int16_t temp_scaled = (int16_t)(temp * 10.0);
-          uint16_t hum_scaled = (uint16_t)(hum * 10.0);
-
-          // Clamp values
-          if (temp_scaled < -400) temp_scaled = -400;
-          if (temp_scaled > 850) temp_scaled = 850;
-          if (hum_scaled > 1000) hum_scaled = 1000;
-
-          // Send 5-byte packet immediately
-          byte status_code = (ledIrState || ledWhiteState) ? RESPONSE_STATUS_ON : RESPONSE_STATUS_OFF;
-          sendRawByte(status_code);
-          sendRawByte((temp_scaled >> 8) & 0xFF);
-          sendRawByte(temp_scaled & 0xFF);
-          sendRawByte((hum_scaled >> 8) & 0xFF);
-          sendRawByte(hum_scaled & 0xFF);
-          Serial.flush();
-
-          debugPrintln("Status sent with fresh sensor data");
-        }
-        break;
-
-      // ================================================================
-      // SET TIMING
-      // ================================================================
-      case CMD_SET_TIMING:
-        {
-          debugPrintln("CMD_SET_TIMING received");
-
-          // Wait for 4 bytes (2x uint16_t, big-endian)
-          unsigned long wait_start = millis();
-          while (Serial.available() < 4) {
-            if (millis() - wait_start > 1000) {
-              debugPrintln("Timeout waiting for timing data");
-              sendStatus(RESPONSE_ERROR);
-              break;
-            }
-            delay(1);
-          }
-
-          if (Serial.available() >= 4) {
-            byte buf[4];
-            Serial.readBytes(buf, 4);
-
-            // Parse big-endian uint16
-            uint16_t stab_ms = (buf[0] << 8) | buf[1];
-            uint16_t exp_ms  = (buf[2] << 8) | buf[3];
-
-            // Validate ranges
-            if (stab_ms < 10) stab_ms = 10;
-            if (stab_ms > 10000) stab_ms = 10000;
-            if (exp_ms < 0) exp_ms = 0;
-            if (exp_ms > 30000) exp_ms = 30000;
-
-            // Update globals
-            LED_STABILIZATION_MS = stab_ms;
-            EXPOSURE_MS = exp_ms;
-
-            debugPrint("Timing set: ");
-            debugPrint(LED_STABILIZATION_MS);
-            debugPrint("ms + ");
-            debugPrint(EXPOSURE_MS);
-            debugPrintln("ms");
-
-            // Send ACK
-            sendStatus(RESPONSE_TIMING_SET);
-            Serial.flush();
-          }
-        }
-        break;
-
-      // ================================================================
-      // SET LED POWER (current LED)
-      // ================================================================
-      case CMD_SET_LED_POWER:
-        {
-          unsigned long wait_start = millis();
-          while (Serial.available() < 1) {
-            if (millis() - wait_start > 500) break;
-            delay(1);
-          }
-          if (Serial.available() >= 1) {
-            uint8_t power = Serial.read();
-            if (power > 100) power = 100;
-            setLedPowerCurrent(power);
-            sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Use 0xAA for consistency
-            debugPrint("LED power set: ");
-            debugPrintln(power);
-          }
-        }
-        break;
-
-      // ================================================================
-      // SET IR POWER
-      // ================================================================
-      case CMD_SET_IR_POWER:
-        {
-          unsigned long wait_start = millis();
-          while (Serial.available() < 1) {
-            if (millis() - wait_start > 500) break;
-            delay(1);
-          }
-          if (Serial.available() >= 1) {
-            uint8_t power = Serial.read();
-            if (power > 100) power = 100;
-            setIrPower(power);
-            sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Use 0xAA for consistency
-            debugPrint("IR power set: ");
-            debugPrintln(power);
-          }
-        }
-        break;
-
-      // ================================================================
-      // SET WHITE POWER
-      // ================================================================
-      case CMD_SET_WHITE_POWER:
-        {
-          unsigned long wait_start = millis();
-          while (Serial.available() < 1) {
-            if (millis() - wait_start > 500) break;
-            delay(1);
-          }
-          if (Serial.available() >= 1) {
-            uint8_t power = Serial.read();
-            if (power > 100) power = 100;
-            setWhitePower(power);
-            sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Use 0xAA for consistency
-            debugPrint("White power set: ");
-            debugPrintln(power);
-          }
-        }
-        break;
-
-      // ================================================================
-      // SELECT LED IR
-      // ================================================================
-      case CMD_SELECT_LED_IR:
-        selectLed(LED_TYPE_IR);
-        sendStatus(RESPONSE_LED_IR_SELECTED);
-        debugPrintln("IR LED selected");
-        break;
-
-      // ================================================================
-      // SELECT LED WHITE
-      // ================================================================
-      case CMD_SELECT_LED_WHITE:
-        selectLed(LED_TYPE_WHITE);
-        sendStatus(RESPONSE_LED_WHITE_SELECTED);
-        debugPrintln("White LED selected");
-        break;
-
-      // ================================================================
-      // DUAL LED OFF
-      // ================================================================
-      case CMD_LED_DUAL_OFF:
-        turnOffAllLeds();
-        sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Use 0xAA for consistency
-        debugPrintln("All LEDs OFF");
-        break;
-
-      // ================================================================
-      // GET LED STATUS - Detailed response
-      // ================================================================
-      case CMD_GET_LED_STATUS:
-        sendLedStatus();
-        debugPrintln("LED status sent");
-        break;
-
-      // ================================================================
-      // SYNC CAPTURE (SINGLE LED)
-      // ================================================================
-      case CMD_SYNC_CAPTURE:
-        performSyncCapture();
-        break;
-
-      // ================================================================
-      // SYNC CAPTURE DUAL
-      // ================================================================
-      case CMD_SYNC_CAPTURE_DUAL:
-        performSyncCaptureDual();
-        break;
-
-      // ================================================================
-      // SET CAMERA TYPE
-      // ================================================================
-      case CMD_SET_CAMERA_TYPE:
-        {
-          unsigned long wait_start = millis();
-          while (Serial.available() < 1) {
-            if (millis() - wait_start > 500) break;
-            delay(1);
-          }
-          if (Serial.available() >= 1) {
-            CAMERA_TYPE = Serial.read();
-            sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Use 0xAA for consistency
-            debugPrint("Camera type set: ");
-            debugPrintln(CAMERA_TYPE);
-          }
-        }
-        break;
-
-      // ================================================================
-      // UNKNOWN COMMAND
-      // ================================================================
-      default:
-        debugPrint("Unknown cmd: 0x");
-        debugPrintln(cmd);
-        sendStatus(RESPONSE_ERROR);
-        break;
-    }
-  }
+  // Commands, pulses and responses are handled by commsTask and rtTask
+  #ifdef USE_DISPLAY
+    vTaskDelay(pdMS_TO_TICKS(LOOP_INTERVAL_MS));
+  #else
+    vTaskDelete(NULL);
+  #endif
 }
 
 // ========================================================================
-// HELPER FUNCTIONS
+// REAL-TIME TASK
 // ========================================================================
+void rtTask(void *param) {
+  esp_task_wdt_add(NULL);
+  TickType_t wait = pdMS_TO_TICKS(WATCHDOG_FEED_MS);
+  for (;;) {
+    // Woken by postRtRequest(), the pulse ISR, a timed queue start or the
+    // watchdog feed interval
+    ulTaskNotifyTake(pdTRUE, wait);
+    esp_task_wdt_reset();
+    int64_t wake_us = esp_timer_get_time();
+
+    RtRequest request;
+    while (xQueueReceive(rtRequestQueue, &request, 0) == pdTRUE) {
+      rtFrameSeq = request.seq;
+      runRtRequest(request);
+    }
+    rtFrameSeq = FRAME_SEQ_EVENT;
+
+    // Complete pulses whose LED-off edge fired in the timer ISR. Idle state is
+    // sampled first: the ISR queues the result before it clears the busy flag.
+    bool engineWasIdle = !pulse_engine_busy();
+    PulseResult pulse;
+    while (pulse_engine_poll(pulse)) {
+      logEventAt(pulse.on_us, EVENT_PULSE_START, pulse.source, pulse.tag, 0);
+      logEventAt(pulse.off_us, EVENT_PULSE_END, pulse.source, pulse.tag,
+                 pulse.off_us - pulse.on_us);
+      if (pulse.source == PULSE_SOURCE_SCHEDULE) {
+        finishScheduledFrame(pulse);
+      } else if (pulse.source == PULSE_SOURCE_SEQUENCE) {
+        finishSequence(pulse);
+      } else if (pulse.source == PULSE_SOURCE_LINE) {
+        finishLinePulse(pulse);
+      } else {
+        finishSyncCapture(pulse);
+      }
+      rtFrameSeq = FRAME_SEQ_EVENT;
+    }
 
-void clearSerialBuffer() {
-  int bytesCleared = 0;
-  while (Serial.available() > 0) {
-    Serial.read();
-    bytesCleared++;
+    // Report frames the timer had to skip once the frame lit meanwhile has
+    // reported, then the end of a finished or stopped schedule
+    if (engineWasIdle) serviceScheduleSkips(scheduleNextFrame);
+    serviceSchedule(engineWasIdle);
+
+    // Start the next queued capture once the engine is idle, otherwise
+    // sleep until its start time (or the next notification)
+    int32_t wait_us = serviceCaptureQueue();
+    wait = pdMS_TO_TICKS(WATCHDOG_FEED_MS);
+    if (wait_us >= 0) {
+      TickType_t ticks = pdMS_TO_TICKS((wait_us - RT_SPIN_THRESHOLD_US / 2) / 1000);
+      if (ticks < wait) wait = ticks > 0 ? ticks : 1;
+    }
+
+    // Slave: arm for the next sync line edge once nothing else is running
+    serviceSyncLine();
+
+    // Keep full clock and no light sleep while captures are pending
+    power_hold_set(POWER_HOLD_PULSE, syncPending || sequencePending || captureQueueCount > 0 ||
+                                     pulse_engine_armed());
+
+    recordTiming(TIMING_RT_ITERATION, esp_timer_get_time() - wake_us);
   }
-  if (bytesCleared > 0) {
-    debugPrint("Cleared ");
-    debugPrint(bytesCleared);
-    debugPrintln(" bytes");
+}
+
+void runRtRequest(const RtRequest &request) {
+  switch (request.type) {
+    case RT_SYNC_CAPTURE:      performSyncCapture(request.received_us); break;
+    case RT_SYNC_CAPTURE_DUAL: performSyncCaptureDual(request.received_us); break;
+    case RT_QUEUE_PUSH:        enqueueCapture(request.capture); break;
+    case RT_QUEUE_CLEAR:
+      captureQueueClear();
+      sendStatus(RESPONSE_LED_ON_ACK);
+      debugPrintln("Capture queue cleared");
+      break;
+    case RT_START_SCHEDULE:
+      if (!startSchedule(request.schedule)) {
+        debugPrintln("Schedule rejected");
+        sendStatus(RESPONSE_ERROR);
+      }
+      break;
+    case RT_STOP_SCHEDULE:
+      stopSchedule();
+      debugPrintln("Schedule stopped");
+      break;
+    case RT_SEQUENCE_STEP: setSequenceStep(request.step_index, request.step); break;
+    case RT_RUN_SEQUENCE:  runSequence(request.run_seq, request.received_us); break;
+    case RT_SETTLE:        runSettleRequest(request.settle_op, request.settle_channel); break;
+    case RT_RESUME_SCHEDULE:
+      resumeSchedule(request.schedule, request.first_frame, request.frames_done);
+      break;
   }
 }
 
-void sendRawByte(byte b) {
-  Serial.write(b);
-  Serial.flush();
+void postRtRequest(RtRequest &request) {
+  request.received_us = esp_timer_get_time();
+  request.seq         = commandFrameSeq;
+  if (xQueueSend(rtRequestQueue, &request, 0) != pdTRUE) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+  xTaskNotifyGive(rtTaskHandle);
 }
 
-void sendStatus(byte code) {
-  // For simple ACK responses, just send the byte
-  sendRawByte(code);
+bool rtIdle() {
+  return uxQueueMessagesWaiting(rtRequestQueue) == 0 && !syncPending && !sequencePending &&
+         captureQueueCount == 0 && !scheduleRunning && !pulse_engine_busy();
 }
 
-void sendStatusWithSensorData(byte code) {
-  // Send status byte + temperature + humidity (5 bytes total)
-  // Format: [code][temp_high][temp_low][hum_high][hum_low]
+uint8_t rtChannelMask() {
+  // commsTask: channels rtTask and the pulse ISR drive, or will for work
+  // already handed over. LED commands leave their outputs alone.
+  const uint8_t all = (1 << LED_CHANNEL_COUNT) - 1;
+  if (uxQueueMessagesWaiting(rtRequestQueue) > 0) return all;
+  uint8_t mask = 0;
+  if (syncPending)       mask |= syncMask;
+  if (sequencePending)   mask |= sequenceMask;
+  if (scheduleRunning)   mask |= ledTypeMask(schedule.led_type);
+  if (captureQueueCount) mask |= ledTypeMask(QUEUE_LED_TYPE_DUAL) | captureMask | 1 << currentLedType;
+  // A slave's line pulse, or a pulse whose flags rtTask has not set yet
+  if (mask == 0 && pulse_engine_busy()) return all;
+  return mask;
+}
+
+// ========================================================================
+// COMMS TASK
+// ========================================================================
+void commsTask(void *param) {
+  esp_task_wdt_add(NULL);
+  for (;;) {
+    // Sleep until serial RX or a queued response - a timed wake-up is only
+    // needed while something can time out
+    bool timeoutPending = baudConfirmPending || !command_parser_idle(commandParser) ||
+                          !frame_decoder_idle(frameDecoder);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutPending ? COMMS_TIMEOUT_POLL_MS : COMMS_IDLE_WAKE_MS));
+    esp_task_wdt_reset();
+    int64_t pass_start_us = esp_timer_get_time();
+    drainTxQueue();
+
+    // Periodic buffer clear (legacy only - framed mode resyncs per frame)
+    if (!protocolFramed && millis() - lastBufferClear > BUFFER_CLEAR_INTERVAL) {
+      if (Serial.available() > 10) {
+        clearSerialBuffer();
+        command_parser_reset(commandParser);
+        frame_decoder_reset(frameDecoder);
+      }
+      lastBufferClear = millis();
+    }
 
-  // Read sensors
-  float temp, hum;
-  readSensorsWithValidation(temp, hum);
+    // Stay awake for a while after host activity (light sleep drops RX bytes)
+    if (Serial.available() > 0) {
+      lastRxMs = millis();
+      power_hold_set(POWER_HOLD_COMMS, true);
+    } else if (millis() - lastRxMs > COMMS_AWAKE_MS) {
+      power_hold_set(POWER_HOLD_COMMS, false);
+    }
 
-  // Convert to int16 (scaled by 10 for 1 decimal precision)
-  int16_t temp_scaled = (int16_t)(temp * 10.0);
-  uint16_t hum_scaled = (uint16_t)(hum * 10.0);
+    // While a baud change waits for confirmation only CMD_BAUD_CONFIRM counts
+    if (baudConfirmPending) {
+      serviceBaudConfirm();
+      continue;
+    }
 
-  // Clamp values
-  if (temp_scaled < -400) temp_scaled = -400;  // -40.0°C
-  if (temp_scaled > 850) temp_scaled = 850;     // 85.0°C
-  if (hum_scaled > 1000) hum_scaled = 1000;     // 100.0%
+    // Process commands - byte at a time, payloads accumulate across iterations
+    while (Serial.available() > 0) {
+      feedSerialByte(Serial.read());
+    }
+    command_parser_poll(commandParser, millis());
+    pollFrameDecoder(frameDecoder, LINK_SERIAL);
+    if (Features::network) serviceNetwork();
+    // A command may have changed the settings an armed slave pulse uses
+    if (sync_line_role() == SYNC_ROLE_SLAVE) xTaskNotifyGive(rtTaskHandle);
+    if (telemetryDue) {
+      telemetryDue = false;
+      sendTelemetry();
+    }
+    if (rampDue) {
+      rampDue = false;
+      serviceRamps();
+    }
+    drainTxQueue();
+    serviceConfigSave();
+    saveResumeState();
 
-  // Send 5-byte packet
-  sendRawByte(code);
-  sendRawByte((temp_scaled >> 8) & 0xFF);  // temp high byte
-  sendRawByte(temp_scaled & 0xFF);          // temp low byte
-  sendRawByte((hum_scaled >> 8) & 0xFF);   // humidity high byte
-  sendRawByte(hum_scaled & 0xFF);          // humidity low byte
+    recordTiming(TIMING_COMMS_ITERATION, esp_timer_get_time() - pass_start_us);
+  }
+}
+
+// ========================================================================
+// TIMING STATISTICS
+// ========================================================================
+
+void recordTiming(TimingStatId id, int64_t us) {
+  if (us < 0) us = 0;
+  if (us > UINT32_MAX) us = UINT32_MAX;
+  portENTER_CRITICAL(&timingMux);
+  timing_stat_record(timingStats[id], (uint32_t)us);
+  portEXIT_CRITICAL(&timingMux);
+}
+
+void logEvent(uint8_t type, uint8_t arg8, uint16_t arg16, uint32_t arg32) {
+  logEventAt(esp_timer_get_time(), type, arg8, arg16, arg32);
+}
+
+void logEventAt(int64_t time_us, uint8_t type, uint8_t arg8, uint16_t arg16, uint32_t arg32) {
+  // Any task (not ISRs - the pulse edges are logged when rtTask polls them)
+  EventRecord record;
+  record.time_us = (uint64_t)time_us;
+  record.type    = type;
+  record.arg8    = arg8;
+  record.arg16   = arg16;
+  record.arg32   = arg32;
+  event_log_add(eventLog, record);
+}
+
+void logCommand(uint8_t cmd) {
+  logEvent(EVENT_COMMAND, cmd, commandFrameSeq, 0);
+}
 
-  Serial.flush();
+void resetTimingStats() {
+  portENTER_CRITICAL(&timingMux);
+  for (uint8_t i = 0; i < TIMING_STAT_COUNT; i++) {
+    timing_stat_reset(timingStats[i]);
+  }
+  portEXIT_CRITICAL(&timingMux);
 }
 
-void sendSyncResponseWithDuration(float temp, float hum, uint16_t duration_ms) {
+void sendTimingStats() {
   // ========================================================================
-  // Send 15-byte response matching Python expectations (esp32_commands.py)
+  // One 59-byte record per statistic (RESPONSE_TIMING_STATS)
   // ========================================================================
-  // Byte 0:      0x1B (RESPONSE_SYNC_COMPLETE)
-  // Bytes 1-2:   timing_ms (uint16 big-endian) - total LED-on duration
-  // Bytes 3-6:   temperature (float, little-endian IEEE 754)
-  // Bytes 7-10:  humidity (float, little-endian IEEE 754)
-  // Byte 11:     led_type_used (0=IR, 1=White)
-  // Bytes 12-13: led_duration_ms (uint16 big-endian) - same as timing_ms
-  // Byte 14:     led_power_actual (0-100%)
+  // Byte 0:      0x38
+  // Byte 1:      stat id (TimingStatId)
+  // Byte 2:      number of stats (records that follow in total)
+  // Bytes 3-6:   count (uint32 big-endian)
+  // Bytes 7-10:  min us (uint32 big-endian, 0 if count == 0)
+  // Bytes 11-14: max us (uint32 big-endian)
+  // Bytes 15-18: mean us (uint32 big-endian)
+  // Bytes 19-58: 20 log2 histogram buckets (uint16 big-endian each)
   // ========================================================================
+  for (uint8_t id = 0; id < TIMING_STAT_COUNT; id++) {
+    TimingStat stat;
+    portENTER_CRITICAL(&timingMux);
+    stat = timingStats[id];
+    portEXIT_CRITICAL(&timingMux);
+
+    ResponseBuilder response;
+    response.put_u8(RESPONSE_TIMING_STATS);
+    response.put_u8(id);
+    response.put_u8(TIMING_STAT_COUNT);
+    response.put_u32_be(stat.count);
+    response.put_u32_be(stat.count ? stat.min_us : 0);
+    response.put_u32_be(stat.max_us);
+    response.put_u32_be(timing_stat_mean(stat));
+    for (uint8_t b = 0; b < TIMING_BUCKETS; b++) {
+      response.put_u16_be(stat.buckets[b]);
+    }
+    queueResponse(response);
+  }
+}
 
-  // Byte 0: Response header
-  sendRawByte(RESPONSE_SYNC_COMPLETE);
+// ========================================================================
+// COMMAND HANDLERS
+// ========================================================================
+// Called by the command parser once the full payload has arrived. Payload
+// lengths and timeouts are defined in COMMAND_TABLE below.
+// ========================================================================
 
-  // Bytes 1-2: timing_ms (big-endian uint16)
-  sendRawByte((duration_ms >> 8) & 0xFF);
-  sendRawByte(duration_ms & 0xFF);
+// ================================================================
+// ✅ LED ON - PYTHON COMPATIBLE
+// ================================================================
+// LED ON / OFF reply 0xFF while the selected LED belongs to a capture,
+// sequence or schedule (rtChannelMask): the pulse owns its output.
+void handleLedOn(const uint8_t *payload) {
+  if ((rtChannelMask() >> currentLedType) & 1) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+  setCurrentLedState(true);
+  sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Send 0xAA for Python
+  debugPrintln("LED ON (ACK sent)");
+}
 
-  // Bytes 3-6: temperature as float (little-endian IEEE 754)
-  union {
-    float f;
-    uint8_t bytes[4];
-  } temp_union;
-  temp_union.f = temp;
-  for (int i = 0; i < 4; i++) {
-    sendRawByte(temp_union.bytes[i]);
+// ================================================================
+// ✅ LED OFF - PYTHON COMPATIBLE
+// ================================================================
+void handleLedOff(const uint8_t *payload) {
+  if ((rtChannelMask() >> currentLedType) & 1) {
+    sendStatus(RESPONSE_ERROR);
+    return;
   }
+  setCurrentLedState(false);
+  sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Send 0xAA for Python
+  debugPrintln("LED OFF (ACK sent)");
+}
 
-  // Bytes 7-10: humidity as float (little-endian IEEE 754)
-  union {
-    float f;
-    uint8_t bytes[4];
-  } hum_union;
-  hum_union.f = hum;
-  for (int i = 0; i < 4; i++) {
-    sendRawByte(hum_union.bytes[i]);
+// ================================================================
+// STATUS - Returns status + sensor data (5 bytes, 7 with sample age)
+// ================================================================
+void handleStatus(const uint8_t *payload) {
+  // Latest snapshot only - never reads the DHT22 or touches the LEDs. A
+  // stale snapshot asks the sensor task for a read in the next LED-off gap.
+  SensorSnapshot snapshot;
+  uint32_t age_ms = getSensorSnapshot(snapshot);
+  if (age_ms > sensorMaxAgeMs) {
+    xTaskNotifyGive(sensorTaskHandle);
   }
 
-  // Byte 11: led_type_used (0=IR, 1=White)
-  sendRawByte(currentLedType);
+  byte status_code = anyLedOn() ? RESPONSE_STATUS_ON : RESPONSE_STATUS_OFF;
+  sendStatusWithSensorData(status_code, snapshot.temperature, snapshot.humidity, age_ms);
 
-  // Bytes 12-13: led_duration_ms (big-endian uint16)
-  sendRawByte((duration_ms >> 8) & 0xFF);
-  sendRawByte(duration_ms & 0xFF);
+  debugPrintln("Status sent with cached sensor data");
+}
 
-  // Byte 14: led_power_actual (0-100%)
-  uint8_t current_power = (currentLedType == LED_TYPE_IR) ? LED_POWER_PERCENT_IR : LED_POWER_PERCENT_WHITE;
-  sendRawByte(current_power);
+// ================================================================
+// SET TIMING - 4 bytes (2x uint16_t, big-endian)
+// ================================================================
+void handleSetTiming(const uint8_t *payload) {
+  debugPrintln("CMD_SET_TIMING received");
 
-  Serial.flush();
+  // Parse big-endian uint16
+  uint16_t stab_ms = (payload[0] << 8) | payload[1];
+  uint16_t exp_ms  = (payload[2] << 8) | payload[3];
 
-  debugPrint("Sent 15-byte sync response: temp=");
-  debugPrint((int)temp);
-  debugPrint(", hum=");
-  debugPrint((int)hum);
-  debugPrint(", duration=");
-  debugPrint(duration_ms);
-  debugPrint("ms, LED=");
-  debugPrint(currentLedType == LED_TYPE_IR ? "IR" : "White");
-  debugPrint(", power=");
-  debugPrint(current_power);
-  debugPrintln("%");
+  // Validate ranges
+  if (stab_ms < 10) stab_ms = 10;
+  if (stab_ms > 10000) stab_ms = 10000;
+  if (exp_ms > 30000) exp_ms = 30000;
+
+  // Update globals
+  setTiming(stab_ms, exp_ms);
+
+  debugPrint("Timing set: ");
+  debugPrint(LED_STABILIZATION_MS);
+  debugPrint("ms + ");
+  debugPrint(EXPOSURE_MS);
+  debugPrintln("ms");
+
+  // Send ACK
+  sendStatus(RESPONSE_TIMING_SET);
 }
 
-void setLedState(bool state, uint8_t ledType) {
-  if (ledType == LED_TYPE_IR) {
-    ledIrState = state;
-    updateLedOutput(LED_TYPE_IR);
-  } else if (ledType == LED_TYPE_WHITE) {
-    ledWhiteState = state;
-    updateLedOutput(LED_TYPE_WHITE);
-  }
+// ================================================================
+// SET LED POWER (current LED)
+// ================================================================
+void handleSetLedPower(const uint8_t *payload) {
+  uint8_t power = payload[0];
+  if (power > 100) power = 100;
+  setChannelPower(currentLedType, power);
+  sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Use 0xAA for consistency
+  debugPrint("LED power set: ");
+  debugPrintln(power);
 }
 
-void setCurrentLedState(bool state) {
-  setLedState(state, currentLedType);
+// ================================================================
+// SET IR POWER
+// ================================================================
+void handleSetIrPower(const uint8_t *payload) {
+  uint8_t power = payload[0];
+  if (power > 100) power = 100;
+  setChannelPower(LED_TYPE_IR, power);
+  sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Use 0xAA for consistency
+  debugPrint("IR power set: ");
+  debugPrintln(power);
 }
 
-void updateLedOutput(uint8_t ledType) {
-  uint16_t maxValue = (1 << PWM_RESOLUTION) - 1;
+// ================================================================
+// SET WHITE POWER
+// ================================================================
+void handleSetWhitePower(const uint8_t *payload) {
+  uint8_t power = payload[0];
+  if (power > 100) power = 100;
+  setChannelPower(LED_TYPE_WHITE, power);
+  sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Use 0xAA for consistency
+  debugPrint("White power set: ");
+  debugPrintln(power);
+}
 
-  if (ledType == LED_TYPE_IR) {
-    if (ledIrState) {
-      uint16_t pwmValue = map(LED_POWER_PERCENT_IR, 0, 100, 0, maxValue);
-      ledcWrite(PWM_CHANNEL_IR, pwmValue);
-    } else {
-      ledcWrite(PWM_CHANNEL_IR, 0);
+// ================================================================
+// SET DUTY CURVE - 24 bytes
+// ================================================================
+// [channel][flags][11 x level (uint16 big-endian)] - channel 0 = IR, 1 = white
+// Levels are the output at 0, 10, ... 100 % power as a fraction of full
+// duty (0-65535) and must not decrease. Flags: see DUTY_CURVE_FLAG_*.
+// Refused unless rtTask is idle (nothing posted or pending either) and the
+// board is no slave: rtTask builds pulses from the LUT, and the NVS write
+// stalls flash for a few ms.
+void handleSetDutyCurve(const uint8_t *payload) {
+  uint8_t channel = payload[0];
+  uint8_t flags   = payload[1];
+  uint16_t points[DUTY_CURVE_POINTS];
+  if (flags & DUTY_CURVE_FLAG_RESET) {
+    duty_curve_identity(points);
+  } else {
+    for (uint8_t i = 0; i < DUTY_CURVE_POINTS; i++) {
+      points[i] = ((uint16_t)payload[2 + 2 * i] << 8) | payload[3 + 2 * i];
     }
-  } else if (ledType == LED_TYPE_WHITE) {
-    if (ledWhiteState) {
-      uint16_t pwmValue = map(LED_POWER_PERCENT_WHITE, 0, 100, 0, maxValue);
-      ledcWrite(PWM_CHANNEL_WHITE, pwmValue);
+  }
+
+  if (channel >= LED_CHANNEL_COUNT || !duty_curve_valid(points) || !rtIdle() ||
+      sync_line_role() == SYNC_ROLE_SLAVE) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+
+  DutyLut lut;
+  duty_lut_build(lut, points, PWM_MAX_DUTY);
+  ledChannels[channel].lut = lut;
+  updateLedDuty(channel);
+  if (ledChannels[channel].on) updateLedOutput(channel);  // Steady on or ramping
+
+  if (flags & DUTY_CURVE_FLAG_PERSIST) {
+    Preferences prefs;
+    prefs.begin(DUTY_CURVE_NVS_NAMESPACE, false);
+    if (flags & DUTY_CURVE_FLAG_RESET) {
+      prefs.remove(DUTY_CURVE_NVS_KEYS[channel]);
     } else {
-      ledcWrite(PWM_CHANNEL_WHITE, 0);
+      prefs.putBytes(DUTY_CURVE_NVS_KEYS[channel], points, sizeof(points));
     }
+    prefs.end();
   }
-}
 
-void updateCurrentLedOutput() {
-  updateLedOutput(currentLedType);
+  sendStatus(RESPONSE_LED_ON_ACK);
+  debugPrint("Duty curve set, channel ");
+  debugPrintln(channel);
 }
 
-void setLedPowerCurrent(uint8_t power) {
-  if (power > 100) power = 100;
+// ================================================================
+// SET CHANNEL MASK - 2 bytes [mask][flags]
+// ================================================================
+// Bit n = LED channel n. Without flags every channel is switched on or off
+// to match the mask. With CHANNEL_MASK_FLAG_CAPTURE the mask instead picks
+// the LEDs of SYNC_CAPTURE / SYNC_CAPTURE_QUEUED (0 = selected LED again).
+// A mask that would switch a channel in rtChannelMask() is refused.
+void handleSetChannelMask(const uint8_t *payload) {
+  uint8_t mask  = payload[0];
+  uint8_t flags = payload[1];
+  if ((mask >> LED_CHANNEL_COUNT) ||
+      (!(flags & CHANNEL_MASK_FLAG_CAPTURE) && (rtChannelMask() & (mask ^ ledOnMask())))) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
 
-  if (currentLedType == LED_TYPE_IR) {
-    LED_POWER_PERCENT_IR = power;
+  if (flags & CHANNEL_MASK_FLAG_CAPTURE) {
+    captureMask = mask;
   } else {
-    LED_POWER_PERCENT_WHITE = power;
+    applyChannelMask(mask);
   }
+  sendStatus(RESPONSE_LED_ON_ACK);
+}
 
-  LED_POWER_PERCENT = power;
-
-  if ((currentLedType == LED_TYPE_IR && ledIrState) ||
-      (currentLedType == LED_TYPE_WHITE && ledWhiteState)) {
-    updateCurrentLedOutput();
+// ================================================================
+// SET CHANNEL POWER - 2 bytes [channel][power 0-100]
+// ================================================================
+void handleSetChannelPower(const uint8_t *payload) {
+  if (payload[0] >= LED_CHANNEL_COUNT) {
+    sendStatus(RESPONSE_ERROR);
+    return;
   }
+  setChannelPower(payload[0], payload[1]);
+  sendStatus(RESPONSE_LED_ON_ACK);
 }
 
-void setIrPower(uint8_t power) {
-  if (power > 100) power = 100;
-  LED_POWER_PERCENT_IR = power;
-  if (ledIrState) {
-    updateLedOutput(LED_TYPE_IR);
+// ================================================================
+// RAMP CHANNEL - 6 bytes [channel][power 0-100][duration_ms u32]
+// ================================================================
+// Fades the channel from its current output to power, switching it on
+// first; a ramp to 0 switches it off at the end and leaves its power
+// setting alone. Duration 0 = at once.
+// A new ramp starts from wherever a running one has got to.
+void handleRampChannel(const uint8_t *payload) {
+  uint8_t  channel     = payload[0];
+  uint8_t  power       = payload[1];
+  uint32_t duration_ms = ((uint32_t)payload[2] << 24) | ((uint32_t)payload[3] << 16) |
+                         ((uint32_t)payload[4] << 8) | payload[5];
+  if (channel >= LED_CHANNEL_COUNT || power > 100 || ((rtChannelMask() >> channel) & 1)) {
+    sendStatus(RESPONSE_ERROR);
+    return;
   }
+  startRamp(channel, power, duration_ms);
+  sendStatus(RESPONSE_LED_ON_ACK);
 }
 
-void setWhitePower(uint8_t power) {
-  if (power > 100) power = 100;
-  LED_POWER_PERCENT_WHITE = power;
-  if (ledWhiteState) {
-    updateLedOutput(LED_TYPE_WHITE);
+// ================================================================
+// CALIBRATE SETTLE - 2 bytes [op][channel]
+// ================================================================
+// Op 0 = query, 1 = calibrate the channel (reply after ~7 s, LED
+// commands meanwhile spoil the run), 2 / 3 = adaptive stabilization
+// on / off, 4 = clear the channel's table. Replies [0x42][status][flags]
+// [channel][settle_us u32 x 10] (big-endian): the channel's table at 10,
+// 20, ... 100 % power, 0 = not calibrated, 0xFFFFFFFF = did not settle,
+// 0xFFFFFFFE = no signal. Flags bit0 = adaptive on. Status: see
+// SETTLE_STATUS_*. The table and the adaptive flag persist in NVS.
+void handleCalibrateSettle(const uint8_t *payload) {
+  RtRequest request;
+  request.type           = RT_SETTLE;
+  request.settle_op      = payload[0];
+  request.settle_channel = payload[1];
+  postRtRequest(request);
+}
+
+// ================================================================
+// GET CHANNELS
+// ================================================================
+// Replies [0x3E][channel count][on mask][capture mask][power x count]
+void handleGetChannels(const uint8_t *payload) {
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_CHANNELS);
+  response.put_u8(LED_CHANNEL_COUNT);
+  response.put_u8(ledOnMask());
+  response.put_u8(captureMask);
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    response.put_u8(ledChannels[ch].power);
   }
+  queueResponse(response);
 }
 
-void selectLed(uint8_t ledType) {
-  // Change LED selection without affecting LED states
-  // This allows switching between IR and White without turning LEDs off
-  currentLedType = ledType;
+// ================================================================
+// SELECT LED IR
+// ================================================================
+void handleSelectLedIr(const uint8_t *payload) {
+  selectLed(LED_TYPE_IR);
+  sendStatus(RESPONSE_LED_IR_SELECTED);
+  debugPrintln("IR LED selected");
+}
 
-  debugPrint("LED selected: ");
-  debugPrintln(ledType == LED_TYPE_IR ? "IR (Night)" : "White (Day)");
+// ================================================================
+// SELECT LED WHITE
+// ================================================================
+void handleSelectLedWhite(const uint8_t *payload) {
+  selectLed(LED_TYPE_WHITE);
+  sendStatus(RESPONSE_LED_WHITE_SELECTED);
+  debugPrintln("White LED selected");
 }
 
-void turnOffAllLeds() {
-  ledIrState = false;
-  ledWhiteState = false;
-  updateLedOutput(LED_TYPE_IR);
-  updateLedOutput(LED_TYPE_WHITE);
+// ================================================================
+// DUAL LED OFF
+// ================================================================
+void handleLedDualOff(const uint8_t *payload) {
+  if (rtChannelMask() & ledOnMask()) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+  turnOffAllLeds();
+  sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Use 0xAA for consistency
+  debugPrintln("All LEDs OFF");
 }
 
-void sendLedStatus() {
-  sendRawByte(RESPONSE_LED_STATUS);
-  sendRawByte(currentLedType);
-  sendRawByte(ledIrState ? 1 : 0);
-  sendRawByte(ledWhiteState ? 1 : 0);
-  sendRawByte(LED_POWER_PERCENT_IR);
-  sendRawByte(LED_POWER_PERCENT_WHITE);
-  Serial.flush();
+// ================================================================
+// GET LED STATUS - Detailed response
+// ================================================================
+void handleGetLedStatus(const uint8_t *payload) {
+  sendLedStatus();
+  debugPrintln("LED status sent");
 }
 
-void setTiming(uint16_t stabilization_ms, uint16_t exposure_ms) {
-  LED_STABILIZATION_MS = stabilization_ms;
-  EXPOSURE_MS = exposure_ms;
+// ================================================================
+// SYNC CAPTURE (SINGLE LED)
+// ================================================================
+void handleSyncCapture(const uint8_t *payload) {
+  RtRequest request;
+  request.type = RT_SYNC_CAPTURE;
+  postRtRequest(request);
 }
 
-// ========================================================================
-// SYNC CAPTURE FUNCTIONS
-// ========================================================================
+// ================================================================
+// SYNC CAPTURE DUAL
+// ================================================================
+void handleSyncCaptureDual(const uint8_t *payload) {
+  RtRequest request;
+  request.type = RT_SYNC_CAPTURE_DUAL;
+  postRtRequest(request);
+}
 
-void performSyncCapture() {
-  debugPrintln("=== SYNC_CAPTURE START ===");
-  debugPrint("LED type: ");
-  debugPrintln(currentLedType == LED_TYPE_IR ? "IR" : "White");
+// ================================================================
+// SET SYNC ROLE - 2 bytes [role][flags]
+// ================================================================
+// Role 0 = off, 1 = master, 2 = slave, 0xFF = query only. Flags bit0 =
+// slave captures both LEDs. Replies [0x41][role][status][edges u32]
+// [missed u32] (big-endian). Status 0 = ok, 1 = invalid role, 2 = no sync
+// line in this build, 3 = busy (pulse, queue or schedule active).
+void handleSetSyncRole(const uint8_t *payload) {
+  uint8_t status = SYNC_LINE_STATUS_OK;
+  if (payload[0] != SYNC_ROLE_QUERY) {
+    if (payload[0] > SYNC_ROLE_SLAVE) {
+      status = SYNC_LINE_STATUS_INVALID;
+    } else if (!Features::sync_line) {
+      status = SYNC_LINE_STATUS_NOT_SUPPORTED;
+    } else if (!rtIdle()) {
+      status = SYNC_LINE_STATUS_BUSY;
+    } else {
+      lineDual = payload[1] & SYNC_ROLE_FLAG_DUAL;
+      sync_line_set_role((SyncRole)payload[0]);
+      xTaskNotifyGive(rtTaskHandle);  // Arms or disarms the slave pulse
+    }
+  }
 
-  unsigned long startTime = millis();
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_SYNC_LINE);
+  response.put_u8(sync_line_role());
+  response.put_u8(status);
+  response.put_u32_be(sync_line_edges());
+  response.put_u32_be(sync_line_missed());
+  queueResponse(response);
+}
 
-  // Turn on current LED
-  setCurrentLedState(true);
+// ================================================================
+// SYNC CAPTURE QUEUED - 7 bytes
+// ================================================================
+// [seq_hi][seq_lo][flags][start_us (uint32 big-endian)]
+// Replies RESPONSE_QUEUE_ACK + seq + free slots, or RESPONSE_QUEUE_FULL + seq.
+// The capture itself reports with a RESPONSE_QUEUED_COMPLETE record.
+void handleSyncCaptureQueued(const uint8_t *payload) {
+  RtRequest request;
+  request.type = RT_QUEUE_PUSH;
+  QueuedCapture &capture = request.capture;
+  capture.seq      = (payload[0] << 8) | payload[1];
+  capture.flags    = payload[2];
+  capture.start_us = ((uint32_t)payload[3] << 24) | ((uint32_t)payload[4] << 16) |
+                     ((uint32_t)payload[5] << 8) | payload[6];
+  postRtRequest(request);
+}
 
-  // Send ACK immediately so Python knows LED is on
-  sendRawByte(RESPONSE_LED_ON_ACK);
-  Serial.flush();
+// ================================================================
+// QUEUE CLEAR - Drops pending queued captures (running pulse finishes)
+// ================================================================
+void handleQueueClear(const uint8_t *payload) {
+  RtRequest request;
+  request.type = RT_QUEUE_CLEAR;
+  postRtRequest(request);
+}
 
-  // Wait for LED stabilization + camera exposure
-  // Total LED-on time = LED_STABILIZATION_MS + EXPOSURE_MS
-  unsigned long totalDuration = LED_STABILIZATION_MS + EXPOSURE_MS;
-  delay(totalDuration);
+// ================================================================
+// START SCHEDULE - 14 bytes
+// ================================================================
+// [interval_ms u32][led_type][power][stab_ms u16][exp_ms u16][frame_count u32]
+// All multi-byte values big-endian. led_type 2 = both LEDs, frame_count 0 =
+// run until CMD_STOP_SCHEDULE. Replies RESPONSE_SCHEDULE_ACK + start time of
+// frame 0 (esp_timer us, low 32 bits), then one RESPONSE_SCHEDULE_FRAME per
+// frame and a final RESPONSE_SCHEDULE_DONE.
+void handleStartSchedule(const uint8_t *payload) {
+  uint32_t interval_ms = ((uint32_t)payload[0] << 24) | ((uint32_t)payload[1] << 16) |
+                         ((uint32_t)payload[2] << 8) | payload[3];
+
+  RtRequest rtRequest;
+  rtRequest.type = RT_START_SCHEDULE;
+  AcquisitionSchedule &request = rtRequest.schedule;
+  request.led_type         = payload[4];
+  request.power            = payload[5] > 100 ? 100 : payload[5];
+  request.stabilization_ms = (payload[6] << 8) | payload[7];
+  request.exposure_ms      = (payload[8] << 8) | payload[9];
+  request.frame_count      = ((uint32_t)payload[10] << 24) | ((uint32_t)payload[11] << 16) |
+                             ((uint32_t)payload[12] << 8) | payload[13];
+  request.interval_us      = (int64_t)interval_ms * 1000;
+
+  // Same limits as CMD_SET_TIMING
+  if (request.stabilization_ms < 10) request.stabilization_ms = 10;
+  if (request.stabilization_ms > 10000) request.stabilization_ms = 10000;
+  if (request.exposure_ms > 30000) request.exposure_ms = 30000;
+
+  int64_t pulse_us = ((int64_t)request.stabilization_ms + request.exposure_ms) * 1000;
+  if (request.led_type > QUEUE_LED_TYPE_DUAL || interval_ms > SCHEDULE_MAX_INTERVAL_MS ||
+      request.interval_us < pulse_us + SCHEDULE_MIN_GAP_US) {
+    debugPrintln("Schedule rejected");
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
 
-  // Turn off LED
-  setCurrentLedState(false);
+  // Remaining checks (capture running, schedule active) happen in rtTask
+  postRtRequest(rtRequest);
+}
 
-  unsigned long actualDuration = millis() - startTime;
+// ================================================================
+// STOP SCHEDULE - Frame in flight still reports, then SCHEDULE_DONE
+// ================================================================
+void handleStopSchedule(const uint8_t *payload) {
+  RtRequest request;
+  request.type = RT_STOP_SCHEDULE;
+  postRtRequest(request);
+}
 
-  // Read sensors after LED is off
-  float temp, hum;
-  readSensorsWithValidation(temp, hum);
+// ================================================================
+// GET TIMING STATS - 1 byte [flags] (bit0 = reset after reading)
+// ================================================================
+void handleGetTimingStats(const uint8_t *payload) {
+  sendTimingStats();
+  if (payload[0] & TIMING_STATS_FLAG_RESET) resetTimingStats();
+}
 
-  // Send 15-byte sync complete response
-  sendSyncResponseWithDuration(temp, hum, (uint16_t)actualDuration);
+// ================================================================
+// SET SEQUENCE STEP - 8 bytes
+// ================================================================
+// [index][channel mask][power][flags][duration_us u32 big-endian]
+// Steps must be written in order; writing step n drops the steps after it,
+// so index 0 starts a new sequence. Power 0xFF = each channel's own power,
+// mask 0 = a dark step. Replies 0xAA, or 0xFF while a sequence is running.
+void handleSetSequenceStep(const uint8_t *payload) {
+  RtRequest request;
+  request.type       = RT_SEQUENCE_STEP;
+  request.step_index = payload[0];
+  SequenceStep &step = request.step;
+  step.mask        = payload[1];
+  step.power       = payload[2];
+  step.flags       = payload[3];
+  step.duration_us = ((uint32_t)payload[4] << 24) | ((uint32_t)payload[5] << 16) |
+                     ((uint32_t)payload[6] << 8) | payload[7];
+
+  if ((step.mask >> LED_CHANNEL_COUNT) || (step.power > 100 && step.power != SEQUENCE_POWER_OWN) ||
+      step.duration_us == 0 || step.duration_us > SEQUENCE_MAX_STEP_US) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+  postRtRequest(request);
+}
 
-  debugPrint("=== SYNC_CAPTURE COMPLETE: ");
-  debugPrint(actualDuration);
-  debugPrintln("ms ===");
+// ================================================================
+// RUN SEQUENCE - 2 bytes [seq_hi][seq_lo]
+// ================================================================
+// Replies 0xAA once the first step is lit, then one
+// RESPONSE_SEQUENCE_COMPLETE record for the whole sequence.
+void handleRunSequence(const uint8_t *payload) {
+  RtRequest request;
+  request.type    = RT_RUN_SEQUENCE;
+  request.run_seq = (payload[0] << 8) | payload[1];
+  postRtRequest(request);
 }
 
-void performSyncCaptureDual() {
-  debugPrintln("=== SYNC_CAPTURE_DUAL START ===");
-  debugPrintln("Both LEDs: IR + White");
+// ================================================================
+// SET CAMERA TYPE
+// ================================================================
+void handleSetCameraType(const uint8_t *payload) {
+  CAMERA_TYPE = payload[0];
+  markConfigDirty();
+  sendStatus(RESPONSE_LED_ON_ACK);  // ✅ Use 0xAA for consistency
+  debugPrint("Camera type set: ");
+  debugPrintln(CAMERA_TYPE);
+}
 
-  unsigned long startTime = millis();
+// ================================================================
+// SET TRIGGER - 3 bytes [enable][width_us (uint16 big-endian)]
+// ================================================================
+void handleSetTrigger(const uint8_t *payload) {
+  if (!Features::camera_trigger) {
+    sendStatus(RESPONSE_ERROR);  // Built with CAMERA_TRIGGER_OUTPUT=0
+    return;
+  }
+  triggerEnabled = payload[0] != 0;
+  uint16_t width_us = (payload[1] << 8) | payload[2];
+  triggerWidthUs = width_us < TRIGGER_MIN_WIDTH_US ? TRIGGER_MIN_WIDTH_US : width_us;
+  markConfigDirty();
+  sendStatus(RESPONSE_LED_ON_ACK);
+  debugPrint("Camera trigger ");
+  debugPrint(triggerEnabled ? "enabled, width us: " : "disabled, width us: ");
+  debugPrintln(triggerWidthUs);
+}
 
-  // Turn on BOTH LEDs simultaneously
-  ledIrState = true;
-  ledWhiteState = true;
-  updateLedOutput(LED_TYPE_IR);
-  updateLedOutput(LED_TYPE_WHITE);
+// ================================================================
+// SET POWER MODE - 1 byte (0 = performance, 1 = DFS, 2 = light sleep)
+// ================================================================
+// Replies [0x3C][active mode][status]. Status 0 = ok, 1 = invalid mode,
+// 2 = not supported by this build/board, 3 = light sleep needs protocol v3.
+void handleSetPowerMode(const uint8_t *payload) {
+  uint8_t status = POWER_STATUS_OK;
+  if (payload[0] > POWER_MODE_LIGHT_SLEEP) {
+    status = POWER_STATUS_INVALID;
+  } else if (payload[0] == POWER_MODE_LIGHT_SLEEP && !protocolFramed) {
+    status = POWER_STATUS_NEEDS_FRAMING;
+  } else if (payload[0] == POWER_MODE_LIGHT_SLEEP && Features::network) {
+    status = POWER_STATUS_NOT_SUPPORTED;  // Wi-Fi stays connected, modem sleep is off
+  } else if (power_mode_set((PowerMode)payload[0]) != ESP_OK) {
+    status = POWER_STATUS_NOT_SUPPORTED;
+  }
 
-  // Send ACK immediately so Python knows LEDs are on
-  sendRawByte(RESPONSE_LED_ON_ACK);
-  Serial.flush();
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_POWER_MODE);
+  response.put_u8(power_mode_get());
+  response.put_u8(status);
+  queueResponse(response);
+}
 
-  // Wait for LED stabilization + camera exposure
-  // Total LED-on time = LED_STABILIZATION_MS + EXPOSURE_MS
-  unsigned long totalDuration = LED_STABILIZATION_MS + EXPOSURE_MS;
-  delay(totalDuration);
+// ================================================================
+// GET CONFIG - Persisted settings in one reply
+// ================================================================
+// Replies [0x3D][flags][config blob, DEVICE_CONFIG_SIZE bytes]. Flags:
+// bit0 = restored from NVS at boot, bit1 = changes not yet saved. The last
+// two blob bytes are the config hash (see device_config.h).
+void handleGetConfig(const uint8_t *payload) {
+  uint8_t blob[DEVICE_CONFIG_SIZE];
+  device_config_encode(currentConfig(), blob);
+
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_CONFIG);
+  response.put_u8((configRestored ? CONFIG_FLAG_RESTORED : 0) |
+                  (configDirty ? CONFIG_FLAG_SAVE_PENDING : 0));
+  for (uint8_t i = 0; i < DEVICE_CONFIG_SIZE; i++) {
+    response.put_u8(blob[i]);
+  }
+  queueResponse(response);
+}
 
-  // Turn off both LEDs
-  ledIrState = false;
-  ledWhiteState = false;
-  updateLedOutput(LED_TYPE_IR);
-  updateLedOutput(LED_TYPE_WHITE);
+// ================================================================
+// SET SYNC FORMAT - 1 byte (0 = 15-byte legacy, 1 = extended, 2 = settle)
+// ================================================================
+void handleSetSyncFormat(const uint8_t *payload) {
+  if (payload[0] > SYNC_FORMAT_SETTLE) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+  syncResponseFormat = payload[0];
+  markConfigDirty();
+  sendStatus(RESPONSE_LED_ON_ACK);
+}
 
-  unsigned long actualDuration = millis() - startTime;
+// ================================================================
+// SET SENSOR POLICY - [max_age_ms u32][flags]
+// ================================================================
+// max_age_ms is the staleness the host accepts (at least one DHT22 sample
+// interval). Flag 0x01 appends the sample age to the CMD_STATUS reply.
+void handleSetSensorPolicy(const uint8_t *payload) {
+  uint32_t max_age_ms = ((uint32_t)payload[0] << 24) | ((uint32_t)payload[1] << 16) |
+                        ((uint32_t)payload[2] << 8) | payload[3];
+  uint8_t flags = payload[4];
+  if (max_age_ms < SENSOR_SAMPLE_INTERVAL_MS || (flags & ~SENSOR_POLICY_STATUS_AGE)) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+  sensorMaxAgeMs = max_age_ms;
+  statusReportsAge = flags & SENSOR_POLICY_STATUS_AGE;
+  // Re-evaluate the sample period right away
+  xTaskNotifyGive(sensorTaskHandle);
+  sendStatus(RESPONSE_LED_ON_ACK);
+}
 
-  // Read sensors after LEDs are off
-  float temp, hum;
-  readSensorsWithValidation(temp, hum);
+// ================================================================
+// STREAM TELEMETRY - 3 bytes
+// ================================================================
+// [period_ms u16 big-endian][field mask (TELEMETRY_FIELD_*)]. Period 0 or
+// mask 0 stops the stream. Replies 0xAA, or 0xFF for a period under 20 ms,
+// unknown field bits or the legacy protocol. Records (RESPONSE_TELEMETRY,
+// layout in response_encode.h) follow every period_ms, seq from 0.
+void handleStreamTelemetry(const uint8_t *payload) {
+  uint16_t period_ms = (payload[0] << 8) | payload[1];
+  uint8_t  fields    = payload[2];
+
+  if (period_ms == 0 || fields == 0) {
+    stopTelemetry();
+    sendStatus(RESPONSE_LED_ON_ACK);
+    return;
+  }
+  if (!linkFramed() || period_ms < TELEMETRY_MIN_PERIOD_MS || (fields & ~TELEMETRY_FIELDS_ALL)) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
 
-  // Send 15-byte sync complete response
-  sendSyncResponseWithDuration(temp, hum, (uint16_t)actualDuration);
+  stopTelemetry();
+  telemetryFields   = fields;
+  telemetryPeriodMs = period_ms;
+  telemetrySeq      = 0;
+  esp_timer_start_periodic(telemetryTimer, (uint64_t)period_ms * 1000);
+  sendStatus(RESPONSE_LED_ON_ACK);
+  debugPrint("Telemetry stream every ms: ");
+  debugPrintln(period_ms);
+}
 
-  debugPrint("=== SYNC_CAPTURE_DUAL COMPLETE: ");
-  debugPrint(actualDuration);
-  debugPrintln("ms ===");
+// ================================================================
+// GET EVENT LOG - 6 bytes
+// ================================================================
+// [from index u32 big-endian][max records][flags] (bit0 = clear what was
+// sent). Sends the records from max(from, oldest) up to the head, at most
+// max (0 = 48, also the limit) as RESPONSE_EVENT_LOG chunks of 3 (layout in
+// response_encode.h). There is no ACK: the last chunk has flags bit0 set,
+// an empty range is one chunk with count 0. The host continues from
+// first + count of the last chunk.
+void handleGetEventLog(const uint8_t *payload) {
+  uint32_t from = ((uint32_t)payload[0] << 24) | ((uint32_t)payload[1] << 16) |
+                  ((uint32_t)payload[2] << 8) | payload[3];
+  uint8_t  max_records = payload[4];
+  uint8_t  flags       = payload[5];
+  if (max_records == 0 || max_records > EVENT_LOG_MAX_RECORDS) max_records = EVENT_LOG_MAX_RECORDS;
+
+  uint32_t head   = event_log_head(eventLog);
+  uint32_t oldest = event_log_oldest(eventLog);
+  uint32_t first  = from < oldest ? oldest : (from > head ? head : from);
+  uint32_t end    = head - first > max_records ? first + max_records : head;
+
+  uint32_t index = first;
+  do {
+    ResponseBuilder response;
+    index += encode_event_chunk(response, RESPONSE_EVENT_LOG, eventLog, index, end);
+    queueResponse(response);
+    drainTxQueue();
+  } while (index < end);
+
+  if (flags & EVENT_LOG_FLAG_CLEAR) event_log_clear(eventLog, end);
 }
 
-// ========================================================================
-// SENSOR FUNCTIONS
-// ========================================================================
+// ================================================================
+// GET RESET INFO - Why this boot happened and what came back
+// ================================================================
+// Replies [0x43][reset reason][flags][warm resets u32][previous uptime ms u32]
+// [resume frame u32][uptime ms u32] (big-endian), see RESUME STATE. Reason
+// is esp_reset_reason_t (1 = power-on, 3 = software, 4 = panic, 5-7 =
+// watchdogs, 9 = brownout). Flags bit0 = state resumed, bit1 = schedule
+// resumed at the resume frame, bit2 = state refused (resumed boot crashed
+// early). A framed host gets the reply as an event right after a resume;
+// esp_timer starts from 0 again, so it re-runs CMD_TIME_SYNC.
+void handleGetResetInfo(const uint8_t *payload) {
+  sendResetInfo();
+}
 
-bool readSensorsWithValidation(float &temperature, float &humidity) {
-  // Save LED states
-  bool irWasOn = ledIrState;
-  bool whiteWasOn = ledWhiteState;
-  uint16_t maxValue = (1 << PWM_RESOLUTION) - 1;
-  uint16_t savedIrPwm = 0;
-  uint16_t savedWhitePwm = 0;
+// ================================================================
+// TIME SYNC - Clock ping-pong (NTP style)
+// ================================================================
+// Replies [0x39][rx_us u64][tx_us u64] in esp_timer us. rx_us is taken when
+// the command is dispatched, tx_us right before the write - bypassing the TX
+// queue (after draining it) so the stamp is not delayed by queued responses.
+// The host estimates offset = ((rx - t1) + (tx - t4)) / 2 and keeps the
+// samples with the smallest round trip.
+void handleTimeSync(const uint8_t *payload) {
+  int64_t rx_us = esp_timer_get_time();
+  drainTxQueue();
+
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_TIME_SYNC);
+  response.put_u64_be((uint64_t)rx_us);
+  response.seq = commandFrameSeq;
+  response.put_u64_be((uint64_t)esp_timer_get_time());
+  writeResponse(response);
+}
 
-  // Turn off LEDs for sensor reading
-  if (irWasOn || whiteWasOn) {
-    savedIrPwm = map(LED_POWER_PERCENT_IR, 0, 100, 0, maxValue);
-    savedWhitePwm = map(LED_POWER_PERCENT_WHITE, 0, 100, 0, maxValue);
-    ledcWrite(PWM_CHANNEL_IR, 0);
-    ledcWrite(PWM_CHANNEL_WHITE, 0);
-    delay(50);
+// ================================================================
+// GET CAPABILITIES - 1 byte [requested protocol]
+// ================================================================
+// Replies [0x3A][active protocol][max protocol][fw major][fw minor]
+// [max frame payload][features u32 big-endian][board (0=ESP32, 1=S3)] in the
+// protocol that was active when the command arrived, then switches.
+// Firmware before v3 answers 0xFF, so hosts probe with the legacy form.
+void handleGetCapabilities(const uint8_t *payload) {
+  uint8_t requested = payload[0];
+  if (requested != PROTOCOL_QUERY && requested != PROTOCOL_LEGACY &&
+      requested != PROTOCOL_FRAMED) {
+    sendStatus(RESPONSE_ERROR);
+    return;
   }
+  // The network link is framed for good; only the serial protocol switches
+  bool serial = commandLink == LINK_SERIAL;
+  uint8_t active = !serial ? PROTOCOL_FRAMED
+                 : requested == PROTOCOL_QUERY ? (protocolFramed ? PROTOCOL_FRAMED : PROTOCOL_LEGACY)
+                                               : requested;
+
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_CAPABILITIES);
+  response.put_u8(active);
+  response.put_u8(PROTOCOL_FRAMED);
+  response.put_u8(FIRMWARE_VERSION_MAJOR);
+  response.put_u8(FIRMWARE_VERSION_MINOR);
+  response.put_u8(FRAME_MAX_PAYLOAD);
+  response.put_u32_be(FIRMWARE_FEATURES);
+  response.put_u8(Board::id);
+  queueResponse(response);
+  drainTxQueue();  // Reply goes out in the old protocol
+  if (!serial) return;
+
+  protocolFramed = active == PROTOCOL_FRAMED;
+  command_parser_reset(commandParser);
+  if (!protocolFramed) stopTelemetry();
+
+  // Legacy hosts cannot recover the bytes lost to a light-sleep wake-up
+  if (!protocolFramed && power_mode_get() == POWER_MODE_LIGHT_SLEEP) {
+    power_mode_set(POWER_MODE_DFS);
+  }
+}
 
-  // Read sensor (retry up to 3 times)
-  float h = NAN, t = NAN;
-  for (int attempt = 0; attempt < 3; attempt++) {
-    h = dht.readHumidity();
-    t = dht.readTemperature();
+// ================================================================
+// SET BAUD - 4 bytes (uint32_t, big-endian)
+// ================================================================
+// Echo is sent at the old rate, then the UART switches. The host must send
+// CMD_BAUD_CONFIRM at the new rate within BAUD_CONFIRM_TIMEOUT_MS, otherwise
+// the firmware falls back to the previous rate.
+void handleSetBaud(const uint8_t *payload) {
+  uint32_t baud = ((uint32_t)payload[0] << 24) | ((uint32_t)payload[1] << 16) |
+                  ((uint32_t)payload[2] << 8) | payload[3];
+
+  bool supported = false;
+  for (uint8_t i = 0; i < sizeof(SUPPORTED_BAUD_RATES) / sizeof(SUPPORTED_BAUD_RATES[0]); i++) {
+    if (SUPPORTED_BAUD_RATES[i] == baud) supported = true;
+  }
 
-    if (!isnan(h) && !isnan(t) &&
-        h >= 0.0 && h <= 100.0 &&
-        t >= -40.0 && t <= 85.0) {
-      break;
-    }
+  // A sync response or queued capture must not straddle the rate switch.
+  // Commands over the network have no UART rate to change.
+  if (!supported || baud > SERIAL_MAX_BAUD_RATE || !rtIdle() || commandLink != LINK_SERIAL) {
+    debugPrintln("Baud rate rejected");
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_BAUD_SET);
+  response.put_u32_be(baud);
+  queueResponse(response);
+  drainTxQueue();  // Echo goes out at the old rate
+
+  previousBaud = serialBaud;
+  applySerialBaud(baud);
+  baudConfirmPending = true;
+  baudSwitchTime = millis();
+  command_parser_reset(commandParser);
+  frame_decoder_reset(frameDecoder);
+}
+
+// ================================================================
+// UNKNOWN COMMAND / INCOMPLETE PAYLOAD
+// ================================================================
+void handleUnknownCommand(uint8_t cmd) {
+  logEvent(EVENT_ERROR, EVENT_ERROR_UNKNOWN_COMMAND, cmd, 0);
+  debugPrint("Unknown cmd: 0x");
+  debugPrintln(cmd);
+  sendStatus(RESPONSE_ERROR);
+}
+
+void handlePayloadTimeout(uint8_t cmd) {
+  logEvent(EVENT_ERROR, EVENT_ERROR_PAYLOAD_TIMEOUT, cmd, 0);
+  debugPrint("Timeout waiting for payload of cmd: 0x");
+  debugPrintln(cmd);
+  sendStatus(RESPONSE_ERROR);
+}
+
+const CommandSpec COMMAND_TABLE[] = {
+  // cmd                    payload  timeout_ms  handler
+  { CMD_LED_ON,             0,       0,          handleLedOn },
+  { CMD_LED_OFF,            0,       0,          handleLedOff },
+  { CMD_STATUS,             0,       0,          handleStatus },
+  { CMD_SYNC_CAPTURE,       0,       0,          handleSyncCapture },
+  { CMD_SYNC_CAPTURE_QUEUED,7,      500,        handleSyncCaptureQueued },
+  { CMD_QUEUE_CLEAR,        0,       0,          handleQueueClear },
+  { CMD_SET_LED_POWER,      1,       500,        handleSetLedPower },
+  { CMD_SET_TIMING,         4,       1000,       handleSetTiming },
+  { CMD_SET_CAMERA_TYPE,    1,       500,        handleSetCameraType },
+  { CMD_SET_BAUD,           4,       1000,       handleSetBaud },
+  { CMD_SET_TRIGGER,        3,       500,        handleSetTrigger },
+  { CMD_SET_POWER_MODE,     1,       500,        handleSetPowerMode },
+  { CMD_GET_CONFIG,         0,       0,          handleGetConfig },
+  { CMD_SET_SYNC_FORMAT,    1,       500,        handleSetSyncFormat },
+  { CMD_SET_SENSOR_POLICY,  5,       500,        handleSetSensorPolicy },
+  { CMD_SET_IR_POWER,       1,       500,        handleSetIrPower },
+  { CMD_SET_WHITE_POWER,    1,       500,        handleSetWhitePower },
+  { CMD_SET_DUTY_CURVE,     24,      500,        handleSetDutyCurve },
+  { CMD_SET_CHANNEL_MASK,   2,       500,        handleSetChannelMask },
+  { CMD_SET_CHANNEL_POWER,  2,       500,        handleSetChannelPower },
+  { CMD_RAMP_CHANNEL,       6,       500,        handleRampChannel },
+  { CMD_CALIBRATE_SETTLE,   2,       500,        handleCalibrateSettle },
+  { CMD_GET_CHANNELS,       0,       0,          handleGetChannels },
+  { CMD_SYNC_CAPTURE_DUAL,  0,       0,          handleSyncCaptureDual },
+  { CMD_SET_SYNC_ROLE,      2,       500,        handleSetSyncRole },
+  { CMD_SELECT_LED_IR,      0,       0,          handleSelectLedIr },
+  { CMD_SELECT_LED_WHITE,   0,       0,          handleSelectLedWhite },
+  { CMD_LED_DUAL_OFF,       0,       0,          handleLedDualOff },
+  { CMD_GET_LED_STATUS,     0,       0,          handleGetLedStatus },
+  { CMD_START_SCHEDULE,     14,      1000,       handleStartSchedule },
+  { CMD_STOP_SCHEDULE,      0,       0,          handleStopSchedule },
+  { CMD_SET_SEQUENCE_STEP,  8,       500,        handleSetSequenceStep },
+  { CMD_RUN_SEQUENCE,       2,       500,        handleRunSequence },
+  { CMD_GET_TIMING_STATS,   1,       500,        handleGetTimingStats },
+  { CMD_TIME_SYNC,          0,       0,          handleTimeSync },
+  { CMD_STREAM_TELEMETRY,   3,       500,        handleStreamTelemetry },
+  { CMD_GET_EVENT_LOG,      6,       500,        handleGetEventLog },
+  { CMD_GET_RESET_INFO,     0,       0,          handleGetResetInfo },
+  { CMD_GET_CAPABILITIES,   1,       500,        handleGetCapabilities },
+};
+const uint8_t COMMAND_TABLE_SIZE = sizeof(COMMAND_TABLE) / sizeof(COMMAND_TABLE[0]);
+
+// ========================================================================
+// HELPER FUNCTIONS
+// ========================================================================
+
+void clearSerialBuffer() {
+  int bytesCleared = 0;
+  while (Serial.available() > 0) {
+    Serial.read();
+    bytesCleared++;
+  }
+  if (bytesCleared > 0) {
+    logEvent(EVENT_BUFFER_CLEAR, 0, 0, bytesCleared);
+    debugPrint("Cleared ");
+    debugPrint(bytesCleared);
+    debugPrintln(" bytes");
+  }
+}
+
+void applySerialBaud(uint32_t baud) {
+  #if !SERIAL_IS_USB_CDC
+    Serial.updateBaudRate(baud);
+  #endif
+  serialBaud = baud;
+}
+
+void serviceBaudConfirm() {
+  while (Serial.available() > 0) {
+    if (Serial.read() == CMD_BAUD_CONFIRM) {
+      // Confirmation echo at the new rate
+      baudConfirmPending = false;
+      ResponseBuilder response;
+      response.put_u8(RESPONSE_BAUD_SET);
+      response.put_u32_be(serialBaud);
+      queueResponse(response);
+      debugPrintln("Baud rate confirmed");
+      return;
+    }
+    // Anything else is line noise from the rate switch
+  }
+
+  if (millis() - baudSwitchTime > BAUD_CONFIRM_TIMEOUT_MS) {
+    applySerialBaud(previousBaud);
+    baudConfirmPending = false;
+    clearSerialBuffer();
+    debugPrintln("Baud rate not confirmed - reverted");
+  }
+}
+
+void sendRawByte(byte b) {
+  ResponseBuilder response;
+  response.put_u8(b);
+  queueResponse(response);
+}
+
+void queueResponse(const ResponseBuilder &response) {
+  // Any task may queue; only commsTask writes to Serial. The frame seq is
+  // that of the command the calling task is serving.
+  ResponseBuilder stamped = response;
+  stamped.seq = xTaskGetCurrentTaskHandle() == rtTaskHandle ? rtFrameSeq : commandFrameSeq;
+  if (xQueueSend(txQueue, &stamped, 0) != pdTRUE) {
+    logEvent(EVENT_ERROR, EVENT_ERROR_TX_DROPPED, response.buf[0], 0);
+    debugPrintln("TX queue full - response dropped");
+    return;
+  }
+  wakeCommsTask();
+}
+
+void wakeCommsTask() {
+  if (commsTaskHandle) xTaskNotifyGive(commsTaskHandle);
+}
+
+// Serial RX callbacks run in the UART / USB event task, not in an ISR
+#if SERIAL_IS_USB_CDC
+void onSerialRxEvent(void *arg, esp_event_base_t base, int32_t id, void *data) {
+  wakeCommsTask();
+}
+#else
+void onSerialReceive() {
+  wakeCommsTask();
+}
+#endif
+
+void drainTxQueue() {
+  ResponseBuilder response;
+  while (xQueueReceive(txQueue, &response, 0) == pdTRUE) {
+    sendResponseTimed(response);
+  }
+}
+
+void sendResponseTimed(const ResponseBuilder &response) {
+  int64_t start_us = esp_timer_get_time();
+  writeResponse(response);
+  recordTiming(TIMING_RESPONSE_SEND, esp_timer_get_time() - start_us);
+}
+
+void writeResponse(const ResponseBuilder &response) {
+  // Response code becomes the frame id, the rest is the payload
+  if (!linkFramed()) {
+    response.send();
+    return;
+  }
+  if (response.overflow || response.len == 0) return;
+  uint8_t frame[FRAME_MAX_SIZE];
+  uint8_t size = frame_encode(frame, response.buf[0], response.seq, &response.buf[1], response.len - 1);
+  if (hostLink == LINK_UDP) {
+    net_transport_send(udpPeer, frame, size);
+  } else {
+    hal_serial_write(frame, size);
+  }
+}
+
+// ========================================================================
+// FRAMED PROTOCOL (v3)
+// ========================================================================
+// In legacy mode a sync byte between commands starts a frame, so a v3 host
+// can negotiate with a framed request too. In framed mode every byte goes
+// to the frame decoder and bytes outside frames are discarded.
+// ========================================================================
+
+void feedSerialByte(uint8_t value) {
+  if (!protocolFramed && frame_decoder_idle(frameDecoder) &&
+      (value != FRAME_SYNC || !command_parser_idle(commandParser))) {
+    command_parser_feed(commandParser, value, millis());
+    return;
+  }
+  frame_decoder_push(frameDecoder, value, millis());
+  pollFrameDecoder(frameDecoder, LINK_SERIAL);
+}
+
+void pollFrameDecoder(FrameDecoder &decoder, HostLink link) {
+  FrameStatus status;
+  while ((status = frame_decoder_next(decoder, millis())) != FRAME_NONE) {
+    // A damaged group frame has nobody to be reported to
+    if (link == LINK_UDP_GROUP && status != FRAME_READY) continue;
+    commandLink = link;
+    if (link != LINK_UDP_GROUP) hostLink = link;
+    switch (status) {
+      case FRAME_READY:         dispatchFrame(decoder); break;
+      case FRAME_ERROR_CRC:     sendFrameError(decoder, FRAME_ERROR_REASON_CRC); break;
+      case FRAME_ERROR_LENGTH:  sendFrameError(decoder, FRAME_ERROR_REASON_LENGTH); break;
+      case FRAME_ERROR_TIMEOUT: sendFrameError(decoder, FRAME_ERROR_REASON_TIMEOUT); break;
+      default: break;
+    }
+  }
+}
+
+void dispatchFrame(const FrameDecoder &decoder) {
+  // Same handlers as the byte parser; the frame length replaces the table's
+  // payload length and timeout
+  commandFrameSeq = decoder.seq;
+  const CommandSpec *spec = command_parser_lookup(commandParser, decoder.id);
+  if (!spec) {
+    handleUnknownCommand(decoder.id);
+  } else if (decoder.len != spec->payload_len) {
+    sendFrameError(decoder, FRAME_ERROR_REASON_LENGTH);
+  } else {
+    logCommand(spec->cmd);
+    spec->handler(decoder.payload);
+  }
+  commandFrameSeq = FRAME_SEQ_EVENT;
+}
+
+void onSerialCommand(uint8_t cmd) {
+  // Byte-parser (legacy) command about to run
+  commandLink = LINK_SERIAL;
+  hostLink    = LINK_SERIAL;
+  logCommand(cmd);
+}
+
+bool linkFramed() {
+  return hostLink == LINK_UDP || protocolFramed;
+}
+
+void serviceNetwork() {
+  // One datagram holds whole frames - a frame never continues in the next
+  NetDatagram datagram;
+  while (net_transport_receive(datagram)) {
+    if (!datagram.multicast) udpPeer = datagram.from;
+    HostLink link = datagram.multicast ? LINK_UDP_GROUP : LINK_UDP;
+    for (uint8_t i = 0; i < datagram.len; i++) {
+      frame_decoder_push(udpDecoder, datagram.data[i], millis());
+      pollFrameDecoder(udpDecoder, link);
+    }
+    frame_decoder_reset(udpDecoder);
+  }
+}
+
+void sendFrameError(const FrameDecoder &decoder, uint8_t reason) {
+  // seq is best effort for damaged frames - the host retries its oldest
+  // unanswered command on a mismatch
+  logEvent(EVENT_ERROR, EVENT_ERROR_FRAME, reason, 0);
+  if (!linkFramed()) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+  uint8_t seq = commandFrameSeq;
+  commandFrameSeq = decoder.seq;
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_FRAME_ERROR);
+  response.put_u8(reason);
+  queueResponse(response);
+  commandFrameSeq = seq;
+}
+
+void sendStatus(byte code) {
+  // For simple ACK responses, just send the byte
+  sendRawByte(code);
+}
+
+void sendStatusWithSensorData(byte code, float temp, float hum, uint32_t age_ms) {
+  // [code][temp x10 i16][hum x10 u16] (5 bytes), with SENSOR_POLICY_STATUS_AGE
+  // + [age u16] in 100 ms units, 0xFFFF = no valid reading yet (7 bytes)
+  ResponseBuilder response;
+  encode_status(response, code, temp, hum);
+  if (statusReportsAge) encode_status_age(response, age_ms);
+  queueResponse(response);
+}
+
+void sendSyncResponseWithDuration(float temp, float hum, uint16_t duration_ms, uint8_t ledType) {
+  // ========================================================================
+  // Send 15-byte response matching Python expectations (esp32_commands.py)
+  // ========================================================================
+  // Byte 0:      0x1B (RESPONSE_SYNC_COMPLETE)
+  // Bytes 1-2:   timing_ms (uint16 big-endian) - total LED-on duration
+  // Bytes 3-6:   temperature (float, little-endian IEEE 754)
+  // Bytes 7-10:  humidity (float, little-endian IEEE 754)
+  // Byte 11:     led_type_used (0=IR, 1=White)
+  // Bytes 12-13: led_duration_ms (uint16 big-endian) - same as timing_ms
+  // Byte 14:     led_power_actual (0-100%)
+  // ========================================================================
+  uint8_t current_power = reportedPower(ledType);
+
+  ResponseBuilder response;
+  encode_sync(response, RESPONSE_SYNC_COMPLETE, temp, hum, duration_ms, ledType, current_power);
+  queueResponse(response);
+
+  debugPrint("Sent 15-byte sync response: temp=");
+  debugPrint((int)temp);
+  debugPrint(", hum=");
+  debugPrint((int)hum);
+  debugPrint(", duration=");
+  debugPrint(duration_ms);
+  debugPrint("ms, LED=");
+  debugPrint(ledType == LED_TYPE_IR ? "IR" : "White");
+  debugPrint(", power=");
+  debugPrint(current_power);
+  debugPrintln("%");
+}
+
+void sendSyncResponseExtended(float temp, float hum, uint16_t duration_ms, uint8_t ledType,
+                              const PulseResult &pulse) {
+  // ========================================================================
+  // 31-byte response (RESPONSE_SYNC_COMPLETE_EXT)
+  // ========================================================================
+  // Bytes 0-14:  same layout as the 15-byte response, header 0x1E
+  // Bytes 15-22: LED-on edge, esp_timer us (uint64 big-endian)
+  // Bytes 23-30: LED-off edge, esp_timer us (uint64 big-endian)
+  // ========================================================================
+  uint8_t current_power = reportedPower(ledType);
+
+  ResponseBuilder response;
+  encode_sync(response, RESPONSE_SYNC_COMPLETE_EXT, temp, hum, duration_ms, ledType, current_power);
+  encode_sync_edges(response, pulse.on_us, pulse.off_us);
+  queueResponse(response);
+}
+
+void sendSyncResponseSettle(float temp, float hum, uint16_t duration_ms, uint8_t ledType,
+                            const PulseResult &pulse, uint16_t stabilization_ms, uint32_t settle_us) {
+  // ========================================================================
+  // 37-byte response (RESPONSE_SYNC_COMPLETE_SETTLE)
+  // ========================================================================
+  // Bytes 0-30:  same layout as the 31-byte response, header 0x1A
+  // Bytes 31-32: stabilization used, LED-on -> exposure ms (uint16 big-endian)
+  // Bytes 33-36: calibrated settle it is based on, us (uint32 big-endian),
+  //              0 = fixed LED_STABILIZATION_MS
+  // ========================================================================
+  uint8_t current_power = reportedPower(ledType);
+
+  ResponseBuilder response;
+  encode_sync(response, RESPONSE_SYNC_COMPLETE_SETTLE, temp, hum, duration_ms, ledType,
+              current_power);
+  encode_sync_edges(response, pulse.on_us, pulse.off_us);
+  encode_sync_settle(response, stabilization_ms, settle_us);
+  queueResponse(response);
+}
+
+void initLedChannels() {
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    LedChannel &led = ledChannels[ch];
+    led.ledc_channel = ch;
+    led.power        = 100;
+    led.on           = false;
+    led.duty         = PWM_MAX_DUTY;
+  }
+}
+
+void setLedState(bool state, uint8_t channel) {
+  if (channel >= LED_CHANNEL_COUNT) return;
+  ledChannels[channel].on = state;
+  updateLedOutput(channel);
+  updateLedHold();
+}
+
+void updateLedHold() {
+  // LEDC stops in light sleep - no sleeping while an LED is lit
+  power_hold_set(POWER_HOLD_LED, anyLedOn());
+}
+
+void setCurrentLedState(bool state) {
+  setLedState(state, currentLedType);
+}
+
+void updateLedOutput(uint8_t channel) {
+  // Replaces a running hardware fade, so the ramp ends here too
+  const LedChannel &led = ledChannels[channel];
+  portENTER_CRITICAL(&rampMux);
+  ledRamps[channel].active = false;
+  portEXIT_CRITICAL(&rampMux);
+  led_channel_write(led.ledc_channel, led.on ? led.duty : 0);
+}
+
+bool anyLedOn() {
+  return ledOnMask() != 0;
+}
+
+uint8_t ledOnMask() {
+  uint8_t mask = 0;
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    if (ledChannels[ch].on) mask |= 1 << ch;
+  }
+  return mask;
+}
+
+void applyChannelMask(uint8_t mask) {
+  // Channels the pulse side owns keep their output; callers refuse a mask
+  // that would switch one of them
+  uint8_t owned = rtChannelMask();
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    if ((owned >> ch) & 1) continue;
+    ledChannels[ch].on = (mask >> ch) & 1;
+    updateLedOutput(ch);
+  }
+  updateLedHold();
+}
+
+uint16_t ledPwmValue(uint8_t channel) {
+  return ledChannels[channel].duty;
+}
+
+uint16_t powerToDuty(uint8_t channel, uint8_t power) {
+  return duty_lut_get(ledChannels[channel].lut, power);
+}
+
+void updateLedDuty(uint8_t channel) {
+  // Called whenever the power or the curve changes
+  LedChannel &led = ledChannels[channel];
+  led.duty = duty_lut_get(led.lut, led.power);
+}
+
+void setPulseChannels(PulseRequest &pulse, uint8_t mask, int power) {
+  // power < 0: each channel's own power, otherwise one power for all
+  pulse.channel_count = 0;
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    if (!((mask >> ch) & 1)) continue;
+    if (ledRamps[ch].active) updateLedOutput(ch);  // The pulse takes the channel over
+    pulse.channels[pulse.channel_count] = ledChannels[ch].ledc_channel;
+    pulse.duty[pulse.channel_count++]   = power < 0 ? ledChannels[ch].duty : powerToDuty(ch, power);
+  }
+}
+
+uint8_t reportedPower(uint8_t ledType) {
+  // Power byte of the capture responses: the first channel of a custom mask
+  if (ledType == LED_TYPE_CHANNELS) {
+    return syncMask ? ledChannels[__builtin_ctz(syncMask)].power : 0;
+  }
+  return ledChannels[ledType].power;
+}
+
+void loadDutyCurves() {
+  Preferences prefs;
+  bool stored = prefs.begin(DUTY_CURVE_NVS_NAMESPACE, true);  // Fails until a curve was saved
+
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    uint16_t points[DUTY_CURVE_POINTS];
+    if (!stored ||
+        prefs.getBytes(DUTY_CURVE_NVS_KEYS[ch], points, sizeof(points)) != sizeof(points) ||
+        !duty_curve_valid(points)) {
+      duty_curve_identity(points);
+    }
+    duty_lut_build(ledChannels[ch].lut, points, PWM_MAX_DUTY);
+    updateLedDuty(ch);
+  }
+
+  if (stored) prefs.end();
+}
+
+void loadSettleTables() {
+  Preferences prefs;
+  if (!prefs.begin(SETTLE_NVS_NAMESPACE, true)) return;  // Fails until a channel was calibrated
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    if (prefs.getBytes(DUTY_CURVE_NVS_KEYS[ch], settleUs[ch], sizeof(settleUs[ch])) !=
+        sizeof(settleUs[ch])) {
+      memset(settleUs[ch], 0, sizeof(settleUs[ch]));
+    }
+  }
+  settleAdaptive = prefs.getBool(SETTLE_NVS_KEY_ADAPTIVE, false);
+  prefs.end();
+}
+
+void saveSettleTable(uint8_t channel) {
+  // Also stores the adaptive flag; a cleared table is removed
+  Preferences prefs;
+  prefs.begin(SETTLE_NVS_NAMESPACE, false);
+  bool calibrated = false;
+  for (uint8_t i = 0; i < SETTLE_LEVELS; i++) {
+    if (settleUs[channel][i]) calibrated = true;
+  }
+  if (calibrated) {
+    prefs.putBytes(DUTY_CURVE_NVS_KEYS[channel], settleUs[channel], sizeof(settleUs[channel]));
+  } else {
+    prefs.remove(DUTY_CURVE_NVS_KEYS[channel]);
+  }
+  prefs.putBool(SETTLE_NVS_KEY_ADAPTIVE, settleAdaptive);
+  prefs.end();
+}
+
+uint16_t settledStabilizationMs(uint8_t mask, uint32_t &settle_us) {
+  // Slowest lit channel at the calibrated levels around its power
+  settle_us = 0;
+  if (!settleAdaptive) return LED_STABILIZATION_MS;
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    uint8_t power = ledChannels[ch].power;
+    if (!((mask >> ch) & 1) || power == 0) continue;
+    uint8_t high = (power + 9) / 10 - 1;
+    uint8_t low  = power >= 10 ? power / 10 - 1 : high;
+    for (uint8_t level = low; level <= high; level++) {
+      uint32_t us = settleUs[ch][level];
+      if (us == 0 || us >= SETTLE_NO_SIGNAL) {
+        settle_us = 0;
+        return LED_STABILIZATION_MS;
+      }
+      if (us > settle_us) settle_us = us;
+    }
+  }
+  if (settle_us == 0) return LED_STABILIZATION_MS;  // Nothing lit
+
+  uint32_t ms = ((uint64_t)settle_us * (100 + SETTLE_MARGIN_PERCENT) / 100 + 999) / 1000;
+  return ms < LED_STABILIZATION_MS ? (uint16_t)ms : LED_STABILIZATION_MS;
+}
+
+uint8_t calibrateSettle(uint8_t channel) {
+  // Each level from dark: dark level, LED on, back-to-back reads through
+  // the fast rise, then one read per tick until the window is over
+  const LedChannel &led = ledChannels[channel];
+  uint32_t settle[SETTLE_LEVELS];
+  bool     signal = false;
+  power_hold_set(POWER_HOLD_PULSE, true);  // LEDC and the ADC stop in light sleep
+  updateLedOutput(channel);                // Ends a ramp
+
+  for (uint8_t level = 0; level < SETTLE_LEVELS; level++) {
+    esp_task_wdt_reset();  // ~0.7 s per level
+    led_channel_write(led.ledc_channel, 0);
+    vTaskDelay(pdMS_TO_TICKS(SETTLE_DARK_MS));
+    uint32_t dark = 0;
+    for (uint8_t i = 0; i < SETTLE_DARK_SAMPLES; i++) dark += analogRead(PHOTODIODE_INPUT_PIN);
+    dark /= SETTLE_DARK_SAMPLES;
+
+    uint8_t  power = (level + 1) * 100 / SETTLE_LEVELS;
+    int64_t  on_us = esp_timer_get_time();
+    led_channel_write(led.ledc_channel, powerToDuty(channel, power));
+    uint16_t count = 0;
+    uint32_t t_us  = 0;
+    while (count < SETTLE_MAX_SAMPLES && t_us < SETTLE_WINDOW_MS * 1000UL) {
+      uint16_t value = analogRead(PHOTODIODE_INPUT_PIN);
+      t_us = (uint32_t)(esp_timer_get_time() - on_us);
+      settleSamples[count].t_us  = t_us;
+      settleSamples[count].value = value;
+      if (++count >= SETTLE_BURST_SAMPLES) vTaskDelay(1);
+    }
+
+    settle[level] = settle_detect(settleSamples, count, (uint16_t)dark, SETTLE_PARAMS);
+    if (settle[level] == 0) settle[level] = 1;  // 0 means not calibrated
+    if (settle[level] != SETTLE_NO_SIGNAL) signal = true;
+  }
+
+  updateLedOutput(channel);
+  power_hold_set(POWER_HOLD_PULSE, false);
+  if (!signal) return SETTLE_STATUS_NO_SIGNAL;
+  memcpy(settleUs[channel], settle, sizeof(settle));
+  saveSettleTable(channel);
+  return SETTLE_STATUS_OK;
+}
+
+void runSettleRequest(uint8_t op, uint8_t channel) {
+  uint8_t status = SETTLE_STATUS_OK;
+  if (op > SETTLE_OP_CLEAR || channel >= LED_CHANNEL_COUNT) {
+    status = SETTLE_STATUS_INVALID;
+  } else if (op == SETTLE_OP_CALIBRATE) {
+    if (!Features::photodiode) {
+      status = SETTLE_STATUS_NOT_SUPPORTED;
+    } else if (syncPending || sequencePending || captureQueueCount || scheduleRunning ||
+               pulse_engine_busy() || sync_line_role() != SYNC_ROLE_OFF) {
+      status = SETTLE_STATUS_BUSY;
+    } else {
+      status = calibrateSettle(channel);
+    }
+  } else if (op == SETTLE_OP_ADAPTIVE_ON || op == SETTLE_OP_ADAPTIVE_OFF) {
+    settleAdaptive = op == SETTLE_OP_ADAPTIVE_ON;
+    saveSettleTable(channel);
+  } else if (op == SETTLE_OP_CLEAR) {
+    memset(settleUs[channel], 0, sizeof(settleUs[channel]));
+    saveSettleTable(channel);
+  }
+
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_SETTLE);
+  response.put_u8(status);
+  response.put_u8(settleAdaptive ? SETTLE_FLAG_ADAPTIVE : 0);
+  response.put_u8(channel);
+  for (uint8_t i = 0; i < SETTLE_LEVELS; i++) {
+    response.put_u32_be(channel < LED_CHANNEL_COUNT ? settleUs[channel][i] : 0);
+  }
+  queueResponse(response);
+}
+
+void applyTrigger(PulseRequest &pulse, uint16_t stabilization_ms) {
+  // Exposure starts once the LED has stabilized
+  pulse.trigger_delay_us = (uint32_t)stabilization_ms * 1000UL;
+  pulse.trigger_width_us = triggerEnabled ? triggerWidthUs : 0;
+}
+
+void setChannelPower(uint8_t channel, uint8_t power) {
+  if (power > 100) power = 100;
+  ledChannels[channel].power = power;
+  updateLedDuty(channel);
+  markConfigDirty();
+  // A pulse lighting the channel keeps its duty, the next one uses the new power
+  if (ledChannels[channel].on && !((rtChannelMask() >> channel) & 1)) {
+    updateLedOutput(channel);
+  }
+}
+
+void startRamp(uint8_t channel, uint8_t power, uint32_t duration_ms) {
+  LedChannel &led  = ledChannels[channel];
+  LedRamp    &ramp = ledRamps[channel];
+  int64_t     now  = esp_timer_get_time();
+
+  // From the current output: dark, mid-ramp or the channel's steady power
+  uint16_t from = 0;
+  if (led.on) from = ramp.active ? rampPower(ramp, now) : led.power * 100;
+
+  // A fade-out keeps the power for the next LED on
+  if (power > 0) {
+    led.power = power;
+    updateLedDuty(channel);
+    markConfigDirty();
+  }
+  if (duration_ms == 0) {
+    led.on = power > 0;
+    updateLedOutput(channel);
+    updateLedHold();
+    return;
+  }
+
+  portENTER_CRITICAL(&rampMux);
+  ramp.from           = from;
+  ramp.to             = power * 100;
+  ramp.start_us       = now;
+  ramp.duration_us    = (int64_t)duration_ms * 1000;
+  ramp.segment_end_us = now;  // First segment due at once
+  ramp.duty           = duty_lut_get_fine(led.lut, from);
+  ramp.active         = true;
+  portEXIT_CRITICAL(&rampMux);
+  led.on = true;
+  updateLedHold();
+  serviceRamps();
+}
+
+uint16_t rampPower(const LedRamp &ramp, int64_t now_us) {
+  int64_t elapsed = now_us - ramp.start_us;
+  if (elapsed >= ramp.duration_us) return ramp.to;
+  if (elapsed <= 0) return ramp.from;
+  return ramp.from + (int32_t)(((int64_t)ramp.to - ramp.from) * elapsed / ramp.duration_us);
+}
+
+void serviceRamps() {
+  // commsTask: program the next segment of every ramp whose fade is done
+  int64_t now  = esp_timer_get_time();
+  int64_t next = 0;
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    LedChannel &led  = ledChannels[ch];
+    LedRamp    &ramp = ledRamps[ch];
+    if (!ramp.active || ramp.segment_end_us > now) {
+      if (ramp.active && (next == 0 || ramp.segment_end_us < next)) next = ramp.segment_end_us;
+      continue;
+    }
+
+    int64_t ramp_end = ramp.start_us + ramp.duration_us;
+    if (now >= ramp_end) {
+      // Steady output at the target (full scale exactly, see led_channel_write)
+      if (ramp.to == 0) led.on = false;
+      updateLedOutput(ch);
+      updateLedHold();
+      continue;
+    }
+
+    // A late service only shortens the segment, the ramp keeps its end
+    int64_t  end   = now + (int64_t)RAMP_SEGMENT_MS * 1000;
+    if (end > ramp_end) end = ramp_end;
+    uint16_t duty  = duty_lut_get_fine(led.lut, rampPower(ramp, end));
+    uint32_t steps = duty > ramp.duty ? duty - ramp.duty : ramp.duty - duty;
+    // Slower than one duty step per LED_FADE_MAX_CYCLES periods (~68 ms),
+    // the fade reaches the segment's duty early and holds it for the rest
+    uint64_t cycles = steps ? (uint64_t)(end - now) * PWM_FREQUENCY / 1000000 / steps : 0;
+    if (cycles > LED_FADE_MAX_CYCLES) cycles = LED_FADE_MAX_CYCLES;
+
+    portENTER_CRITICAL(&rampMux);
+    if (ramp.active) {  // Unless a pulse has just taken the channel over
+      if (steps) led_channel_fade(led.ledc_channel, ramp.duty, duty, (uint32_t)cycles);
+      ramp.duty           = duty;
+      ramp.segment_end_us = end;
+    }
+    portEXIT_CRITICAL(&rampMux);
+    if (ramp.active && (next == 0 || end < next)) next = end;
+  }
+
+  esp_timer_stop(rampTimer);
+  if (next) esp_timer_start_once(rampTimer, next > now ? next - now : 1);
+}
+
+// esp_timer task - commsTask programs the segment
+void onRampTimer(void *arg) {
+  rampDue = true;
+  wakeCommsTask();
+}
+
+void selectLed(uint8_t ledType) {
+  // Change LED selection without affecting LED states
+  // This allows switching between IR and White without turning LEDs off
+  currentLedType = ledType;
+  captureMask    = 0;
+  markConfigDirty();
+
+  debugPrint("LED selected: ");
+  debugPrintln(ledType == LED_TYPE_IR ? "IR (Night)" : "White (Day)");
+}
+
+void turnOffAllLeds() {
+  applyChannelMask(0);
+}
+
+// ========================================================================
+// TELEMETRY STREAM
+// ========================================================================
+
+// esp_timer task - commsTask builds and sends the record
+void onTelemetryTimer(void *arg) {
+  telemetryDue = true;
+  wakeCommsTask();
+}
+
+void stopTelemetry() {
+  esp_timer_stop(telemetryTimer);
+  telemetryFields = 0;
+  telemetryDue    = false;
+}
+
+void sendTelemetry() {
+  // A late record is sent once, never as a burst; gaps show in the seq
+  if (telemetryFields == 0) return;
+  TelemetryRecord record = {};
+  record.seq         = telemetrySeq++;
+  record.fields      = telemetryFields;
+  record.led_on_mask = ledOnMask();
+  record.led_type    = currentLedType;
+  record.ir_power    = ledChannels[LED_TYPE_IR].power;
+  record.white_power = ledChannels[LED_TYPE_WHITE].power;
+
+  // Same staleness rule as CMD_STATUS
+  SensorSnapshot snapshot;
+  record.sensor_age_ms = getSensorSnapshot(snapshot);
+  record.temperature   = snapshot.temperature;
+  record.humidity      = snapshot.humidity;
+  if ((telemetryFields & TELEMETRY_FIELD_SENSOR) && record.sensor_age_ms > sensorMaxAgeMs) {
+    xTaskNotifyGive(sensorTaskHandle);
+  }
+
+  portENTER_CRITICAL(&timingMux);
+  record.pulse_count            = timingStats[TIMING_LED_ON_DURATION].count;
+  record.cmd_to_led_on_max_us   = timingStats[TIMING_CMD_TO_LED_ON].max_us;
+  record.led_on_error_max_us    = timingStats[TIMING_LED_ON_ERROR].max_us;
+  record.rt_iteration_max_us    = timingStats[TIMING_RT_ITERATION].max_us;
+  record.comms_iteration_max_us = timingStats[TIMING_COMMS_ITERATION].max_us;
+  portEXIT_CRITICAL(&timingMux);
+  record.uptime_ms = millis() - bootTime;
+
+  ResponseBuilder response;
+  encode_telemetry(response, RESPONSE_TELEMETRY, record);
+  queueResponse(response);
+}
+
+void sendLedStatus() {
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_LED_STATUS);
+  response.put_u8(currentLedType);
+  response.put_u8(ledChannels[LED_TYPE_IR].on ? 1 : 0);
+  response.put_u8(ledChannels[LED_TYPE_WHITE].on ? 1 : 0);
+  response.put_u8(ledChannels[LED_TYPE_IR].power);
+  response.put_u8(ledChannels[LED_TYPE_WHITE].power);
+  queueResponse(response);
+}
+
+void setTiming(uint16_t stabilization_ms, uint16_t exposure_ms) {
+  LED_STABILIZATION_MS = stabilization_ms;
+  EXPOSURE_MS = exposure_ms;
+  markConfigDirty();
+}
+
+// ========================================================================
+// PERSISTENT CONFIG
+// ========================================================================
+
+DeviceConfig currentConfig() {
+  DeviceConfig config;
+  config.stabilization_ms = LED_STABILIZATION_MS;
+  config.exposure_ms      = EXPOSURE_MS;
+  config.ir_power         = ledChannels[LED_TYPE_IR].power;
+  config.white_power      = ledChannels[LED_TYPE_WHITE].power;
+  config.camera_type      = CAMERA_TYPE;
+  config.led_type         = currentLedType;
+  config.trigger_enabled  = triggerEnabled ? 1 : 0;
+  config.trigger_width_us = triggerWidthUs;
+  config.sync_format      = syncResponseFormat;
+  return config;
+}
+
+void applyConfig(const DeviceConfig &config) {
+  // Same limits as the SET handlers - a blob from older firmware must not
+  // put the globals out of range
+  LED_STABILIZATION_MS    = config.stabilization_ms;
+  EXPOSURE_MS             = config.exposure_ms;
+  ledChannels[LED_TYPE_IR].power    = config.ir_power > 100 ? 100 : config.ir_power;
+  ledChannels[LED_TYPE_WHITE].power = config.white_power > 100 ? 100 : config.white_power;
+  CAMERA_TYPE             = config.camera_type;
+  currentLedType          = config.led_type == LED_TYPE_WHITE ? LED_TYPE_WHITE : LED_TYPE_IR;
+  triggerEnabled          = config.trigger_enabled != 0;
+  triggerWidthUs          = config.trigger_width_us < TRIGGER_MIN_WIDTH_US ? TRIGGER_MIN_WIDTH_US
+                                                                          : config.trigger_width_us;
+  syncResponseFormat      = config.sync_format > SYNC_FORMAT_SETTLE ? SYNC_FORMAT_LEGACY
+                                                                    : config.sync_format;
+}
+
+void loadConfig() {
+  Preferences prefs;
+  if (!prefs.begin(CONFIG_NVS_NAMESPACE, true)) return;  // Nothing saved yet
+
+  uint8_t blob[DEVICE_CONFIG_SIZE];
+  size_t len = prefs.getBytes(CONFIG_NVS_KEY, blob, sizeof(blob));
+  prefs.end();
+
+  DeviceConfig config;
+  if (device_config_decode(config, blob, len)) {
+    applyConfig(config);
+    configRestored  = true;
+    configStored    = true;
+    configSavedHash = device_config_hash(blob);
+    debugPrintln("Config restored from NVS");
+  } else {
+    debugPrintln("Stored config invalid - using defaults");
+  }
+}
+
+void markConfigDirty() {
+  configChangedMs = millis();
+  configDirty     = true;
+}
+
+void serviceConfigSave() {
+  if (!configDirty || millis() - configChangedMs < CONFIG_SAVE_DELAY_MS) return;
+  if (pulse_engine_busy() || scheduleFrameImminent()) return;
+  configDirty = false;
+
+  uint8_t blob[DEVICE_CONFIG_SIZE];
+  device_config_encode(currentConfig(), blob);
+  uint16_t hash = device_config_hash(blob);
+  if (configStored && hash == configSavedHash) return;  // Unchanged, spare the flash
+
+  Preferences prefs;
+  if (prefs.begin(CONFIG_NVS_NAMESPACE, false)) {
+    prefs.putBytes(CONFIG_NVS_KEY, blob, sizeof(blob));
+    prefs.end();
+    configStored    = true;
+    configSavedHash = hash;
+  }
+}
+
+// ========================================================================
+// RESUME STATE FUNCTIONS
+// ========================================================================
+
+int64_t systemTimeUs() {
+  // gettimeofday() runs on the RTC timer through warm resets, esp_timer restarts
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+bool loadResumeState(ResumeState &state) {
+  // setup(): newest slot and the RESET_INFO counters, true = resume
+  bool warm = resetReason == ESP_RST_SW || resetReason == ESP_RST_PANIC ||
+              resetReason == ESP_RST_INT_WDT || resetReason == ESP_RST_TASK_WDT ||
+              resetReason == ESP_RST_WDT;
+  int8_t slot = resetReason == ESP_RST_POWERON ? -1 : resume_state_read(resumeSlots, state);
+  if (slot < 0) return false;
+
+  // Snapshots go on behind the newest slot, whatever this boot does
+  resumeNextSlot   = (slot + 1) % RESUME_SLOTS;
+  resumeGeneration = state.generation + 1;
+  if (!warm) return false;
+
+  warmResets       = state.warm_resets + 1;
+  previousUptimeMs = state.uptime_ms;
+  if (!resume_state_usable(state)) {
+    resetInfoFlags |= RESET_INFO_FLAG_REFUSED;
+    return false;
+  }
+
+  // Marked before anything can crash, so a crash within
+  // RESUME_MIN_UPTIME_MS boots cold next time
+  ResumeState marker = state;
+  marker.resumed     = 1;
+  marker.uptime_ms   = 0;
+  marker.warm_resets = warmResets;
+  marker.generation  = resumeGeneration++;
+  resume_state_write(resumeSlots[resumeNextSlot], marker);
+  resumeNextSlot = (resumeNextSlot + 1) % RESUME_SLOTS;
+
+  resetInfoFlags |= RESET_INFO_FLAG_RESUMED;
+  return true;
+}
+
+void saveResumeState() {
+  // commsTask, every pass
+  if (syncPending || sequencePending) return;
+
+  ResumeState state;
+  memset(&state, 0, sizeof(state));  // The CRC covers the padding too
+  state.resumed     = bootResumed;
+  state.generation  = resumeGeneration++;
+  state.warm_resets = warmResets;
+  state.uptime_ms   = millis();
+  device_config_encode(currentConfig(), state.config);
+
+  int64_t now_us = esp_timer_get_time();
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    const LedChannel &led = ledChannels[ch];
+    state.power[ch] = led.power;
+    if (led.on) state.on_mask |= 1 << ch;
+
+    portENTER_CRITICAL(&rampMux);
+    LedRamp ramp = ledRamps[ch];
+    portEXIT_CRITICAL(&rampMux);
+    if (ramp.active) {
+      ResumeRamp &saved    = state.ramps[ch];
+      int64_t remaining_us = ramp.start_us + ramp.duration_us - now_us;
+      saved.active       = 1;
+      saved.power        = rampPower(ramp, now_us);
+      saved.to           = ramp.to;
+      saved.remaining_ms = remaining_us > 0 ? (uint32_t)(remaining_us / 1000) : 0;
+    }
+  }
+  state.capture_mask        = captureMask;
+  state.framed              = protocolFramed;
+  state.power_mode          = power_mode_get();
+  state.sync_role           = sync_line_role();
+  state.sync_dual           = lineDual;
+  state.sensor_flags        = statusReportsAge ? SENSOR_POLICY_STATUS_AGE : 0;
+  state.sensor_max_age_ms   = sensorMaxAgeMs;
+  state.telemetry_fields    = telemetryFields;
+  state.telemetry_period_ms = telemetryPeriodMs;
+  state.baud                = baudConfirmPending ? previousBaud : serialBaud;
+
+  // The timer callback advances the frame under scheduleMux
+  portENTER_CRITICAL(&scheduleMux);
+  bool     active = scheduleActive;
+  uint32_t next   = scheduleNextFrame;
+  portEXIT_CRITICAL(&scheduleMux);
+  if (active) {
+    ResumeSchedule &saved = state.schedule;
+    int64_t deadline_us = schedule.start_us + (int64_t)next * schedule.interval_us;
+    saved.running            = 1;
+    saved.led_type           = schedule.led_type;
+    saved.power              = schedule.power;
+    saved.stabilization_ms   = schedule.stabilization_ms;
+    saved.exposure_ms        = schedule.exposure_ms;
+    saved.frame_count        = schedule.frame_count;
+    saved.next_frame         = next;
+    saved.frames_done        = scheduleFramesDone;
+    saved.interval_us        = schedule.interval_us;
+    saved.next_frame_wall_us = systemTimeUs() + (deadline_us - esp_timer_get_time());
+  }
+
+  resume_state_write(resumeSlots[resumeNextSlot], state);
+  resumeNextSlot = (resumeNextSlot + 1) % RESUME_SLOTS;
+}
+
+void resumeSettings(const ResumeState &state) {
+  // Before the duty LUTs are built. The snapshot's config may be newer
+  // than the delayed NVS save.
+  DeviceConfig config;
+  if (device_config_decode(config, state.config, DEVICE_CONFIG_SIZE)) {
+    applyConfig(config);
+    markConfigDirty();  // Saved unless NVS has it already
+  }
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    ledChannels[ch].power = state.power[ch] > 100 ? 100 : state.power[ch];
+  }
+  captureMask      = state.capture_mask & ((1 << LED_CHANNEL_COUNT) - 1);
+  protocolFramed   = state.framed != 0;
+  lineDual         = state.sync_dual != 0;
+  statusReportsAge = state.sensor_flags & SENSOR_POLICY_STATUS_AGE;
+  if (state.sensor_max_age_ms >= SENSOR_SAMPLE_INTERVAL_MS) sensorMaxAgeMs = state.sensor_max_age_ms;
+}
+
+void resumeOutputs(const ResumeState &state) {
+  // Once LEDC and the timers are set up: steady outputs, ramps from the
+  // level they had reached, telemetry and power mode
+  int64_t now = esp_timer_get_time();
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    LedChannel       &led   = ledChannels[ch];
+    const ResumeRamp &saved = state.ramps[ch];
+    led.on = (state.on_mask >> ch) & 1;
+    if (!led.on || !saved.active) {
+      updateLedOutput(ch);
+      continue;
+    }
+
+    LedRamp &ramp = ledRamps[ch];
+    ramp.from           = saved.power;
+    ramp.to             = saved.to;
+    ramp.start_us       = now;
+    ramp.duration_us    = (int64_t)saved.remaining_ms * 1000;
+    ramp.segment_end_us = now;  // First segment due at once
+    ramp.duty           = duty_lut_get_fine(led.lut, saved.power);
+    ramp.active         = true;
+    led_channel_write(led.ledc_channel, ramp.duty);
+  }
+  updateLedHold();
+  serviceRamps();
+
+  if (protocolFramed && state.telemetry_fields != 0 &&
+      state.telemetry_period_ms >= TELEMETRY_MIN_PERIOD_MS) {
+    telemetryFields   = state.telemetry_fields & TELEMETRY_FIELDS_ALL;
+    telemetryPeriodMs = state.telemetry_period_ms;
+    esp_timer_start_periodic(telemetryTimer, (uint64_t)telemetryPeriodMs * 1000);
+  }
+  if (state.power_mode != power_mode_get()) power_mode_set((PowerMode)state.power_mode);
+}
+
+void resumeTasks(const ResumeState &state) {
+  // Once rtTask runs: sync role, the schedule, then the RESET_INFO event
+  if (Features::sync_line && state.sync_role != SYNC_ROLE_OFF &&
+      state.sync_role <= SYNC_ROLE_SLAVE) {
+    sync_line_set_role((SyncRole)state.sync_role);
+    xTaskNotifyGive(rtTaskHandle);
+  }
+
+  // Deadlines that passed during the reset are skipped, the others keep
+  // their index and time
+  const ResumeSchedule &saved = state.schedule;
+  if (saved.running && saved.interval_us > 0) {
+    int64_t  late_us = systemTimeUs() - saved.next_frame_wall_us;
+    uint32_t first   = saved.next_frame;
+    if (late_us > 0) first += (uint32_t)(late_us / saved.interval_us) + 1;
+
+    if (saved.frame_count == 0 || first < saved.frame_count) {
+      RtRequest request;
+      request.type = RT_RESUME_SCHEDULE;
+      AcquisitionSchedule &resumed = request.schedule;
+      resumed.interval_us      = saved.interval_us;
+      resumed.frame_count      = saved.frame_count;
+      resumed.led_type         = saved.led_type;
+      resumed.power            = saved.power;
+      resumed.stabilization_ms = saved.stabilization_ms;
+      resumed.exposure_ms      = saved.exposure_ms;
+      // Frame 0 of the old grid on this boot's esp_timer clock
+      resumed.start_us    = esp_timer_get_time() - late_us -
+                            (int64_t)saved.next_frame * saved.interval_us;
+      request.first_frame = first;
+      request.frames_done = saved.frames_done;
+      postRtRequest(request);
+      resumeFrame     = first;
+      resetInfoFlags |= RESET_INFO_FLAG_SCHEDULE;
+    }
+  }
+
+  logEvent(EVENT_RESUME, resetInfoFlags, 0, resumeFrame);
+  if (protocolFramed) sendResetInfo();  // Legacy hosts ask with CMD_GET_RESET_INFO
+}
+
+void sendResetInfo() {
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_RESET_INFO);
+  response.put_u8(resetReason);
+  response.put_u8(resetInfoFlags);
+  response.put_u32_be(warmResets);
+  response.put_u32_be(previousUptimeMs);
+  response.put_u32_be(resumeFrame);
+  response.put_u32_be(millis());
+  queueResponse(response);
+}
+
+// ========================================================================
+// SYNC CAPTURE FUNCTIONS
+// ========================================================================
+
+// Sync captures run on the pulse engine: startSyncPulse() switches the LED
+// on and returns, the timer ISR switches it off, and loop() completes the
+// capture via finishSyncCapture() once the result arrives on the queue.
+bool startSyncPulse(bool dual, int64_t received_us) {
+  if (scheduleRunning) {
+    debugPrintln("Sync capture rejected: schedule running");
+    return false;
+  }
+  if (syncPending || sequencePending || pulse_engine_busy()) {
+    debugPrintln("Sync capture rejected: pulse already running");
+    return false;
+  }
+
+  PulseRequest pulse;
+  uint32_t settle_us;
+  uint8_t mask = buildSyncPulse(dual, PULSE_SOURCE_SYNC, pulse, settle_us);
+
+  if (sync_line_role() == SYNC_ROLE_MASTER) {
+    // Every board on the line, this one included, starts on the same edge.
+    // A late edge may still have started the pulse after the wait gave up.
+    bool started = pulse_engine_arm(pulse) && sync_line_trigger();
+    pulse_engine_disarm();
+    if (!started && !pulse_engine_busy()) {
+      logEvent(EVENT_ERROR, EVENT_ERROR_SYNC_NO_EDGE, 0, 0);
+      debugPrintln("Sync capture rejected: no edge on the sync line");
+      return false;
+    }
+  } else {
+    pulse_engine_start(pulse);
+  }
+
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    if ((mask >> ch) & 1) ledChannels[ch].on = true;
+  }
+
+  power_hold_set(POWER_HOLD_PULSE, true);
+  syncPending = true;
+  syncDual    = dual;
+  syncMask    = mask;
+  syncLedType = (!dual && captureMask) ? LED_TYPE_CHANNELS : currentLedType;
+  syncQueued  = false;
+  syncReceivedUs = received_us;
+  syncRequestedUs = pulse.duration_us;
+  syncStabilizationMs = pulse.trigger_delay_us / 1000;
+  syncSettleUs = settle_us;
+  syncFrameSeq = rtFrameSeq;
+  return true;
+}
+
+uint8_t buildSyncPulse(bool dual, uint8_t source, PulseRequest &pulse, uint32_t &settle_us) {
+  // Dual = IR + white together, otherwise the selected LED or the
+  // CMD_SET_CHANNEL_MASK capture set. Returns the channel mask.
+  uint8_t mask = dual ? ledTypeMask(QUEUE_LED_TYPE_DUAL)
+                      : (captureMask ? captureMask : 1 << currentLedType);
+
+  // Total LED-on time = stabilization + EXPOSURE_MS, the stabilization
+  // is LED_STABILIZATION_MS or less with adaptive settle (settle_us != 0)
+  uint16_t stabilization_ms = settledStabilizationMs(mask, settle_us);
+  pulse.duration_us = ((uint32_t)stabilization_ms + EXPOSURE_MS) * 1000UL;
+  pulse.source      = source;
+  pulse.tag         = 0;
+  applyTrigger(pulse, stabilization_ms);
+  setPulseChannels(pulse, mask, -1);
+  return mask;
+}
+
+void performSyncCapture(int64_t received_us) {
+  debugPrintln("=== SYNC_CAPTURE START ===");
+  debugPrint("LED type: ");
+  debugPrintln(currentLedType == LED_TYPE_IR ? "IR" : "White");
+
+  if (!startSyncPulse(false, received_us)) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+
+  // Send ACK immediately so Python knows LED is on
+  sendRawByte(RESPONSE_LED_ON_ACK);
+}
+
+void performSyncCaptureDual(int64_t received_us) {
+  debugPrintln("=== SYNC_CAPTURE_DUAL START ===");
+  debugPrintln("Both LEDs: IR + White");
+
+  if (!startSyncPulse(true, received_us)) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+
+  // Send ACK immediately so Python knows LEDs are on
+  sendRawByte(RESPONSE_LED_ON_ACK);
+}
+
+void finishSyncCapture(const PulseResult &pulse) {
+  // The LED-off edge already happened in the timer ISR - sync the state flags
+  syncPending = false;
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    if ((syncMask >> ch) & 1) ledChannels[ch].on = false;
+  }
+  updateLedHold();
+
+  uint32_t actualDurationUs = (uint32_t)(pulse.off_us - pulse.on_us);
+  uint16_t actualDuration = (uint16_t)((actualDurationUs + 500) / 1000);
+
+  if (syncReceivedUs != 0) recordTiming(TIMING_CMD_TO_LED_ON, pulse.on_us - syncReceivedUs);
+  recordTiming(TIMING_LED_ON_DURATION, actualDurationUs);
+  recordTiming(TIMING_LED_ON_ERROR, llabs((int64_t)actualDurationUs - (int64_t)syncRequestedUs));
+
+  // Latest background sensor reading (constant-time copy, no DHT access)
+  SensorSnapshot snapshot;
+  uint32_t sensorAge = getSensorSnapshot(snapshot);
+  rtFrameSeq = syncFrameSeq;
+
+  if (syncQueued) {
+    // Sequence-tagged completion record for the capture queue
+    sendQueuedCaptureRecord(syncSeq, syncFlags, pulse, snapshot);
+  } else if (syncResponseFormat == SYNC_FORMAT_SETTLE) {
+    // 37 bytes: 31-byte layout + stabilization used and its calibrated settle
+    sendSyncResponseSettle(snapshot.temperature, snapshot.humidity, actualDuration, syncLedType, pulse,
+                           syncStabilizationMs, syncSettleUs);
+  } else if (syncResponseFormat == SYNC_FORMAT_EXTENDED) {
+    // Send 31-byte sync complete response with 64-bit edge times
+    sendSyncResponseExtended(snapshot.temperature, snapshot.humidity, actualDuration, syncLedType, pulse);
+  } else {
+    // Send 15-byte sync complete response
+    sendSyncResponseWithDuration(snapshot.temperature, snapshot.humidity, actualDuration, syncLedType);
+  }
+
+  debugPrint(syncDual ? "=== SYNC_CAPTURE_DUAL COMPLETE: " : "=== SYNC_CAPTURE COMPLETE: ");
+  debugPrint((int)actualDurationUs);
+  debugPrint("us, sensor age ");
+  debugPrint((int)sensorAge);
+  debugPrintln("ms ===");
+}
+
+// ========================================================================
+// SYNC LINE (slave side)
+// ========================================================================
+
+bool samePulse(const PulseRequest &a, const PulseRequest &b) {
+  if (a.channel_count != b.channel_count || a.duration_us != b.duration_us ||
+      a.trigger_delay_us != b.trigger_delay_us || a.trigger_width_us != b.trigger_width_us) {
+    return false;
+  }
+  for (uint8_t i = 0; i < a.channel_count; i++) {
+    if (a.channels[i] != b.channels[i] || a.duty[i] != b.duty[i]) return false;
+  }
+  return true;
+}
+
+void serviceSyncLine() {
+  uint32_t missed = sync_line_missed();
+  if (missed != lineMissedLogged) {
+    lineMissedLogged = missed;
+    logEvent(EVENT_ERROR, EVENT_ERROR_SYNC_MISSED, 0, missed);
+  }
+
+  // Local captures, schedules, sequences and a manually lit LED win over
+  // the line; the slave re-arms once they are done
+  bool ready = sync_line_role() == SYNC_ROLE_SLAVE && !syncPending && !sequencePending &&
+               !scheduleRunning && captureQueueCount == 0 && !pulse_engine_busy() && !anyLedOn();
+  if (!ready) {
+    pulse_engine_disarm();
+    return;
+  }
+
+  // Re-arming opens a short window in which an edge is missed, so only
+  // when the settings have changed
+  PulseRequest pulse;
+  uint32_t settle_us;
+  buildSyncPulse(lineDual, PULSE_SOURCE_LINE, pulse, settle_us);
+  if (pulse_engine_armed() && samePulse(pulse, linePulse)) return;
+  if (pulse_engine_arm(pulse)) {
+    linePulse   = pulse;
+    lineSettleUs = settle_us;
+    lineLedType = (!lineDual && captureMask) ? LED_TYPE_CHANNELS : currentLedType;
+  }
+}
+
+void finishLinePulse(const PulseResult &pulse) {
+  // Edge-started slave capture: reported like a sync capture, as an event
+  uint32_t actualDurationUs = (uint32_t)(pulse.off_us - pulse.on_us);
+  uint16_t actualDuration = (uint16_t)((actualDurationUs + 500) / 1000);
+  recordTiming(TIMING_LED_ON_DURATION, actualDurationUs);
+  recordTiming(TIMING_LED_ON_ERROR, llabs((int64_t)actualDurationUs - (int64_t)linePulse.duration_us));
+
+  SensorSnapshot snapshot;
+  getSensorSnapshot(snapshot);
+  rtFrameSeq = FRAME_SEQ_EVENT;
+  if (syncResponseFormat == SYNC_FORMAT_SETTLE) {
+    sendSyncResponseSettle(snapshot.temperature, snapshot.humidity, actualDuration, lineLedType,
+                           pulse, linePulse.trigger_delay_us / 1000, lineSettleUs);
+  } else if (syncResponseFormat == SYNC_FORMAT_EXTENDED) {
+    sendSyncResponseExtended(snapshot.temperature, snapshot.humidity, actualDuration, lineLedType,
+                             pulse);
+  } else {
+    sendSyncResponseWithDuration(snapshot.temperature, snapshot.humidity, actualDuration,
+                                 lineLedType);
+  }
+}
+
+// ========================================================================
+// CAPTURE QUEUE
+// ========================================================================
+// CMD_SYNC_CAPTURE_QUEUED appends a request (sequence number, flags,
+// optional start time) to a ring buffer. loop() starts the next request as
+// soon as the pulse engine is idle and its start time has been reached, so
+// captures run back-to-back while the host is still sending more requests.
+// ========================================================================
+
+bool captureQueuePush(const QueuedCapture &capture) {
+  if (captureQueueCount >= CAPTURE_QUEUE_SIZE) return false;
+  uint8_t tail = (captureQueueHead + captureQueueCount) % CAPTURE_QUEUE_SIZE;
+  captureQueue[tail] = capture;
+  captureQueueCount++;
+  return true;
+}
+
+void captureQueueClear() {
+  captureQueueHead = 0;
+  captureQueueCount = 0;
+}
+
+void enqueueCapture(const QueuedCapture &capture) {
+  // A running schedule owns the pulse engine - nothing queued could start
+  bool queued = !scheduleRunning && captureQueuePush(capture);
+
+  ResponseBuilder response;
+  if (!queued && !scheduleRunning) logEvent(EVENT_ERROR, EVENT_ERROR_QUEUE_FULL, capture.seq, 0);
+  response.put_u8(queued ? RESPONSE_QUEUE_ACK : RESPONSE_QUEUE_FULL);
+  response.put_u16_be(capture.seq);
+  if (queued) response.put_u8(CAPTURE_QUEUE_SIZE - captureQueueCount);
+  queueResponse(response);
+}
+
+int32_t serviceCaptureQueue() {
+  // Returns the us until the head entry may start, -1 if rtTask can sleep
+  // until the next notification (queue empty or a pulse still running)
+  if (captureQueueCount == 0 || syncPending || sequencePending || pulse_engine_busy()) return -1;
+
+  const QueuedCapture &next = captureQueue[captureQueueHead];
+  uint8_t status = 0;
+  if (next.flags & QUEUE_FLAG_TIMED) {
+    // Signed difference handles the 32-bit wrap (~71 min) of the start time
+    int32_t wait_us = (int32_t)(next.start_us - (uint32_t)esp_timer_get_time());
+    if (wait_us > RT_SPIN_THRESHOLD_US) return wait_us;
+    while (wait_us > 0) {
+      wait_us = (int32_t)(next.start_us - (uint32_t)esp_timer_get_time());
+    }
+    if (wait_us < -(int32_t)QUEUE_LATE_TOLERANCE_US) {
+      status |= QUEUE_STATUS_LATE;
+      logEvent(EVENT_ERROR, EVENT_ERROR_LATE_CAPTURE, next.seq, -wait_us);
+    }
+  }
+
+  bool     dual    = next.flags & QUEUE_FLAG_DUAL;
+  uint16_t seq     = next.seq;
+  bool     started = startSyncPulse(dual, 0);
+  captureQueueHead = (captureQueueHead + 1) % CAPTURE_QUEUE_SIZE;
+  captureQueueCount--;
+
+  if (!started) {
+    // Engine idle, so a schedule or a missing sync edge refused it: answer
+    // the seq as skipped rather than retrying the head on every wake
+    PulseResult none = {};
+    SensorSnapshot snapshot;
+    getSensorSnapshot(snapshot);
+    syncDual    = dual;
+    syncLedType = (!dual && captureMask) ? LED_TYPE_CHANNELS : currentLedType;
+    sendQueuedCaptureRecord(seq, status | QUEUE_STATUS_SKIPPED, none, snapshot);
+    return 0;  // Next entry right away
+  }
+  syncQueued = true;
+  syncSeq    = seq;
+  syncFlags  = status;
+  return -1;
+}
+
+void sendQueuedCaptureRecord(uint16_t seq, uint8_t status, const PulseResult &pulse,
+                             const SensorSnapshot &snapshot) {
+  // ========================================================================
+  // 22-byte completion record (RESPONSE_QUEUED_COMPLETE)
+  // ========================================================================
+  // Byte 0:      0x1C
+  // Bytes 1-2:   sequence number (uint16 big-endian)
+  // Bytes 3-6:   LED-on time, esp_timer us (uint32 big-endian, wraps)
+  // Bytes 7-10:  LED-on duration in us (uint32 big-endian)
+  // Bytes 11-14: temperature (float, little-endian IEEE 754)
+  // Bytes 15-18: humidity (float, little-endian IEEE 754)
+  // Byte 19:     led_type_used (0=IR, 1=White, 2=Dual)
+  // Byte 20:     led_power_actual (0-100%)
+  // Byte 21:     status flags (bit0 = started late, bit1 = skipped)
+  // ========================================================================
+  uint8_t power = reportedPower(syncLedType);
+
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_QUEUED_COMPLETE);
+  response.put_u16_be(seq);
+  response.put_u32_be((uint32_t)pulse.on_us);
+  response.put_u32_be((uint32_t)(pulse.off_us - pulse.on_us));
+  response.put_f32_le(snapshot.temperature);
+  response.put_f32_le(snapshot.humidity);
+  response.put_u8(syncDual ? QUEUE_LED_TYPE_DUAL : syncLedType);
+  response.put_u8(power);
+  response.put_u8(status);
+  queueResponse(response);
+}
+
+// ========================================================================
+// ILLUMINATION SEQUENCE
+// ========================================================================
+// All steps go to the pulse engine at once. Step transitions run in the
+// timer ISR, so a whole IR / white interleave costs one command and one
+// completion record instead of a SELECT + SYNC round trip per frame.
+// ========================================================================
+
+void setSequenceStep(uint8_t index, const SequenceStep &step) {
+  if (sequencePending || index > sequenceLength || index >= PULSE_MAX_STEPS) {
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+  sequenceSteps[index] = step;
+  sequenceLength       = index + 1;
+  sendStatus(RESPONSE_LED_ON_ACK);
+}
+
+void runSequence(uint16_t seq, int64_t received_us) {
+  if (sequenceLength == 0 || scheduleRunning || syncPending || sequencePending ||
+      pulse_engine_busy()) {
+    debugPrintln("Sequence rejected");
+    sendStatus(RESPONSE_ERROR);
+    return;
+  }
+
+  uint8_t mask = 0;
+  for (uint8_t s = 0; s < sequenceLength; s++) {
+    const SequenceStep &step = sequenceSteps[s];
+    PulseRequest &pulse = sequencePulses[s];
+    pulse.duration_us = step.duration_us;
+    pulse.source      = PULSE_SOURCE_SEQUENCE;
+    pulse.tag         = seq;
+    setPulseChannels(pulse, step.mask, step.power == SEQUENCE_POWER_OWN ? -1 : step.power);
+    applyTrigger(pulse, LED_STABILIZATION_MS);
+    if (!(step.flags & SEQUENCE_STEP_FLAG_TRIGGER)) pulse.trigger_width_us = 0;
+    mask |= step.mask;
+  }
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    if ((mask >> ch) & 1) ledChannels[ch].on = true;
+  }
+
+  power_hold_set(POWER_HOLD_PULSE, true);
+  sequencePending    = true;
+  sequenceSeq        = seq;
+  sequenceMask       = mask;
+  sequenceReceivedUs = received_us;
+  sequenceFrameSeq   = rtFrameSeq;
+  pulse_engine_start_sequence(sequencePulses, sequenceLength, sequenceResults);
+
+  // Same ACK as SYNC_CAPTURE: the first step is lit
+  sendRawByte(RESPONSE_LED_ON_ACK);
+}
+
+void finishSequence(const PulseResult &pulse) {
+  sequencePending = false;
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    if ((sequenceMask >> ch) & 1) ledChannels[ch].on = false;
+  }
+  updateLedHold();
+
+  recordTiming(TIMING_CMD_TO_LED_ON, pulse.on_us - sequenceReceivedUs);
+  for (uint8_t s = 0; s < sequenceLength; s++) {
+    int64_t actual_us = sequenceResults[s].off_us - sequenceResults[s].on_us;
+    recordTiming(TIMING_LED_ON_DURATION, actual_us);
+    recordTiming(TIMING_LED_ON_ERROR, llabs(actual_us - (int64_t)sequenceSteps[s].duration_us));
+  }
+
+  SensorSnapshot snapshot;
+  getSensorSnapshot(snapshot);
+  rtFrameSeq = sequenceFrameSeq;
+  sendSequenceRecord(pulse, snapshot);
+
+  debugPrint("=== SEQUENCE COMPLETE: ");
+  debugPrint((int)(pulse.off_us - pulse.on_us));
+  debugPrintln("us ===");
+}
+
+void sendSequenceRecord(const PulseResult &pulse, const SensorSnapshot &snapshot) {
+  // ========================================================================
+  // Completion record (RESPONSE_SEQUENCE_COMPLETE), 16 + 6 x steps bytes
+  // ========================================================================
+  // Byte 0:      0x1F
+  // Bytes 1-2:   seq from CMD_RUN_SEQUENCE (uint16 big-endian)
+  // Byte 3:      step count n
+  // Bytes 4-7:   LED-on time of step 0, esp_timer us (uint32 big-endian, wraps)
+  // Bytes 8-11:  temperature (float, little-endian IEEE 754)
+  // Bytes 12-15: humidity (float, little-endian IEEE 754)
+  // Per step:    channel mask, power (0-100%), LED-on duration in us (uint32
+  //              big-endian). Steps are contiguous, so step k started at the
+  //              sum of the durations before it.
+  // ========================================================================
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_SEQUENCE_COMPLETE);
+  response.put_u16_be(sequenceSeq);
+  response.put_u8(sequenceLength);
+  response.put_u32_be((uint32_t)pulse.on_us);
+  response.put_f32_le(snapshot.temperature);
+  response.put_f32_le(snapshot.humidity);
+  for (uint8_t s = 0; s < sequenceLength; s++) {
+    const SequenceStep &step = sequenceSteps[s];
+    uint8_t power = step.power;
+    if (power == SEQUENCE_POWER_OWN) {
+      power = step.mask ? ledChannels[__builtin_ctz(step.mask)].power : 0;
+    }
+    response.put_u8(step.mask);
+    response.put_u8(power);
+    response.put_u32_be((uint32_t)(sequenceResults[s].off_us - sequenceResults[s].on_us));
+  }
+  queueResponse(response);
+}
+
+// ========================================================================
+// ACQUISITION SCHEDULE
+// ========================================================================
+// CMD_START_SCHEDULE hands a whole timelapse to the firmware. Frame n starts
+// at start_us + n * interval_us: an esp_timer one-shot (hardware systimer,
+// dispatched from the esp_timer task) is re-armed for each absolute deadline,
+// so frame timing neither drifts nor depends on host or loop() latency. The
+// callback only starts the prebuilt pulse; loop() sends the frame events.
+// ========================================================================
+
+bool startSchedule(const AcquisitionSchedule &request) {
+  if (scheduleRunning || syncPending || sequencePending || captureQueueCount > 0 ||
+      pulse_engine_busy()) {
+    return false;
+  }
+
+  schedule = request;
+  schedule.start_us  = esp_timer_get_time() + SCHEDULE_START_DELAY_US;
+  scheduleFramesDone = 0;
+
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_SCHEDULE_ACK);
+  response.put_u32_be((uint32_t)schedule.start_us);
+  queueResponse(response);
+  armSchedule(0);
+
+  debugPrint("Schedule started: interval ");
+  debugPrint((int)(schedule.interval_us / 1000));
+  debugPrint("ms, frames ");
+  debugPrintln((int)schedule.frame_count);
+  return true;
+}
+
+void resumeSchedule(const AcquisitionSchedule &request, uint32_t first_frame, uint32_t frames_done) {
+  // After a warm reset: the grid of the schedule the host started, carried
+  // over to this boot's clock by resumeTasks(). No new SCHEDULE_ACK.
+  schedule           = request;
+  scheduleFramesDone = frames_done;
+  armSchedule(first_frame);
+  debugPrint("Schedule resumed at frame ");
+  debugPrintln((int)first_frame);
+}
+
+void armSchedule(uint32_t first_frame) {
+  // schedule holds the settings and start_us; the timer first fires at the
+  // deadline of first_frame
+  PulseRequest &pulse = schedule.pulse;
+  pulse.duration_us = ((uint32_t)schedule.stabilization_ms + schedule.exposure_ms) * 1000UL;
+  pulse.source      = PULSE_SOURCE_SCHEDULE;
+  pulse.tag         = 0;
+  applyTrigger(pulse, schedule.stabilization_ms);
+  setPulseChannels(pulse, ledTypeMask(schedule.led_type), schedule.power);
+
+  // A late callback from a previous schedule must not fire into this one
+  esp_timer_stop(scheduleTimer);
+
+  scheduleNextFrame = first_frame;
+  scheduleRunning   = true;
+
+  portENTER_CRITICAL(&scheduleMux);
+  scheduleSkipCount = 0;
+  scheduleActive    = true;
+  portEXIT_CRITICAL(&scheduleMux);
+  int64_t wait_us = schedule.start_us + (int64_t)first_frame * schedule.interval_us -
+                    esp_timer_get_time();
+  esp_timer_start_once(scheduleTimer, wait_us > 0 ? wait_us : 1);
+}
+
+void stopSchedule() {
+  // No frame can start after this; serviceSchedule() sends SCHEDULE_DONE
+  // once a pulse still in flight has reported
+  portENTER_CRITICAL(&scheduleMux);
+  scheduleActive = false;
+  portEXIT_CRITICAL(&scheduleMux);
+  esp_timer_stop(scheduleTimer);
+
+  if (!scheduleRunning) {
+    ResponseBuilder response;
+    response.put_u8(RESPONSE_SCHEDULE_DONE);
+    response.put_u32_be(scheduleFramesDone);
+    queueResponse(response);
+  }
+}
+
+void onScheduleTimer(void *arg) {
+  // esp_timer task context. The pulse is started inside the critical
+  // section so stopSchedule() cannot race a frame that is about to begin.
+  bool     rearm   = false;
+  bool     started = false;
+  bool     skipped = false;
+  uint32_t frame   = 0;
+  int64_t  next_us = 0;
+  int64_t  late_us = 0;
+
+  // Released by finishScheduledFrame(), or below if no frame starts
+  power_hold_set(POWER_HOLD_SCHEDULE, true);
+
+  portENTER_CRITICAL(&scheduleMux);
+  if (scheduleActive) {
+    late_us = esp_timer_get_time() - (schedule.start_us + (int64_t)scheduleNextFrame * schedule.interval_us);
+    frame   = scheduleNextFrame;
+    schedule.pulse.tag = frame;
+    started = pulse_engine_start(schedule.pulse);
+    if (!started) {
+      // A late callback found the previous frame still lit. rtTask reports
+      // the frame as skipped; a skip that does not extend the pending range
+      // (rtTask behind since a frame started in between) is only logged.
+      skipped = true;
+      if (scheduleSkipCount == 0) scheduleSkipFirst = frame;
+      if (scheduleSkipFirst + scheduleSkipCount == frame) scheduleSkipCount++;
+    }
+    scheduleNextFrame = frame + 1;
+    if (schedule.frame_count != 0 && scheduleNextFrame >= schedule.frame_count) {
+      scheduleActive = false;
+    } else {
+      next_us = schedule.start_us + (int64_t)scheduleNextFrame * schedule.interval_us;
+      rearm   = true;
+    }
+  }
+  portEXIT_CRITICAL(&scheduleMux);
+
+  if (started) {
+    recordTiming(TIMING_SCHEDULE_WAKE, late_us);
+  } else if (skipped) {
+    // The hold stays with the lit frame, whose finishScheduledFrame() releases it
+    logEvent(EVENT_ERROR, EVENT_ERROR_LATE_FRAME, frame, late_us);
+    xTaskNotifyGive(rtTaskHandle);
+  } else {
+    power_hold_set(POWER_HOLD_SCHEDULE, false);
+  }
+
+  if (rearm) {
+    int64_t wait_us = next_us - esp_timer_get_time();
+    esp_timer_start_once(scheduleTimer, wait_us > 0 ? wait_us : 1);
+  }
+}
+
+void finishScheduledFrame(const PulseResult &pulse) {
+  int64_t deadline_us = schedule.start_us + (int64_t)pulse.tag * schedule.interval_us;
+  uint8_t status = 0;
+  if (pulse.on_us - deadline_us > SCHEDULE_LATE_TOLERANCE_US) {
+    status |= SCHEDULE_STATUS_LATE;
+    logEvent(EVENT_ERROR, EVENT_ERROR_LATE_FRAME, pulse.tag, pulse.on_us - deadline_us);
+  }
+  // Frames skipped before this one report first, so indexes stay in order
+  serviceScheduleSkips(pulse.tag);
+
+  int64_t duration_us = pulse.off_us - pulse.on_us;
+  recordTiming(TIMING_LED_ON_DURATION, duration_us);
+  recordTiming(TIMING_LED_ON_ERROR, llabs(duration_us - (int64_t)schedule.pulse.duration_us));
+
+  sendScheduleFrame(pulse.tag, status, pulse);
+  power_hold_set(POWER_HOLD_SCHEDULE, false);
+}
+
+void serviceScheduleSkips(uint32_t before) {
+  // rtTask: one SKIPPED frame event per frame onScheduleTimer() could not
+  // start, for the skipped frames with an index below before
+  portENTER_CRITICAL(&scheduleMux);
+  uint32_t first = scheduleSkipFirst;
+  uint32_t count = scheduleSkipCount;
+  if ((int32_t)(before - first) < (int32_t)count) {
+    count = (int32_t)(before - first) > 0 ? before - first : 0;
+  }
+  scheduleSkipFirst += count;
+  scheduleSkipCount -= count;
+  portEXIT_CRITICAL(&scheduleMux);
+
+  PulseResult none = {};
+  for (uint32_t i = 0; i < count; i++) {
+    sendScheduleFrame(first + i, SCHEDULE_STATUS_SKIPPED, none);
+  }
+}
+
+void sendScheduleFrame(uint32_t index, uint8_t status, const PulseResult &pulse) {
+  // ========================================================================
+  // 18-byte frame event (RESPONSE_SCHEDULE_FRAME)
+  // ========================================================================
+  // Byte 0:      0x1D
+  // Bytes 1-4:   frame index (uint32 big-endian)
+  // Bytes 5-8:   LED-on time, esp_timer us (uint32 big-endian, wraps)
+  // Bytes 9-12:  LED-on duration in us (uint32 big-endian)
+  // Bytes 13-14: temperature x10 (int16 big-endian)
+  // Bytes 15-16: humidity x10 (uint16 big-endian)
+  // Byte 17:     status flags (bit0 = started late, bit1 = last frame,
+  //              bit2 = skipped)
+  // ========================================================================
+  if (schedule.frame_count != 0 && index + 1 >= schedule.frame_count) {
+    status |= SCHEDULE_STATUS_LAST;
+  }
+
+  SensorSnapshot snapshot;
+  getSensorSnapshot(snapshot);
+
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_SCHEDULE_FRAME);
+  response.put_u32_be(index);
+  response.put_u32_be((uint32_t)pulse.on_us);
+  response.put_u32_be((uint32_t)(pulse.off_us - pulse.on_us));
+  response.put_i16_be((int16_t)(snapshot.temperature * 10.0));
+  response.put_u16_be((uint16_t)(snapshot.humidity * 10.0));
+  response.put_u8(status);
+  queueResponse(response);
+
+  scheduleFramesDone++;
+}
+
+void serviceSchedule(bool engineWasIdle) {
+  // engineWasIdle was sampled before loop() drained the pulse queue, so the
+  // last frame event is always sent before SCHEDULE_DONE
+  if (!scheduleRunning || scheduleActive || !engineWasIdle || scheduleSkipCount) return;
+
+  scheduleRunning = false;
+  ResponseBuilder response;
+  response.put_u8(RESPONSE_SCHEDULE_DONE);
+  response.put_u32_be(scheduleFramesDone);
+  queueResponse(response);
+  debugPrintln("Schedule done");
+}
+
+bool scheduleFrameImminent() {
+  // True shortly before a scheduled frame: DHT reads are kept to the
+  // LED-off gap between frames and must not overlap the next one
+  if (!scheduleActive) return false;
+  int64_t next_us = schedule.start_us + (int64_t)scheduleNextFrame * schedule.interval_us;
+  return next_us - esp_timer_get_time() < SCHEDULE_SENSOR_GUARD_US;
+}
+
+// ========================================================================
+// SENSOR FUNCTIONS
+// ========================================================================
+
+bool readDhtValidated(float &temperature, float &humidity) {
+  // The mutex serializes DHT access and makes the holder the single writer
+  // of history and snapshot.
+  xSemaphoreTake(dhtMutex, portMAX_DELAY);
+  power_hold_set(POWER_HOLD_SENSOR, true);  // No light sleep while the RMT captures
+  int64_t read_start_us = esp_timer_get_time();
+
+  // Read sensor (retry up to 3 times)
+  float h = NAN, t = NAN;
+  for (int attempt = 0; attempt < 3; attempt++) {
+    if (!readDhtOnce(t, h)) {
+      h = NAN;
+      t = NAN;
+    }
+
+    if (!isnan(h) && !isnan(t) &&
+        h >= 0.0 && h <= 100.0 &&
+        t >= -40.0 && t <= 85.0) {
+      break;
+    }
 
     if (attempt < 2) {
       delay(100);
     }
   }
 
-  // Restore LED states
-  if (irWasOn) ledcWrite(PWM_CHANNEL_IR, savedIrPwm);
-  if (whiteWasOn) ledcWrite(PWM_CHANNEL_WHITE, savedWhitePwm);
-
   // Check if valid
   bool valid = (!isnan(h) && !isnan(t) &&
                 h >= 0.0 && h <= 100.0 &&
                 t >= -40.0 && t <= 85.0);
+  recordTiming(TIMING_SENSOR_READ, esp_timer_get_time() - read_start_us);
+  power_hold_set(POWER_HOLD_SENSOR, false);
 
   if (valid) {
-    addToSensorHistory(t, h);
+    sensor_filter_add(sensor_history, t, h, millis());
     // Return fresh values directly (not filtered average)
     temperature = t;
     humidity = h;
-    return true;
   } else {
     // Only use filtered values as fallback when reading fails
-    temperature = getFilteredTemperature();
-    humidity = getFilteredHumidity();
-    return false;
+    temperature = sensor_filter_temperature(sensor_history);
+    humidity = sensor_filter_humidity(sensor_history);
   }
+
+  publishSensorSnapshot(valid);
+  xSemaphoreGive(dhtMutex);
+  return valid;
 }
 
-void addToSensorHistory(float temp, float hum) {
-  if (!sensor_history.initialized) {
-    for (int i = 0; i < 5; i++) {
-      sensor_history.temp_values[i] = temp;
-      sensor_history.hum_values[i] = hum;
-    }
-    sensor_history.count = 5;
-    sensor_history.initialized = true;
+bool readDhtOnce(float &temperature, float &humidity) {
+  // Start pulse and reply are timed by the RMT peripheral, the task only
+  // sleeps between polls - nothing masks interrupts during a read
+  if (!dht_rmt_start()) return false;
+  DhtStatus status;
+  do {
+    vTaskDelay(pdMS_TO_TICKS(DHT_POLL_INTERVAL_MS));
+    status = dht_rmt_poll(temperature, humidity);
+  } while (status == DHT_PENDING);
+  return status == DHT_OK;
+}
+
+void publishSensorSnapshot(bool readingValid) {
+  // Caller holds dhtMutex
+  uint8_t next = sensor_snapshot_index ^ 1;
+  SensorSnapshot &slot = sensor_snapshots[next];
+  const SensorSnapshot &prev = sensor_snapshots[sensor_snapshot_index];
+
+  if (readingValid) {
+    sensor_filter_newest(sensor_history, slot.temperature, slot.humidity);
+    slot.sample_ms   = sensor_history.last_valid_ms;
+    slot.fail_count  = 0;
+    slot.valid       = true;
   } else {
-    sensor_history.temp_values[sensor_history.index] = temp;
-    sensor_history.hum_values[sensor_history.index] = hum;
-    sensor_history.index = (sensor_history.index + 1) % 5;
-    if (sensor_history.count < 5) sensor_history.count++;
+    slot.temperature = prev.temperature;
+    slot.humidity    = prev.humidity;
+    slot.sample_ms   = prev.sample_ms;
+    slot.fail_count  = prev.fail_count < 0xFFFF ? prev.fail_count + 1 : prev.fail_count;
+    slot.valid       = prev.valid;
+    // First failure, then every power of two - a dead sensor cannot flood the log
+    if ((slot.fail_count & (slot.fail_count - 1)) == 0) {
+      logEvent(EVENT_SENSOR_FAIL, 0, slot.fail_count, 0);
+    }
   }
+  slot.filtered_temperature = sensor_filter_temperature(sensor_history);
+  slot.filtered_humidity    = sensor_filter_humidity(sensor_history);
+
+  __atomic_store_n(&sensor_snapshot_index, next, __ATOMIC_RELEASE);
+  __atomic_add_fetch(&sensor_snapshot_seq, 1, __ATOMIC_RELEASE);
 }
 
-float getFilteredTemperature() {
-  if (!sensor_history.initialized) return 25.0;
-  float sum = 0;
-  for (int i = 0; i < sensor_history.count; i++) {
-    sum += sensor_history.temp_values[i];
+uint32_t getSensorSnapshot(SensorSnapshot &snapshot) {
+  // Lock-free copy of the latest snapshot, returns its age in ms
+  uint32_t seq;
+  do {
+    seq = __atomic_load_n(&sensor_snapshot_seq, __ATOMIC_ACQUIRE);
+    snapshot = sensor_snapshots[__atomic_load_n(&sensor_snapshot_index, __ATOMIC_ACQUIRE)];
+  } while (seq != __atomic_load_n(&sensor_snapshot_seq, __ATOMIC_ACQUIRE));
+
+  return snapshot.valid ? (uint32_t)(millis() - snapshot.sample_ms) : UINT32_MAX;
+}
+
+void sensorTask(void *param) {
+  esp_task_wdt_add(NULL);
+  // The DHT22 stayed powered through a warm reset
+  if (!bootResumed) sensorWait(SENSOR_WARMUP_MS);
+
+  bool first = true;
+  for (;;) {
+    esp_task_wdt_reset();
+
+    // Only read in LED-off gaps - illumination is never changed for a read,
+    // status requests are served from the snapshot in the meantime
+    if (anyLedOn() || pulse_engine_busy() || scheduleFrameImminent()) {
+      vTaskDelay(pdMS_TO_TICKS(SENSOR_RETRY_INTERVAL_MS));
+      continue;
+    }
+
+    float temp, hum;
+    uint32_t read_ms = millis();
+    bool valid = readDhtValidated(temp, hum);
+    if (first) {
+      debugPrintln(valid ? "Initial sensor reading ok" : "Warning: Initial sensor reading failed");
+      first = false;
+    }
+
+    // DHT22 rate limit first, then sleep until the period ends or a stale
+    // status request / policy change wakes the task
+    sensorWait(SENSOR_SAMPLE_INTERVAL_MS);
+    uint32_t period_ms = sensorMaxAgeMs / 2;
+    uint32_t elapsed_ms = millis() - read_ms;
+    bool requested = ulTaskNotifyTake(pdTRUE, 0) > 0;  // Arrived during the wait
+    while (!requested && period_ms > elapsed_ms) {
+      uint32_t wait_ms = period_ms - elapsed_ms;
+      if (wait_ms > WATCHDOG_FEED_MS) wait_ms = WATCHDOG_FEED_MS;
+      requested  = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms)) > 0;
+      elapsed_ms = millis() - read_ms;
+      esp_task_wdt_reset();
+    }
   }
-  return sum / sensor_history.count;
 }
 
-float getFilteredHumidity() {
-  if (!sensor_history.initialized) return 50.0;
-  float sum = 0;
-  for (int i = 0; i < sensor_history.count; i++) {
-    sum += sensor_history.hum_values[i];
+void sensorWait(uint32_t ms) {
+  // vTaskDelay in watchdog feed slices
+  while (ms > 0) {
+    uint32_t slice = ms < WATCHDOG_FEED_MS ? ms : WATCHDOG_FEED_MS;
+    vTaskDelay(pdMS_TO_TICKS(slice));
+    esp_task_wdt_reset();
+    ms -= slice;
   }
-  return sum / sensor_history.count;
 }
+
 // DHT dht(14, DHT22);
 
 // void setup() {
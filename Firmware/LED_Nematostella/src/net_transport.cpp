@@ -0,0 +1,144 @@
+#include "net_transport.h"
+
+#include <WiFi.h>
+#include "lwip/sockets.h"
+
+const uint8_t     NET_RX_QUEUE_LENGTH  = 8;
+const uint32_t    NET_TASK_STACK       = 4096;
+const UBaseType_t NET_TASK_PRIORITY    = 6;    // Just above commsTask
+const BaseType_t  NET_TASK_CORE        = 0;    // With the Wi-Fi stack, off the pulse core
+const uint32_t    NET_RETRY_MS         = 500;  // Wi-Fi down / socket setup failed
+const long        NET_SELECT_TIMEOUT_S = 1;    // Re-check the Wi-Fi state this often
+
+static QueueHandle_t rxQueue         = NULL;
+static volatile int  unicastSocket   = -1;
+static int           multicastSocket = -1;
+static uint16_t      netPort         = 0;
+static in_addr       multicastGroup  = {};
+static void        (*onReceive)()    = NULL;
+
+static int openSocket(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (fd < 0) return -1;
+
+  sockaddr_in addr = {};
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void closeSockets() {
+  int fd = unicastSocket;
+  unicastSocket = -1;
+  if (fd >= 0) close(fd);
+  if (multicastSocket >= 0) close(multicastSocket);
+  multicastSocket = -1;
+}
+
+static bool openSockets() {
+  int fd = openSocket(netPort);
+  if (fd < 0) return false;
+
+  // Without the group the rig still works, it just misses group commands
+  multicastSocket = openSocket(netPort + 1);
+  if (multicastSocket >= 0) {
+    ip_mreq membership = {};
+    membership.imr_multiaddr        = multicastGroup;
+    membership.imr_interface.s_addr = (uint32_t)WiFi.localIP();
+    if (setsockopt(multicastSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership,
+                   sizeof(membership)) < 0) {
+      close(multicastSocket);
+      multicastSocket = -1;
+    }
+  }
+  unicastSocket = fd;
+  return true;
+}
+
+static void receiveFrom(int fd, bool multicast) {
+  NetDatagram datagram;
+  sockaddr_in from = {};
+  socklen_t from_len = sizeof(from);
+  int len = recvfrom(fd, datagram.data, sizeof(datagram.data), 0, (sockaddr *)&from, &from_len);
+  if (len <= 0) return;
+
+  datagram.from.addr = from.sin_addr.s_addr;
+  datagram.from.port = from.sin_port;
+  datagram.multicast = multicast;
+  datagram.len       = len;
+  // Full queue: the datagram is lost like on the air, the host retries
+  if (xQueueSend(rxQueue, &datagram, 0) == pdTRUE && onReceive) onReceive();
+}
+
+static void netTask(void *param) {
+  for (;;) {
+    if (WiFi.status() != WL_CONNECTED) {
+      closeSockets();
+      vTaskDelay(pdMS_TO_TICKS(NET_RETRY_MS));
+      continue;
+    }
+    if (unicastSocket < 0 && !openSockets()) {
+      vTaskDelay(pdMS_TO_TICKS(NET_RETRY_MS));
+      continue;
+    }
+
+    int unicast = unicastSocket;
+    fd_set ready;
+    FD_ZERO(&ready);
+    FD_SET(unicast, &ready);
+    if (multicastSocket >= 0) FD_SET(multicastSocket, &ready);
+    timeval timeout = { NET_SELECT_TIMEOUT_S, 0 };
+    int max_fd = unicast > multicastSocket ? unicast : multicastSocket;
+
+    int count = select(max_fd + 1, &ready, NULL, NULL, &timeout);
+    if (count < 0) {
+      closeSockets();
+      continue;
+    }
+    if (FD_ISSET(unicast, &ready)) receiveFrom(unicast, false);
+    if (multicastSocket >= 0 && FD_ISSET(multicastSocket, &ready)) {
+      receiveFrom(multicastSocket, true);
+    }
+  }
+}
+
+void net_transport_init(const char *ssid, const char *password, uint16_t port,
+                        const char *multicast_group, void (*on_receive)()) {
+  netPort   = port;
+  onReceive = on_receive;
+  inet_aton(multicast_group, &multicastGroup);
+  rxQueue = xQueueCreate(NET_RX_QUEUE_LENGTH, sizeof(NetDatagram));
+
+  // Connects in the background; the Wi-Fi driver reconnects by itself
+  WiFi.mode(WIFI_STA);
+  WiFi.setSleep(false);
+  WiFi.setAutoReconnect(true);
+  WiFi.begin(ssid, password);
+
+  xTaskCreatePinnedToCore(netTask, "net", NET_TASK_STACK, NULL, NET_TASK_PRIORITY, NULL,
+                          NET_TASK_CORE);
+}
+
+bool net_transport_receive(NetDatagram &datagram) {
+  return rxQueue && xQueueReceive(rxQueue, &datagram, 0) == pdTRUE;
+}
+
+bool net_transport_send(const NetPeer &to, const uint8_t *data, uint8_t len) {
+  int fd = unicastSocket;
+  if (fd < 0) return false;
+
+  sockaddr_in addr = {};
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = to.port;
+  addr.sin_addr.s_addr = to.addr;
+  return sendto(fd, data, len, 0, (sockaddr *)&addr, sizeof(addr)) == len;
+}
+
+bool net_transport_connected() {
+  return unicastSocket >= 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ========================================================================
+// NET TRANSPORT - Protocol v3 frames over Wi-Fi UDP
+// ========================================================================
+// Optional second host link (Features::network). Datagrams carry whole v3
+// frames (frame_codec.h): CRC, seq and the host's retransmit already make
+// the serial protocol loss-tolerant, so the same command set runs over
+// UDP unchanged. Two sockets:
+//   port       unicast commands from one host; replies go back to it
+//   port + 1   multicast group - one datagram reaches every rig in the
+//              same radio frame (e.g. a SYNC_CAPTURE for all plates)
+// A receive task blocks in select() and queues datagrams for commsTask;
+// sends go out directly from the caller (lwIP sockets are thread-safe).
+// Wi-Fi modem sleep is off - it would hold multicast back to the next
+// DTIM beacon, hundreds of ms. Sockets are reopened after a reconnect.
+// ========================================================================
+
+const uint8_t NET_DATAGRAM_MAX = 128;  // Two full frames
+
+struct NetPeer {
+  uint32_t addr;  // IPv4, network byte order
+  uint16_t port;  // Network byte order
+};
+
+struct NetDatagram {
+  NetPeer from;
+  bool    multicast;  // Arrived on the group socket
+  uint8_t len;
+  uint8_t data[NET_DATAGRAM_MAX];
+};
+
+// on_receive runs in the receive task after each queued datagram
+void net_transport_init(const char *ssid, const char *password, uint16_t port,
+                        const char *multicast_group, void (*on_receive)());
+bool net_transport_receive(NetDatagram &datagram);  // Non-blocking, false if none queued
+bool net_transport_send(const NetPeer &to, const uint8_t *data, uint8_t len);
+bool net_transport_connected();
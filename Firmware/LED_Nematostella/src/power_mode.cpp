@@ -0,0 +1,76 @@
+#include "power_mode.h"
+
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "driver/uart.h"
+
+// UART RX positive edges needed to wake from light sleep
+const int POWER_UART_WAKE_THRESHOLD = 3;
+
+static PowerMode            currentMode = POWER_MODE_PERFORMANCE;
+static int                  wakeUart    = -1;
+static esp_pm_lock_handle_t cpuLock     = NULL;
+static esp_pm_lock_handle_t noSleepLock = NULL;
+static portMUX_TYPE         holdMux     = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t              holdMask    = 0;
+
+void power_mode_init(int wake_uart) {
+  wakeUart = wake_uart;
+#if CONFIG_PM_ENABLE
+  esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "hold_cpu", &cpuLock);
+  esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "hold_awake", &noSleepLock);
+#endif
+}
+
+esp_err_t power_mode_set(PowerMode mode) {
+  if (mode > POWER_MODE_LIGHT_SLEEP) return ESP_ERR_INVALID_ARG;
+#if !CONFIG_PM_ENABLE
+  return mode == POWER_MODE_PERFORMANCE ? ESP_OK : ESP_ERR_NOT_SUPPORTED;
+#else
+  if (mode == POWER_MODE_LIGHT_SLEEP && wakeUart < 0) return ESP_ERR_NOT_SUPPORTED;
+
+  #if defined(CONFIG_IDF_TARGET_ESP32S3)
+    esp_pm_config_esp32s3_t config;
+  #else
+    esp_pm_config_esp32_t config;
+  #endif
+  config.max_freq_mhz       = POWER_MAX_FREQ_MHZ;
+  config.min_freq_mhz       = mode == POWER_MODE_PERFORMANCE ? POWER_MAX_FREQ_MHZ : POWER_MIN_FREQ_MHZ;
+  config.light_sleep_enable = mode == POWER_MODE_LIGHT_SLEEP;
+
+  esp_err_t err = esp_pm_configure(&config);
+  if (err != ESP_OK) return err;
+
+  if (mode == POWER_MODE_LIGHT_SLEEP) {
+    uart_set_wakeup_threshold(wakeUart, POWER_UART_WAKE_THRESHOLD);
+    esp_sleep_enable_uart_wakeup(wakeUart);
+  } else {
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_UART);
+  }
+  currentMode = mode;
+  return ESP_OK;
+#endif
+}
+
+PowerMode power_mode_get() {
+  return currentMode;
+}
+
+void power_hold_set(uint8_t reason, bool held) {
+  // Locks are taken on the first and dropped with the last hold reason.
+  // Inside the critical section so concurrent callers cannot reorder
+  // acquire and release.
+  portENTER_CRITICAL(&holdMux);
+  uint8_t previous = holdMask;
+  holdMask = held ? (holdMask | reason) : (holdMask & ~reason);
+  if (cpuLock && noSleepLock) {
+    if (previous == 0 && holdMask != 0) {
+      esp_pm_lock_acquire(cpuLock);
+      esp_pm_lock_acquire(noSleepLock);
+    } else if (previous != 0 && holdMask == 0) {
+      esp_pm_lock_release(noSleepLock);
+      esp_pm_lock_release(cpuLock);
+    }
+  }
+  portEXIT_CRITICAL(&holdMux);
+}
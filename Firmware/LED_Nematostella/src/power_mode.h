@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ========================================================================
+// POWER MODE - esp_pm frequency scaling and automatic light sleep
+// ========================================================================
+// POWER_MODE_DFS lets the CPU drop from 240 to 80 MHz when idle. The
+// minimum stays at 80 MHz so APB (UART baud, LEDC PWM, the 1 MHz pulse
+// timer) never changes. POWER_MODE_LIGHT_SLEEP additionally sleeps when
+// every task is blocked; the next esp_timer alarm (schedule frames) and
+// UART RX edges wake it. The bytes that wake the UART are lost.
+//
+// Hold reasons keep the CPU at full speed and out of light sleep while
+// timing matters: power_hold_set() is cheap and may be called from any task.
+//
+// Both modes need CONFIG_PM_ENABLE (light sleep also
+// CONFIG_FREERTOS_USE_TICKLESS_IDLE) in the sdkconfig; otherwise
+// power_mode_set() returns ESP_ERR_NOT_SUPPORTED and the ESP32 keeps
+// running at full clock.
+// ========================================================================
+
+enum PowerMode : uint8_t {
+  POWER_MODE_PERFORMANCE = 0,  // Fixed max clock (boot default)
+  POWER_MODE_DFS         = 1,
+  POWER_MODE_LIGHT_SLEEP = 2
+};
+
+const uint8_t POWER_HOLD_PULSE    = 0x01;  // Sync capture / capture queue pending
+const uint8_t POWER_HOLD_SCHEDULE = 0x02;  // Scheduled frame in flight
+const uint8_t POWER_HOLD_LED      = 0x04;  // LED switched on by command
+const uint8_t POWER_HOLD_SENSOR   = 0x08;  // DHT22 read (RMT capture)
+const uint8_t POWER_HOLD_COMMS    = 0x10;  // Host active recently
+
+const uint16_t POWER_MAX_FREQ_MHZ = 240;
+const uint16_t POWER_MIN_FREQ_MHZ = 80;   // Lowest clock with APB at 80 MHz
+
+void      power_mode_init(int wake_uart);  // -1 = USB-CDC console, no light sleep
+esp_err_t power_mode_set(PowerMode mode);
+PowerMode power_mode_get();
+void      power_hold_set(uint8_t reason, bool held);
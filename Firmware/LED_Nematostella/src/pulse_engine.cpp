@@ -0,0 +1,231 @@
+#include "pulse_engine.h"
+#include "led_io.h"
+
+// Timer 0 at 80 MHz APB / 80 = 1 MHz -> 1 tick per microsecond
+const uint8_t  PULSE_TIMER_NUM     = 0;
+const uint16_t PULSE_TIMER_DIVIDER = 80;
+const uint8_t  PULSE_QUEUE_LENGTH  = 4;
+
+// Edges closer than this to the current count are handled in the same ISR -
+// an alarm value the counter has already passed would never fire
+const uint32_t PULSE_EDGE_MARGIN_US = 2;
+
+// LED-on of every step but the first, trigger on/off and LED-off
+const uint8_t PULSE_MAX_EDGES = PULSE_MAX_STEPS * 4;
+
+enum PulseEdgeKind : uint8_t {
+  EDGE_LED_ON,
+  EDGE_TRIGGER_ON,
+  EDGE_TRIGGER_OFF,
+  EDGE_LED_OFF
+};
+
+struct PulseEdge {
+  uint32_t      at_us;  // Offset from the first LED-on edge
+  PulseEdgeKind kind;
+  uint8_t       step;
+};
+
+static hw_timer_t        *pulseTimer   = NULL;
+static QueueHandle_t      pulseQueue   = NULL;
+static portMUX_TYPE       pulseMux     = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool      pulseActive  = false;
+static volatile bool      pulseArmed   = false;  // Loaded, waiting for pulse_engine_fire()
+static PulseRequest       activeSteps[PULSE_MAX_STEPS];
+static PulseResult        activeResult;
+static PulseResult       *stepResults  = NULL;  // Per-step edge times, sequences only
+static int                triggerPin   = -1;
+static TaskHandle_t       notifyTask   = NULL;
+static PulseEdge          edges[PULSE_MAX_EDGES];
+static uint8_t            edgeCount    = 0;
+static volatile uint8_t   edgeIndex    = 0;
+
+static void IRAM_ATTR writeStep(const PulseRequest &step, bool on) {
+  for (uint8_t i = 0; i < step.channel_count; i++) {
+    led_channel_write(step.channels[i], on ? step.duty[i] : 0);
+  }
+}
+
+static void IRAM_ATTR runEdge(const PulseEdge &edge) {
+  switch (edge.kind) {
+    case EDGE_LED_ON:
+      writeStep(activeSteps[edge.step], true);
+      if (stepResults) stepResults[edge.step].on_us = esp_timer_get_time();
+      break;
+    case EDGE_TRIGGER_ON:
+      trigger_write(triggerPin, true);
+      break;
+    case EDGE_TRIGGER_OFF:
+      trigger_write(triggerPin, false);
+      break;
+    case EDGE_LED_OFF:
+      writeStep(activeSteps[edge.step], false);
+      activeResult.off_us = esp_timer_get_time();
+      if (stepResults) stepResults[edge.step].off_us = activeResult.off_us;
+      break;
+  }
+}
+
+static void IRAM_ATTR onPulseEdge() {
+  // Edge first, bookkeeping afterwards
+  runEdge(edges[edgeIndex++]);
+  while (edgeIndex < edgeCount &&
+         edges[edgeIndex].at_us <= (uint32_t)timerRead(pulseTimer) + PULSE_EDGE_MARGIN_US) {
+    runEdge(edges[edgeIndex++]);
+  }
+
+  if (edgeIndex < edgeCount) {
+    timerAlarmWrite(pulseTimer, edges[edgeIndex].at_us, false);
+    timerAlarmEnable(pulseTimer);
+    return;
+  }
+
+  BaseType_t woken = pdFALSE;
+  xQueueSendFromISR(pulseQueue, &activeResult, &woken);
+  if (notifyTask) vTaskNotifyGiveFromISR(notifyTask, &woken);
+
+  portENTER_CRITICAL_ISR(&pulseMux);
+  pulseActive = false;
+  portEXIT_CRITICAL_ISR(&pulseMux);
+
+  if (woken) portYIELD_FROM_ISR();
+}
+
+static void addEdge(uint32_t at_us, PulseEdgeKind kind, uint8_t step) {
+  // Insertion sort - ties keep insertion order, so the LED-off edge of a
+  // step runs before the LED-on edge of the next
+  uint8_t i = edgeCount++;
+  while (i > 0 && edges[i - 1].at_us > at_us) {
+    edges[i] = edges[i - 1];
+    i--;
+  }
+  edges[i].at_us = at_us;
+  edges[i].kind  = kind;
+  edges[i].step  = step;
+}
+
+void pulse_engine_init(int trigger_pin) {
+  triggerPin = trigger_pin;
+  if (triggerPin >= 0) {
+    pinMode(triggerPin, OUTPUT);
+    digitalWrite(triggerPin, LOW);
+  }
+
+  pulseQueue = xQueueCreate(PULSE_QUEUE_LENGTH, sizeof(PulseResult));
+  pulseTimer = timerBegin(PULSE_TIMER_NUM, PULSE_TIMER_DIVIDER, true);
+  timerAttachInterrupt(pulseTimer, &onPulseEdge, true);
+}
+
+void pulse_engine_notify(TaskHandle_t task) {
+  notifyTask = task;
+}
+
+bool pulse_engine_start(const PulseRequest &request) {
+  return pulse_engine_start_sequence(&request, 1, NULL);
+}
+
+static void loadSteps(const PulseRequest *steps, uint8_t count, PulseResult *step_results) {
+  stepResults = step_results;
+  edgeCount = 0;
+  edgeIndex = 0;
+
+  uint32_t start_us = 0;
+  for (uint8_t s = 0; s < count; s++) {
+    PulseRequest &step = activeSteps[s];
+    step = steps[s];
+    if (step.channel_count > PULSE_MAX_CHANNELS) {
+      step.channel_count = PULSE_MAX_CHANNELS;
+    }
+
+    if (s > 0) addEdge(start_us, EDGE_LED_ON, s);
+    if (triggerPin >= 0 && step.trigger_width_us > 0) {
+      addEdge(start_us + step.trigger_delay_us, EDGE_TRIGGER_ON, s);
+      addEdge(start_us + step.trigger_delay_us + step.trigger_width_us, EDGE_TRIGGER_OFF, s);
+    }
+    addEdge(start_us + step.duration_us, EDGE_LED_OFF, s);
+    start_us += step.duration_us;
+  }
+}
+
+static void IRAM_ATTR fireLoaded() {
+  // LED-on edge of the first step, then arm the one-shot alarm for the
+  // first timed edge
+  writeStep(activeSteps[0], true);
+  activeResult.on_us  = esp_timer_get_time();
+  activeResult.source = activeSteps[0].source;
+  activeResult.tag    = activeSteps[0].tag;
+  if (stepResults) stepResults[0].on_us = activeResult.on_us;
+
+  timerWrite(pulseTimer, 0);
+  timerAlarmWrite(pulseTimer, edges[0].at_us, false);
+  timerAlarmEnable(pulseTimer);
+}
+
+bool pulse_engine_start_sequence(const PulseRequest *steps, uint8_t count, PulseResult *step_results) {
+  if (count == 0 || count > PULSE_MAX_STEPS) return false;
+
+  portENTER_CRITICAL(&pulseMux);
+  if (pulseActive) {
+    portEXIT_CRITICAL(&pulseMux);
+    return false;
+  }
+  pulseActive = true;
+  pulseArmed  = false;
+  portEXIT_CRITICAL(&pulseMux);
+
+  loadSteps(steps, count, step_results);
+  fireLoaded();
+  return true;
+}
+
+bool pulse_engine_arm(const PulseRequest &request) {
+  // Disarmed while the steps are rewritten - an edge in between is missed,
+  // never run on half a request
+  portENTER_CRITICAL(&pulseMux);
+  if (pulseActive) {
+    portEXIT_CRITICAL(&pulseMux);
+    return false;
+  }
+  pulseArmed = false;
+  portEXIT_CRITICAL(&pulseMux);
+
+  loadSteps(&request, 1, NULL);
+
+  portENTER_CRITICAL(&pulseMux);
+  bool armed = !pulseActive;
+  pulseArmed = armed;
+  portEXIT_CRITICAL(&pulseMux);
+  return armed;
+}
+
+void pulse_engine_disarm() {
+  portENTER_CRITICAL(&pulseMux);
+  pulseArmed = false;
+  portEXIT_CRITICAL(&pulseMux);
+}
+
+bool pulse_engine_armed() {
+  return pulseArmed;
+}
+
+bool IRAM_ATTR pulse_engine_fire() {
+  portENTER_CRITICAL_ISR(&pulseMux);
+  if (!pulseArmed || pulseActive) {
+    portEXIT_CRITICAL_ISR(&pulseMux);
+    return false;
+  }
+  pulseArmed  = false;
+  pulseActive = true;
+  portEXIT_CRITICAL_ISR(&pulseMux);
+
+  fireLoaded();
+  return true;
+}
+
+bool pulse_engine_busy() {
+  return pulseActive;
+}
+
+bool pulse_engine_poll(PulseResult &result) {
+  return xQueueReceive(pulseQueue, &result, 0) == pdTRUE;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ========================================================================
+// PULSE ENGINE - Hardware-timer driven LED pulses
+// ========================================================================
+// The LED-on edge is written when a pulse is started, the LED-off edge is
+// written from a one-shot hardware timer ISR (1 us resolution). Completed
+// pulses are reported through a FreeRTOS queue, so loop() keeps running
+// (and processing commands) while the LED is on.
+//
+// Optionally the same timer drives a camera trigger output: a TTL pulse of
+// trigger_width_us starting trigger_delay_us after the LED-on edge. All
+// edges are offsets on one timer counter, so they cannot drift apart.
+//
+// A sequence chains up to PULSE_MAX_STEPS pulses back to back: the LED-off
+// edge of one step and the LED-on edge of the next run in the same ISR, and
+// every step keeps its own channels, duty and trigger. It completes with a
+// single result; the per-step edge times go to a caller-owned array.
+//
+// An armed pulse is loaded ahead and started later by pulse_engine_fire()
+// from an interrupt (the shared sync line, sync_line.h), so the LED-on edge
+// follows the interrupt instead of a task wake-up. Starting a pulse drops
+// an armed one.
+// ========================================================================
+
+const uint8_t PULSE_MAX_CHANNELS = 8;  // One per LEDC channel on the ESP32-S3
+const uint8_t PULSE_MAX_STEPS    = 8;  // Steps per sequence
+
+// Who started a pulse - copied into the result so loop() can route it
+const uint8_t PULSE_SOURCE_SYNC     = 0;  // Host command / capture queue
+const uint8_t PULSE_SOURCE_SCHEDULE = 1;  // On-device acquisition schedule
+const uint8_t PULSE_SOURCE_SEQUENCE = 2;  // Uploaded illumination sequence
+const uint8_t PULSE_SOURCE_LINE     = 3;  // Armed, started by a sync line edge (slave)
+
+struct PulseRequest {
+  uint8_t  channel_count;
+  uint8_t  channels[PULSE_MAX_CHANNELS];  // LEDC channels
+  uint16_t duty[PULSE_MAX_CHANNELS];      // LEDC duty while the pulse is on
+  uint32_t duration_us;                   // LED-on time
+  uint32_t trigger_delay_us;              // Trigger rising edge after LED-on
+  uint32_t trigger_width_us;              // 0 = no trigger pulse
+  uint8_t  source;                        // PULSE_SOURCE_*
+  uint32_t tag;                           // Caller data, e.g. frame index
+};
+
+struct PulseResult {
+  int64_t on_us;   // esp_timer time of the LED-on edge
+  int64_t off_us;  // esp_timer time of the LED-off edge (taken in the ISR)
+  uint8_t  source;
+  uint32_t tag;
+};
+
+void pulse_engine_init(int trigger_pin);               // trigger_pin < 0 = no trigger output
+void pulse_engine_notify(TaskHandle_t task);           // Task notified on each completion
+bool pulse_engine_start(const PulseRequest &request);  // false while a pulse is running
+// Result: on_us of the first step, off_us of the last, source/tag of step 0.
+// step_results must stay valid until the result has been polled.
+bool pulse_engine_start_sequence(const PulseRequest *steps, uint8_t count, PulseResult *step_results);
+bool pulse_engine_arm(const PulseRequest &request);  // false while a pulse is running
+void pulse_engine_disarm();
+bool pulse_engine_armed();
+bool pulse_engine_fire();                             // ISR-safe; false if nothing was armed
+bool pulse_engine_busy();
+bool pulse_engine_poll(PulseResult &result);           // Non-blocking completion read
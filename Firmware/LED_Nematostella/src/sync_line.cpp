@@ -0,0 +1,83 @@
+#include "sync_line.h"
+#include "driver/gpio.h"
+#include "led_io.h"
+#include "pulse_engine.h"
+
+const uint32_t SYNC_LINE_HIGH_US         = 20;   // Line pulse width
+const uint32_t SYNC_LINE_EDGE_TIMEOUT_US = 100;  // Master waits this long for its own edge
+
+static int               syncPin     = -1;
+static TaskHandle_t      notifyTask  = NULL;
+static volatile SyncRole syncRole    = SYNC_ROLE_OFF;
+static volatile uint32_t edgeCount   = 0;
+static volatile uint32_t missedCount = 0;
+static volatile bool     edgeFired   = false;  // Last edge started the armed pulse
+
+static void IRAM_ATTR onSyncEdge() {
+  // Pulse first, bookkeeping afterwards
+  bool fired = pulse_engine_fire();
+  edgeCount++;
+  if (!fired) missedCount++;
+  edgeFired = fired;
+
+  BaseType_t woken = pdFALSE;
+  if (notifyTask) vTaskNotifyGiveFromISR(notifyTask, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+void sync_line_init(int pin, TaskHandle_t notify_task) {
+  syncPin    = pin;
+  notifyTask = notify_task;
+  if (syncPin < 0) return;
+  pinMode(syncPin, INPUT);
+  attachInterrupt(syncPin, onSyncEdge, RISING);
+}
+
+bool sync_line_set_role(SyncRole role) {
+  if (syncPin < 0) return false;
+  switch (role) {
+    case SYNC_ROLE_MASTER:
+      trigger_write(syncPin, false);
+      // Input stays enabled, the edge interrupt sees the pad like on a slave
+      gpio_set_direction((gpio_num_t)syncPin, GPIO_MODE_INPUT_OUTPUT);
+      break;
+    case SYNC_ROLE_SLAVE:
+      gpio_set_direction((gpio_num_t)syncPin, GPIO_MODE_INPUT);
+      gpio_set_pull_mode((gpio_num_t)syncPin, GPIO_PULLDOWN_ONLY);
+      break;
+    default:
+      gpio_set_direction((gpio_num_t)syncPin, GPIO_MODE_INPUT);
+      gpio_set_pull_mode((gpio_num_t)syncPin, GPIO_FLOATING);
+      break;
+  }
+  syncRole = role;
+  return true;
+}
+
+SyncRole sync_line_role() {
+  return syncRole;
+}
+
+bool sync_line_trigger() {
+  if (syncRole != SYNC_ROLE_MASTER) return false;
+
+  edgeFired = false;
+  uint32_t edges = edgeCount;
+  int64_t start_us = esp_timer_get_time();
+  trigger_write(syncPin, true);
+  // The edge ISR runs on this core and preempts the wait
+  while (edgeCount == edges && esp_timer_get_time() - start_us < SYNC_LINE_EDGE_TIMEOUT_US) {
+  }
+  while (esp_timer_get_time() - start_us < SYNC_LINE_HIGH_US) {
+  }
+  trigger_write(syncPin, false);
+  return edgeCount != edges && edgeFired;
+}
+
+uint32_t sync_line_edges() {
+  return edgeCount;
+}
+
+uint32_t sync_line_missed() {
+  return missedCount;
+}
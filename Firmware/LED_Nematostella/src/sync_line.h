@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ========================================================================
+// SYNC LINE - One shared GPIO that starts the pulses of several boards
+// ========================================================================
+// All boards' sync pins are wired together (plus a common ground). The
+// master drives a short high pulse on the line; every board, the master
+// included, starts its armed pulse (pulse_engine_arm) from the rising-edge
+// interrupt. All LED-on edges therefore follow one electrical edge through
+// the same ISR path - the skew is interrupt latency jitter (a few us), not
+// host round trips. The master reads its own edge back through the pad
+// (input + output mode), so it has no shortcut the slaves lack.
+//
+// Slaves drop edges that arrive while nothing is armed (own pulse still
+// running) and count them as missed.
+// ========================================================================
+
+enum SyncRole : uint8_t {
+  SYNC_ROLE_OFF    = 0,  // Pin released (input)
+  SYNC_ROLE_MASTER = 1,  // Drives the line
+  SYNC_ROLE_SLAVE  = 2   // Listens, pull-down keeps an open line low
+};
+
+// pin < 0 = no sync line; notify_task is woken after every edge
+void     sync_line_init(int pin, TaskHandle_t notify_task);
+bool     sync_line_set_role(SyncRole role);  // false without a pin
+SyncRole sync_line_role();
+// Master: drive one edge. True once this board's armed pulse has started
+// from it (false: wrong role, or the edge never came back - line held low)
+bool     sync_line_trigger();
+uint32_t sync_line_edges();   // Rising edges seen since boot
+uint32_t sync_line_missed();  // Edges with no armed pulse
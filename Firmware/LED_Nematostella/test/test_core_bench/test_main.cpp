@@ -0,0 +1,221 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+
+#include "command_parser.h"
+#include "dht_decode.h"
+#include "duty_lut.h"
+#include "frame_codec.h"
+#include "led_io.h"
+#include "pulse_engine.h"
+#include "timing_stats.h"
+
+// ========================================================================
+// ON-DEVICE CORE BENCHMARKS - pio test -e esp32dev_bench
+// ========================================================================
+// Correctness checks plus per-operation cost of the code on the command
+// and pulse paths, measured with esp_timer on the target. Each benchmark
+// prints "[bench] <name>: <ns>/op" and fails above its budget, so a
+// regression shows up before the host-side soak test
+// (scripts/firmware_benchmark.py) ever runs.
+// ========================================================================
+
+const uint32_t BENCH_ITERATIONS = 2000;
+
+static uint32_t dispatched = 0;
+static void countHandler(const uint8_t *payload) { dispatched++; }
+static void ignoreError(uint8_t cmd) {}
+
+static const CommandSpec BENCH_TABLE[] = {
+  { 0x02, 0,  0,    countHandler },  // STATUS
+  { 0x0C, 0,  0,    countHandler },  // SYNC_CAPTURE
+  { 0x11, 4,  1000, countHandler },  // SET_TIMING
+  { 0x40, 14, 1000, countHandler },  // START_SCHEDULE
+};
+
+static void reportBench(const char *name, int64_t elapsed_us, uint32_t ops, uint32_t budget_ns) {
+  uint32_t ns_per_op = (uint32_t)(elapsed_us * 1000 / ops);
+  char line[80];
+  snprintf(line, sizeof(line), "[bench] %s: %u ns/op (budget %u)", name,
+           (unsigned)ns_per_op, (unsigned)budget_ns);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(budget_ns, ns_per_op);
+}
+
+void test_command_parser_dispatch() {
+  static CommandParser parser;
+  command_parser_init(parser, BENCH_TABLE, sizeof(BENCH_TABLE) / sizeof(BENCH_TABLE[0]),
+                      ignoreError, ignoreError);
+  const uint8_t stream[] = { 0x02, 0x11, 0x01, 0x90, 0x00, 0x14, 0x0C };
+
+  dispatched = 0;
+  int64_t start_us = esp_timer_get_time();
+  for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+    for (uint8_t b = 0; b < sizeof(stream); b++) {
+      command_parser_feed(parser, stream[b], 0);
+    }
+  }
+  int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+  TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS * 3, dispatched);
+  TEST_ASSERT_TRUE(command_parser_idle(parser));
+  reportBench("parser_feed_byte", elapsed_us, BENCH_ITERATIONS * sizeof(stream), 2000);
+}
+
+void test_frame_roundtrip() {
+  uint8_t payload[31];
+  for (uint8_t i = 0; i < sizeof(payload); i++) payload[i] = i * 7;
+  uint8_t wire[FRAME_MAX_SIZE];
+  static FrameDecoder decoder;
+  frame_decoder_init(decoder, 100);
+
+  int64_t start_us = esp_timer_get_time();
+  uint8_t size = 0;
+  for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+    size = frame_encode(wire, 0x1E, (uint8_t)i, payload, sizeof(payload));
+  }
+  int64_t encode_us = esp_timer_get_time() - start_us;
+
+  uint32_t ready = 0;
+  start_us = esp_timer_get_time();
+  for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+    for (uint8_t b = 0; b < size; b++) {
+      frame_decoder_push(decoder, wire[b], 0);
+      while (frame_decoder_next(decoder, 0) == FRAME_READY) ready++;
+    }
+  }
+  int64_t decode_us = esp_timer_get_time() - start_us;
+
+  TEST_ASSERT_EQUAL_UINT8(sizeof(payload) + FRAME_OVERHEAD, size);
+  TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS, ready);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, decoder.payload, sizeof(payload));
+  reportBench("frame_encode_31", encode_us, BENCH_ITERATIONS, 20000);
+  reportBench("frame_decode_31", decode_us, BENCH_ITERATIONS, 60000);
+}
+
+void test_duty_lut() {
+  uint16_t curve[DUTY_CURVE_POINTS];
+  duty_curve_identity(curve);
+  TEST_ASSERT_TRUE(duty_curve_valid(curve));
+
+  static DutyLut lut;
+  int64_t start_us = esp_timer_get_time();
+  for (uint32_t i = 0; i < BENCH_ITERATIONS / 10; i++) {
+    duty_lut_build(lut, curve, 1023);
+  }
+  int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+  // Identity curve reproduces map(power, 0, 100, 0, 1023)
+  for (uint8_t power = 0; power <= 100; power++) {
+    TEST_ASSERT_EQUAL_UINT16(map(power, 0, 100, 0, 1023), duty_lut_get(lut, power));
+  }
+  reportBench("duty_lut_build", elapsed_us, BENCH_ITERATIONS / 10, 100000);
+}
+
+void test_dht_decode() {
+  // 65.2 %RH, -10.1 C: 0x028C, 0x8065, checksum 0x73
+  const uint8_t bytes[5] = { 0x02, 0x8C, 0x80, 0x65, 0x73 };
+  uint16_t high_us[DHT_FRAME_BITS + 2] = { 80, 80 };  // Preamble
+  for (uint8_t i = 0; i < DHT_FRAME_BITS; i++) {
+    high_us[i + 2] = (bytes[i / 8] >> (7 - i % 8)) & 1 ? 70 : 27;
+  }
+
+  float t = 0, h = 0;
+  int64_t start_us = esp_timer_get_time();
+  DhtStatus status = DHT_PENDING;
+  for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+    status = dht_decode(high_us, sizeof(high_us) / sizeof(high_us[0]), t, h);
+  }
+  int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+  TEST_ASSERT_EQUAL_UINT8(DHT_OK, status);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 65.2f, h);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, -10.1f, t);
+  uint16_t &last = high_us[DHT_FRAME_BITS + 1];  // Flip the last checksum bit
+  last = last > DHT_BIT_THRESHOLD_US ? 27 : 70;
+  TEST_ASSERT_EQUAL_UINT8(DHT_CHECKSUM, dht_decode(high_us, DHT_FRAME_BITS + 2, t, h));
+  reportBench("dht_decode", elapsed_us, BENCH_ITERATIONS, 10000);
+}
+
+void test_timing_stat_record() {
+  static TimingStat stat;
+  timing_stat_reset(stat);
+
+  int64_t start_us = esp_timer_get_time();
+  for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+    timing_stat_record(stat, i);
+  }
+  int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+  TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS, stat.count);
+  TEST_ASSERT_EQUAL_UINT32(0, stat.min_us);
+  TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS - 1, stat.max_us);
+  TEST_ASSERT_EQUAL_UINT32((BENCH_ITERATIONS - 1) / 2, timing_stat_mean(stat));
+  reportBench("timing_stat_record", elapsed_us, BENCH_ITERATIONS, 2000);
+}
+
+void test_led_channel_write() {
+  // LEDC channel without a pin - register writes only
+  const uint8_t channel = 0;
+  ledcSetup(channel, PWM_FREQUENCY, PWM_RESOLUTION);
+
+  int64_t start_us = esp_timer_get_time();
+  for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+    ledcWrite(channel, i & 1 ? 512 : 0);
+  }
+  int64_t driver_us = esp_timer_get_time() - start_us;
+
+  start_us = esp_timer_get_time();
+  for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+    led_channel_write(channel, i & 1 ? 512 : 0);
+  }
+  int64_t direct_us = esp_timer_get_time() - start_us;
+
+  led_channel_write(channel, 0);
+  reportBench("ledcWrite", driver_us, BENCH_ITERATIONS, 20000);
+  reportBench("led_channel_write", direct_us, BENCH_ITERATIONS, 2000);
+}
+
+void test_pulse_engine_accuracy() {
+  // No LEDC channels and no trigger - only the timer ISR and edge stamps
+  pulse_engine_init(-1);
+  PulseRequest request = {};
+  request.duration_us = 10000;
+
+  uint32_t worst_error_us = 0;
+  for (uint8_t i = 0; i < 20; i++) {
+    request.tag = i;
+    TEST_ASSERT_TRUE(pulse_engine_start(request));
+    TEST_ASSERT_FALSE(pulse_engine_start(request));  // Busy until the ISR completes
+
+    PulseResult result;
+    uint32_t waited_ms = 0;
+    while (!pulse_engine_poll(result)) {
+      TEST_ASSERT_LESS_THAN_UINT32(100, waited_ms++);
+      delay(1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(i, result.tag);
+    uint32_t error_us = (uint32_t)llabs(result.off_us - result.on_us - (int64_t)request.duration_us);
+    if (error_us > worst_error_us) worst_error_us = error_us;
+  }
+
+  char line[64];
+  snprintf(line, sizeof(line), "[bench] pulse_10ms_worst_error: %u us", (unsigned)worst_error_us);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(20, worst_error_us);
+}
+
+void setup() {
+  delay(2000);  // Let the test runner open the port
+  UNITY_BEGIN();
+  RUN_TEST(test_command_parser_dispatch);
+  RUN_TEST(test_frame_roundtrip);
+  RUN_TEST(test_duty_lut);
+  RUN_TEST(test_dht_decode);
+  RUN_TEST(test_timing_stat_record);
+  RUN_TEST(test_led_channel_write);
+  RUN_TEST(test_pulse_engine_accuracy);
+  UNITY_END();
+}
+
+void loop() {}
@@ -0,0 +1,473 @@
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include "command_parser.h"
+#include "device_config.h"
+#include "duty_lut.h"
+#include "event_log.h"
+#include "frame_codec.h"
+#include "hal.h"
+#include "response_builder.h"
+#include "response_encode.h"
+#include "resume_state.h"
+#include "sensor_filter.h"
+#include "settle_detect.h"
+
+// ========================================================================
+// NATIVE PROTOCOL CORE TESTS - pio test -e native
+// ========================================================================
+// lib/protocol_core built for the workstation: wire layouts, parser and
+// framing behaviour, duty LUT, sensor filter, event log ring, LED settle
+// detection, resume state slots. The benchmarks at the end print "[bench] <name>: <ns>/op"
+// without budgets - host numbers only compare against runs on the same
+// machine (on-device budgets: test_core_bench).
+// ========================================================================
+
+// HAL: responses land in a capture buffer instead of a serial port
+static uint8_t  serialOut[256];
+static uint16_t serialOutLen = 0;
+
+void hal_serial_write(const uint8_t *data, uint8_t len) {
+  if (serialOutLen + len > sizeof(serialOut)) return;
+  memcpy(&serialOut[serialOutLen], data, len);
+  serialOutLen += len;
+}
+
+static uint8_t lastCmd = 0;
+static uint8_t lastPayload[COMMAND_MAX_PAYLOAD];
+static uint32_t dispatched = 0;
+static uint8_t unknownCmd = 0;
+static uint8_t timedOutCmd = 0;
+
+static void onStatus(const uint8_t *payload) { lastCmd = 0x02; dispatched++; }
+static void onSetTiming(const uint8_t *payload) {
+  lastCmd = 0x11;
+  memcpy(lastPayload, payload, 4);
+  dispatched++;
+}
+static void onUnknown(uint8_t cmd) { unknownCmd = cmd; }
+static void onTimeout(uint8_t cmd) { timedOutCmd = cmd; }
+
+static const CommandSpec TEST_TABLE[] = {
+  { 0x02, 0, 0,    onStatus },     // STATUS
+  { 0x11, 4, 1000, onSetTiming },  // SET_TIMING
+};
+static CommandParser parser;
+
+void setUp() {
+  command_parser_init(parser, TEST_TABLE, sizeof(TEST_TABLE) / sizeof(TEST_TABLE[0]),
+                      onUnknown, onTimeout);
+  dispatched = 0;
+  lastCmd = unknownCmd = timedOutCmd = 0;
+  serialOutLen = 0;
+}
+
+void tearDown() {}
+
+void test_parser_dispatch_fragmented_payload() {
+  const uint8_t stream[] = { 0x11, 0x01, 0x90, 0x00, 0x14 };
+  for (uint8_t i = 0; i < sizeof(stream); i++) {
+    command_parser_feed(parser, stream[i], i * 10);  // One byte per 10 ms
+    TEST_ASSERT_EQUAL_UINT32(i == sizeof(stream) - 1 ? 1 : 0, dispatched);
+  }
+  TEST_ASSERT_EQUAL_HEX8(0x11, lastCmd);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(&stream[1], lastPayload, 4);
+  TEST_ASSERT_TRUE(command_parser_idle(parser));
+}
+
+void test_parser_unknown_and_timeout() {
+  command_parser_feed(parser, 0x99, 0);
+  TEST_ASSERT_EQUAL_HEX8(0x99, unknownCmd);
+
+  command_parser_feed(parser, 0x11, 100);
+  command_parser_feed(parser, 0x01, 200);
+  command_parser_poll(parser, 1100);  // Exactly the timeout - still waiting
+  TEST_ASSERT_EQUAL_HEX8(0, timedOutCmd);
+  command_parser_poll(parser, 1101);
+  TEST_ASSERT_EQUAL_HEX8(0x11, timedOutCmd);
+  TEST_ASSERT_TRUE(command_parser_idle(parser));
+
+  // The parser is usable again after the timeout
+  command_parser_feed(parser, 0x02, 1200);
+  TEST_ASSERT_EQUAL_HEX8(0x02, lastCmd);
+}
+
+void test_status_layout() {
+  ResponseBuilder response;
+  encode_status(response, 0x11, 23.46f, 101.0f);
+  const uint8_t expected[] = { 0x11, 0x00, 0xEA, 0x03, 0xE8 };  // 23.4 C, humidity clamped
+  TEST_ASSERT_EQUAL_UINT8(sizeof(expected), response.len);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, response.buf, sizeof(expected));
+
+  ResponseBuilder cold;
+  encode_status(cold, 0x10, -55.0f, 40.0f);
+  TEST_ASSERT_EQUAL_HEX8(0xFE, cold.buf[1]);  // -40.0 C = 0xFE70
+  TEST_ASSERT_EQUAL_HEX8(0x70, cold.buf[2]);
+}
+
+void test_status_age() {
+  ResponseBuilder response;
+  encode_status_age(response, 12345);
+  encode_status_age(response, UINT32_MAX);
+  encode_status_age(response, 0xFFFFFFF0);
+  const uint8_t expected[] = { 0x00, 0x7B, 0xFF, 0xFF, 0xFF, 0xFE };
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, response.buf, sizeof(expected));
+}
+
+void test_sync_layout() {
+  ResponseBuilder response;
+  encode_sync(response, 0x1B, 1.0f, 2.0f, 425, 1, 80);
+  // 1.0f = 0x3F800000, 2.0f = 0x40000000, both little-endian
+  const uint8_t expected[15] = { 0x1B, 0x01, 0xA9, 0x00, 0x00, 0x80, 0x3F, 0x00, 0x00,
+                                 0x00, 0x40, 0x01, 0x01, 0xA9, 0x50 };
+  TEST_ASSERT_EQUAL_UINT8(15, response.len);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, response.buf, sizeof(expected));
+
+  encode_sync_edges(response, 0x0102030405060708LL, 1);
+  TEST_ASSERT_EQUAL_UINT8(31, response.len);
+  TEST_ASSERT_EQUAL_HEX8(0x01, response.buf[15]);
+  TEST_ASSERT_EQUAL_HEX8(0x08, response.buf[22]);
+  TEST_ASSERT_EQUAL_HEX8(0x01, response.buf[30]);
+
+  ResponseBuilder settle = response;
+  encode_sync_settle(settle, 95, 0x00012345);
+  const uint8_t tail[6] = { 0x00, 0x5F, 0x00, 0x01, 0x23, 0x45 };
+  TEST_ASSERT_EQUAL_UINT8(37, settle.len);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(tail, &settle.buf[31], sizeof(tail));
+
+  response.send();
+  TEST_ASSERT_EQUAL_UINT16(31, serialOutLen);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(response.buf, serialOut, 31);
+}
+
+void test_telemetry_layout() {
+  TelemetryRecord record = {};
+  record.seq         = 0x0102;
+  record.fields      = TELEMETRY_FIELD_LEDS | TELEMETRY_FIELD_TIMING;
+  record.led_on_mask = 0x03;
+  record.ir_power    = 80;
+  record.pulse_count = 7;
+  record.cmd_to_led_on_max_us = 250;
+  record.led_on_error_max_us  = 100000;  // Saturates
+  ResponseBuilder response;
+  encode_telemetry(response, 0x3F, record);
+  const uint8_t expected[] = { 0x3F, 0x01, 0x02, 0x05, 0x03, 0x00, 0x50, 0x00,
+                               0x00, 0x00, 0x00, 0x07, 0x00, 0xFA, 0xFF, 0xFF,
+                               0x00, 0x00, 0x00, 0x00 };
+  TEST_ASSERT_EQUAL_UINT8(telemetry_record_size(record.fields), response.len);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, response.buf, sizeof(expected));
+
+  // Every group at once still fits one response; unknown bits are dropped
+  ResponseBuilder full;
+  record.fields        = 0xFF;
+  record.sensor_age_ms = UINT32_MAX;
+  encode_telemetry(full, 0x3F, record);
+  TEST_ASSERT_FALSE(full.overflow);
+  TEST_ASSERT_EQUAL_UINT8(30, full.len);
+  TEST_ASSERT_EQUAL_HEX8(TELEMETRY_FIELDS_ALL, full.buf[3]);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, full.buf[12]);  // Sensor age "none"
+}
+
+static EventRecord eventAt(uint64_t time_us, uint8_t type, uint16_t arg16) {
+  EventRecord record = {};
+  record.time_us = time_us;
+  record.type    = type;
+  record.arg16   = arg16;
+  return record;
+}
+
+void test_event_log_ring() {
+  EventSlot slots[4];
+  EventLog log;
+  event_log_init(log, slots, 4, false);
+  for (uint16_t i = 0; i < 6; i++) {
+    TEST_ASSERT_EQUAL_UINT32(i, event_log_add(log, eventAt(1000 + i, EVENT_COMMAND, i)));
+  }
+
+  // The ring holds the newest 4, older indexes are gone
+  EventRecord record;
+  TEST_ASSERT_EQUAL_UINT32(6, event_log_head(log));
+  TEST_ASSERT_EQUAL_UINT32(2, event_log_oldest(log));
+  TEST_ASSERT_FALSE(event_log_read(log, 1, record));
+  TEST_ASSERT_FALSE(event_log_read(log, 6, record));
+  TEST_ASSERT_TRUE(event_log_read(log, 5, record));
+  TEST_ASSERT_EQUAL_UINT16(5, record.arg16);
+  TEST_ASSERT_EQUAL_UINT32(1005, (uint32_t)record.time_us);
+
+  // A slot caught mid-write reads as missing
+  slots[3 % 4].stamp = 0;
+  TEST_ASSERT_FALSE(event_log_read(log, 3, record));
+
+  // Reset with kept slots: head and records come back, the torn slot does not
+  EventLog kept;
+  event_log_init(kept, slots, 4, true);
+  TEST_ASSERT_EQUAL_UINT32(6, event_log_head(kept));
+  TEST_ASSERT_EQUAL_UINT32(2, event_log_oldest(kept));
+  TEST_ASSERT_TRUE(event_log_read(kept, 4, record));
+  TEST_ASSERT_EQUAL_UINT16(4, record.arg16);
+  TEST_ASSERT_FALSE(event_log_read(kept, 3, record));
+
+  // Cleared records stay gone across another reset
+  event_log_clear(kept, 5);
+  TEST_ASSERT_EQUAL_UINT32(5, event_log_oldest(kept));
+  event_log_init(kept, slots, 4, true);
+  TEST_ASSERT_EQUAL_UINT32(5, event_log_oldest(kept));
+  TEST_ASSERT_EQUAL_UINT32(6, event_log_head(kept));
+}
+
+void test_event_chunk_layout() {
+  EventSlot slots[8];
+  EventLog log;
+  event_log_init(log, slots, 8, false);
+  EventRecord record = eventAt(0x0102030405ULL, EVENT_PULSE_END, 0x0A0B);
+  record.arg8  = 1;
+  record.arg32 = 20000;
+  event_log_add(log, record);
+  event_log_add(log, eventAt(7, EVENT_BOOT, 0));
+
+  ResponseBuilder response;
+  TEST_ASSERT_EQUAL_UINT8(2, encode_event_chunk(response, 0x40, log, 0, 2));
+  const uint8_t expected[] = { 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+                               0x02, EVENT_CHUNK_FLAG_LAST,
+                               EVENT_PULSE_END, 0x01, 0x0A, 0x0B, 0x00, 0x00, 0x4E, 0x20,
+                               0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 };
+  TEST_ASSERT_EQUAL_UINT8(EVENT_CHUNK_HEADER_SIZE + 2 * EVENT_RECORD_SIZE, response.len);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, response.buf, sizeof(expected));
+
+  // A full chunk fits one frame and is not the last one of a longer range
+  for (uint8_t i = 0; i < 4; i++) event_log_add(log, eventAt(i, EVENT_COMMAND, i));
+  ResponseBuilder full;
+  TEST_ASSERT_EQUAL_UINT8(EVENT_CHUNK_RECORDS, encode_event_chunk(full, 0x40, log, 0, 6));
+  TEST_ASSERT_FALSE(full.overflow);
+  TEST_ASSERT_EQUAL_HEX8(0, full.buf[10]);
+}
+
+void test_response_overflow_drops() {
+  ResponseBuilder response;
+  for (uint8_t i = 0; i < RESPONSE_BUILDER_CAPACITY / 4 + 1; i++) {
+    response.put_u32_be(i);
+  }
+  TEST_ASSERT_TRUE(response.overflow);
+  response.send();
+  TEST_ASSERT_EQUAL_UINT16(0, serialOutLen);
+}
+
+void test_frame_resync_after_corruption() {
+  const uint8_t payload[] = { 0x00, 0x14 };
+  uint8_t wire[2 * FRAME_MAX_SIZE];
+  uint8_t first = frame_encode(wire, 0x11, 7, payload, sizeof(payload));
+  uint8_t second = frame_encode(&wire[first], 0x02, 8, NULL, 0);
+  wire[first - 1] ^= 0xFF;  // Corrupt the CRC of the first frame
+
+  FrameDecoder decoder;
+  frame_decoder_init(decoder, 100);
+  uint8_t errors = 0, ready = 0;
+  for (uint8_t i = 0; i < first + second; i++) {
+    frame_decoder_push(decoder, wire[i], 0);
+    FrameStatus status;
+    while ((status = frame_decoder_next(decoder, 0)) != FRAME_NONE) {
+      if (status == FRAME_READY) {
+        ready++;
+        TEST_ASSERT_EQUAL_HEX8(0x02, decoder.id);
+        TEST_ASSERT_EQUAL_UINT8(8, decoder.seq);
+      } else {
+        errors++;
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT8(1, errors);
+  TEST_ASSERT_EQUAL_UINT8(1, ready);
+}
+
+void test_device_config_roundtrip() {
+  DeviceConfig config = { 400, 20, 80, 30, 1, 0, 1, 1000, 1 };
+  uint8_t blob[DEVICE_CONFIG_SIZE];
+  device_config_encode(config, blob);
+
+  DeviceConfig decoded = {};
+  TEST_ASSERT_TRUE(device_config_decode(decoded, blob, sizeof(blob)));
+  TEST_ASSERT_EQUAL_UINT16(400, decoded.stabilization_ms);
+  TEST_ASSERT_EQUAL_UINT16(1000, decoded.trigger_width_us);
+  TEST_ASSERT_EQUAL_UINT8(1, decoded.sync_format);
+
+  blob[3] ^= 0x01;
+  TEST_ASSERT_FALSE(device_config_decode(decoded, blob, sizeof(blob)));
+}
+
+void test_resume_state_slots() {
+  ResumeSlot slots[RESUME_SLOTS];
+  memset(slots, 0xA5, sizeof(slots));  // Power-on garbage
+  ResumeState state;
+  TEST_ASSERT_EQUAL_INT8(-1, resume_state_read(slots, state));
+
+  ResumeState written;
+  memset(&written, 0, sizeof(written));
+  written.generation = 0xFFFFFFFF;
+  written.on_mask    = 0x01;
+  written.schedule.next_frame = 41;
+  resume_state_write(slots[1], written);
+  written.generation = 0;  // Wrapped, still newer
+  written.on_mask    = 0x03;
+  resume_state_write(slots[0], written);
+
+  TEST_ASSERT_EQUAL_INT8(0, resume_state_read(slots, state));
+  TEST_ASSERT_EQUAL_UINT8(0x03, state.on_mask);
+  TEST_ASSERT_EQUAL_UINT32(41, state.schedule.next_frame);
+
+  // Torn write: the older slot is brought back
+  slots[0].words[3] ^= 0x100;
+  TEST_ASSERT_EQUAL_INT8(1, resume_state_read(slots, state));
+  TEST_ASSERT_EQUAL_UINT8(0x01, state.on_mask);
+
+  // A resumed boot that crashed early boots cold
+  TEST_ASSERT_TRUE(resume_state_usable(state));
+  state.resumed   = 1;
+  state.uptime_ms = RESUME_MIN_UPTIME_MS - 1;
+  TEST_ASSERT_FALSE(resume_state_usable(state));
+  state.uptime_ms = RESUME_MIN_UPTIME_MS;
+  TEST_ASSERT_TRUE(resume_state_usable(state));
+}
+
+void test_duty_lut_fine() {
+  uint16_t points[DUTY_CURVE_POINTS];
+  duty_curve_identity(points);
+  DutyLut lut;
+  duty_lut_build(lut, points, 1023);
+
+  TEST_ASSERT_EQUAL_UINT16(0, duty_lut_get_fine(lut, 0));
+  TEST_ASSERT_EQUAL_UINT16(duty_lut_get(lut, 37), duty_lut_get_fine(lut, 3700));
+  TEST_ASSERT_EQUAL_UINT16(1023, duty_lut_get_fine(lut, 10000));
+  TEST_ASSERT_EQUAL_UINT16(1023, duty_lut_get_fine(lut, 12000));  // Clamped
+
+  // Halfway between two entries, and never outside them
+  uint16_t mid = duty_lut_get_fine(lut, 5050);
+  TEST_ASSERT_EQUAL_UINT16((duty_lut_get(lut, 50) + duty_lut_get(lut, 51) + 1) / 2, mid);
+  TEST_ASSERT_TRUE(mid >= duty_lut_get(lut, 50) && mid <= duty_lut_get(lut, 51));
+}
+
+void test_settle_detect() {
+  // Step from dark 100 to 2100 counts: overshoot, ringing, then flat
+  SettleSample samples[64];
+  const uint16_t rise[] = { 600, 1500, 2300, 2250, 1850, 2150, 2070 };
+  for (uint16_t i = 0; i < 64; i++) {
+    samples[i].t_us  = i * 1000;
+    samples[i].value = i < sizeof(rise) / sizeof(rise[0]) ? rise[i] : 2100 + (i & 1) * 4;
+  }
+  SettleParams params = { 20, 8, 40 };  // 2 % of the step = 40 counts
+  TEST_ASSERT_EQUAL_UINT32(6000, settle_detect(samples, 64, 100, params));
+
+  // A wider band accepts the ringing earlier
+  params.tolerance_permille = 100;
+  TEST_ASSERT_EQUAL_UINT32(5000, settle_detect(samples, 64, 100, params));
+
+  // Still drifting at the end of the window
+  params.tolerance_permille = 20;
+  for (uint16_t i = 40; i < 64; i++) samples[i].value = 2100 + (i - 40) * 10;
+  TEST_ASSERT_EQUAL_UINT32(SETTLE_NONE, settle_detect(samples, 64, 100, params));
+
+  // No light on the photodiode
+  for (uint16_t i = 0; i < 64; i++) samples[i].value = 110;
+  TEST_ASSERT_EQUAL_UINT32(SETTLE_NO_SIGNAL, settle_detect(samples, 64, 100, params));
+  TEST_ASSERT_EQUAL_UINT32(SETTLE_NONE, settle_detect(samples, SETTLE_FINAL_SAMPLES, 100, params));
+}
+
+void test_sensor_filter() {
+  SensorFilter filter;
+  sensor_filter_reset(filter);
+  TEST_ASSERT_EQUAL_FLOAT(SENSOR_FILTER_DEFAULT_TEMP, sensor_filter_temperature(filter));
+
+  sensor_filter_add(filter, 20.0f, 40.0f, 1000);  // Fills the window
+  TEST_ASSERT_EQUAL_FLOAT(20.0f, sensor_filter_temperature(filter));
+  sensor_filter_add(filter, 25.0f, 60.0f, 3000);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 21.0f, sensor_filter_temperature(filter));
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 44.0f, sensor_filter_humidity(filter));
+
+  float t, h;
+  sensor_filter_newest(filter, t, h);
+  TEST_ASSERT_EQUAL_FLOAT(25.0f, t);
+  TEST_ASSERT_EQUAL_FLOAT(60.0f, h);
+  TEST_ASSERT_EQUAL_UINT32(3000, filter.last_valid_ms);
+
+  for (uint8_t i = 0; i < SENSOR_FILTER_SIZE; i++) {
+    sensor_filter_add(filter, 30.0f, 50.0f, 5000);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(30.0f, sensor_filter_temperature(filter));
+}
+
+// ------------------------------------------------------------------------
+// Benchmarks
+// ------------------------------------------------------------------------
+
+const uint32_t BENCH_ITERATIONS = 1000000;
+
+static void reportBench(const char *name, std::chrono::steady_clock::duration elapsed,
+                        uint32_t ops) {
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count() / ops;
+  char line[80];
+  snprintf(line, sizeof(line), "[bench] %s: %.1f ns/op", name, ns);
+  TEST_MESSAGE(line);
+}
+
+void bench_parser_throughput() {
+  const uint8_t stream[] = { 0x02, 0x11, 0x01, 0x90, 0x00, 0x14 };
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+    for (uint8_t b = 0; b < sizeof(stream); b++) {
+      command_parser_feed(parser, stream[b], i);
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS * 2, dispatched);
+  reportBench("parser_feed_byte", elapsed, BENCH_ITERATIONS * sizeof(stream));
+}
+
+void bench_sync_encode() {
+  volatile uint8_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+    ResponseBuilder response;
+    encode_sync(response, 0x1E, 24.5f, 55.0f, (uint16_t)i, 0, 100);
+    encode_sync_edges(response, i, i + 420000);
+    sink = sink + response.buf[30];
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  reportBench("sync_encode_31", elapsed, BENCH_ITERATIONS);
+}
+
+void bench_frame_encode() {
+  uint8_t payload[30] = { 0 };
+  uint8_t wire[FRAME_MAX_SIZE];
+  volatile uint8_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+    payload[0] = (uint8_t)i;
+    sink = sink + frame_encode(wire, 0x1E, (uint8_t)i, payload, sizeof(payload));
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  reportBench("frame_encode_31", elapsed, BENCH_ITERATIONS);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_parser_dispatch_fragmented_payload);
+  RUN_TEST(test_parser_unknown_and_timeout);
+  RUN_TEST(test_status_layout);
+  RUN_TEST(test_status_age);
+  RUN_TEST(test_sync_layout);
+  RUN_TEST(test_telemetry_layout);
+  RUN_TEST(test_event_log_ring);
+  RUN_TEST(test_event_chunk_layout);
+  RUN_TEST(test_response_overflow_drops);
+  RUN_TEST(test_frame_resync_after_corruption);
+  RUN_TEST(test_device_config_roundtrip);
+  RUN_TEST(test_resume_state_slots);
+  RUN_TEST(test_duty_lut_fine);
+  RUN_TEST(test_settle_detect);
+  RUN_TEST(test_sensor_filter);
+  RUN_TEST(bench_parser_throughput);
+  RUN_TEST(bench_sync_encode);
+  RUN_TEST(bench_frame_encode);
+  return UNITY_END();
+}
@@ -0,0 +1,349 @@
+#!/usr/bin/env python3
+"""
+Host-side latency benchmark and soak test for the LED_Nematostella firmware.
+
+Measures the round trip of each serial command (p50/p99/max in µs), the
+sustained SYNC_CAPTURE rate and, in soak mode, repeats both for hours while
+collecting the on-device timing statistics (CMD_GET_TIMING_STATS) of every
+interval. Results go to a JSON file; passing the JSON of a previous run
+(e.g. the last firmware release) as --baseline flags timing regressions
+and makes the script exit with status 1.
+
+The on-device counterpart (parser/codec cost, pulse accuracy) is the Unity
+suite in Firmware/LED_Nematostella/test, run with `pio test -e esp32dev_bench`.
+
+Run with:
+    python scripts/firmware_benchmark.py --port COM3 --output v2.5.json
+    python scripts/firmware_benchmark.py --soak-hours 8 --baseline v2.4.json
+"""
+
+import argparse
+import json
+import logging
+import math
+import os
+import pathlib
+import sys
+import time
+
+_repo_root = pathlib.Path(os.path.abspath(__file__)).parent.parent
+sys.path.insert(0, str(_repo_root / "src"))
+
+from timeseries_capture.ESP32_Controller import (  # noqa: E402
+    CommandBuilder,
+    ESP32Controller,
+    LEDTypes,
+    ResponseParser,
+    Responses,
+)
+
+logging.basicConfig(level=logging.WARNING)
+
+# Sleep between serial polls while waiting for a reply - small enough not to
+# quantize the measured round trip
+POLL_INTERVAL_S = 0.0002
+
+# A result only counts as a regression above both limits, so USB jitter on
+# sub-millisecond commands does not trip the comparison
+DEFAULT_THRESHOLD = 0.20  # Relative increase
+ABSOLUTE_SLACK_US = 250
+
+# name -> (command bytes, reply length). Replies of a fixed length, read
+# completely before the next command goes out.
+MEASURED_COMMANDS = {
+    "STATUS": (CommandBuilder.build_status(), 5),
+    "GET_LED_STATUS": (CommandBuilder.build_get_led_status(), 6),
+    "SELECT_LED_IR": (CommandBuilder.build_select_led_ir(), 1),
+    "SET_LED_POWER": (CommandBuilder.build_set_led_power(50), 1),
+    "LED_OFF": (CommandBuilder.build_led_off(), 1),
+    "GET_CONFIG": (CommandBuilder.build_get_config(), ResponseParser.CONFIG_LENGTH),
+    "TIME_SYNC": (CommandBuilder.build_time_sync(), 17),
+}
+
+# Captures: 0xAA ACK on LED-on, then the 15-byte completion
+CAPTURE_COMMANDS = {
+    "SYNC_CAPTURE": CommandBuilder.build_sync_capture(),
+    "SYNC_CAPTURE_DUAL": CommandBuilder.build_sync_capture_dual(),
+}
+SYNC_RESPONSE_LENGTH = ResponseParser.SYNC_RESPONSE_LENGTHS[Responses.SYNC_COMPLETE]
+
+
+# ---------------------------------------------------------------------------
+# Helpers
+# ---------------------------------------------------------------------------
+
+
+def percentile(values, fraction):
+    """Nearest-rank percentile of a non-empty list"""
+    ordered = sorted(values)
+    return ordered[max(0, math.ceil(fraction * len(ordered)) - 1)]
+
+
+def summarize(samples_us):
+    if not samples_us:
+        return {"count": 0}
+    return {
+        "count": len(samples_us),
+        "p50_us": percentile(samples_us, 0.50),
+        "p99_us": percentile(samples_us, 0.99),
+        "max_us": max(samples_us),
+    }
+
+
+def exchange(controller, command, reply_length, timeout=2.0):
+    """Send one command and read its reply, returns the round trip in µs or None"""
+    comm = controller.comm
+    start = time.perf_counter()
+    if not comm.send_bytes(command):
+        return None
+    reply = comm.read_bytes(reply_length, timeout=timeout, poll_interval=POLL_INTERVAL_S)
+    elapsed_us = (time.perf_counter() - start) * 1e6
+    return elapsed_us if reply else None
+
+
+def capture(controller, command, timeout=5.0):
+    """One sync capture, returns (ack µs, complete µs) or None"""
+    comm = controller.comm
+    start = time.perf_counter()
+    if not comm.send_bytes(command):
+        return None
+    ack = comm.read_bytes(1, timeout=1.0, poll_interval=POLL_INTERVAL_S)
+    if not ack or ack[0] != Responses.LED_ON_ACK:
+        return None
+    ack_us = (time.perf_counter() - start) * 1e6
+    done = comm.read_bytes(SYNC_RESPONSE_LENGTH, timeout=timeout, poll_interval=POLL_INTERVAL_S)
+    if not done:
+        return None
+    return ack_us, (time.perf_counter() - start) * 1e6
+
+
+# ---------------------------------------------------------------------------
+# Benchmarks
+# ---------------------------------------------------------------------------
+
+
+def run_command_round(controller, args):
+    """Round trip per command, returns name -> summary (failures counted separately)"""
+    iterations = args.iterations
+    results = {}
+    for name, (command, reply_length) in MEASURED_COMMANDS.items():
+        samples, failures = [], 0
+        for _ in range(iterations):
+            elapsed = exchange(controller, command, reply_length)
+            if elapsed is None:
+                failures += 1
+                controller.comm.clear_buffers()
+            else:
+                samples.append(elapsed)
+        results[name] = dict(summarize(samples), failures=failures)
+
+    for name, command in CAPTURE_COMMANDS.items():
+        acks, completes, failures = [], [], 0
+        for _ in range(iterations):
+            timing = capture(controller, command)
+            if timing is None:
+                failures += 1
+                controller.comm.clear_buffers()
+            else:
+                acks.append(timing[0])
+                completes.append(timing[1])
+        results[name + "_ACK"] = dict(summarize(acks), failures=failures)
+        results[name] = dict(summarize(completes), failures=failures)
+
+    # SET_TIMING last - captures above ran with the benchmark timing
+    samples = []
+    command = CommandBuilder.build_set_timing(args.stab_ms, args.exp_ms)
+    for _ in range(iterations):
+        elapsed = exchange(controller, command, 1)
+        if elapsed is not None:
+            samples.append(elapsed)
+    results["SET_TIMING"] = dict(summarize(samples), failures=iterations - len(samples))
+    return results
+
+
+def run_capture_rate(controller, seconds):
+    """Back-to-back SYNC_CAPTURE for `seconds`, returns captures per second"""
+    command = CAPTURE_COMMANDS["SYNC_CAPTURE"]
+    done, failures = 0, 0
+    start = time.perf_counter()
+    while time.perf_counter() - start < seconds:
+        if capture(controller, command):
+            done += 1
+        else:
+            failures += 1
+            controller.comm.clear_buffers()
+    elapsed = time.perf_counter() - start
+    return {"captures_per_s": done / elapsed, "captures": done, "failures": failures}
+
+
+def read_device_stats(controller):
+    """On-device timing stats since the last read (counters are reset)"""
+    stats = controller.get_timing_stats(reset=True) or {}
+    return {
+        name: {"count": s.count, "min_us": s.min_us, "mean_us": s.mean_us, "max_us": s.max_us}
+        for name, s in stats.items()
+        if s.count
+    }
+
+
+def run_interval(controller, args):
+    return {
+        "time": time.time(),
+        "commands": run_command_round(controller, args),
+        "capture_rate": run_capture_rate(controller, args.rate_seconds),
+        "device": read_device_stats(controller),
+    }
+
+
+# ---------------------------------------------------------------------------
+# Regression check
+# ---------------------------------------------------------------------------
+
+
+def worst_case(intervals):
+    """Per metric the worst value over all intervals of a run"""
+    worst = {"commands": {}, "device": {}, "captures_per_s": None}
+    for interval in intervals:
+        for name, summary in interval["commands"].items():
+            if summary.get("count"):
+                entry = worst["commands"].setdefault(name, {"p99_us": 0, "max_us": 0})
+                entry["p99_us"] = max(entry["p99_us"], summary["p99_us"])
+                entry["max_us"] = max(entry["max_us"], summary["max_us"])
+        for name, stat in interval["device"].items():
+            entry = worst["device"].setdefault(name, {"mean_us": 0, "max_us": 0})
+            entry["mean_us"] = max(entry["mean_us"], stat["mean_us"])
+            entry["max_us"] = max(entry["max_us"], stat["max_us"])
+        rate = interval["capture_rate"]["captures_per_s"]
+        if worst["captures_per_s"] is None or rate < worst["captures_per_s"]:
+            worst["captures_per_s"] = rate
+    return worst
+
+
+def find_regressions(current, baseline, threshold):
+    """Compare two worst_case() summaries, returns a list of messages"""
+    messages = []
+
+    def check(label, new, old):
+        if new > old * (1 + threshold) and new - old > ABSOLUTE_SLACK_US:
+            messages.append(f"{label}: {old:.0f} µs -> {new:.0f} µs")
+
+    for group, metrics in (("commands", ("p99_us",)), ("device", ("mean_us", "max_us"))):
+        for name, entry in current[group].items():
+            old = baseline[group].get(name)
+            if old:
+                for metric in metrics:
+                    check(f"{group}/{name} {metric}", entry[metric], old[metric])
+
+    old_rate, new_rate = baseline["captures_per_s"], current["captures_per_s"]
+    if old_rate and new_rate < old_rate * (1 - threshold):
+        messages.append(f"captures/s: {old_rate:.2f} -> {new_rate:.2f}")
+    return messages
+
+
+# ---------------------------------------------------------------------------
+# Main
+# ---------------------------------------------------------------------------
+
+
+def restore_settings(controller, config):
+    """Put back what the benchmark changed (the ESP32 persists it in NVS)"""
+    controller.set_timing(config.stabilization_ms, config.exposure_ms)
+    controller.set_led_power(config.ir_power, "ir")
+    controller.select_led_type("ir" if config.led_type == LEDTypes.IR else "white")
+    if config.sync_format:
+        controller.set_sync_timestamps(True)
+
+
+def print_interval(interval):
+    for name, summary in interval["commands"].items():
+        if summary.get("count"):
+            print(
+                f"  {name:<20} p50 {summary['p50_us']:8.0f}  p99 {summary['p99_us']:8.0f}  "
+                f"max {summary['max_us']:8.0f} µs  ({summary['failures']} failed)"
+            )
+        else:
+            print(f"  {name:<20} no replies")
+    rate = interval["capture_rate"]
+    print(f"  sustained capture rate: {rate['captures_per_s']:.2f}/s ({rate['failures']} failed)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--port", help="Serial port (auto-detected if omitted)")
+    parser.add_argument("--baud", type=int, help="Raise the link to this baudrate first")
+    parser.add_argument("--framed", action="store_true", help="Use the CRC-framed protocol v3")
+    parser.add_argument("--iterations", type=int, default=200, help="Samples per command")
+    parser.add_argument("--rate-seconds", type=float, default=20.0, help="Capture rate window")
+    parser.add_argument("--stab-ms", type=int, default=5, help="LED stabilization in benchmarks")
+    parser.add_argument("--exp-ms", type=int, default=5, help="Exposure in benchmarks")
+    parser.add_argument("--soak-hours", type=float, default=0.0, help="Repeat for this long")
+    parser.add_argument("--soak-interval", type=float, default=600.0, help="Seconds per interval")
+    parser.add_argument("--output", help="Write results as JSON")
+    parser.add_argument("--baseline", help="JSON of an earlier run to compare against")
+    parser.add_argument("--threshold", type=float, default=DEFAULT_THRESHOLD)
+    args = parser.parse_args()
+
+    controller = ESP32Controller(port=args.port, auto_connect=False, framed_protocol=args.framed)
+    if not controller.connect():
+        print("❌ ESP32 not found")
+        return 2
+
+    # Benchmarks expect the 15-byte sync response and change timing / LED
+    config = controller.get_device_config()
+    try:
+        if config and config.sync_format:
+            controller.set_sync_timestamps(False)
+        if args.baud and not controller.set_baudrate(args.baud):
+            print(f"❌ Baudrate {args.baud} not accepted")
+            return 2
+        capabilities = controller.get_capabilities()
+        controller.set_timing(args.stab_ms, args.exp_ms)
+        controller.get_timing_stats(reset=True)
+
+        run = {
+            "firmware_version": capabilities.firmware_version if capabilities else "unknown",
+            "baudrate": controller.comm.get_connection_stats()["line_baudrate"],
+            "framed": args.framed,
+            "stab_ms": args.stab_ms,
+            "exp_ms": args.exp_ms,
+            "intervals": [],
+        }
+        print(f"Firmware {run['firmware_version']} at {run['baudrate']} baud")
+
+        soak_end = time.time() + args.soak_hours * 3600
+        while True:
+            interval_start = time.time()
+            interval = run_interval(controller, args)
+            run["intervals"].append(interval)
+            print(f"Interval {len(run['intervals'])}:")
+            print_interval(interval)
+            if args.output:
+                pathlib.Path(args.output).write_text(json.dumps(run, indent=2))
+            if time.time() >= soak_end:
+                break
+            # Idle until the next interval, the firmware keeps its own stats
+            time.sleep(max(0.0, args.soak_interval - (time.time() - interval_start)))
+
+        run["worst"] = worst_case(run["intervals"])
+        if args.output:
+            pathlib.Path(args.output).write_text(json.dumps(run, indent=2))
+
+        if args.baseline:
+            baseline = json.loads(pathlib.Path(args.baseline).read_text())
+            regressions = find_regressions(run["worst"], baseline["worst"], args.threshold)
+            print(f"Compared with {baseline['firmware_version']}:")
+            for message in regressions:
+                print(f"  ⚠️ {message}")
+            if regressions:
+                return 1
+            print("  ✅ no timing regressions")
+        return 0
+
+    finally:
+        if config:
+            restore_settings(controller, config)
+        controller.cleanup()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -8,18 +8,45 @@ Modulare Struktur für ESP32-Kommunikation mit klarer Trennung:
 - Main Controller (High-level API)
 """
 
+from .esp32_clock_sync import ClockSync
 from .esp32_commands import (
+    BaudRates,
     CameraTypes,
+    Capabilities,
     CommandBuilder,
     Commands,
+    DeviceConfig,
+    DutyCurves,
+    EventChunk,
+    EventErrors,
+    EventRecord,
+    EventTypes,
+    FrameCodec,
     LEDStatus,
     LEDTypes,
+    PowerModes,
+    QueueAck,
+    QueuedCaptureRecord,
+    QueueFlags,
+    Protocols,
+    ResetInfo,
+    ResetReasons,
     ResponseParser,
     Responses,
+    ScheduleDone,
+    ScheduleFrame,
+    SettleOps,
+    SettleTable,
+    SyncFormats,
+    SyncLineStatus,
     SyncResponse,
+    SyncRoles,
+    TelemetryFields,
+    TelemetryRecord,
     TimingConfig,
+    TimingStats,
 )
-from .esp32_communication import ESP32Communication
+from .esp32_communication import ESP32Communication, MulticastTrigger, UdpLink
 from .esp32_controller import ESP32Controller
 from .esp32_state import ESP32State
 
@@ -30,16 +57,45 @@ __all__ = [
     "ESP32Controller",
     # Layers
     "ESP32Communication",
+    "MulticastTrigger",
+    "UdpLink",
+    "ClockSync",
     "ESP32State",
     # Commands
     "Commands",
+    "DeviceConfig",
+    "DutyCurves",
+    "EventErrors",
+    "EventTypes",
     "Responses",
     "CameraTypes",
+    "BaudRates",
     "LEDTypes",
+    "PowerModes",
+    "Protocols",
+    "ResetReasons",
+    "SettleOps",
+    "SyncFormats",
+    "SyncRoles",
+    "TelemetryFields",
     "CommandBuilder",
     "ResponseParser",
+    "FrameCodec",
     # Data Structures
     "SyncResponse",
+    "SyncLineStatus",
+    "Capabilities",
+    "EventChunk",
+    "EventRecord",
     "LEDStatus",
+    "QueueAck",
+    "QueuedCaptureRecord",
+    "QueueFlags",
+    "ResetInfo",
+    "ScheduleDone",
+    "ScheduleFrame",
+    "SettleTable",
+    "TelemetryRecord",
     "TimingConfig",
+    "TimingStats",
 ]
@@ -0,0 +1,130 @@
+"""
+ESP32 Clock Sync - Abbildung ESP32 esp_timer µs → Host-Zeit
+
+Verantwortlich für:
+- Auswertung der TIME_SYNC Ping-Pongs (NTP-Stil)
+- Offset- und Drift-Schätzung (lineare Regression über die besten Samples)
+- Umrechnung von Firmware-Zeitstempeln (LED-on/off) in Host-Zeit
+"""
+
+import logging
+import threading
+import time
+from collections import deque
+from dataclasses import dataclass
+from typing import Optional
+
+logger = logging.getLogger(__name__)
+
+
+@dataclass
+class ClockSample:
+    """Ein TIME_SYNC Austausch (Host-Zeiten: perf_counter Sekunden)"""
+
+    host_send: float  # t1
+    device_rx_us: int  # t2
+    device_tx_us: int  # t3
+    host_recv: float  # t4
+
+    @property
+    def rtt_us(self) -> float:
+        """Round trip ohne Verarbeitungszeit auf dem ESP32"""
+        return (self.host_recv - self.host_send) * 1e6 - (self.device_tx_us - self.device_rx_us)
+
+    @property
+    def device_mid_s(self) -> float:
+        return (self.device_rx_us + self.device_tx_us) / 2e6
+
+    @property
+    def host_mid_s(self) -> float:
+        return (self.host_send + self.host_recv) / 2
+
+
+class ClockSync:
+    """
+    Schätzt host_time = offset + (1 + drift) * device_time.
+
+    Nur Samples mit kleinem Round Trip (≤ rtt_margin × bestes RTT) gehen in
+    die Regression ein - USB/Treiber-Jitter erhöht nur das RTT einzelner
+    Samples und fällt so heraus. Die Firmware-Zeit (esp_timer) beginnt bei
+    jedem Boot neu, daher nach einem Reconnect reset() aufrufen.
+    """
+
+    def __init__(self, max_samples: int = 64, rtt_margin: float = 1.5):
+        self._lock = threading.Lock()
+        self._samples = deque(maxlen=max_samples)
+        self._rtt_margin = rtt_margin
+        self._offset_s = 0.0  # perf_counter Sekunden bei device_time = 0
+        self._slope = 1.0
+        # perf_counter → time.time() für Wall-Clock Zeitstempel
+        self._wall_minus_perf = time.time() - time.perf_counter()
+
+    def reset(self):
+        """Alle Samples verwerfen (z.B. nach ESP32 Reset)"""
+        with self._lock:
+            self._samples.clear()
+            self._offset_s = 0.0
+            self._slope = 1.0
+
+    def add_sample(self, host_send: float, device_rx_us: int, device_tx_us: int, host_recv: float):
+        """
+        TIME_SYNC Austausch hinzufügen und Schätzung aktualisieren.
+
+        Args:
+            host_send: time.perf_counter() direkt vor dem Senden
+            device_rx_us: rx_us aus RESPONSE_TIME_SYNC
+            device_tx_us: tx_us aus RESPONSE_TIME_SYNC
+            host_recv: time.perf_counter() direkt nach dem Empfang
+        """
+        with self._lock:
+            self._samples.append(ClockSample(host_send, device_rx_us, device_tx_us, host_recv))
+            self._update()
+
+    def _update(self):
+        best_rtt = min(s.rtt_us for s in self._samples)
+        good = [s for s in self._samples if s.rtt_us <= best_rtt * self._rtt_margin + 1.0]
+
+        if len(good) < 2 or good[-1].device_mid_s - good[0].device_mid_s < 1.0:
+            # Zu wenig Zeitbasis für Drift - nur Offset aus dem besten Sample
+            best = min(good, key=lambda s: s.rtt_us)
+            self._slope = 1.0
+            self._offset_s = best.host_mid_s - best.device_mid_s
+            return
+
+        n = len(good)
+        mean_x = sum(s.device_mid_s for s in good) / n
+        mean_y = sum(s.host_mid_s for s in good) / n
+        sxx = sum((s.device_mid_s - mean_x) ** 2 for s in good)
+        sxy = sum((s.device_mid_s - mean_x) * (s.host_mid_s - mean_y) for s in good)
+        self._slope = sxy / sxx
+        self._offset_s = mean_y - self._slope * mean_x
+
+    @property
+    def is_synced(self) -> bool:
+        return len(self._samples) > 0
+
+    @property
+    def drift_ppm(self) -> float:
+        """Gangabweichung ESP32 gegenüber Host in ppm"""
+        return (self._slope - 1.0) * 1e6
+
+    @property
+    def best_rtt_us(self) -> Optional[float]:
+        with self._lock:
+            return min((s.rtt_us for s in self._samples), default=None)
+
+    def device_to_perf(self, device_us: int) -> float:
+        """ESP32 esp_timer µs → host time.perf_counter() Sekunden"""
+        with self._lock:
+            return self._offset_s + self._slope * (device_us / 1e6)
+
+    def device_to_host(self, device_us: int) -> float:
+        """ESP32 esp_timer µs → host time.time() Sekunden"""
+        return self.device_to_perf(device_us) + self._wall_minus_perf
+
+    def get_stats(self) -> dict:
+        return {
+            "samples": len(self._samples),
+            "best_rtt_us": self.best_rtt_us,
+            "drift_ppm": self.drift_ppm,
+        }
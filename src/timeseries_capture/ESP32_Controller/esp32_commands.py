@@ -28,23 +28,54 @@ class Commands:
     LED_OFF = 0x00
     STATUS = 0x02
     SYNC_CAPTURE = 0x0C
+    SYNC_CAPTURE_QUEUED = 0x0D
+    QUEUE_CLEAR = 0x0E
     SET_LED_POWER = 0x10
     SET_TIMING = 0x11
     SET_CAMERA_TYPE = 0x13
+    SET_BAUD = 0x14
+    BAUD_CONFIRM = 0x15
+    SET_TRIGGER = 0x16
+    SET_POWER_MODE = 0x17
+    GET_CONFIG = 0x18
+    SET_SYNC_FORMAT = 0x19
+    SET_SENSOR_POLICY = 0x1A
     SELECT_LED_IR = 0x20
     SELECT_LED_WHITE = 0x21
     LED_DUAL_OFF = 0x22
     GET_LED_STATUS = 0x23
     SET_IR_POWER = 0x24
     SET_WHITE_POWER = 0x25
+    SET_DUTY_CURVE = 0x26
+    SET_CHANNEL_MASK = 0x27
+    SET_CHANNEL_POWER = 0x28
+    RAMP_CHANNEL = 0x29
+    CALIBRATE_SETTLE = 0x2A
+    GET_CHANNELS = 0x2B
     SYNC_CAPTURE_DUAL = 0x2C
+    SET_SYNC_ROLE = 0x2D
+    START_SCHEDULE = 0x40
+    STOP_SCHEDULE = 0x41
+    SET_SEQUENCE_STEP = 0x42
+    RUN_SEQUENCE = 0x43
+    GET_TIMING_STATS = 0x50
+    TIME_SYNC = 0x52
+    STREAM_TELEMETRY = 0x53
+    GET_EVENT_LOG = 0x54
+    GET_RESET_INFO = 0x55
+    GET_CAPABILITIES = 0x60
 
 
 class Responses:
     """Response-Bytes die von ESP32 empfangen werden"""
 
     LED_ON_ACK = 0xAA
+    SYNC_COMPLETE_SETTLE = 0x1A
     SYNC_COMPLETE = 0x1B
+    QUEUED_COMPLETE = 0x1C
+    SCHEDULE_FRAME = 0x1D
+    SYNC_COMPLETE_EXT = 0x1E
+    SEQUENCE_COMPLETE = 0x1F
     TIMING_SET = 0x21
     ACK_ON = 0x01
     ACK_OFF = 0x02
@@ -54,6 +85,272 @@ class Responses:
     LED_IR_SELECTED = 0x30
     LED_WHITE_SELECTED = 0x31
     LED_STATUS = 0x32
+    BAUD_SET = 0x33
+    QUEUE_ACK = 0x34
+    QUEUE_FULL = 0x35
+    SCHEDULE_ACK = 0x36
+    SCHEDULE_DONE = 0x37
+    TIMING_STATS = 0x38
+    TIME_SYNC = 0x39
+    CAPABILITIES = 0x3A
+    FRAME_ERROR = 0x3B
+    POWER_MODE = 0x3C
+    CONFIG = 0x3D
+    CHANNELS = 0x3E
+    TELEMETRY = 0x3F
+    EVENT_LOG = 0x40
+    SYNC_LINE = 0x41
+    SETTLE = 0x42
+    RESET_INFO = 0x43
+
+
+class BaudRates:
+    """Von der Firmware unterstützte Baudraten (CMD_SET_BAUD)"""
+
+    BOOT = 115200
+    SUPPORTED = (115200, 230400, 460800, 921600, 1500000, 2000000)
+
+
+class Protocols:
+    """Protokoll-Versionen für GET_CAPABILITIES"""
+
+    QUERY = 0  # Nur abfragen, aktives Protokoll beibehalten
+    LEGACY = 2  # Rohe Command-Bytes
+    FRAMED = 3  # Frames mit Länge, Sequenznummer und CRC-16
+
+
+class Features:
+    """Feature-Bits aus CAPABILITIES"""
+
+    CAPTURE_QUEUE = 1 << 0
+    SCHEDULE = 1 << 1
+    CAMERA_TRIGGER = 1 << 2
+    TIMING_STATS = 1 << 3
+    TIME_SYNC = 1 << 4
+    BAUD_SWITCH = 1 << 5
+    POWER_MODES = 1 << 6
+    LED_CHANNELS = 1 << 7
+    SEQUENCES = 1 << 8
+    SENSOR_POLICY = 1 << 9
+    TELEMETRY = 1 << 10
+    EVENT_LOG = 1 << 11
+    NETWORK = 1 << 12  # Wi-Fi/UDP-Link (Build mit NETWORK_TRANSPORT)
+    SYNC_LINE = 1 << 13  # Gemeinsame Sync-Leitung (SET_SYNC_ROLE)
+    LED_RAMP = 1 << 14  # Hardware-Rampen (RAMP_CHANNEL)
+    LED_SETTLE = 1 << 15  # Photodiode für CALIBRATE_SETTLE (Build mit PHOTODIODE)
+    RECOVERY = 1 << 16  # Task-Watchdog, Resume nach Warm-Reset (GET_RESET_INFO)
+
+
+class PowerModes:
+    """Modi für SET_POWER_MODE"""
+
+    PERFORMANCE = 0  # 240 MHz
+    DFS = 1  # 80-240 MHz nach Last
+    LIGHT_SLEEP = 2  # DFS + Light Sleep, Wake per UART/Schedule-Timer (nur Frame-Protokoll)
+
+    STATUS_OK = 0
+    STATUS_INVALID = 1
+    STATUS_NOT_SUPPORTED = 2  # Build ohne esp_pm oder USB-CDC
+    STATUS_NEEDS_FRAMING = 3
+
+
+class SyncRoles:
+    """Rollen und Status für SET_SYNC_ROLE"""
+
+    OFF = 0
+    MASTER = 1  # Sync-Captures treiben die Leitung
+    SLAVE = 2  # Pulse bei jeder steigenden Flanke
+    QUERY = 0xFF  # Nur abfragen
+
+    FLAG_DUAL = 0x01  # Slave: IR + White
+
+    STATUS_OK = 0
+    STATUS_INVALID = 1
+    STATUS_NOT_SUPPORTED = 2  # Build mit SYNC_LINE=0
+    STATUS_BUSY = 3  # Puls, Queue oder Schedule aktiv
+
+
+class SyncFormats:
+    """Formate für SET_SYNC_FORMAT"""
+
+    LEGACY = 0  # 15 bytes SYNC_COMPLETE
+    EXTENDED = 1  # 31 bytes SYNC_COMPLETE_EXT (LED-Flanken)
+    SETTLE = 2  # 37 bytes SYNC_COMPLETE_SETTLE (+ Stabilisierung und Settle-Zeit)
+
+
+class SettleOps:
+    """Operationen und Status für CALIBRATE_SETTLE"""
+
+    QUERY = 0
+    CALIBRATE = 1  # Kanal messen (~7 s, Antwort am Ende)
+    ADAPTIVE_ON = 2  # Sync-Captures mit gemessener Settle-Zeit
+    ADAPTIVE_OFF = 3
+    CLEAR = 4  # Tabelle des Kanals löschen
+
+    FLAG_ADAPTIVE = 0x01
+
+    STATUS_OK = 0
+    STATUS_INVALID = 1
+    STATUS_NOT_SUPPORTED = 2  # Build ohne PHOTODIODE
+    STATUS_BUSY = 3  # Puls, Queue, Schedule oder Sync-Rolle aktiv
+    STATUS_NO_SIGNAL = 4  # Photodiode sieht die LED nicht, Tabelle unverändert
+
+    LEVELS = 10  # Settle-Zeit bei 10, 20, ... 100 % Power
+    NOT_CALIBRATED = 0
+    NO_SIGNAL = 0xFFFFFFFE
+    NOT_SETTLED = 0xFFFFFFFF  # Nicht stabil innerhalb von 600 ms
+
+
+class DutyCurves:
+    """
+    Kalibrierkurven für SET_DUTY_CURVE.
+
+    Eine Kurve sind 11 Ausgangswerte (Anteil des vollen Duty, 0.0-1.0) bei
+    0, 10, ... 100 % Power. Die Firmware interpoliert daraus eine Duty-LUT.
+    """
+
+    POINTS = 11
+    FLAG_PERSIST = 0x01  # Im NVS speichern (übersteht Reset)
+    FLAG_RESET = 0x02  # Zurück auf lineare Kurve
+
+    @staticmethod
+    def linear() -> list:
+        return [i / (DutyCurves.POINTS - 1) for i in range(DutyCurves.POINTS)]
+
+    @staticmethod
+    def gamma(gamma: float) -> list:
+        """Kurve duty = power^gamma"""
+        return [x**gamma for x in DutyCurves.linear()]
+
+    @staticmethod
+    def from_measurements(powers: list, intensities: list) -> list:
+        """
+        Linearisierung aus einer Messreihe mit linearer Kurve.
+
+        Invertiert die gemessene Kennlinie (z.B. Photodiode oder mittlere
+        Bildhelligkeit), so dass die Helligkeit danach proportional zur
+        Power ist - gleiche Power ergibt auf allen Rigs vergleichbares Licht
+        relativ zum jeweiligen Maximum.
+
+        Args:
+            powers: Power-Werte 0-100 der Messpunkte (aufsteigend, inkl. 0 und 100)
+            intensities: Gemessene Helligkeit je Power-Wert
+
+        Returns:
+            11 Kurvenpunkte (0.0-1.0)
+        """
+        pairs = sorted(zip(powers, intensities))
+        duty = [p / 100.0 for p, _ in pairs]
+        # Messrauschen darf die Kennlinie nicht fallen lassen
+        level = []
+        for _, value in pairs:
+            level.append(max(value, level[-1]) if level else value)
+        low, high = level[0], level[-1]
+        if high <= low:
+            raise ValueError("Intensities do not increase with power")
+
+        points = []
+        for i in range(DutyCurves.POINTS):
+            target = low + (high - low) * i / (DutyCurves.POINTS - 1)
+            for k in range(1, len(level)):
+                if level[k] >= target:
+                    span = level[k] - level[k - 1]
+                    frac = (target - level[k - 1]) / span if span > 0 else 0.0
+                    points.append(duty[k - 1] + (duty[k] - duty[k - 1]) * frac)
+                    break
+            else:
+                points.append(duty[-1])
+        return points
+
+
+class QueueFlags:
+    """Flags für SYNC_CAPTURE_QUEUED"""
+
+    DUAL = 0x01
+    TIMED = 0x02
+
+
+class TelemetryFields:
+    """Feldgruppen für STREAM_TELEMETRY (Records enthalten sie in Bit-Reihenfolge)"""
+
+    LEDS = 0x01  # on_mask, LED-Typ, IR/White Power
+    SENSOR = 0x02  # Temperatur, Feuchte, Sample-Alter
+    TIMING = 0x04  # Pulszahl + Maxima der Latenz-Statistiken
+    UPTIME = 0x08  # ms seit Boot
+    ALL = 0x0F
+
+    MIN_PERIOD_MS = 20
+    SIZES = ((LEDS, 4), (SENSOR, 6), (TIMING, 12), (UPTIME, 4))
+
+
+class EventTypes:
+    """Record-Typen des Event-Logs (GET_EVENT_LOG)"""
+
+    NONE = 0  # Beim Lesen überschrieben
+    BOOT = 1  # arg8 = Reset-Grund (esp_reset_reason_t)
+    COMMAND = 2  # arg8 = Command-Byte, arg16 = Frame-seq (0 = legacy)
+    PULSE_START = 3  # time = LED-on Flanke, arg8 = Quelle, arg16 = Tag
+    PULSE_END = 4  # time = LED-off Flanke, arg8 = Quelle, arg32 = Dauer µs
+    SENSOR_FAIL = 5  # arg16 = Fehler in Folge (1., 2., 4., 8. ... geloggt)
+    BUFFER_CLEAR = 6  # arg32 = verworfene Bytes
+    ERROR = 7  # arg8 = EventErrors Code
+    RESUME = 8  # arg8 = ResetReasons.FLAG_* Bits, arg32 = erster Frame des Schedules
+
+    NAMES = {
+        NONE: "none",
+        BOOT: "boot",
+        COMMAND: "command",
+        PULSE_START: "pulse_start",
+        PULSE_END: "pulse_end",
+        SENSOR_FAIL: "sensor_fail",
+        BUFFER_CLEAR: "buffer_clear",
+        ERROR: "error",
+        RESUME: "resume",
+    }
+
+    MAX_RECORDS = 48  # Pro GET_EVENT_LOG Anfrage
+
+
+class EventErrors:
+    """Sub-Codes von EventTypes.ERROR (arg8)"""
+
+    UNKNOWN_COMMAND = 1  # arg16 = Byte
+    PAYLOAD_TIMEOUT = 2  # arg16 = Command
+    FRAME = 3  # arg16 = Frame-Fehlergrund
+    TX_DROPPED = 4  # TX-Queue voll, arg16 = Response-Code
+    QUEUE_FULL = 5  # Capture-Queue voll, arg16 = seq
+    LATE_CAPTURE = 6  # arg16 = seq, arg32 = µs zu spät
+    LATE_FRAME = 7  # arg16 = Frame-Index, arg32 = µs zu spät
+    SYNC_MISSED = 8  # Sync-Flanke ohne gespannten Puls, arg32 = Summe
+    SYNC_NO_EDGE = 9  # Master sah seine eigene Flanke nicht
+
+
+class ResetReasons:
+    """Reset-Gründe (esp_reset_reason_t) und Flags von GET_RESET_INFO"""
+
+    POWER_ON = 1
+    EXTERNAL = 2  # EN-Pin
+    SOFTWARE = 3
+    PANIC = 4
+    INT_WATCHDOG = 5
+    TASK_WATCHDOG = 6
+    WATCHDOG = 7
+    BROWNOUT = 9
+
+    NAMES = {
+        POWER_ON: "power_on",
+        EXTERNAL: "external",
+        SOFTWARE: "software",
+        PANIC: "panic",
+        INT_WATCHDOG: "int_watchdog",
+        TASK_WATCHDOG: "task_watchdog",
+        WATCHDOG: "watchdog",
+        BROWNOUT: "brownout",
+    }
+
+    FLAG_RESUMED = 0x01  # Zustand aus dem RTC-RAM übernommen
+    FLAG_SCHEDULE = 0x02  # Laufender Schedule fortgesetzt
+    FLAG_REFUSED = 0x04  # Nicht übernommen: vorheriger Resume-Boot früh abgestürzt
 
 
 class CameraTypes:
@@ -68,6 +365,8 @@ class LEDTypes:
 
     IR = 0
     WHITE = 1
+    DUAL = 2  # Nur für START_SCHEDULE
+    CHANNELS = 0x80  # Sync-Response bei eigener Capture-Maske (SET_CHANNEL_MASK)
 
 
 # ============================================================================
@@ -86,6 +385,156 @@ class SyncResponse:
     led_duration_ms: int
     led_power_actual: int
     success: bool
+    led_on_us: Optional[int] = None  # esp_timer µs, bei SYNC_COMPLETE_EXT / _SETTLE
+    led_off_us: Optional[int] = None
+    stabilization_ms: Optional[int] = None  # LED-on → Belichtung, nur bei SYNC_COMPLETE_SETTLE
+    settle_us: Optional[int] = None  # Kalibrierte Settle-Zeit dahinter, 0 = feste Zeit
+
+
+@dataclass
+class QueueAck:
+    """Response auf SYNC_CAPTURE_QUEUED (angenommen oder Queue voll)"""
+
+    seq: int
+    accepted: bool
+    free_slots: int
+
+
+@dataclass
+class QueuedCaptureRecord:
+    """Completion-Record einer Capture aus der Queue"""
+
+    seq: int
+    led_on_us: int  # esp_timer Zeit der LED-on Flanke (uint32, läuft über)
+    duration_us: int
+    temperature: float
+    humidity: float
+    led_type_used: str  # 'ir', 'white', 'dual' oder 'channels'
+    led_power_actual: int
+    started_late: bool
+    skipped: bool = False  # Nicht gestartet (Schedule aktiv, keine Sync-Flanke), Zeiten 0
+
+
+@dataclass
+class ScheduleFrame:
+    """Frame-Event eines laufenden On-Device Schedules"""
+
+    frame_index: int
+    led_on_us: int  # esp_timer Zeit der LED-on Flanke (uint32, läuft über)
+    duration_us: int
+    temperature: float
+    humidity: float
+    started_late: bool
+    last_frame: bool
+    skipped: bool = False  # Nicht gestartet (Timer zu spät, voriger Frame noch an), Zeiten 0
+
+
+@dataclass
+class ScheduleDone:
+    """Ende eines Schedules (Frame-Anzahl erreicht oder STOP_SCHEDULE)"""
+
+    frames_sent: int
+
+
+@dataclass
+class SequenceStep:
+    """Ein Schritt einer Beleuchtungssequenz (SET_SEQUENCE_STEP)"""
+
+    POWER_OWN = 0xFF  # Jeder Kanal mit seiner eigenen Power
+    MAX_STEPS = 8
+
+    mask: int  # Bit n = LED-Kanal n, 0 = dunkler Schritt
+    duration_us: int
+    power: int = POWER_OWN
+    trigger: bool = False  # Kamera-Triggerpuls stab_ms nach Schrittbeginn
+
+
+@dataclass
+class SequenceRecord:
+    """Abschluss einer Sequenz (SEQUENCE_COMPLETE)"""
+
+    seq: int
+    led_on_us: int  # esp_timer Zeit der LED-on Flanke von Schritt 0 (uint32, läuft über)
+    temperature: float
+    humidity: float
+    steps: list  # (mask, power, duration_us) pro Schritt
+
+    @property
+    def step_offsets_us(self) -> list:
+        """Start jedes Schritts relativ zu led_on_us (Schritte liegen lückenlos hintereinander)"""
+        offsets, t = [], 0
+        for _, _, duration_us in self.steps:
+            offsets.append(t)
+            t += duration_us
+        return offsets
+
+
+@dataclass
+class TimingStats:
+    """Latenz-Statistik der Firmware (µs), ein Record von GET_TIMING_STATS"""
+
+    name: str
+    count: int
+    min_us: int
+    max_us: int
+    mean_us: int
+    histogram: list  # 20 log2 Buckets: [0-1], [2-3], [4-7], ... [524288+] µs
+
+
+@dataclass
+class Capabilities:
+    """Antwort auf GET_CAPABILITIES"""
+
+    active_protocol: int
+    max_protocol: int
+    firmware_version: str
+    max_frame_payload: int
+    features: int  # Features.* Bits
+    board: str
+
+    def has(self, feature: int) -> bool:
+        return bool(self.features & feature)
+
+
+@dataclass
+class DeviceConfig:
+    """Im NVS gespeicherte Einstellungen (GET_CONFIG)"""
+
+    VERSION = 1
+
+    stabilization_ms: int
+    exposure_ms: int
+    ir_power: int
+    white_power: int
+    camera_type: int
+    led_type: int  # Ausgewählte LED (LEDTypes)
+    trigger_enabled: bool
+    trigger_width_us: int
+    sync_format: int  # SyncFormats: 0 = 15 bytes, 1 = extended, 2 = settle
+    restored: bool = False  # Beim Boot aus dem NVS geladen
+    save_pending: bool = False  # Änderungen noch nicht gespeichert
+
+    def encode(self) -> bytes:
+        """Config-Blob wie in der Firmware (inkl. Hash)"""
+        body = struct.pack(
+            ">BHHBBBBBHB",
+            DeviceConfig.VERSION,
+            self.stabilization_ms,
+            self.exposure_ms,
+            self.ir_power,
+            self.white_power,
+            self.camera_type,
+            self.led_type,
+            1 if self.trigger_enabled else 0,
+            self.trigger_width_us,
+            self.sync_format,
+        )
+        return body + struct.pack(">H", FrameCodec.crc16(body))
+
+    @property
+    def config_hash(self) -> int:
+        """CRC-16 über die Einstellungen - gleich dem Hash der Firmware"""
+        return struct.unpack(">H", self.encode()[-2:])[0]
 
 
 @dataclass
@@ -99,6 +548,101 @@ class LEDStatus:
     white_power: int  # 0-100
 
 
+@dataclass
+class ChannelStatus:
+    """Status aller LED-Kanäle (GET_CHANNELS)"""
+
+    count: int
+    on_mask: int  # Bit n = Kanal n an
+    capture_mask: int  # LEDs für SYNC_CAPTURE, 0 = gewählte LED
+    powers: list  # 0-100 pro Kanal
+
+
+@dataclass
+class TelemetryRecord:
+    """Ein Record des Telemetrie-Streams (TELEMETRY), None = Feld nicht abonniert"""
+
+    seq: int  # uint16, Lücken = verworfene Records
+    fields: int  # TelemetryFields Bits
+    led_on_mask: Optional[int] = None
+    led_type: Optional[int] = None
+    ir_power: Optional[int] = None
+    white_power: Optional[int] = None
+    temperature: Optional[float] = None
+    humidity: Optional[float] = None
+    sensor_age_s: Optional[float] = None  # None auch wenn noch keine Messung
+    pulse_count: Optional[int] = None
+    cmd_to_led_on_max_us: Optional[int] = None  # Maxima sättigen bei 65535
+    led_on_error_max_us: Optional[int] = None
+    rt_iteration_max_us: Optional[int] = None
+    comms_iteration_max_us: Optional[int] = None
+    uptime_ms: Optional[int] = None
+
+
+@dataclass
+class EventRecord:
+    """Ein Record des Event-Logs (GET_EVENT_LOG)"""
+
+    index: int  # Fortlaufend seit Power-on, läuft nicht mit dem Ring über
+    type: int  # EventTypes
+    arg8: int
+    arg16: int
+    arg32: int
+    time_us: int  # esp_timer µs, beginnt bei jedem BOOT neu
+
+    @property
+    def name(self) -> str:
+        return EventTypes.NAMES.get(self.type, f"0x{self.type:02X}")
+
+
+@dataclass
+class EventChunk:
+    """Ein EVENT_LOG Chunk (bis zu 3 Records)"""
+
+    first: int  # Index des ersten Records, > angefragter Index = Records verloren
+    head: int  # Index des nächsten Events
+    last: bool  # Letzter Chunk der Anfrage
+    records: list  # EventRecord
+
+
+@dataclass
+class SyncLineStatus:
+    """SYNC_LINE Response (SET_SYNC_ROLE)"""
+
+    role: int  # SyncRoles.OFF / MASTER / SLAVE
+    status: int  # SyncRoles.STATUS_*
+    edges: int  # Steigende Flanken seit Boot
+    missed: int  # Flanken ohne gespannten Puls
+
+
+@dataclass
+class SettleTable:
+    """SETTLE Response (CALIBRATE_SETTLE)"""
+
+    status: int  # SettleOps.STATUS_*
+    adaptive: bool  # Adaptive Stabilisierung aktiv
+    channel: int
+    settle_us: list  # SettleOps.LEVELS Werte in µs (SettleOps.NOT_CALIBRATED / NO_SIGNAL / ...)
+
+
+@dataclass
+class ResetInfo:
+    """RESET_INFO Response (GET_RESET_INFO)"""
+
+    reason: int  # ResetReasons
+    resumed: bool  # LEDs, Einstellungen und Protokoll aus dem RTC-RAM übernommen
+    schedule_resumed: bool
+    refused: bool
+    warm_resets: int  # Seit dem letzten Kaltstart
+    previous_uptime_ms: int  # Uptime des abgestürzten Boots beim letzten Snapshot
+    resume_frame: int  # Erster Frame-Index des fortgesetzten Schedules
+    uptime_ms: int
+
+    @property
+    def reason_name(self) -> str:
+        return ResetReasons.NAMES.get(self.reason, f"0x{self.reason:02X}")
+
+
 @dataclass
 class TimingConfig:
     """Timing-Konfiguration"""
@@ -202,6 +746,84 @@ class CommandBuilder:
         power = max(0, min(100, power))
         return bytes([Commands.SET_WHITE_POWER, power])
 
+    @staticmethod
+    def build_set_duty_curve(
+        led_type: int, points: Optional[list] = None, persist: bool = False
+    ) -> bytes:
+        """
+        Build SET_DUTY_CURVE Command.
+
+        Firmware erwartet: CMD + led_type + flags + 11 × level (uint16 big-endian)
+
+        Args:
+            led_type: LED-Kanal (LEDTypes.IR, LEDTypes.WHITE oder 2-7)
+            points: 11 Werte 0.0-1.0 (DutyCurves), None = zurück auf linear
+            persist: Kurve im NVS speichern bzw. gespeicherte Kurve löschen
+
+        Returns:
+            Command bytes
+        """
+        flags = DutyCurves.FLAG_PERSIST if persist else 0
+        if points is None:
+            flags |= DutyCurves.FLAG_RESET
+            points = DutyCurves.linear()
+        if len(points) != DutyCurves.POINTS:
+            raise ValueError(f"Duty curve needs {DutyCurves.POINTS} points")
+        levels = [round(max(0.0, min(1.0, p)) * 0xFFFF) for p in points]
+        return bytes([Commands.SET_DUTY_CURVE, led_type, flags]) + struct.pack(
+            f">{DutyCurves.POINTS}H", *levels
+        )
+
+    @staticmethod
+    def build_set_channel_mask(mask: int, capture: bool = False) -> bytes:
+        """
+        Build SET_CHANNEL_MASK Command.
+
+        Args:
+            mask: Bit n = LED-Kanal n (0 = IR, 1 = White)
+            capture: Maske gilt für SYNC_CAPTURE statt die LEDs direkt zu schalten
+
+        Returns:
+            Command bytes
+        """
+        return bytes([Commands.SET_CHANNEL_MASK, mask & 0xFF, 0x01 if capture else 0x00])
+
+    @staticmethod
+    def build_set_channel_power(channel: int, power: int) -> bytes:
+        """
+        Build SET_CHANNEL_POWER Command.
+
+        Args:
+            channel: LED-Kanal (0 = IR, 1 = White)
+            power: Power in Prozent (0-100)
+
+        Returns:
+            Command bytes
+        """
+        return bytes([Commands.SET_CHANNEL_POWER, channel, max(0, min(100, power))])
+
+    @staticmethod
+    def build_ramp_channel(channel: int, power: int, duration_ms: int) -> bytes:
+        """
+        Build RAMP_CHANNEL Command.
+
+        Args:
+            channel: LED-Kanal (0 = IR, 1 = White)
+            power: Ziel-Power in Prozent (0-100, 0 = ausblenden)
+            duration_ms: Rampendauer in ms (0 = sofort)
+
+        Returns:
+            Command bytes
+        """
+        power = max(0, min(100, power))
+        duration_ms = max(0, min(0xFFFFFFFF, int(duration_ms)))
+        return struct.pack(">BBBI", Commands.RAMP_CHANNEL, channel, power, duration_ms)
+
+    @staticmethod
+    def build_get_channels() -> bytes:
+        """Build GET_CHANNELS Command"""
+        return bytes([Commands.GET_CHANNELS])
+
     @staticmethod
     def build_set_timing(stabilization_ms: int, exposure_ms: int) -> bytes:
         """
@@ -240,6 +862,288 @@ class CommandBuilder:
         """
         return bytes([Commands.SET_CAMERA_TYPE, camera_type])
 
+    @staticmethod
+    def build_set_trigger(enabled: bool, width_us: int = 1000) -> bytes:
+        """
+        Build SET_TRIGGER Command (Hardware-Kameratrigger).
+
+        Firmware erwartet: CMD + enable (uint8) + width_us (uint16 big-endian)
+
+        Args:
+            enabled: Trigger-Ausgang aktivieren
+            width_us: Pulsbreite in µs (min. 10)
+
+        Returns:
+            Command bytes
+        """
+        return bytes([Commands.SET_TRIGGER, 1 if enabled else 0]) + struct.pack(
+            ">H", max(10, min(0xFFFF, width_us))
+        )
+
+    @staticmethod
+    def build_get_config() -> bytes:
+        """Build GET_CONFIG Command (im NVS gespeicherte Einstellungen)"""
+        return bytes([Commands.GET_CONFIG])
+
+    @staticmethod
+    def build_set_sync_role(role: int, dual: bool = False) -> bytes:
+        """
+        Build SET_SYNC_ROLE Command.
+
+        Args:
+            role: SyncRoles.OFF / MASTER / SLAVE / QUERY
+            dual: Slave leuchtet mit IR + White
+
+        Returns:
+            Command bytes
+        """
+        return bytes([Commands.SET_SYNC_ROLE, role, SyncRoles.FLAG_DUAL if dual else 0])
+
+    @staticmethod
+    def build_set_power_mode(mode: int) -> bytes:
+        """
+        Build SET_POWER_MODE Command.
+
+        Args:
+            mode: PowerModes.PERFORMANCE / DFS / LIGHT_SLEEP
+
+        Returns:
+            Command bytes
+        """
+        return bytes([Commands.SET_POWER_MODE, mode])
+
+    @staticmethod
+    def build_sync_capture_queued(
+        seq: int, dual: bool = False, start_us: Optional[int] = None
+    ) -> bytes:
+        """
+        Build SYNC_CAPTURE_QUEUED Command.
+
+        Firmware erwartet: CMD + seq (uint16 BE) + flags (uint8) + start_us (uint32 BE)
+
+        Args:
+            seq: Sequenznummer (0-65535), kommt im Completion-Record zurück
+            dual: Beide LEDs statt der gewählten LED
+            start_us: Startzeit in ESP32 esp_timer µs (untere 32 bit), None = sofort
+
+        Returns:
+            Command bytes
+        """
+        flags = QueueFlags.DUAL if dual else 0
+        if start_us is not None:
+            flags |= QueueFlags.TIMED
+        return bytes([Commands.SYNC_CAPTURE_QUEUED]) + struct.pack(
+            ">HBI", seq & 0xFFFF, flags, (start_us or 0) & 0xFFFFFFFF
+        )
+
+    @staticmethod
+    def build_queue_clear() -> bytes:
+        """Build QUEUE_CLEAR Command"""
+        return bytes([Commands.QUEUE_CLEAR])
+
+    @staticmethod
+    def build_set_baud(baudrate: int) -> bytes:
+        """
+        Build SET_BAUD Command.
+
+        Firmware erwartet: CMD (1 byte) + baudrate (4 bytes big-endian)
+
+        Args:
+            baudrate: Ziel-Baudrate (siehe BaudRates.SUPPORTED)
+
+        Returns:
+            Command bytes
+
+        Raises:
+            ValueError: Baudrate wird von der Firmware nicht unterstützt
+        """
+        if baudrate not in BaudRates.SUPPORTED:
+            raise ValueError(f"Unsupported baudrate: {baudrate}")
+        return bytes([Commands.SET_BAUD]) + struct.pack(">I", baudrate)
+
+    @staticmethod
+    def build_baud_confirm() -> bytes:
+        """Build BAUD_CONFIRM Command (bei neuer Baudrate senden)"""
+        return bytes([Commands.BAUD_CONFIRM])
+
+    @staticmethod
+    def build_start_schedule(
+        interval_ms: int,
+        led_type: int,
+        power: int,
+        stabilization_ms: int,
+        exposure_ms: int,
+        frame_count: int = 0,
+    ) -> bytes:
+        """
+        Build START_SCHEDULE Command.
+
+        Firmware erwartet: CMD + interval_ms (uint32) + led_type (uint8) + power (uint8)
+        + stab_ms (uint16) + exp_ms (uint16) + frame_count (uint32), alles big-endian
+
+        Args:
+            interval_ms: Frame-Intervall, muss > stab_ms + exp_ms + 5 ms sein
+            led_type: LEDTypes.IR, LEDTypes.WHITE oder LEDTypes.DUAL
+            power: LED Power (0-100)
+            stabilization_ms: Stabilisierungszeit pro Frame
+            exposure_ms: Belichtungszeit pro Frame
+            frame_count: Anzahl Frames, 0 = bis STOP_SCHEDULE
+
+        Returns:
+            Command bytes
+
+        Raises:
+            ValueError: Intervall zu kurz für die LED-on Zeit
+        """
+        if interval_ms * 1000 < (stabilization_ms + exposure_ms) * 1000 + 5000:
+            raise ValueError(
+                f"Interval {interval_ms}ms too short for {stabilization_ms}+{exposure_ms}ms pulse"
+            )
+        return bytes([Commands.START_SCHEDULE]) + struct.pack(
+            ">IBBHHI",
+            interval_ms,
+            led_type,
+            max(0, min(100, power)),
+            stabilization_ms,
+            exposure_ms,
+            frame_count,
+        )
+
+    @staticmethod
+    def build_stop_schedule() -> bytes:
+        """Build STOP_SCHEDULE Command"""
+        return bytes([Commands.STOP_SCHEDULE])
+
+    @staticmethod
+    def build_set_sequence_step(index: int, step: SequenceStep) -> bytes:
+        """
+        Build SET_SEQUENCE_STEP Command.
+
+        Firmware erwartet: CMD + index + mask + power + flags + duration_us (uint32 big-endian)
+
+        Args:
+            index: Schritt 0-7, Schritte in Reihenfolge senden (0 beginnt neue Sequenz)
+            step: SequenceStep
+
+        Returns:
+            Command bytes
+
+        Raises:
+            ValueError: Ungültiger Index oder Dauer
+        """
+        if not 0 <= index < SequenceStep.MAX_STEPS:
+            raise ValueError(f"Sequence step index must be 0-{SequenceStep.MAX_STEPS - 1}")
+        if not 0 < step.duration_us <= 30_000_000:
+            raise ValueError("Sequence step duration must be 1 µs - 30 s")
+        power = step.power if step.power == SequenceStep.POWER_OWN else max(0, min(100, step.power))
+        flags = 0x01 if step.trigger else 0x00
+        command = bytes([Commands.SET_SEQUENCE_STEP, index, step.mask & 0xFF, power, flags])
+        return command + struct.pack(">I", step.duration_us)
+
+    @staticmethod
+    def build_run_sequence(seq: int) -> bytes:
+        """Build RUN_SEQUENCE Command (seq wird im SEQUENCE_COMPLETE Record zurückgegeben)"""
+        return bytes([Commands.RUN_SEQUENCE]) + struct.pack(">H", seq & 0xFFFF)
+
+    @staticmethod
+    def build_set_sync_format(extended: bool, settle: bool = False) -> bytes:
+        """
+        Build SET_SYNC_FORMAT Command.
+
+        Args:
+            extended: 31-byte SYNC_COMPLETE_EXT mit LED-Flanken
+            settle: 37-byte SYNC_COMPLETE_SETTLE (Flanken + Stabilisierung, schließt extended ein)
+
+        Returns:
+            Command bytes
+        """
+        if settle:
+            sync_format = SyncFormats.SETTLE
+        else:
+            sync_format = SyncFormats.EXTENDED if extended else SyncFormats.LEGACY
+        return bytes([Commands.SET_SYNC_FORMAT, sync_format])
+
+    @staticmethod
+    def build_calibrate_settle(op: int, channel: int = 0) -> bytes:
+        """
+        Build CALIBRATE_SETTLE Command.
+
+        Args:
+            op: SettleOps.QUERY / CALIBRATE / ADAPTIVE_ON / ADAPTIVE_OFF / CLEAR
+            channel: LED-Kanal (0 = IR, 1 = White), auch bei ADAPTIVE_* gültig angeben
+
+        Returns:
+            Command bytes
+        """
+        return bytes([Commands.CALIBRATE_SETTLE, op, channel])
+
+    @staticmethod
+    def build_set_sensor_policy(max_age_ms: int, report_age: bool = False) -> bytes:
+        """
+        Build SET_SENSOR_POLICY Command
+
+        Args:
+            max_age_ms: Tolerierte Sensor-Staleness (≥ 2000 ms, DHT22 Samplerate)
+            report_age: STATUS Antwort um Sample-Alter erweitern (7 statt 5 bytes)
+        """
+        flags = 0x01 if report_age else 0x00
+        return bytes([Commands.SET_SENSOR_POLICY]) + struct.pack(">IB", max_age_ms, flags)
+
+    @staticmethod
+    def build_stream_telemetry(period_ms: int, fields: int = TelemetryFields.ALL) -> bytes:
+        """
+        Build STREAM_TELEMETRY Command
+
+        Args:
+            period_ms: Record-Periode (≥ 20 ms), 0 = Stream stoppen
+            fields: TelemetryFields Bits, 0 = Stream stoppen
+        """
+        if period_ms and fields:
+            if not TelemetryFields.MIN_PERIOD_MS <= period_ms <= 0xFFFF:
+                raise ValueError(f"Telemetry period must be 20-65535 ms: {period_ms}")
+            if fields & ~TelemetryFields.ALL:
+                raise ValueError(f"Unknown telemetry fields: 0x{fields:02X}")
+        return bytes([Commands.STREAM_TELEMETRY]) + struct.pack(">HB", period_ms, fields)
+
+    @staticmethod
+    def build_get_event_log(
+        from_index: int = 0, max_records: int = 0, clear: bool = False
+    ) -> bytes:
+        """
+        Build GET_EVENT_LOG Command
+
+        Args:
+            from_index: Erster gewünschter Event-Index
+            max_records: Anzahl Records, 0 = Limit pro Anfrage (48)
+            clear: Gesendete Records danach im Log löschen
+        """
+        if not 0 <= max_records <= EventTypes.MAX_RECORDS:
+            raise ValueError(f"max_records must be 0-{EventTypes.MAX_RECORDS}: {max_records}")
+        flags = 0x01 if clear else 0x00
+        return bytes([Commands.GET_EVENT_LOG]) + struct.pack(
+            ">IBB", from_index & 0xFFFFFFFF, max_records, flags
+        )
+
+    @staticmethod
+    def build_get_reset_info() -> bytes:
+        """Build GET_RESET_INFO Command"""
+        return bytes([Commands.GET_RESET_INFO])
+
+    @staticmethod
+    def build_time_sync() -> bytes:
+        """Build TIME_SYNC Command (Clock Ping-Pong)"""
+        return bytes([Commands.TIME_SYNC])
+
+    @staticmethod
+    def build_get_capabilities(protocol: int = Protocols.QUERY) -> bytes:
+        """Build GET_CAPABILITIES Command (protocol: Protocols.*)"""
+        return bytes([Commands.GET_CAPABILITIES, protocol])
+
+    @staticmethod
+    def build_get_timing_stats(reset: bool = False) -> bytes:
+        """Build GET_TIMING_STATS Command (reset=True setzt die Zähler danach zurück)"""
+        return bytes([Commands.GET_TIMING_STATS, 0x01 if reset else 0x00])
+
 
 # ============================================================================
 # RESPONSE PARSERS
@@ -249,32 +1153,43 @@ class CommandBuilder:
 class ResponseParser:
     """Parser für ESP32 Responses"""
 
+    # Länge der Sync Responses inkl. Header-Byte
+    SYNC_RESPONSE_LENGTHS = {
+        Responses.SYNC_COMPLETE: 15,
+        Responses.SYNC_COMPLETE_EXT: 31,
+        Responses.SYNC_COMPLETE_SETTLE: 37,
+    }
+
     @staticmethod
     def parse_sync_response(data: bytes) -> Optional[SyncResponse]:
         """
-        Parse SYNC_COMPLETE Response.
+        Parse SYNC_COMPLETE, SYNC_COMPLETE_EXT oder SYNC_COMPLETE_SETTLE Response.
 
         Format (aus Firmware):
-        - Byte 0: 0x1B (RESPONSE_SYNC_COMPLETE)
+        - Byte 0: 0x1B (RESPONSE_SYNC_COMPLETE), 0x1E (RESPONSE_SYNC_COMPLETE_EXT)
+          oder 0x1A (RESPONSE_SYNC_COMPLETE_SETTLE)
         - Bytes 1-2: timing_ms (uint16 big-endian)
         - Bytes 3-6: temperature (float)
         - Bytes 7-10: humidity (float)
-        - Byte 11: led_type_used (0=IR, 1=White)
+        - Byte 11: led_type_used (0=IR, 1=White, 0x80=Kanal-Maske)
         - Bytes 12-13: led_duration_ms (uint16 big-endian)
         - Byte 14: led_power_actual (uint8)
+        - 0x1E / 0x1A: Bytes 15-22 led_on_us, Bytes 23-30 led_off_us (uint64 big-endian)
+        - Nur 0x1A: Bytes 31-32 stabilization_ms (uint16), Bytes 33-36 settle_us (uint32)
 
         Args:
-            data: Response bytes (sollte 15 bytes sein)
+            data: Response bytes (15, 31 bzw. 37 bytes)
 
         Returns:
             SyncResponse oder None bei Fehler
         """
-        if len(data) < 15:
-            logger.error(f"Sync response too short: {len(data)} bytes")
+        expected = ResponseParser.SYNC_RESPONSE_LENGTHS.get(data[0]) if data else None
+        if expected is None:
+            logger.error(f"Invalid sync response header: {data[:1].hex() if data else 'empty'}")
             return None
 
-        if data[0] != Responses.SYNC_COMPLETE:
-            logger.error(f"Invalid sync response header: 0x{data[0]:02X}")
+        if len(data) < expected:
+            logger.error(f"Sync response too short: {len(data)} bytes")
             return None
 
         try:
@@ -287,7 +1202,13 @@ class ResponseParser:
             led_power_actual = data[14]
 
             # Map LED type to string
-            led_type_str = "ir" if led_type_used == LEDTypes.IR else "white"
+            led_type_str = {LEDTypes.IR: "ir", LEDTypes.CHANNELS: "channels"}.get(led_type_used, "white")
+
+            led_on_us = led_off_us = stabilization_ms = settle_us = None
+            if data[0] in (Responses.SYNC_COMPLETE_EXT, Responses.SYNC_COMPLETE_SETTLE):
+                led_on_us, led_off_us = struct.unpack(">QQ", data[15:31])
+            if data[0] == Responses.SYNC_COMPLETE_SETTLE:
+                stabilization_ms, settle_us = struct.unpack(">HI", data[31:37])
 
             return SyncResponse(
                 timing_ms=timing_ms,
@@ -297,6 +1218,10 @@ class ResponseParser:
                 led_duration_ms=led_duration_ms,
                 led_power_actual=led_power_actual,
                 success=True,
+                led_on_us=led_on_us,
+                led_off_us=led_off_us,
+                stabilization_ms=stabilization_ms,
+                settle_us=settle_us,
             )
 
         except Exception as e:
@@ -343,6 +1268,628 @@ class ResponseParser:
             return None
 
 
+    # Länge der Capture-Queue Records inkl. Header-Byte
+    QUEUE_EVENT_LENGTHS = {
+        Responses.QUEUE_ACK: 4,
+        Responses.QUEUE_FULL: 3,
+        Responses.QUEUED_COMPLETE: 22,
+    }
+
+    @staticmethod
+    def parse_queue_event(data: bytes):
+        """
+        Parse Capture-Queue Event (QUEUE_ACK, QUEUE_FULL oder QUEUED_COMPLETE).
+
+        QUEUED_COMPLETE Format (22 bytes):
+        - Byte 0: 0x1C
+        - Bytes 1-2: seq (uint16 big-endian)
+        - Bytes 3-6: led_on_us (uint32 big-endian)
+        - Bytes 7-10: duration_us (uint32 big-endian)
+        - Bytes 11-14: temperature (float)
+        - Bytes 15-18: humidity (float)
+        - Byte 19: led_type_used (0=IR, 1=White, 2=Dual)
+        - Byte 20: led_power_actual (uint8)
+        - Byte 21: status flags (bit0 = started late, bit1 = übersprungen)
+
+        Args:
+            data: Event bytes inkl. Header
+
+        Returns:
+            QueueAck, QueuedCaptureRecord oder None bei Fehler
+        """
+        if not data:
+            return None
+
+        expected = ResponseParser.QUEUE_EVENT_LENGTHS.get(data[0])
+        if expected is None or len(data) < expected:
+            logger.error(f"Invalid queue event: {data.hex()}")
+            return None
+
+        if data[0] == Responses.QUEUE_ACK:
+            seq, free_slots = struct.unpack(">HB", data[1:4])
+            return QueueAck(seq=seq, accepted=True, free_slots=free_slots)
+
+        if data[0] == Responses.QUEUE_FULL:
+            return QueueAck(seq=struct.unpack(">H", data[1:3])[0], accepted=False, free_slots=0)
+
+        seq, led_on_us, duration_us = struct.unpack(">HII", data[1:11])
+        temperature, humidity = struct.unpack("<ff", data[11:19])
+        led_type_str = {LEDTypes.IR: "ir", LEDTypes.WHITE: "white", LEDTypes.CHANNELS: "channels"}.get(
+            data[19], "dual"
+        )
+        return QueuedCaptureRecord(
+            seq=seq,
+            led_on_us=led_on_us,
+            duration_us=duration_us,
+            temperature=temperature,
+            humidity=humidity,
+            led_type_used=led_type_str,
+            led_power_actual=data[20],
+            started_late=bool(data[21] & 0x01),
+            skipped=bool(data[21] & 0x02),
+        )
+
+    # Länge der Schedule Events inkl. Header-Byte
+    SCHEDULE_EVENT_LENGTHS = {
+        Responses.SCHEDULE_ACK: 5,
+        Responses.SCHEDULE_FRAME: 18,
+        Responses.SCHEDULE_DONE: 5,
+    }
+
+    @staticmethod
+    def parse_schedule_event(data: bytes):
+        """
+        Parse Schedule Event (SCHEDULE_FRAME oder SCHEDULE_DONE).
+
+        SCHEDULE_FRAME Format (18 bytes):
+        - Byte 0: 0x1D
+        - Bytes 1-4: frame_index (uint32 big-endian)
+        - Bytes 5-8: led_on_us (uint32 big-endian)
+        - Bytes 9-12: duration_us (uint32 big-endian)
+        - Bytes 13-14: temperature x10 (int16 big-endian)
+        - Bytes 15-16: humidity x10 (uint16 big-endian)
+        - Byte 17: status flags (bit0 = started late, bit1 = last frame, bit2 = übersprungen)
+
+        Args:
+            data: Event bytes inkl. Header
+
+        Returns:
+            ScheduleFrame, ScheduleDone oder None bei Fehler
+        """
+        if not data or data[0] not in (Responses.SCHEDULE_FRAME, Responses.SCHEDULE_DONE):
+            logger.error(f"Invalid schedule event: {data.hex() if data else 'empty'}")
+            return None
+
+        if len(data) < ResponseParser.SCHEDULE_EVENT_LENGTHS[data[0]]:
+            logger.error(f"Schedule event too short: {data.hex()}")
+            return None
+
+        if data[0] == Responses.SCHEDULE_DONE:
+            return ScheduleDone(frames_sent=struct.unpack(">I", data[1:5])[0])
+
+        frame_index, led_on_us, duration_us, temp_raw, hum_raw, status = struct.unpack(
+            ">IIIhHB", data[1:18]
+        )
+        return ScheduleFrame(
+            frame_index=frame_index,
+            led_on_us=led_on_us,
+            duration_us=duration_us,
+            temperature=temp_raw / 10.0,
+            humidity=hum_raw / 10.0,
+            started_late=bool(status & 0x01),
+            last_frame=bool(status & 0x02),
+            skipped=bool(status & 0x04),
+        )
+
+    SEQUENCE_HEADER_LENGTH = 16
+    SEQUENCE_STEP_LENGTH = 6
+
+    @staticmethod
+    def parse_sequence_record(data: bytes) -> Optional[SequenceRecord]:
+        """
+        Parse SEQUENCE_COMPLETE Record.
+
+        Format (16 + 6 × n bytes):
+        - Byte 0: 0x1F
+        - Bytes 1-2: seq (uint16 big-endian)
+        - Byte 3: Anzahl Schritte n
+        - Bytes 4-7: led_on_us von Schritt 0 (uint32 big-endian)
+        - Bytes 8-11: temperature (float little-endian)
+        - Bytes 12-15: humidity (float little-endian)
+        - Pro Schritt: mask, power, duration_us (uint32 big-endian)
+
+        Returns:
+            SequenceRecord oder None bei Fehler
+        """
+        header = ResponseParser.SEQUENCE_HEADER_LENGTH
+        if len(data) < header or data[0] != Responses.SEQUENCE_COMPLETE:
+            logger.error(f"Invalid sequence record: {data.hex() if data else 'empty'}")
+            return None
+        count = data[3]
+        if len(data) < header + count * ResponseParser.SEQUENCE_STEP_LENGTH:
+            logger.error(f"Sequence record too short: {data.hex()}")
+            return None
+
+        seq, led_on_us = struct.unpack(">HxI", data[1:8])
+        temperature, humidity = struct.unpack("<ff", data[8:16])
+        steps = [
+            struct.unpack(">BBI", data[header + i * 6 : header + (i + 1) * 6]) for i in range(count)
+        ]
+        return SequenceRecord(
+            seq=seq, led_on_us=led_on_us, temperature=temperature, humidity=humidity, steps=steps
+        )
+
+    # Reihenfolge der Statistiken in der Firmware (TimingStatId)
+    TIMING_STAT_NAMES = (
+        "cmd_to_led_on",
+        "led_on_duration",
+        "led_on_error",
+        "sensor_read",
+        "response_send",
+        "rt_iteration",
+        "comms_iteration",
+        "schedule_wake",
+    )
+    TIMING_STATS_LENGTH = 59
+    TIMING_BUCKETS = 20
+
+    @staticmethod
+    def parse_timing_stats(data: bytes) -> Optional[TimingStats]:
+        """
+        Parse TIMING_STATS Record.
+
+        Format (59 bytes):
+        - Byte 0: 0x38
+        - Byte 1: stat id
+        - Byte 2: Anzahl Statistiken (Records insgesamt)
+        - Bytes 3-18: count, min_us, max_us, mean_us (je uint32 big-endian)
+        - Bytes 19-58: 20 Histogramm-Buckets (je uint16 big-endian)
+
+        Args:
+            data: Record bytes inkl. Header
+
+        Returns:
+            TimingStats oder None bei Fehler
+        """
+        if len(data) < ResponseParser.TIMING_STATS_LENGTH or data[0] != Responses.TIMING_STATS:
+            logger.error(f"Invalid timing stats: {data.hex() if data else 'empty'}")
+            return None
+
+        stat_id = data[1]
+        names = ResponseParser.TIMING_STAT_NAMES
+        count, min_us, max_us, mean_us = struct.unpack(">IIII", data[3:19])
+        histogram = list(struct.unpack(f">{ResponseParser.TIMING_BUCKETS}H", data[19:59]))
+        return TimingStats(
+            name=names[stat_id] if stat_id < len(names) else f"stat_{stat_id}",
+            count=count,
+            min_us=min_us,
+            max_us=max_us,
+            mean_us=mean_us,
+            histogram=histogram,
+        )
+
+    @staticmethod
+    def parse_time_sync(data: bytes) -> Optional[tuple]:
+        """
+        Parse TIME_SYNC Response.
+
+        Format (17 bytes):
+        - Byte 0: 0x39 (RESPONSE_TIME_SYNC)
+        - Bytes 1-8: rx_us - Empfang des Commands (uint64 big-endian, esp_timer)
+        - Bytes 9-16: tx_us - Senden der Response (uint64 big-endian, esp_timer)
+
+        Returns:
+            (rx_us, tx_us) oder None bei Fehler
+        """
+        if len(data) < 17 or data[0] != Responses.TIME_SYNC:
+            logger.error(f"Invalid time sync response: {data.hex() if data else 'empty'}")
+            return None
+        return struct.unpack(">QQ", data[1:17])
+
+    CAPABILITIES_LENGTH = 11
+
+    @staticmethod
+    def parse_capabilities(data: bytes) -> Optional[Capabilities]:
+        """
+        Parse CAPABILITIES Response.
+
+        Format (11 bytes):
+        - Byte 0: 0x3A (RESPONSE_CAPABILITIES)
+        - Byte 1: aktives Protokoll (2 = legacy, 3 = framed)
+        - Byte 2: höchstes unterstütztes Protokoll
+        - Bytes 3-4: Firmware-Version (major, minor)
+        - Byte 5: max. Frame-Payload
+        - Bytes 6-9: Feature-Bits (uint32 big-endian)
+        - Byte 10: Board (0 = ESP32 DevKit, 1 = ESP32-S3)
+
+        Returns:
+            Capabilities oder None bei Fehler
+        """
+        if len(data) < ResponseParser.CAPABILITIES_LENGTH or data[0] != Responses.CAPABILITIES:
+            logger.error(f"Invalid capabilities response: {data.hex() if data else 'empty'}")
+            return None
+        features = struct.unpack(">I", data[6:10])[0]
+        return Capabilities(
+            active_protocol=data[1],
+            max_protocol=data[2],
+            firmware_version=f"{data[3]}.{data[4]}",
+            max_frame_payload=data[5],
+            features=features,
+            board="ESP32-S3" if data[10] == 1 else "ESP32",
+        )
+
+    POWER_MODE_LENGTH = 3
+    CONFIG_LENGTH = 17
+    SYNC_LINE_LENGTH = 11
+    SETTLE_LENGTH = 4 + 4 * SettleOps.LEVELS
+    RESET_INFO_LENGTH = 19
+
+    @staticmethod
+    def parse_sync_line(data: bytes) -> Optional[SyncLineStatus]:
+        """
+        Parse SYNC_LINE Response.
+
+        Format (11 bytes):
+        - Byte 0: 0x41
+        - Byte 1: aktive Rolle
+        - Byte 2: Status (SyncRoles.STATUS_*)
+        - Bytes 3-6: Flanken seit Boot (uint32 big-endian)
+        - Bytes 7-10: verpasste Flanken (uint32 big-endian)
+
+        Returns:
+            SyncLineStatus oder None bei Fehler
+        """
+        if len(data) < ResponseParser.SYNC_LINE_LENGTH or data[0] != Responses.SYNC_LINE:
+            logger.error(f"Invalid sync line response: {data.hex() if data else 'empty'}")
+            return None
+        role, status, edges, missed = struct.unpack(">BBII", data[1:11])
+        return SyncLineStatus(role=role, status=status, edges=edges, missed=missed)
+
+    @staticmethod
+    def parse_reset_info(data: bytes) -> Optional[ResetInfo]:
+        """
+        Parse RESET_INFO Response.
+
+        Format (19 bytes):
+        - Byte 0: 0x43
+        - Byte 1: Reset-Grund (ResetReasons)
+        - Byte 2: Flags (ResetReasons.FLAG_*)
+        - Bytes 3-6: Warm-Resets seit Kaltstart (uint32 big-endian)
+        - Bytes 7-10: Uptime des abgestürzten Boots in ms (uint32 big-endian)
+        - Bytes 11-14: erster Frame des fortgesetzten Schedules (uint32 big-endian)
+        - Bytes 15-18: Uptime dieses Boots in ms (uint32 big-endian)
+
+        Returns:
+            ResetInfo oder None bei Fehler
+        """
+        if len(data) < ResponseParser.RESET_INFO_LENGTH or data[0] != Responses.RESET_INFO:
+            logger.error(f"Invalid reset info response: {data.hex() if data else 'empty'}")
+            return None
+        reason, flags, warm, previous, frame, uptime = struct.unpack(">BBIIII", data[1:19])
+        return ResetInfo(
+            reason=reason,
+            resumed=bool(flags & ResetReasons.FLAG_RESUMED),
+            schedule_resumed=bool(flags & ResetReasons.FLAG_SCHEDULE),
+            refused=bool(flags & ResetReasons.FLAG_REFUSED),
+            warm_resets=warm,
+            previous_uptime_ms=previous,
+            resume_frame=frame,
+            uptime_ms=uptime,
+        )
+
+    @staticmethod
+    def parse_settle(data: bytes) -> Optional[SettleTable]:
+        """
+        Parse SETTLE Response.
+
+        Format (44 bytes):
+        - Byte 0: 0x42
+        - Byte 1: Status (SettleOps.STATUS_*)
+        - Byte 2: Flags (Bit 0 = adaptive Stabilisierung an)
+        - Byte 3: Kanal
+        - Bytes 4-43: Settle-Zeit in µs bei 10, 20, ... 100 % (10 × uint32 big-endian)
+
+        Returns:
+            SettleTable oder None bei Fehler
+        """
+        if len(data) < ResponseParser.SETTLE_LENGTH or data[0] != Responses.SETTLE:
+            logger.error(f"Invalid settle response: {data.hex() if data else 'empty'}")
+            return None
+        settle_us = list(
+            struct.unpack(f">{SettleOps.LEVELS}I", data[4 : ResponseParser.SETTLE_LENGTH])
+        )
+        return SettleTable(
+            status=data[1],
+            adaptive=bool(data[2] & SettleOps.FLAG_ADAPTIVE),
+            channel=data[3],
+            settle_us=settle_us,
+        )
+
+    @staticmethod
+    def parse_config(data: bytes) -> Optional[DeviceConfig]:
+        """
+        Parse CONFIG Response.
+
+        Format (17 bytes):
+        - Byte 0: 0x3D
+        - Byte 1: flags (bit0 = aus NVS geladen, bit1 = Speichern ausstehend)
+        - Byte 2: Config-Version (1)
+        - Bytes 3-4 / 5-6: stab_ms, exp_ms (uint16 big-endian)
+        - Bytes 7-8: IR-/White-Power
+        - Byte 9: Kamera-Typ, Byte 10: ausgewählte LED
+        - Byte 11: Trigger an, Bytes 12-13: Trigger-Pulsbreite µs
+        - Byte 14: Sync-Format
+        - Bytes 15-16: Config-Hash (CRC-16 über Bytes 2-14)
+
+        Returns:
+            DeviceConfig oder None bei Fehler
+        """
+        if len(data) < ResponseParser.CONFIG_LENGTH or data[0] != Responses.CONFIG:
+            logger.error(f"Invalid config response: {data.hex() if data else 'empty'}")
+            return None
+        blob = data[2:17]
+        if blob[0] != DeviceConfig.VERSION or FrameCodec.crc16(blob[:-2]) != struct.unpack(">H", blob[-2:])[0]:
+            logger.error(f"Unsupported config blob: {blob.hex()}")
+            return None
+        stab, exp, ir, white, cam, led, trig, width, sync = struct.unpack(">HHBBBBBHB", blob[1:13])
+        return DeviceConfig(
+            stabilization_ms=stab,
+            exposure_ms=exp,
+            ir_power=ir,
+            white_power=white,
+            camera_type=cam,
+            led_type=led,
+            trigger_enabled=bool(trig),
+            trigger_width_us=width,
+            sync_format=sync,
+            restored=bool(data[1] & 0x01),
+            save_pending=bool(data[1] & 0x02),
+        )
+
+    @staticmethod
+    def parse_channels(data: bytes) -> Optional[ChannelStatus]:
+        """
+        Parse CHANNELS Response.
+
+        Format (4 + Kanalzahl bytes):
+        - Byte 0: 0x3E
+        - Byte 1: Anzahl Kanäle
+        - Byte 2: Maske der eingeschalteten Kanäle
+        - Byte 3: Capture-Maske (0 = gewählte LED)
+        - Ab Byte 4: Power pro Kanal (0-100)
+
+        Returns:
+            ChannelStatus oder None bei Fehler
+        """
+        if len(data) < 4 or data[0] != Responses.CHANNELS or len(data) < 4 + data[1]:
+            logger.error(f"Invalid channels response: {data.hex() if data else 'empty'}")
+            return None
+        count = data[1]
+        return ChannelStatus(
+            count=count, on_mask=data[2], capture_mask=data[3], powers=list(data[4 : 4 + count])
+        )
+
+    @staticmethod
+    def telemetry_length(fields: int) -> int:
+        """Länge eines TELEMETRY Records inkl. Header für die Feldmaske"""
+        return 4 + sum(size for bit, size in TelemetryFields.SIZES if fields & bit)
+
+    @staticmethod
+    def parse_telemetry(data: bytes) -> Optional[TelemetryRecord]:
+        """
+        Parse TELEMETRY Record.
+
+        Format (4-30 bytes):
+        - Byte 0: 0x3F
+        - Bytes 1-2: seq (uint16 big-endian)
+        - Byte 3: Feldmaske, danach die Gruppen in Bit-Reihenfolge:
+          LEDS (4): on_mask, LED-Typ, IR Power, White Power
+          SENSOR (6): temp x10 (int16), humidity x10 (uint16), Alter (uint16, 100 ms)
+          TIMING (12): Pulse (uint32), max µs (uint16) cmd→LED-on, LED-on Fehler,
+                       rtTask, commsTask
+          UPTIME (4): ms seit Boot (uint32)
+
+        Returns:
+            TelemetryRecord oder None bei Fehler
+        """
+        if len(data) < 4 or data[0] != Responses.TELEMETRY:
+            logger.error(f"Invalid telemetry record: {data.hex() if data else 'empty'}")
+            return None
+        seq, fields = struct.unpack(">HB", data[1:4])
+        if len(data) < ResponseParser.telemetry_length(fields):
+            logger.error(f"Telemetry record too short: {data.hex()}")
+            return None
+
+        record = TelemetryRecord(seq=seq, fields=fields)
+        pos = 4
+        if fields & TelemetryFields.LEDS:
+            record.led_on_mask, record.led_type, record.ir_power, record.white_power = data[
+                pos : pos + 4
+            ]
+            pos += 4
+        if fields & TelemetryFields.SENSOR:
+            temp_raw, hum_raw, age = struct.unpack(">hHH", data[pos : pos + 6])
+            record.temperature = temp_raw / 10.0
+            record.humidity = hum_raw / 10.0
+            record.sensor_age_s = None if age == 0xFFFF else age / 10.0
+            pos += 6
+        if fields & TelemetryFields.TIMING:
+            (
+                record.pulse_count,
+                record.cmd_to_led_on_max_us,
+                record.led_on_error_max_us,
+                record.rt_iteration_max_us,
+                record.comms_iteration_max_us,
+            ) = struct.unpack(">IHHHH", data[pos : pos + 12])
+            pos += 12
+        if fields & TelemetryFields.UPTIME:
+            record.uptime_ms = struct.unpack(">I", data[pos : pos + 4])[0]
+        return record
+
+    EVENT_CHUNK_HEADER_LENGTH = 11
+    EVENT_RECORD_LENGTH = 16
+
+    @staticmethod
+    def parse_event_chunk(data: bytes) -> Optional[EventChunk]:
+        """
+        Parse EVENT_LOG Chunk.
+
+        Format (11 + 16 × n bytes, n ≤ 3):
+        - Byte 0: 0x40
+        - Bytes 1-4: Index des ersten Records (uint32 big-endian)
+        - Bytes 5-8: Head (uint32 big-endian)
+        - Byte 9: Anzahl Records n
+        - Byte 10: Flags (Bit 0 = letzter Chunk)
+        - Pro Record: type, arg8, arg16 (uint16), arg32 (uint32), time_us (uint64)
+
+        Returns:
+            EventChunk oder None bei Fehler
+        """
+        header = ResponseParser.EVENT_CHUNK_HEADER_LENGTH
+        size = ResponseParser.EVENT_RECORD_LENGTH
+        if len(data) < header or data[0] != Responses.EVENT_LOG:
+            logger.error(f"Invalid event log chunk: {data.hex() if data else 'empty'}")
+            return None
+        first, head, count, flags = struct.unpack(">IIBB", data[1:header])
+        if len(data) < header + count * size:
+            logger.error(f"Event log chunk too short: {data.hex()}")
+            return None
+
+        records = []
+        for i in range(count):
+            fields = struct.unpack(">BBHIQ", data[header + i * size : header + (i + 1) * size])
+            records.append(EventRecord(first + i, *fields))
+        return EventChunk(first=first, head=head, last=bool(flags & 0x01), records=records)
+
+    @staticmethod
+    def parse_power_mode(data: bytes) -> Optional[tuple]:
+        """
+        Parse POWER_MODE Response.
+
+        Format (3 bytes):
+        - Byte 0: 0x3C
+        - Byte 1: aktiver Modus
+        - Byte 2: Status (PowerModes.STATUS_*)
+
+        Returns:
+            (mode, status) oder None bei Fehler
+        """
+        if len(data) < ResponseParser.POWER_MODE_LENGTH or data[0] != Responses.POWER_MODE:
+            logger.error(f"Invalid power mode response: {data.hex() if data else 'empty'}")
+            return None
+        return data[1], data[2]
+
+    @staticmethod
+    def parse_baud_set(data: bytes) -> Optional[int]:
+        """
+        Parse BAUD_SET Response (Echo von SET_BAUD und BAUD_CONFIRM).
+
+        Format:
+        - Byte 0: 0x33 (RESPONSE_BAUD_SET)
+        - Bytes 1-4: baudrate (uint32 big-endian)
+
+        Args:
+            data: Response bytes (sollte 5 bytes sein)
+
+        Returns:
+            Baudrate oder None bei Fehler
+        """
+        if len(data) < 5 or data[0] != Responses.BAUD_SET:
+            logger.error(f"Invalid baud response: {data.hex() if data else 'empty'}")
+            return None
+        return struct.unpack(">I", data[1:5])[0]
+
+
+# ============================================================================
+# FRAMED PROTOCOL (v3)
+# ============================================================================
+
+
+class FrameCodec:
+    """
+    Frames: [0x7E][len][id][seq][payload][crc16 hi][crc16 lo]
+
+    id ist das Command-Byte bzw. der Response-Code, der Payload hat das
+    Legacy-Layout - encode(cmd[0], seq, cmd[1:]) rahmt jeden CommandBuilder
+    Output. CRC-16/CCITT-FALSE über len, id, seq und payload.
+    """
+
+    SYNC = 0x7E
+    MAX_PAYLOAD = 64
+    OVERHEAD = 6
+    SEQ_EVENT = 0  # Unaufgeforderte Events (Queue-Completions, Schedule Frames)
+
+    @staticmethod
+    def crc16(data: bytes) -> int:
+        crc = 0xFFFF
+        for byte in data:
+            crc ^= byte << 8
+            for _ in range(8):
+                crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+                crc &= 0xFFFF
+        return crc
+
+    @staticmethod
+    def encode(frame_id: int, seq: int, payload: bytes = b"") -> bytes:
+        if len(payload) > FrameCodec.MAX_PAYLOAD:
+            raise ValueError(f"Frame payload too long: {len(payload)} bytes")
+        body = bytes([len(payload), frame_id, seq]) + bytes(payload)
+        crc = FrameCodec.crc16(body)
+        return bytes([FrameCodec.SYNC]) + body + bytes([crc >> 8, crc & 0xFF])
+
+
+class FrameDecoder:
+    """
+    Inkrementeller Frame-Decoder (Gegenstück zu frame_codec.cpp).
+
+    Nach einem CRC- oder Längenfehler wird ab dem nächsten Sync-Byte im
+    Puffer weitergesucht - ein beschädigtes Byte kostet nur einen Frame.
+    """
+
+    def __init__(self):
+        self._buffer = bytearray()
+        self.errors = 0
+        self.dropped = 0
+
+    def reset(self):
+        self._buffer.clear()
+
+    def feed(self, data: bytes) -> list:
+        """Bytes anhängen, liefert Liste von (id, seq, payload) fertiger Frames"""
+        self._buffer.extend(data)
+        frames = []
+        while True:
+            start = self._buffer.find(FrameCodec.SYNC)
+            if start < 0:
+                self.dropped += len(self._buffer)
+                self._buffer.clear()
+                break
+            if start:
+                self.dropped += start
+                del self._buffer[:start]
+            if len(self._buffer) < 2:
+                break
+
+            length = self._buffer[1]
+            if length > FrameCodec.MAX_PAYLOAD:
+                self.errors += 1
+                del self._buffer[0]
+                continue
+            size = length + FrameCodec.OVERHEAD
+            if len(self._buffer) < size:
+                break
+
+            crc = (self._buffer[size - 2] << 8) | self._buffer[size - 1]
+            if FrameCodec.crc16(bytes(self._buffer[1 : size - 2])) != crc:
+                self.errors += 1
+                del self._buffer[0]
+                continue
+
+            frames.append((self._buffer[2], self._buffer[3], bytes(self._buffer[4 : size - 2])))
+            del self._buffer[:size]
+        return frames
+
+
 # ============================================================================
 # PROTOCOL DOCUMENTATION
 # ============================================================================
@@ -384,12 +1931,175 @@ class ProtocolDocs:
     - SET_LED_POWER: CMD_SET_LED_POWER (0x10) + power_byte
     - SET_IR_POWER: CMD_SET_IR_POWER (0x24) + power_byte
     - SET_WHITE_POWER: CMD_SET_WHITE_POWER (0x25) + power_byte
+    - SET_DUTY_CURVE: CMD (0x26) + led_type + flags + 11 × level (uint16 big-endian) → 0xAA / 0xFF
+      → Level = Duty-Anteil (0-65535) bei 0, 10, ... 100 % Power, nicht fallend
+      → flags bit0 = im NVS speichern, bit1 = zurück auf linear
+      → Firmware rechnet daraus einmalig eine 101-Einträge-LUT pro LED
+      → led_type = Kanalnummer, weitere Kanäle ab 2 (siehe LED-KANÄLE)
+
+    LED-KANÄLE:
+    -----------
+    - Kanal 0 = IR, Kanal 1 = White, weitere per Build-Flag LED_EXTRA_PINS (max. 8)
+    - SET_CHANNEL_MASK: CMD (0x27) + mask + flags → 0xAA / 0xFF
+      → ohne Flags: alle Kanäle nach Maske ein/aus
+      → flags bit0: Maske wählt die LEDs für SYNC_CAPTURE / SYNC_CAPTURE_QUEUED
+        (led_type in der Response = 0x80, 0 = wieder gewählte LED)
+    - SET_CHANNEL_POWER: CMD (0x28) + channel + power → 0xAA / 0xFF
+    - RAMP_CHANNEL: CMD (0x29) + channel + power + duration_ms (4) → 0xAA / 0xFF
+      → LEDC-Hardware-Fade vom aktuellen Wert aus, schaltet ein
+      → Ziel 0 blendet aus und schaltet am Ende ab, die Power bleibt erhalten
+      → folgt der Duty-Kurve, kein Host-Traffic während der Rampe (Feature-Bit 14)
+      → LED ON/OFF, Power, Duty-Kurve oder ein Puls auf dem Kanal beenden sie am Ziel
+    - CALIBRATE_SETTLE: CMD (0x2A) + op + channel → SETTLE (0x42) + status + flags + channel
+      + settle_us (4) × 10 bei 10, 20, ... 100 % Power (Feature-Bit 15, Photodiode)
+      → op 0 = abfragen, 1 = messen (~7 s, Antwort am Ende), 2/3 = adaptiv an/aus, 4 = löschen
+      → adaptiv: Sync-Captures belichten nach Settle-Zeit + 25 %, höchstens SET_TIMING stab_ms
+      → Tabelle und Flag im NVS; Schedules und Sequenzen behalten ihre Zeiten
+    - GET_CHANNELS: CMD (0x2B) → CHANNELS (0x3E) + count + on_mask + capture_mask + power × count
+
+    BELEUCHTUNGSSEQUENZ:
+    --------------------
+    - SET_SEQUENCE_STEP: CMD (0x42) + index + mask + power + flags + duration_us (4) → 0xAA / 0xFF
+      → bis zu 8 Schritte, in Reihenfolge; power 0xFF = eigene Power je Kanal, mask 0 = dunkel
+      → flags bit0 = Kamera-Trigger (stab_ms nach Schrittbeginn, wenn SET_TRIGGER aktiv)
+    - RUN_SEQUENCE: CMD (0x43) + seq (2 bytes) → 0xAA, danach SEQUENCE_COMPLETE (0x1F)
+      → Schritte laufen lückenlos, Übergänge µs-genau im Timer-ISR
+      → Record: seq, Schrittzahl, led_on_us, temp, humidity + (mask, power, dauer_us) je Schritt
+
+    HARDWARE TRIGGER:
+    -----------------
+    - SET_TRIGGER: CMD (0x16) + enable (1 byte) + width_us (2 bytes) → 0xAA
+      → TTL Puls am Trigger-Pin, stab_ms nach LED-on, vom selben Timer wie die LED
+
+    PERSISTENTE CONFIG:
+    -------------------
+    - GET_CONFIG: CMD (0x18) → CONFIG (0x3D) + flags + 15-byte Config-Blob
+      → Timing, Power, Kamera-Typ, LED-Auswahl, Trigger, Sync-Format
+      → Firmware speichert Änderungen 2 s nach dem letzten SET im NVS
+      → Letzte 2 Bytes = Hash (CRC-16): stimmt er mit DeviceConfig.config_hash
+        überein, muss der Host nach einem Reset nichts erneut setzen
+
+    POWER MODE:
+    -----------
+    - SET_POWER_MODE: CMD (0x17) + mode (0 = performance, 1 = DFS, 2 = light sleep)
+      → POWER_MODE (0x3C) + aktiver Modus + Status (0 ok, 1 ungültig, 2 nicht unterstützt,
+        3 Light Sleep nur mit Frame-Protokoll)
+      → Benötigt Firmware-Build mit esp_pm (Feature-Bit 6), USB-CDC nur DFS
+      → Light Sleep: Host sendet nach >1.5 s Pause 0x55-Präambel zum Wecken
 
     TIMING:
     -------
     - SET_TIMING: CMD_SET_TIMING (0x11) + stab_ms (2 bytes) + exp_ms (2 bytes)
     - Response: RESPONSE_TIMING_SET (0x21)
 
+    CAPTURE QUEUE (Pipelining):
+    ---------------------------
+    - SYNC_CAPTURE_QUEUED: CMD (0x0D) + seq (2 bytes) + flags (1 byte) + start_us (4 bytes)
+      → Response: QUEUE_ACK (0x34) + seq + freie Slots, oder QUEUE_FULL (0x35) + seq
+        (auch während ein Schedule läuft)
+      → Pro Capture: QUEUED_COMPLETE (0x1C) + 21 bytes Record (kein 0xAA ACK)
+      → Status Bit 1: übersprungen (Schedule, keine Sync-Flanke), Queue läuft weiter
+      → Captures laufen direkt hintereinander aus einem 16er Ring-Buffer
+    - QUEUE_CLEAR: CMD (0x0E) → 0xAA, verwirft wartende Captures
+
+    ON-DEVICE SCHEDULE (Timelapse):
+    -------------------------------
+    - START_SCHEDULE: CMD (0x40) + interval_ms (4) + led_type (1) + power (1)
+      + stab_ms (2) + exp_ms (2) + frame_count (4, 0 = endlos)
+      → Response: SCHEDULE_ACK (0x36) + Startzeit Frame 0 (esp_timer µs, uint32)
+      → Pro Frame: SCHEDULE_FRAME (0x1D) + 17 bytes (Index, Zeitstempel, Dauer, Sensoren)
+      → Status Bit 2: übersprungen (Timer zu spät), jeder Index kommt genau einmal
+      → Am Ende: SCHEDULE_DONE (0x37) + Anzahl gesendeter Frames (uint32)
+      → Während der Schedule läuft werden SYNC_CAPTURE* und SET_BAUD mit 0xFF abgelehnt
+    - STOP_SCHEDULE: CMD (0x41) → SCHEDULE_DONE (nach evtl. laufendem Frame)
+
+    CLOCK SYNC / ZEITSTEMPEL:
+    -------------------------
+    - TIME_SYNC: CMD (0x52) → TIME_SYNC (0x39) + rx_us (8 bytes) + tx_us (8 bytes)
+      → NTP-Stil: offset = ((rx - t1) + (tx - t4)) / 2, Samples mit kleinstem RTT zählen
+    - SET_SENSOR_POLICY: CMD (0x1A) + max_age_ms (4) + flags (1) → 0xAA
+      → STATUS liest nie den DHT22 und schaltet nie die LEDs ab, sondern liefert
+        den letzten Snapshot; älter als max_age_ms → Messung in der nächsten LED-Pause
+      → Flag 0x01: STATUS + Alter (uint16, 100 ms Schritte, 0xFFFF = noch keine Messung)
+    - SET_SYNC_FORMAT: CMD (0x19) + format (0 = 15 bytes, 1 = extended, 2 = settle) → 0xAA
+      → extended: SYNC_COMPLETE_EXT (0x1E) + 30 bytes, d.h. 15-Byte Layout
+        + led_on_us (8 bytes) + led_off_us (8 bytes) in esp_timer µs
+      → settle: SYNC_COMPLETE_SETTLE (0x1A) + 36 bytes, d.h. extended Layout
+        + stabilization_ms (2 bytes) + settle_us (4 bytes, 0 = feste Stabilisierung)
+
+    TELEMETRIE-STREAM (nur Frame-Protokoll):
+    ----------------------------------------
+    - STREAM_TELEMETRY: CMD (0x53) + period_ms (2) + Feldmaske (1) → 0xAA / 0xFF
+      → alle period_ms ein TELEMETRY (0x3F) Event-Frame (seq 0): seq (uint16) + Maske
+        + gewählte Gruppen (LEDs 4, Sensor 6, Timing 12, Uptime 4 bytes)
+      → period 0 oder Maske 0 stoppt, ebenso Umschalten auf legacy oder Reboot
+      → ersetzt das Pollen von STATUS / GET_LED_STATUS / GET_TIMING_STATS
+
+    EVENT-LOG:
+    ----------
+    - GET_EVENT_LOG: CMD (0x54) + from (4) + max (1, 0 = 48) + flags (Bit 0 = löschen)
+      → EVENT_LOG (0x40) Chunks: first (4) + head (4) + n (1) + flags (Bit 0 = letzter)
+        + n × 16 bytes (type, arg8, arg16, arg32, time_us), kein ACK
+      → Ring der letzten 256 Events im RTC-RAM, übersteht Soft-/Watchdog-Resets
+      → Indizes zählen seit Power-on; weiter mit first + n des letzten Chunks
+
+    WATCHDOG / RECOVERY (Feature-Bit 16):
+    -------------------------------------
+    - rt-, comms- und sensor-Task am Task-Watchdog (5 s), Hänger → Panic → Warm-Reset
+    - Snapshot (LEDs, Rampen, Einstellungen, Protokoll, Baud, Sync-Rolle, Telemetrie,
+      Schedule) jede Sekunde im RTC-RAM, nach Panic/Watchdog/Soft-Reset übernommen
+      → Schedule bleibt im Raster, nur während des Resets verpasste Frames fehlen
+      → erneuter Absturz < 10 s nach einem Resume → Kaltstart
+    - GET_RESET_INFO: CMD (0x55)
+      → RESET_INFO (0x43) + Grund + Flags + Warm-Resets (4) + alte Uptime (4)
+        + erster Frame (4) + Uptime (4)
+      → Frame-Host bekommt die Response nach einem Resume auch als Event (seq 0)
+      → danach TIME_SYNC wiederholen, die esp_timer µs beginnen neu
+
+    PROTOKOLL v3 (Frames, opt-in):
+    ------------------------------
+    - GET_CAPABILITIES: CMD (0x60) + Protokoll (0 = abfragen, 2 = legacy, 3 = framed)
+      → CAPABILITIES (0x3A) + 10 bytes (Protokoll, Version, Feature-Bits, Board)
+      → Antwort kommt im bisherigen Protokoll, danach wird umgeschaltet
+      → Firmware ohne v3 antwortet 0xFF → Host bleibt bei legacy
+    - Frame: 0x7E + len + id + seq + payload + CRC-16 (CCITT-FALSE, big-endian)
+      → id = Command bzw. Response-Code, payload im bekannten Layout
+      → Antworten tragen die seq des Commands, Events seq 0
+      → Defekter Frame: FRAME_ERROR (0x3B) + Grund (1 = CRC, 2 = Länge, 3 = Timeout)
+    - BAUD_CONFIRM wird auch im Frame-Modus als rohes Byte gesendet
+
+    SYNC-LEITUNG (Master/Slave, Feature-Bit 13):
+    --------------------------------------------
+    - SET_SYNC_ROLE: CMD (0x2D) + Rolle (0 = aus, 1 = Master, 2 = Slave, 0xFF = abfragen)
+      + flags (Bit 0 = Slave mit IR + White)
+      → SYNC_LINE (0x41) + Rolle + Status + Flanken (4) + verpasst (4)
+      → Master: SYNC_CAPTURE / DUAL / QUEUED treiben die Leitung, Antworten wie bisher
+      → Slave: Puls mit eigenen Einstellungen bei jeder Flanke, Sync-Response als Event
+      → alle Boards starten in der Flanken-ISR, Versatz wenige µs; Rolle nicht gespeichert
+
+    NETZWERK (Wi-Fi/UDP, Feature-Bit 12):
+    -------------------------------------
+    - Port "udp://<host>[:4210]": jedes Datagramm trägt v3-Frames, kein legacy
+      → Antworten gehen über den Link des letzten Commands (seriell oder UDP)
+    - Multicast-Gruppe 239.255.42.10:4211: ein Frame erreicht alle Rigs gleichzeitig
+      → jedes Rig antwortet über seinen eigenen Host-Link (MulticastTrigger)
+    - SET_BAUD über das Netz → 0xFF, Light Sleep → Status 2
+
+    TIMING STATS (Diagnose):
+    ------------------------
+    - GET_TIMING_STATS: CMD (0x50) + flags (bit0 = danach zurücksetzen)
+      → Pro Statistik: TIMING_STATS (0x38) + 58 bytes (count/min/max/mean + 20 log2 Buckets)
+      → cmd_to_led_on, led_on_duration, led_on_error, sensor_read, response_send,
+        rt_iteration, comms_iteration, schedule_wake
+
+    BAUDRATE:
+    ---------
+    - SET_BAUD: CMD_SET_BAUD (0x14) + baudrate (4 bytes big-endian)
+      → Response (alte Baudrate): RESPONSE_BAUD_SET (0x33) + baudrate, danach wechselt die UART
+    - BAUD_CONFIRM: CMD_BAUD_CONFIRM (0x15) bei neuer Baudrate innerhalb 1 s
+      → Response (neue Baudrate): RESPONSE_BAUD_SET (0x33) + baudrate
+      → Ohne Bestätigung fällt die Firmware auf die alte Baudrate zurück
+
     STATUS:
     -------
     - GET_STATUS: CMD_STATUS (0x02)
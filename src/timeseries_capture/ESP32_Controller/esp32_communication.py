@@ -11,16 +11,152 @@ FIXES:
 """
 
 import logging
+import select
+import socket
 import threading
 import time
+from collections import deque
 from typing import Optional
 
 import serial
 import serial.tools.list_ports
 
+from .esp32_commands import (
+    CommandBuilder,
+    Commands,
+    FrameCodec,
+    FrameDecoder,
+    Protocols,
+    Responses,
+)
+
 logger = logging.getLogger(__name__)
 
 
+class UdpLink:
+    """
+    Netzwerk-Link zu einem ESP32 mit NETWORK_TRANSPORT (v3-Frames über UDP).
+
+    Bildet die von ESP32Communication genutzte Untermenge von serial.Serial
+    nach, damit Frame-Decoder, Retransmit und alle Parser unverändert bleiben.
+    Port-Angabe: "udp://<host>[:<port>]".
+    """
+
+    URL_PREFIX = "udp://"
+    DEFAULT_PORT = 4210
+    DATAGRAM_MAX = 512
+
+    @classmethod
+    def is_url(cls, port: Optional[str]) -> bool:
+        return isinstance(port, str) and port.startswith(cls.URL_PREFIX)
+
+    def __init__(self, url: str, timeout: float):
+        host, _, port = url[len(self.URL_PREFIX) :].partition(":")
+        self.address = (host, int(port) if port else self.DEFAULT_PORT)
+        self.timeout = timeout
+        self.baudrate = 0  # Kein UART - SET_BAUD lehnt die Firmware über das Netz ab
+        self._rx = bytearray()
+        self._sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        # connect(): nur Datagramme von diesem ESP32 annehmen
+        self._sock.connect(self.address)
+        self._sock.setblocking(False)
+        self.is_open = True
+
+    def _receive(self, wait: float = 0.0):
+        """Holt alle wartenden Datagramme in den Empfangspuffer"""
+        if wait > 0:
+            select.select([self._sock], [], [], wait)
+        while True:
+            try:
+                self._rx.extend(self._sock.recv(self.DATAGRAM_MAX))
+            except (BlockingIOError, InterruptedError):
+                return
+            except ConnectionError:
+                # ICMP port unreachable: ESP32 (noch) nicht im Netz, wie Stille behandeln
+                return
+
+    @property
+    def in_waiting(self) -> int:
+        self._receive()
+        return len(self._rx)
+
+    def read(self, size: int = 1) -> bytes:
+        deadline = time.time() + (self.timeout or 0)
+        self._receive()
+        while len(self._rx) < size:
+            remaining = deadline - time.time()
+            if remaining <= 0:
+                break
+            self._receive(remaining)
+        data = bytes(self._rx[:size])
+        del self._rx[:size]
+        return data
+
+    def write(self, data: bytes) -> int:
+        try:
+            self._sock.send(data)
+        except ConnectionError:
+            pass  # Verloren wie auf der Funkstrecke - der Host wiederholt
+        return len(data)
+
+    def flush(self):
+        pass  # Jedes write() ist bereits ein Datagramm
+
+    def reset_input_buffer(self):
+        self._receive()
+        self._rx.clear()
+
+    def reset_output_buffer(self):
+        pass
+
+    def close(self):
+        self._sock.close()
+        self.is_open = False
+
+
+class MulticastTrigger:
+    """
+    Sendet ein Command als ein Multicast-Datagramm an alle ESP32 der Gruppe
+    (z.B. SYNC_CAPTURE für alle Platten im selben Moment).
+
+    Die Rigs antworten über ihren eigenen Host-Link, die Antworten liest
+    also weiterhin jeder ESP32Controller selbst.
+    """
+
+    GROUP = "239.255.42.10"
+    PORT = 4211
+
+    def __init__(
+        self,
+        group: str = GROUP,
+        port: int = PORT,
+        ttl: int = 1,
+        interface: Optional[str] = None,
+    ):
+        self.address = (group, port)
+        self._seq = 0
+        self._sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+        self._sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, ttl)
+        if interface:
+            self._sock.setsockopt(
+                socket.IPPROTO_IP, socket.IP_MULTICAST_IF, socket.inet_aton(interface)
+            )
+
+    def send(self, data: bytes) -> int:
+        """
+        Rahmt ein Command (ein CommandBuilder-Ergebnis) und sendet es an die Gruppe.
+
+        Returns:
+            seq des Frames - die Antworten der Rigs tragen sie
+        """
+        self._seq = self._seq % 255 + 1
+        self._sock.sendto(FrameCodec.encode(data[0], self._seq, data[1:]), self.address)
+        return self._seq
+
+    def close(self):
+        self._sock.close()
+
+
 class ESP32Communication:
     """Low-level serielle Kommunikation mit ESP32 - FIXED"""
 
@@ -43,6 +179,21 @@ class ESP32Communication:
         # Thread safety
         self._comm_lock = threading.RLock()
 
+        # Framed protocol (v3) - negotiated by ESP32Controller
+        self.framed = False
+        self._framed_session = False  # Framed mode was used on this link
+        self._frame_decoder = FrameDecoder()
+        self._rx_buffer = bytearray()  # Decoded response bytes (id + payload)
+        self._tx_seq = 0
+        self._last_frame: Optional[bytes] = None  # For one retransmit on FRAME_ERROR
+        self._last_frame_answered = True
+        # Telemetry event frames, kept apart from command responses
+        self._telemetry = deque(maxlen=self.TELEMETRY_BACKLOG)
+
+        # Light sleep (SET_POWER_MODE 2): the bytes that wake the UART are lost
+        self.wake_preamble = False
+        self._last_tx = 0.0
+
         # Stats
         self._consecutive_failures = 0
         self._max_failures_before_reconnect = 3
@@ -146,6 +297,8 @@ class ESP32Communication:
             True wenn erfolgreich verbunden
         """
         with self._comm_lock:
+            self.set_framed(False)
+
             # Close existing connection
             if self.serial_connection and self.serial_connection.is_open:
                 try:
@@ -164,6 +317,9 @@ class ESP32Communication:
                 self.connected = False
                 return False
 
+            if UdpLink.is_url(target_port):
+                return self._connect_udp(target_port)
+
             # Try to connect with different DTR/RTS configurations
             configs = [
                 # Most common: DTR and RTS low (prevents auto-reset)
@@ -234,6 +390,40 @@ class ESP32Communication:
             self.connected = False
             return False
 
+    def _connect_udp(self, url: str) -> bool:
+        """
+        Verbindet über das Netz. Kein Reset beim Öffnen, kein Boot-Delay;
+        die Firmware spricht dort nur v3-Frames.
+        """
+        try:
+            self.serial_connection = UdpLink(url, self.read_timeout)
+        except (OSError, ValueError) as e:
+            logger.error(f"Cannot open {url}: {e}")
+            self.connected = False
+            return False
+
+        self.set_framed(True)
+        for attempt in range(3):
+            self.clear_buffers()
+            self._write(self._frame(CommandBuilder.build_status()))
+            time.sleep(0.2 + attempt * 0.3)
+            response = self._read_chunk(64)
+            if response and response[0] in (0x10, 0x11):
+                self.port = url
+                self.connected = True
+                self._consecutive_failures = 0
+                self._connection_start_time = time.time()
+                logger.info(f"✅ Successfully connected to ESP32 at {url}")
+                return True
+            logger.debug(f"No valid response (attempt {attempt+1}/3)")
+
+        logger.error(f"ESP32 at {url} not responding")
+        self.serial_connection.close()
+        self.serial_connection = None
+        self.set_framed(False)
+        self.connected = False
+        return False
+
     def _test_connection(self) -> bool:
         """
         Testet ob ESP32 antwortet mit Retry-Logik.
@@ -243,6 +433,12 @@ class ESP32Communication:
         """
         for attempt in range(3):
             try:
+                if attempt == 2 and self._framed_session:
+                    # ESP32 was not reset and may still expect frames
+                    self.serial_connection.write(self._revert_frame())
+                    self.serial_connection.flush()
+                    time.sleep(0.1)
+
                 # Clear any leftover data before test
                 if self.serial_connection.in_waiting > 0:
                     self.serial_connection.read(self.serial_connection.in_waiting)
@@ -283,6 +479,11 @@ class ESP32Communication:
         with self._comm_lock:
             if self.serial_connection and self.serial_connection.is_open:
                 try:
+                    if self.framed and not isinstance(self.serial_connection, UdpLink):
+                        # Leave the ESP32 in legacy mode for the next host
+                        self.serial_connection.write(self._revert_frame())
+                        self.serial_connection.flush()
+                        time.sleep(0.05)
                     self.clear_buffers()
                     self.serial_connection.close()
                     logger.info("ESP32 disconnected")
@@ -291,6 +492,145 @@ class ESP32Communication:
 
             self.connected = False
             self.serial_connection = None
+            self.set_framed(False)
+
+    def set_framed(self, enabled: bool):
+        """
+        Schaltet auf Frame-Protokoll (v3) um, nachdem die Firmware es per
+        GET_CAPABILITIES bestätigt hat. send_bytes() rahmt dann jedes Command,
+        read_*() liefern die entpackten Responses (Response-Code + Payload),
+        d.h. alle Parser arbeiten unverändert.
+        """
+        with self._comm_lock:
+            self.framed = enabled
+            self._framed_session = self._framed_session or enabled
+            self._frame_decoder.reset()
+            self._rx_buffer.clear()
+            self._telemetry.clear()
+            self._last_frame = None
+            self._last_frame_answered = True
+
+    def get_frame_stats(self) -> dict:
+        """CRC-/Längenfehler und verworfene Bytes des Frame-Decoders"""
+        return {
+            "framed": self.framed,
+            "frame_errors": self._frame_decoder.errors,
+            "dropped_bytes": self._frame_decoder.dropped,
+        }
+
+    TELEMETRY_BACKLOG = 256  # Records; older ones are dropped if nobody reads
+
+    def poll_events(self):
+        """
+        Verarbeitet bereits empfangene Frames ohne zu blockieren, damit
+        Telemetrie-Records auch ohne laufendes Command ankommen.
+        """
+        with self._comm_lock:
+            if not self.framed or not self.serial_connection or not self.serial_connection.is_open:
+                return
+            try:
+                waiting = self.serial_connection.in_waiting
+                if waiting > 0:
+                    for frame in self._frame_decoder.feed(self.serial_connection.read(waiting)):
+                        self._on_frame(*frame)
+            except Exception as e:
+                logger.debug(f"Event poll failed: {e}")
+
+    def pop_telemetry(self) -> list:
+        """Alle seit dem letzten Aufruf empfangenen TELEMETRY Records (id + payload)"""
+        with self._comm_lock:
+            records = list(self._telemetry)
+            self._telemetry.clear()
+        return records
+
+    def _revert_frame(self) -> bytes:
+        cmd = bytes([Commands.GET_CAPABILITIES, Protocols.LEGACY])
+        return FrameCodec.encode(cmd[0], 1, cmd[1:])
+
+    WAKE_PREAMBLE = b"\x55" * 4
+    WAKE_IDLE_SEC = 1.5  # ESP32 bleibt 2 s nach dem letzten Byte wach
+    WAKE_SETTLE_SEC = 0.003
+
+    def _write(self, data: bytes):
+        """Schreibt auf die UART, weckt das ESP32 vorher ggf. aus dem Light Sleep"""
+        now = time.time()
+        if self.wake_preamble and self.framed and now - self._last_tx > self.WAKE_IDLE_SEC:
+            # 0x55 liegt außerhalb jedes Frames und wird vom Decoder verworfen
+            self.serial_connection.write(self.WAKE_PREAMBLE)
+            self.serial_connection.flush()
+            time.sleep(self.WAKE_SETTLE_SEC)
+        self.serial_connection.write(data)
+        self._last_tx = time.time()
+
+    def _frame(self, data: bytes) -> bytes:
+        """Rahmt ein Command (ein CommandBuilder-Ergebnis pro Aufruf)"""
+        self._tx_seq = self._tx_seq % 255 + 1  # 1..255, 0 = Events
+        frame = FrameCodec.encode(data[0], self._tx_seq, data[1:])
+        self._last_frame = frame
+        self._last_frame_answered = False
+        return frame
+
+    def _on_frame(self, frame_id: int, seq: int, payload: bytes):
+        if frame_id == Responses.FRAME_ERROR:
+            reason = payload[0] if payload else 0
+            # seq of a damaged frame is best effort: resend only the
+            # outstanding command, and only once
+            if seq == self._tx_seq and not self._last_frame_answered and self._last_frame:
+                logger.warning(f"Frame error (reason {reason}) - resending seq {seq}")
+                self.serial_connection.write(self._last_frame)
+                self.serial_connection.flush()
+                self._last_frame_answered = True
+            else:
+                logger.warning(f"Frame error (reason {reason}, seq {seq})")
+            return
+        if seq == 0 and frame_id == Responses.TELEMETRY:
+            self._telemetry.append(bytes([frame_id]) + payload)
+            return
+        if seq == self._tx_seq:
+            self._last_frame_answered = True
+        self._rx_buffer.append(frame_id)
+        self._rx_buffer.extend(payload)
+
+    def _read_chunk(self, max_count: int) -> bytes:
+        """
+        Liefert bis zu max_count bereits empfangene Bytes ohne zu blockieren.
+        Im Frame-Modus die entpackten Responses. Caller hält _comm_lock.
+        """
+        if not self.framed:
+            waiting = self.serial_connection.in_waiting
+            if waiting == 0:
+                return b""
+            return self.serial_connection.read(min(waiting, max_count))
+
+        waiting = self.serial_connection.in_waiting
+        if waiting > 0:
+            for frame in self._frame_decoder.feed(self.serial_connection.read(waiting)):
+                self._on_frame(*frame)
+        chunk = bytes(self._rx_buffer[:max_count])
+        del self._rx_buffer[:max_count]
+        return chunk
+
+    def set_line_baudrate(self, baudrate: int) -> bool:
+        """
+        Ändert die Baudrate der offenen Verbindung (nach CMD_SET_BAUD).
+
+        self.baudrate bleibt die Boot-Baudrate, mit der (Re-)Connects starten.
+
+        Args:
+            baudrate: Neue Baudrate
+
+        Returns:
+            True wenn erfolgreich
+        """
+        with self._comm_lock:
+            if not self.serial_connection or not self.serial_connection.is_open:
+                return False
+            try:
+                self.serial_connection.baudrate = baudrate
+                return True
+            except Exception as e:
+                logger.error(f"Error setting baudrate {baudrate}: {e}")
+                return False
 
     def is_connected(self, force_check: bool = False) -> bool:
         """
@@ -322,7 +662,7 @@ class ESP32Communication:
 
     def send_byte(self, byte: int) -> bool:
         """
-        Sendet einzelnes Byte.
+        Sendet einzelnes Byte (im Frame-Modus als Frame ohne Payload).
 
         Args:
             byte: Byte zu senden (0-255)
@@ -336,7 +676,8 @@ class ESP32Communication:
                 return False
 
             try:
-                self.serial_connection.write(bytes([byte]))
+                data = bytes([byte])
+                self._write(self._frame(data) if self.framed else data)
                 self.serial_connection.flush()
                 self._last_successful_command = time.time()
                 self._consecutive_failures = 0
@@ -349,12 +690,13 @@ class ESP32Communication:
                 self._check_reconnect()
                 return False
 
-    def send_bytes(self, data: bytes) -> bool:
+    def send_bytes(self, data: bytes, raw: bool = False) -> bool:
         """
         Sendet mehrere Bytes.
 
         Args:
-            data: Bytes zu senden
+            data: Bytes zu senden - im Frame-Modus genau ein Command
+            raw: Auch im Frame-Modus ungerahmt senden (BAUD_CONFIRM)
 
         Returns:
             True wenn erfolgreich
@@ -365,7 +707,7 @@ class ESP32Communication:
                 return False
 
             try:
-                self.serial_connection.write(data)
+                self._write(self._frame(data) if self.framed and not raw else data)
                 self.serial_connection.flush()
                 self._last_successful_command = time.time()
                 self._consecutive_failures = 0
@@ -388,6 +730,10 @@ class ESP32Communication:
         Returns:
             Byte (0-255) oder None bei Fehler
         """
+        if self.framed:
+            data = self.read_bytes(1, timeout=timeout if timeout is not None else self.read_timeout)
+            return data[0] if data else None
+
         with self._comm_lock:
             if not self.is_connected():
                 return None
@@ -411,7 +757,9 @@ class ESP32Communication:
                 logger.error(f"Error reading byte: {e}")
                 return None
 
-    def read_bytes(self, count: int, timeout: Optional[float] = None) -> Optional[bytes]:
+    def read_bytes(
+        self, count: int, timeout: Optional[float] = None, poll_interval: float = 0.010
+    ) -> Optional[bytes]:
         """
         Reads exactly `count` bytes from the serial port without holding
         _comm_lock during pyserial's blocking wait.
@@ -426,6 +774,8 @@ class ESP32Communication:
         Args:
             count: Number of bytes to read
             timeout: Total wait timeout in seconds (default 2.0)
+            poll_interval: Sleep between polls in seconds. The default keeps
+                the CPU idle; latency measurements pass a much smaller value.
 
         Returns:
             Bytes object of length `count`, or None on timeout / partial read.
@@ -441,23 +791,20 @@ class ESP32Communication:
                 if not self.is_connected():
                     return None
                 try:
-                    waiting = self.serial_connection.in_waiting
+                    chunk = self._read_chunk(count - len(buffer))
                 except Exception as e:
-                    logger.error(f"Error querying in_waiting: {e}")
+                    logger.error(f"Error reading serial input: {e}")
                     return None
 
-                if waiting > 0:
-                    needed = count - len(buffer)
-                    chunk = self.serial_connection.read(min(waiting, needed))
-                    if chunk:
-                        buffer.extend(chunk)
+                if chunk:
+                    buffer.extend(chunk)
                     if len(buffer) >= count:
                         result = bytes(buffer[:count])
                         logger.debug(f"Read {count} bytes: {result.hex()}")
                         return result
                     continue
             # Lock released here — other threads can acquire while we wait
-            time.sleep(0.010)
+            time.sleep(poll_interval)
 
         if len(buffer) == count:
             result = bytes(buffer)
@@ -503,21 +850,14 @@ class ESP32Communication:
             with self._comm_lock:
                 if not self.is_connected():
                     return False
+                # Read however many bytes are already buffered (non-blocking)
                 try:
-                    waiting = self.serial_connection.in_waiting
+                    data = self._read_chunk(max_bytes - bytes_read)
                 except Exception as e:
-                    logger.debug(f"in_waiting check failed: {e}")
+                    logger.debug(f"read failed: {e}")
                     return False
 
-                if waiting > 0:
-                    # Read however many bytes are already buffered (non-blocking)
-                    chunk_size = min(waiting, max_bytes - bytes_read)
-                    try:
-                        data = self.serial_connection.read(chunk_size)
-                    except Exception as e:
-                        logger.debug(f"read failed: {e}")
-                        return False
-
+                if data:
                     for byte in data:
                         bytes_read += 1
                         if byte == expected_byte:
@@ -550,6 +890,11 @@ class ESP32Communication:
             if not self.serial_connection or not self.serial_connection.is_open:
                 return False
 
+            # Telemetry records already on the wire survive, stale replies do not
+            self.poll_events()
+            self._frame_decoder.reset()
+            self._rx_buffer.clear()
+
             try:
                 if aggressive:
                     # AGGRESSIVE CLEARING: Multiple passes with delays
@@ -670,6 +1015,9 @@ class ESP32Communication:
             "connected": self.connected,
             "port": self.port,
             "baudrate": self.baudrate,
+            "line_baudrate": (
+                self.serial_connection.baudrate if self.serial_connection else self.baudrate
+            ),
             "consecutive_failures": self._consecutive_failures,
             "last_successful_command": self._last_successful_command,
             "time_since_last_command": (
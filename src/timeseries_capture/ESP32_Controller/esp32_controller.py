@@ -17,13 +17,32 @@ import logging
 import time
 from typing import Optional
 
+from .esp32_clock_sync import ClockSync
 from .esp32_commands import (
     CameraTypes,
+    Capabilities,
+    ChannelStatus,
     CommandBuilder,
+    DeviceConfig,
+    EventChunk,
+    EventTypes,
+    Features,
     LEDStatus,
     LEDTypes,
+    PowerModes,
+    Protocols,
+    ResetInfo,
     ResponseParser,
     Responses,
+    SequenceRecord,
+    SequenceStep,
+    SettleOps,
+    SettleTable,
+    SyncFormats,
+    SyncLineStatus,
+    SyncRoles,
+    TelemetryFields,
+    TelemetryRecord,
     TimingConfig,
 )
 from .esp32_communication import ESP32Communication
@@ -40,17 +59,31 @@ class ESP32Controller:
     """
 
     def __init__(
-        self, port: Optional[str] = None, baudrate: int = 115200, auto_connect: bool = False
+        self,
+        port: Optional[str] = None,
+        baudrate: int = 115200,
+        auto_connect: bool = False,
+        framed_protocol: bool = False,
     ):
         """
         Args:
             port: Serial port (None = auto-detect)
             baudrate: Serial baudrate
             auto_connect: Automatically connect on init
+            framed_protocol: Negotiate the CRC-checked v3 protocol on connect
+                (falls back to legacy on older firmware)
         """
         # Components
         self.comm = ESP32Communication(port=port, baudrate=baudrate)
         self.state = ESP32State()
+        self.clock_sync = ClockSync()
+        self._extended_sync = False
+        self._settle_sync = False  # Extended + stabilization / settle (SyncFormats.SETTLE)
+        self._sensor_policy: Optional[tuple] = None  # (max_age_ms, report_age)
+        self._telemetry: Optional[tuple] = None  # (period_ms, fields) while streaming
+        self.latest_telemetry: Optional[TelemetryRecord] = None
+        self.framed_protocol = framed_protocol
+        self.capabilities: Optional[Capabilities] = None
 
         # Auto-connect
         if auto_connect:
@@ -75,8 +108,18 @@ class ESP32Controller:
         if success:
             # Re-send timing config so the ESP32 is ready for the next capture
             try:
+                if self.framed_protocol:
+                    self.negotiate_protocol(framed=True)
                 self.set_timing(1000, 10)
                 self.set_camera_type(CameraTypes.HIK_GIGE)
+                # The ESP32 may have rebooted: new esp_timer epoch, legacy format
+                self.clock_sync.reset()
+                if self._extended_sync:
+                    self.set_sync_timestamps(True, settle=self._settle_sync)
+                if self._sensor_policy:
+                    self.set_sensor_policy(*self._sensor_policy)
+                if self._telemetry:
+                    self.start_telemetry(*self._telemetry)
                 logger.info("✅ ESP32 re-initialized after background reconnect")
             except Exception as e:
                 logger.warning(f"Re-init after reconnect failed: {e}")
@@ -94,11 +137,20 @@ class ESP32Controller:
         success = self.comm.connect(port)
 
         if success:
-            # Initialize with default timing
-            self.set_timing(1000, 10)
+            self.clock_sync.reset()
 
-            # Set camera type to HIK GigE
-            self.set_camera_type(CameraTypes.HIK_GIGE)
+            if self.framed_protocol:
+                self.negotiate_protocol(framed=True)
+
+            # Settings stored on the ESP32 survive resets - only initialize
+            # defaults when there are none (or the firmware cannot tell)
+            config = self.get_device_config()
+            if config is None or not config.restored:
+                # Initialize with default timing
+                self.set_timing(1000, 10)
+
+                # Set camera type to HIK GigE
+                self.set_camera_type(CameraTypes.HIK_GIGE)
 
             # Query initial LED status
             try:
@@ -133,6 +185,63 @@ class ESP32Controller:
         """
         return self.comm.is_connected(force_check)
 
+    # ========================================================================
+    # PROTOCOL NEGOTIATION
+    # ========================================================================
+
+    def get_capabilities(self, protocol: int = Protocols.QUERY) -> Optional[Capabilities]:
+        """
+        Query firmware version, features and protocol (CMD_GET_CAPABILITIES).
+
+        Args:
+            protocol: Protocols.QUERY, or LEGACY / FRAMED to switch after the reply
+
+        Returns:
+            Capabilities, or None for firmware without the command
+        """
+        if not self.is_connected():
+            return None
+
+        self.comm.clear_buffers()
+        if not self.comm.send_bytes(CommandBuilder.build_get_capabilities(protocol)):
+            return None
+
+        header = self.comm.read_bytes(1, timeout=0.5)
+        if not header or header[0] != Responses.CAPABILITIES:
+            return None
+        body = self.comm.read_bytes(ResponseParser.CAPABILITIES_LENGTH - 1, timeout=0.5)
+        caps = ResponseParser.parse_capabilities(header + body) if body else None
+        if caps:
+            self.capabilities = caps
+        return caps
+
+    def negotiate_protocol(self, framed: bool = True) -> bool:
+        """
+        Switch the link to the framed v3 protocol (or back to legacy).
+
+        Firmware without framing answers 0xFF and the link stays legacy.
+
+        Args:
+            framed: True = framed protocol, False = legacy bytes
+
+        Returns:
+            True if the requested protocol is active
+        """
+        target = Protocols.FRAMED if framed else Protocols.LEGACY
+        caps = self.get_capabilities(target)
+        if caps is None:
+            if framed:
+                logger.info("Firmware has no framed protocol - staying on legacy")
+            return not framed and not self.comm.framed
+
+        # Reply came in the old protocol; the ESP32 has switched now
+        self.comm.set_framed(caps.active_protocol == Protocols.FRAMED)
+        logger.info(
+            f"ESP32 firmware {caps.firmware_version} ({caps.board}), "
+            f"protocol v{caps.active_protocol}"
+        )
+        return caps.active_protocol == target
+
     # ========================================================================
     # LED TYPE SELECTION
     # ========================================================================
@@ -327,6 +436,159 @@ class ESP32Controller:
         logger.info(f"{led_name} LED power set to {power}%")
         return True
 
+    def set_duty_curve(
+        self, led_type: str, points: Optional[list] = None, persist: bool = True
+    ) -> bool:
+        """
+        Upload a power -> duty calibration curve (CMD_SET_DUTY_CURVE).
+
+        The ESP32 precomputes a duty LUT from it, so power values stay
+        comparable across rigs without iterative host-side calibration.
+        See DutyCurves.from_measurements() to linearize a measured LED.
+        Refused while captures, a schedule or a slave sync role are active.
+
+        Args:
+            led_type: 'ir' or 'white'
+            points: 11 duty fractions (0.0-1.0) at 0, 10, ... 100 % power;
+                None restores the linear curve
+            persist: Store the curve in the ESP32's NVS
+
+        Returns:
+            True if the ESP32 accepted the curve
+        """
+        if not self.is_connected():
+            return False
+
+        if led_type not in ("ir", "white"):
+            logger.error(f"Invalid LED type: {led_type}")
+            return False
+
+        led = LEDTypes.IR if led_type == "ir" else LEDTypes.WHITE
+        if not self.comm.send_bytes(CommandBuilder.build_set_duty_curve(led, points, persist)):
+            return False
+
+        response = self.comm.read_bytes(1, timeout=1.0)
+        if not response or response[0] != Responses.LED_ON_ACK:
+            logger.error(f"Duty curve rejected for {led_type.upper()} LED")
+            return False
+
+        logger.info(f"{led_type.upper()} duty curve {'reset' if points is None else 'uploaded'}")
+        return True
+
+    def set_channel_mask(self, mask: int, capture: bool = False) -> bool:
+        """
+        Switch LED channels by bit mask (CMD_SET_CHANNEL_MASK).
+
+        Channel 0 is the IR LED, channel 1 the white LED; firmware built
+        with LED_EXTRA_PINS has up to 8 channels.
+
+        Args:
+            mask: Bit n = channel n
+            capture: Instead of switching now, light these channels for
+                every following sync capture (0 = selected LED again)
+
+        Returns:
+            True if the ESP32 accepted the mask
+        """
+        if not self.is_connected():
+            return False
+
+        if not self.comm.send_bytes(CommandBuilder.build_set_channel_mask(mask, capture)):
+            return False
+
+        response = self.comm.read_bytes(1, timeout=1.0)
+        if not response or response[0] != Responses.LED_ON_ACK:
+            logger.error(f"Channel mask 0x{mask:02X} rejected")
+            return False
+
+        logger.info(f"{'Capture' if capture else 'Output'} channel mask set to 0x{mask:02X}")
+        return True
+
+    def set_channel_power(self, channel: int, power: int) -> bool:
+        """
+        Set the power of one LED channel (CMD_SET_CHANNEL_POWER).
+
+        Args:
+            channel: Channel index (0 = IR, 1 = white)
+            power: Power in percent (0-100)
+
+        Returns:
+            True if the ESP32 accepted the power
+        """
+        if not self.is_connected():
+            return False
+
+        if not self.comm.send_bytes(CommandBuilder.build_set_channel_power(channel, power)):
+            return False
+
+        response = self.comm.read_bytes(1, timeout=1.0)
+        if not response or response[0] != Responses.LED_ON_ACK:
+            logger.error(f"Power for LED channel {channel} rejected")
+            return False
+
+        if channel in (LEDTypes.IR, LEDTypes.WHITE):
+            self.state.set_led_power(max(0, min(100, power)), "ir" if channel == LEDTypes.IR else "white")
+        logger.info(f"LED channel {channel} power set to {power}%")
+        return True
+
+    def ramp_channel(self, channel: int, power: int, duration_s: float) -> bool:
+        """
+        Fade one LED channel to a power on the ESP32 (CMD_RAMP_CHANNEL).
+
+        The LEDC fade hardware runs the ramp from the channel's current
+        output, so a dawn or dusk transition takes one command instead of a
+        power command per step. The channel is switched on; a ramp to 0
+        fades out and switches it off, keeping its power setting. LED
+        on/off or power commands for the channel end the ramp.
+
+        Args:
+            channel: Channel index (0 = IR, 1 = white)
+            power: Target power in percent (0-100, 0 = fade out)
+            duration_s: Ramp duration in seconds (0 = at once)
+
+        Returns:
+            True if the ESP32 started the ramp, False without firmware support
+            (see get_capabilities())
+        """
+        if not self.is_connected():
+            return False
+        if not self.capabilities or not self.capabilities.has(Features.LED_RAMP):
+            return False
+
+        power = max(0, min(100, power))
+        cmd = CommandBuilder.build_ramp_channel(channel, power, round(duration_s * 1000))
+        if not self.comm.send_bytes(cmd):
+            return False
+
+        response = self.comm.read_bytes(1, timeout=1.0)
+        if not response or response[0] != Responses.LED_ON_ACK:
+            logger.error(f"Ramp for LED channel {channel} rejected")
+            return False
+
+        if power > 0 and channel in (LEDTypes.IR, LEDTypes.WHITE):
+            self.state.set_led_power(power, "ir" if channel == LEDTypes.IR else "white")
+        logger.info(f"LED channel {channel} ramping to {power}% over {duration_s:.1f}s")
+        return True
+
+    def get_channels(self) -> Optional[ChannelStatus]:
+        """
+        Read channel count, on/capture masks and powers (CMD_GET_CHANNELS).
+
+        Returns:
+            ChannelStatus, or None for firmware without LED channels
+        """
+        if not self.is_connected():
+            return None
+
+        if not self.comm.send_bytes(CommandBuilder.build_get_channels()):
+            return None
+
+        header = self.comm.read_bytes(2, timeout=0.5)
+        if not header or len(header) < 2 or header[0] != Responses.CHANNELS:
+            return None
+        body = self.comm.read_bytes(2 + header[1], timeout=0.5)
+        return ResponseParser.parse_channels(header + body) if body else None
+
     # ========================================================================
     # SYNC PULSE (For Recording)
     # ========================================================================
@@ -370,6 +632,64 @@ class ESP32Controller:
 
         return pulse_start
 
+    @staticmethod
+    def begin_line_sync_pulse(master, slaves: list, dual: bool = False) -> float:
+        """
+        Start one phase-aligned pulse on all boards of a shared sync line.
+
+        Only the master gets a command; the slaves start on its edge and each
+        reports with a sync response, read with wait_sync_complete() on every
+        controller as usual.
+
+        Args:
+            master: ESP32Controller in SyncRoles.MASTER
+            slaves: ESP32Controller per board in SyncRoles.SLAVE
+            dual: Master lights IR + white (slaves use their own setting)
+
+        Returns:
+            Pulse start time of the master
+        """
+        for slave in slaves:
+            slave.comm.clear_buffers(aggressive=True)
+        start = master.begin_sync_pulse(dual)
+        for slave in slaves:
+            slave.state.begin_sync_pulse()
+        return start
+
+    @staticmethod
+    def begin_group_sync_pulse(trigger, controllers: list, dual: bool = False) -> list:
+        """
+        Start one sync pulse on several rigs with a single multicast frame.
+
+        Every rig receives the same datagram (Wi-Fi builds, MulticastTrigger)
+        and answers over its own host link, so each controller then reads its
+        result with wait_sync_complete() as usual.
+
+        Args:
+            trigger: MulticastTrigger for the rigs' group
+            controllers: ESP32Controller per rig in the group
+            dual: If True, use dual LED mode (both IR + White)
+
+        Returns:
+            Pulse start time per controller, None where no ACK arrived
+        """
+        for controller in controllers:
+            controller.comm.clear_buffers(aggressive=True)
+
+        if dual:
+            trigger.send(CommandBuilder.build_sync_capture_dual())
+        else:
+            trigger.send(CommandBuilder.build_sync_capture())
+
+        starts = []
+        for controller in controllers:
+            if controller.comm.read_until_response(Responses.LED_ON_ACK, timeout=1.0):
+                starts.append(controller.state.begin_sync_pulse())
+            else:
+                logger.warning(f"No group sync ACK from {controller.comm.port}")
+                starts.append(None)
+        return starts
+
     def wait_sync_complete(self, timeout: float = 5.0) -> dict:
         """
         Wait for sync pulse to complete and get response.
@@ -383,8 +703,12 @@ class ESP32Controller:
         if not self.is_connected():
             raise RuntimeError("Not connected")
 
-        # Read sync complete response (15 bytes)
-        response_data = self.comm.read_bytes(15, timeout=timeout)
+        # Read sync complete response (15 bytes, 31 / 37 bytes in extended / settle format)
+        response_data = self.comm.read_bytes(1, timeout=timeout)
+        length = ResponseParser.SYNC_RESPONSE_LENGTHS.get(response_data[0]) if response_data else None
+        if length:
+            body = self.comm.read_bytes(length - 1, timeout=timeout)
+            response_data = response_data + body if body else None
 
         if not response_data:
             logger.error("No sync complete response received")
@@ -428,6 +752,21 @@ class ESP32Controller:
             "led_power_actual": sync_response.led_power_actual,
         }
 
+        # Device edge times (extended format), mapped to host time if synced
+        if sync_response.led_on_us is not None:
+            result["led_on_us"] = sync_response.led_on_us
+            result["led_off_us"] = sync_response.led_off_us
+            if self.clock_sync.is_synced:
+                result["led_on_host_time"] = self.clock_sync.device_to_host(sync_response.led_on_us)
+                result["led_off_host_time"] = self.clock_sync.device_to_host(
+                    sync_response.led_off_us
+                )
+
+        # Stabilization the capture used (settle format, see calibrate_settle())
+        if sync_response.stabilization_ms is not None:
+            result["stabilization_ms"] = sync_response.stabilization_ms
+            result["settle_us"] = sync_response.settle_us
+
         # Update state
         self.state.complete_sync(result)
 
@@ -435,6 +774,520 @@ class ESP32Controller:
 
         return result
 
+    # ========================================================================
+    # CLOCK SYNC (Device Timestamps)
+    # ========================================================================
+
+    def sync_clock(self, rounds: int = 8) -> bool:
+        """
+        Run TIME_SYNC ping-pongs and update the device-to-host clock model.
+
+        Call once after connect and then periodically (e.g. every few
+        minutes) so the drift estimate builds up over a long baseline.
+
+        Args:
+            rounds: Number of ping-pong exchanges
+
+        Returns:
+            True if at least one exchange succeeded
+        """
+        if not self.is_connected():
+            return False
+
+        cmd = CommandBuilder.build_time_sync()
+        success = 0
+        for _ in range(rounds):
+            host_send = time.perf_counter()
+            if not self.comm.send_bytes(cmd):
+                break
+            data = self.comm.read_bytes(17, timeout=0.5)
+            host_recv = time.perf_counter()
+
+            stamps = ResponseParser.parse_time_sync(data) if data else None
+            if stamps is None:
+                continue
+            self.clock_sync.add_sample(host_send, stamps[0], stamps[1], host_recv)
+            success += 1
+
+        stats = self.clock_sync.get_stats()
+        logger.debug(
+            f"Clock sync: {success}/{rounds} ok, best RTT {stats['best_rtt_us']}µs, "
+            f"drift {stats['drift_ppm']:.1f}ppm"
+        )
+        return success > 0
+
+    def set_sync_timestamps(self, enabled: bool, settle: bool = False) -> bool:
+        """
+        Switch sync responses to the extended format with 64-bit LED-on/off
+        edge times (esp_timer µs). wait_sync_complete() then also returns
+        led_on_us/led_off_us and, once sync_clock() ran, host timestamps.
+
+        Args:
+            enabled: True = extended 31-byte response, False = legacy 15 bytes
+            settle: With enabled, the 37-byte response that also carries the
+                stabilization used (stabilization_ms / settle_us in the result)
+
+        Returns:
+            True if successful
+        """
+        if not self.is_connected():
+            return False
+
+        settle = enabled and settle
+        if not self.comm.send_bytes(CommandBuilder.build_set_sync_format(enabled, settle)):
+            return False
+
+        if not self.comm.read_until_response(Responses.LED_ON_ACK, timeout=0.5):
+            logger.error("No ACK for SET_SYNC_FORMAT")
+            return False
+
+        self._extended_sync = enabled
+        self._settle_sync = settle
+        return True
+
+    def calibrate_settle(self, channel: int, timeout: float = 15.0) -> Optional[SettleTable]:
+        """
+        Measure the LED's rise-to-stable time at 10, 20, ... 100 % power with
+        the ESP32's photodiode (CMD_CALIBRATE_SETTLE). Blocks for ~7 s; do not
+        send LED commands meanwhile. The table is stored on the ESP32.
+
+        Args:
+            channel: LED channel (0 = IR, 1 = white)
+            timeout: Seconds to wait for the result
+
+        Returns:
+            SettleTable (check .status), or None without photodiode / no reply
+        """
+        if not self.capabilities or not self.capabilities.has(Features.LED_SETTLE):
+            logger.warning("ESP32 has no photodiode for settle calibration")
+            return None
+        result = self._settle_request(SettleOps.CALIBRATE, channel, timeout)
+        if result and result.status != SettleOps.STATUS_OK:
+            logger.warning(f"Settle calibration of channel {channel}: status {result.status}")
+        return result
+
+    def get_settle_table(self, channel: int) -> Optional[SettleTable]:
+        """Calibrated settle times of one channel and the adaptive flag."""
+        return self._settle_request(SettleOps.QUERY, channel, 0.5)
+
+    def set_adaptive_settle(self, enabled: bool) -> bool:
+        """
+        Let sync captures expose once the lit LEDs have settled (calibrated
+        settle + 25 %, at most the set stabilization) instead of after the
+        fixed stabilization time. Persisted on the ESP32.
+
+        Returns:
+            True if successful
+        """
+        op = SettleOps.ADAPTIVE_ON if enabled else SettleOps.ADAPTIVE_OFF
+        result = self._settle_request(op, 0, 0.5)
+        return result is not None and result.status == SettleOps.STATUS_OK
+
+    def _settle_request(self, op: int, channel: int, timeout: float) -> Optional[SettleTable]:
+        if not self.is_connected():
+            return None
+
+        self.comm.clear_buffers()
+        if not self.comm.send_bytes(CommandBuilder.build_calibrate_settle(op, channel)):
+            return None
+
+        data = self.comm.read_bytes(ResponseParser.SETTLE_LENGTH, timeout=timeout)
+        return ResponseParser.parse_settle(data) if data else None
+
+    def set_sensor_policy(self, max_age_ms: int, report_age: bool = True) -> bool:
+        """
+        Configure how stale the sensor data served by CMD_STATUS may be.
+
+        Status queries never read the DHT22 or blank the LEDs; the firmware
+        samples in LED-off gaps and reads early once a queried snapshot is
+        older than max_age_ms.
+
+        Args:
+            max_age_ms: Accepted staleness in ms (at least 2000, the DHT22 rate)
+            report_age: Append the sample age to status replies, returned by
+                get_sensor_data() as 'age_s'
+
+        Returns:
+            True if successful
+        """
+        if not self.is_connected():
+            return False
+
+        cmd = CommandBuilder.build_set_sensor_policy(max_age_ms, report_age)
+        if not self.comm.send_bytes(cmd):
+            return False
+
+        if not self.comm.read_until_response(Responses.LED_ON_ACK, timeout=0.5):
+            logger.error("No ACK for SET_SENSOR_POLICY")
+            return False
+
+        self._sensor_policy = (max_age_ms, report_age)
+        return True
+
+    # ========================================================================
+    # TELEMETRY STREAM
+    # ========================================================================
+
+    @property
+    def telemetry_active(self) -> bool:
+        """True while subscribed to the telemetry stream."""
+        return self._telemetry is not None
+
+    def start_telemetry(self, period_ms: int = 500, fields: int = TelemetryFields.ALL) -> bool:
+        """
+        Subscribe to periodic status records (CMD_STREAM_TELEMETRY).
+
+        Replaces polling get_sensor_data() / get_led_status() /
+        get_timing_stats(): the ESP32 pushes one fixed-size record per
+        period, read with read_telemetry(). Needs the framed protocol.
+
+        Args:
+            period_ms: Record period (at least 20 ms)
+            fields: TelemetryFields bits to include
+
+        Returns:
+            True if the stream is running
+        """
+        if not self.is_connected() or not self.comm.framed:
+            logger.error("Telemetry stream needs the framed protocol")
+            return False
+
+        try:
+            cmd = CommandBuilder.build_stream_telemetry(period_ms, fields)
+        except ValueError as e:
+            logger.error(str(e))
+            return False
+
+        if not self.comm.send_bytes(cmd):
+            return False
+        if not self.comm.read_until_response(Responses.LED_ON_ACK, timeout=0.5):
+            logger.error("STREAM_TELEMETRY rejected")
+            return False
+
+        self._telemetry = (period_ms, fields)
+        return True
+
+    def stop_telemetry(self) -> bool:
+        """Stop the telemetry stream."""
+        self._telemetry = None
+        if not self.is_connected():
+            return False
+        if not self.comm.send_bytes(CommandBuilder.build_stream_telemetry(0, 0)):
+            return False
+        return self.comm.read_until_response(Responses.LED_ON_ACK, timeout=0.5)
+
+    def read_telemetry(self) -> list:
+        """
+        Records received since the last call, oldest first. Never sends a
+        command; latest_telemetry keeps the newest record.
+
+        Returns:
+            List of TelemetryRecord (empty if none arrived)
+        """
+        self.comm.poll_events()
+        records = []
+        for data in self.comm.pop_telemetry():
+            record = ResponseParser.parse_telemetry(data)
+            if record:
+                records.append(record)
+        if records:
+            self.latest_telemetry = records[-1]
+        return records
+
+    def set_sync_role(self, role: int, dual: bool = False) -> Optional[SyncLineStatus]:
+        """
+        Make this board master or slave on the shared sync line (CMD_SET_SYNC_ROLE).
+
+        A master's sync captures start every board on the line; a slave then
+        answers each edge with a sync response of its own (read it with
+        wait_sync_complete()). Not persisted, only kept across a warm reset -
+        set it again after a reconnect.
+
+        Args:
+            role: SyncRoles.OFF, MASTER, SLAVE or QUERY (counters only)
+            dual: Slave lights IR + white
+
+        Returns:
+            SyncLineStatus (check .status), or None for firmware without the command
+        """
+        if not self.is_connected():
+            return None
+
+        self.comm.clear_buffers()
+        if not self.comm.send_bytes(CommandBuilder.build_set_sync_role(role, dual)):
+            return None
+
+        data = self.comm.read_bytes(ResponseParser.SYNC_LINE_LENGTH, timeout=0.5)
+        result = ResponseParser.parse_sync_line(data) if data else None
+        if result and result.status != SyncRoles.STATUS_OK:
+            logger.warning(f"Sync role {role} rejected (status {result.status})")
+        return result
+
+    def set_power_mode(self, mode: int) -> bool:
+        """
+        Select how the ESP32 idles between captures (CMD_SET_POWER_MODE).
+
+        LIGHT_SLEEP needs the framed protocol (negotiate_protocol()) and a
+        UART link; the host then sends a wake preamble after idle periods.
+
+        Args:
+            mode: PowerModes.PERFORMANCE, DFS or LIGHT_SLEEP
+
+        Returns:
+            True if the ESP32 accepted the mode
+        """
+        if not self.is_connected():
+            return False
+
+        if not self.comm.send_bytes(CommandBuilder.build_set_power_mode(mode)):
+            return False
+
+        data = self.comm.read_bytes(ResponseParser.POWER_MODE_LENGTH, timeout=0.5)
+        result = ResponseParser.parse_power_mode(data) if data else None
+        if result is None:
+            return False
+
+        active, status = result
+        self.comm.wake_preamble = active == PowerModes.LIGHT_SLEEP
+        if status != PowerModes.STATUS_OK:
+            logger.warning(f"Power mode {mode} rejected (status {status}), active mode {active}")
+            return False
+        logger.info(f"Power mode {active} active")
+        return True
+
+    # ========================================================================
+    # CAPTURE QUEUE (Pipelined Sync Pulses)
+    # ========================================================================
+
+    def enqueue_sync_capture(
+        self, seq: int, dual: bool = False, start_us: Optional[int] = None
+    ) -> bool:
+        """
+        Queue a sync capture on the ESP32 without waiting for it.
+
+        The ESP32 answers with a QueueAck and, once the pulse is done, a
+        QueuedCaptureRecord tagged with the same seq. Read both with
+        read_queue_event(). Several captures can be outstanding at once.
+
+        Args:
+            seq: Sequence number (0-65535)
+            dual: Use both LEDs
+            start_us: Start time in ESP32 esp_timer µs (low 32 bits), None = ASAP
+
+        Returns:
+            True if the command was sent
+        """
+        if not self.is_connected():
+            return False
+        return self.comm.send_bytes(CommandBuilder.build_sync_capture_queued(seq, dual, start_us))
+
+    def clear_capture_queue(self) -> bool:
+        """Drop all queued captures that have not started yet."""
+        if not self.is_connected():
+            return False
+        if not self.comm.send_bytes(CommandBuilder.build_queue_clear()):
+            return False
+        return self.comm.read_until_response(Responses.LED_ON_ACK, timeout=0.5)
+
+    def read_queue_event(self, timeout: float = 2.0):
+        """
+        Read the next capture queue event from the ESP32.
+
+        Args:
+            timeout: Timeout in seconds
+
+        Returns:
+            QueueAck, QueuedCaptureRecord or None on timeout/parse error
+        """
+        header = self.comm.read_bytes(1, timeout=timeout)
+        if not header:
+            return None
+
+        length = ResponseParser.QUEUE_EVENT_LENGTHS.get(header[0])
+        if length is None:
+            logger.warning(f"Unexpected byte in capture queue stream: 0x{header[0]:02X}")
+            return None
+
+        body = self.comm.read_bytes(length - 1, timeout=timeout)
+        if not body:
+            return None
+        return ResponseParser.parse_queue_event(header + body)
+
+    # ========================================================================
+    # ON-DEVICE SCHEDULE (Timelapse)
+    # ========================================================================
+
+    def start_schedule(
+        self,
+        interval_ms: int,
+        led_type: str = "ir",
+        power: int = 100,
+        stabilization_ms: int = 400,
+        exposure_ms: int = 20,
+        frame_count: int = 0,
+    ) -> Optional[int]:
+        """
+        Start a timelapse that the ESP32 runs on its own.
+
+        The firmware generates every pulse from its own timer; afterwards the
+        host only consumes ScheduleFrame events via read_schedule_event()
+        until a ScheduleDone arrives.
+
+        Args:
+            interval_ms: Frame interval
+            led_type: 'ir', 'white' or 'dual'
+            power: LED power (0-100)
+            stabilization_ms: LED stabilization time per frame
+            exposure_ms: Exposure time per frame
+            frame_count: Number of frames, 0 = until stop_schedule()
+
+        Returns:
+            esp_timer time of frame 0 (µs, low 32 bits) or None on error
+        """
+        if not self.is_connected():
+            return None
+
+        type_map = {"ir": LEDTypes.IR, "white": LEDTypes.WHITE, "dual": LEDTypes.DUAL}
+        if led_type.lower() not in type_map:
+            logger.error(f"Invalid LED type for schedule: {led_type}")
+            return None
+
+        try:
+            command = CommandBuilder.build_start_schedule(
+                interval_ms,
+                type_map[led_type.lower()],
+                power,
+                stabilization_ms,
+                exposure_ms,
+                frame_count,
+            )
+        except ValueError as e:
+            logger.error(str(e))
+            return None
+
+        if not self.comm.send_bytes(command):
+            return None
+
+        # 0xFF (rejected) is a single byte, so read the header separately
+        header = self.comm.read_bytes(1, timeout=1.0)
+        if not header or header[0] != Responses.SCHEDULE_ACK:
+            logger.error(f"Schedule not accepted: {header.hex() if header else 'timeout'}")
+            return None
+
+        body = self.comm.read_bytes(4, timeout=0.5)
+        if not body:
+            return None
+
+        start_us = int.from_bytes(body, "big")
+        logger.info(f"Schedule started: {interval_ms}ms interval, {frame_count or 'endless'} frames")
+        return start_us
+
+    def stop_schedule(self) -> bool:
+        """
+        Stop the running schedule.
+
+        The ScheduleDone event (after a frame still in flight) is delivered
+        through read_schedule_event().
+        """
+        if not self.is_connected():
+            return False
+        return self.comm.send_bytes(CommandBuilder.build_stop_schedule())
+
+    def read_schedule_event(self, timeout: float = 2.0):
+        """
+        Read the next schedule event from the ESP32.
+
+        Args:
+            timeout: Timeout in seconds (should exceed the frame interval)
+
+        Returns:
+            ScheduleFrame, ScheduleDone or None on timeout/parse error
+        """
+        header = self.comm.read_bytes(1, timeout=timeout)
+        if not header:
+            return None
+
+        length = ResponseParser.SCHEDULE_EVENT_LENGTHS.get(header[0])
+        if length is None or header[0] == Responses.SCHEDULE_ACK:
+            logger.warning(f"Unexpected byte in schedule stream: 0x{header[0]:02X}")
+            return None
+
+        body = self.comm.read_bytes(length - 1, timeout=timeout)
+        if not body:
+            return None
+        return ResponseParser.parse_schedule_event(header + body)
+
+    # ========================================================================
+    # ILLUMINATION SEQUENCE
+    # ========================================================================
+
+    def upload_sequence(self, steps: list) -> bool:
+        """
+        Upload an illumination sequence (CMD_SET_SEQUENCE_STEP per step).
+
+        The steps run back to back on the ESP32's pulse timer, e.g. IR with
+        trigger, then white with trigger, for interleaved acquisitions
+        without a host round trip per frame.
+
+        Args:
+            steps: Up to 8 SequenceStep
+
+        Returns:
+            True if the ESP32 accepted every step
+        """
+        if not self.is_connected():
+            return False
+
+        if not 0 < len(steps) <= SequenceStep.MAX_STEPS:
+            logger.error(f"Sequence needs 1-{SequenceStep.MAX_STEPS} steps")
+            return False
+
+        for index, step in enumerate(steps):
+            try:
+                command = CommandBuilder.build_set_sequence_step(index, step)
+            except ValueError as e:
+                logger.error(str(e))
+                return False
+            if not self.comm.send_bytes(command):
+                return False
+            response = self.comm.read_bytes(1, timeout=1.0)
+            if not response or response[0] != Responses.LED_ON_ACK:
+                logger.error(f"Sequence step {index} rejected")
+                return False
+
+        logger.info(f"Sequence with {len(steps)} steps uploaded")
+        return True
+
+    def run_sequence(self, seq: int = 0, timeout: float = 5.0) -> Optional[SequenceRecord]:
+        """
+        Run the uploaded sequence and wait for its completion record.
+
+        Args:
+            seq: Sequence number echoed in the record
+            timeout: Seconds to wait after the ACK (should exceed the
+                total sequence duration)
+
+        Returns:
+            SequenceRecord or None on error/timeout
+        """
+        if not self.is_connected():
+            return None
+
+        if not self.comm.send_bytes(CommandBuilder.build_run_sequence(seq)):
+            return None
+
+        ack = self.comm.read_bytes(1, timeout=1.0)
+        if not ack or ack[0] != Responses.LED_ON_ACK:
+            logger.error(f"Sequence not started: {ack.hex() if ack else 'timeout'}")
+            return None
+
+        header = self.comm.read_bytes(ResponseParser.SEQUENCE_HEADER_LENGTH, timeout=timeout)
+        if not header or len(header) < ResponseParser.SEQUENCE_HEADER_LENGTH:
+            logger.error("No sequence record received")
+            return None
+        body = self.comm.read_bytes(header[3] * ResponseParser.SEQUENCE_STEP_LENGTH, timeout=0.5)
+        return ResponseParser.parse_sequence_record(header + (body or b""))
+
     # ========================================================================
     # TIMING CONFIGURATION
     # ========================================================================
@@ -485,6 +1338,8 @@ class ESP32Controller:
 
         Sends CMD_STATUS and reads 5-byte response:
         [status_code][temp_high][temp_low][hum_high][hum_low]
+        followed by [age_high][age_low] (100 ms units) when enabled through
+        set_sensor_policy(). The values are the firmware's latest snapshot.
 
         Note: Applies -2.0°C calibration offset to compensate for:
         - ESP32 self-heating (~+1°C)
@@ -492,7 +1347,8 @@ class ESP32Controller:
         To adjust offset, modify TEMPERATURE_CALIBRATION_OFFSET constant.
 
         Returns:
-            dict with 'temperature' and 'humidity', or None if failed
+            dict with 'temperature' and 'humidity' (and 'age_s', None before
+            the first valid reading, if the age is reported), or None if failed
         """
         if not self.is_connected():
             return None
@@ -504,10 +1360,12 @@ class ESP32Controller:
         if not self.comm.send_bytes(cmd):
             return None
 
-        # Read 5-byte response
-        response_data = self.comm.read_bytes(5, timeout=1.0)
+        # Read 5-byte response (7 with sample age)
+        report_age = bool(self._sensor_policy and self._sensor_policy[1])
+        length = 7 if report_age else 5
+        response_data = self.comm.read_bytes(length, timeout=1.0)
 
-        if not response_data or len(response_data) < 5:
+        if not response_data or len(response_data) < length:
             logger.error("No sensor data response")
             return None
 
@@ -550,7 +1408,11 @@ class ESP32Controller:
                 f"Sensor data: T={temperature:.1f}°C (calibrated, offset={TEMPERATURE_CALIBRATION_OFFSET}°C), H={humidity:.1f}%"
             )
 
-            return {"temperature": temperature, "humidity": humidity, "status_code": status_code}
+            result = {"temperature": temperature, "humidity": humidity, "status_code": status_code}
+            if report_age:
+                age_raw = (response_data[5] << 8) | response_data[6]
+                result["age_s"] = None if age_raw == 0xFFFF else age_raw / 10.0
+            return result
 
         except Exception as e:
             logger.error(f"Error parsing sensor data: {e}")
@@ -599,6 +1461,154 @@ class ESP32Controller:
 
         return led_status
 
+    def get_timing_stats(self, reset: bool = False) -> Optional[dict]:
+        """
+        Read the firmware's µs latency statistics.
+
+        Args:
+            reset: Clear the counters on the ESP32 after reading
+
+        Returns:
+            Dict name -> TimingStats, or None on error
+        """
+        if not self.is_connected():
+            return None
+
+        if not self.comm.send_bytes(CommandBuilder.build_get_timing_stats(reset)):
+            return None
+
+        stats = {}
+        expected = len(ResponseParser.TIMING_STAT_NAMES)
+        while len(stats) < expected:
+            data = self.comm.read_bytes(ResponseParser.TIMING_STATS_LENGTH, timeout=1.0)
+            record = ResponseParser.parse_timing_stats(data) if data else None
+            if record is None:
+                logger.error(f"Timing stats incomplete: {len(stats)}/{expected} records")
+                return None
+            stats[record.name] = record
+            expected = data[2]
+        return stats
+
+    def download_event_log(self, from_index: int = 0, clear: bool = False) -> Optional[list]:
+        """
+        Download the on-device event log (CMD_GET_EVENT_LOG).
+
+        Requests 48 records at a time until the head is reached. Records
+        the ring overwrote before they were read are simply missing; resume
+        later with from_index = last record's index + 1.
+
+        Args:
+            from_index: First event index wanted
+            clear: Drop the downloaded records from the ESP32's log
+
+        Returns:
+            List of EventRecord, oldest first, or None on error
+        """
+        if not self.is_connected():
+            return None
+
+        records = []
+        index = from_index
+        while True:
+            cmd = CommandBuilder.build_get_event_log(index, EventTypes.MAX_RECORDS, clear)
+            if not self.comm.send_bytes(cmd):
+                return None
+            while True:
+                chunk = self._read_event_chunk()
+                if chunk is None:
+                    logger.error(f"Event log download incomplete after {len(records)} records")
+                    return None
+                records.extend(r for r in chunk.records if r.type != EventTypes.NONE)
+                index = chunk.first + len(chunk.records)
+                if chunk.last:
+                    break
+            if not chunk.records or index >= chunk.head:
+                return records
+
+    def _read_event_chunk(self) -> Optional[EventChunk]:
+        """Read one EVENT_LOG chunk: fixed header, then its records."""
+        header = self.comm.read_bytes(ResponseParser.EVENT_CHUNK_HEADER_LENGTH, timeout=1.0)
+        if not header or header[0] != Responses.EVENT_LOG:
+            return None
+        body = b""
+        if header[9]:
+            body = self.comm.read_bytes(header[9] * ResponseParser.EVENT_RECORD_LENGTH, timeout=1.0)
+            if not body:
+                return None
+        return ResponseParser.parse_event_chunk(header + body)
+
+    def get_reset_info(self) -> Optional[ResetInfo]:
+        """
+        Ask why the ESP32 last booted and what it restored (CMD_GET_RESET_INFO).
+
+        After a panic or watchdog reset the firmware brings back LEDs,
+        settings, protocol, sync role and a running schedule from RTC
+        memory. Poll this after the link comes back: if .resumed, the host
+        setup is still in place; re-run sync_clock() either way, since the
+        ESP32's µs timestamps start again from 0.
+
+        Returns:
+            ResetInfo, or None for firmware without the command
+        """
+        if not self.is_connected():
+            return None
+
+        self.comm.clear_buffers()
+        if not self.comm.send_bytes(CommandBuilder.build_get_reset_info()):
+            return None
+
+        header = self.comm.read_bytes(1, timeout=0.5)
+        if not header or header[0] != Responses.RESET_INFO:
+            return None
+        body = self.comm.read_bytes(ResponseParser.RESET_INFO_LENGTH - 1, timeout=0.5)
+        info = ResponseParser.parse_reset_info(header + body) if body else None
+        if info and info.warm_resets:
+            logger.warning(
+                f"ESP32 reset ({info.reason_name}), {info.warm_resets} warm reset(s), "
+                f"resumed: {info.resumed}"
+            )
+        return info
+
+    def get_device_config(self) -> Optional[DeviceConfig]:
+        """
+        Read the settings the ESP32 keeps in NVS (CMD_GET_CONFIG) and
+        adopt them as host state.
+
+        Compare config_hash with DeviceConfig(...).config_hash of the
+        wanted settings to skip re-sending them after a reset.
+
+        Returns:
+            DeviceConfig, or None for firmware without the command
+        """
+        if not self.is_connected():
+            return None
+
+        if not self.comm.send_bytes(CommandBuilder.build_get_config()):
+            return None
+
+        header = self.comm.read_bytes(1, timeout=0.5)
+        if not header or header[0] != Responses.CONFIG:
+            return None
+        body = self.comm.read_bytes(ResponseParser.CONFIG_LENGTH - 1, timeout=0.5)
+        config = ResponseParser.parse_config(header + body) if body else None
+        if config is None:
+            return None
+
+        self.state.set_timing(config.stabilization_ms, config.exposure_ms)
+        self.state.set_led_power(config.ir_power, "ir")
+        self.state.set_led_power(config.white_power, "white")
+        self.state.set_camera_type(config.camera_type)
+        self.state.set_current_led_type("white" if config.led_type == LEDTypes.WHITE else "ir")
+        self._extended_sync = config.sync_format in (SyncFormats.EXTENDED, SyncFormats.SETTLE)
+        self._settle_sync = config.sync_format == SyncFormats.SETTLE
+
+        logger.info(
+            f"ESP32 config {'restored from NVS' if config.restored else 'defaults'}: "
+            f"{config.stabilization_ms}+{config.exposure_ms}ms, IR {config.ir_power}%, "
+            f"White {config.white_power}%, hash 0x{config.config_hash:04X}"
+        )
+        return config
+
     def get_state_snapshot(self) -> dict:
         """Get complete state snapshot"""
         return self.state.get_snapshot()
@@ -633,6 +1643,87 @@ class ESP32Controller:
         logger.info(f"Camera type set to {cam_name}")
         return True
 
+    def set_camera_trigger(self, enabled: bool, width_us: int = 1000) -> bool:
+        """
+        Enable or disable the hardware camera trigger output.
+
+        When enabled, every sync pulse also drives a TTL pulse on the trigger
+        pin, stabilization_ms after LED-on. Cameras in hardware-trigger mode
+        then expose independently of host latency.
+
+        Args:
+            enabled: Drive the trigger output
+            width_us: Trigger pulse width in µs
+
+        Returns:
+            True if successful
+        """
+        if not self.is_connected():
+            return False
+
+        if not self.comm.send_bytes(CommandBuilder.build_set_trigger(enabled, width_us)):
+            return False
+
+        if not self.comm.read_until_response(Responses.LED_ON_ACK, timeout=0.5):
+            logger.error("No ACK for SET_TRIGGER")
+            return False
+
+        logger.info(f"Camera trigger {'enabled' if enabled else 'disabled'} ({width_us}µs)")
+        return True
+
+    # ========================================================================
+    # BAUDRATE NEGOTIATION
+    # ========================================================================
+
+    def set_baudrate(self, baudrate: int) -> bool:
+        """
+        Raise the serial link speed (CMD_SET_BAUD + CMD_BAUD_CONFIRM).
+
+        The ESP32 echoes the rate at the old speed, switches, and waits up to
+        1 s for the confirmation at the new speed. Without it, it reverts.
+
+        Args:
+            baudrate: Target baudrate (see BaudRates.SUPPORTED)
+
+        Returns:
+            True if both sides run at the new baudrate
+        """
+        if not self.is_connected():
+            return False
+
+        old_baudrate = self.comm.get_connection_stats()["line_baudrate"]
+
+        try:
+            cmd = CommandBuilder.build_set_baud(baudrate)
+        except ValueError as e:
+            logger.error(str(e))
+            return False
+
+        self.comm.clear_buffers()
+        if not self.comm.send_bytes(cmd):
+            return False
+
+        echo = ResponseParser.parse_baud_set(self.comm.read_bytes(5, timeout=0.5) or b"")
+        if echo != baudrate:
+            logger.error(f"Baudrate {baudrate} rejected by ESP32")
+            return False
+
+        # ESP32 switches right after the echo - follow and confirm
+        self.comm.set_line_baudrate(baudrate)
+        time.sleep(0.02)
+        self.comm.send_bytes(CommandBuilder.build_baud_confirm(), raw=True)
+
+        confirm = ResponseParser.parse_baud_set(self.comm.read_bytes(5, timeout=0.5) or b"")
+        if confirm != baudrate:
+            logger.error(f"Baudrate {baudrate} not confirmed, reverting to {old_baudrate}")
+            time.sleep(1.0)  # ESP32 reverts after its confirm timeout
+            self.comm.set_line_baudrate(old_baudrate)
+            self.comm.clear_buffers()
+            return False
+
+        logger.info(f"Serial link switched to {baudrate} baud")
+        return True
+
     # ========================================================================
     # STATISTICS
     # ========================================================================
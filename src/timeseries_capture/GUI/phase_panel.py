@@ -95,6 +95,20 @@ class PhaseConfigPanel(QWidget):
         self.dark_duration_spin.valueChanged.connect(self._update_cycle_info)
         duration_layout.addRow("Full Cycle:", self.cycle_info_label)
 
+        # Dawn/Dusk Ramp (continuous white LED only)
+        self.white_ramp_spin = QSpinBox()
+        self.white_ramp_spin.setRange(0, 3600)
+        self.white_ramp_spin.setValue(0)
+        self.white_ramp_spin.setSuffix(" s")
+        self.white_ramp_spin.setSpecialValueText("Off")
+        self.white_ramp_spin.setToolTip(
+            "Fade the continuous white LED in at the start of each light phase\n"
+            "and out at the start of each dark phase. The ESP32 runs the ramp\n"
+            "in hardware; frames taken meanwhile see the changing light level."
+        )
+        self.white_ramp_spin.valueChanged.connect(self._emit_config_changed)
+        duration_layout.addRow("Dawn/Dusk Ramp:", self.white_ramp_spin)
+
         self.duration_group.setLayout(duration_layout)
         self.duration_group.setEnabled(False)
         layout.addWidget(self.duration_group)
@@ -246,6 +260,7 @@ class PhaseConfigPanel(QWidget):
         return {
             "enabled": self.phase_enabled_check.isChecked(),
             "white_led_continuous": self.white_led_continuous_check.isChecked(),
+            "white_ramp_sec": self.white_ramp_spin.value(),
             "light_duration_min": self.light_duration_spin.value(),
             "dark_duration_min": self.dark_duration_spin.value(),
             "start_with_light": self.start_light_radio.isChecked(),
@@ -258,6 +273,7 @@ class PhaseConfigPanel(QWidget):
         self.phase_enabled_check.setChecked(config.get("enabled", False))
         self.light_duration_spin.setValue(config.get("light_duration_min", 30))
         self.dark_duration_spin.setValue(config.get("dark_duration_min", 30))
+        self.white_ramp_spin.setValue(config.get("white_ramp_sec", 0))
 
         if config.get("start_with_light", True):
             self.start_light_radio.setChecked(True)
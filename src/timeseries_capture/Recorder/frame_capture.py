@@ -15,6 +15,8 @@ import numpy as np
 
 logger = logging.getLogger(__name__)
 
+LED_CHANNEL_WHITE = 1  # Firmware-Kanal der White LED (RAMP_CHANNEL)
+
 
 class FrameCaptureService:
     """
@@ -384,30 +386,43 @@ class FrameCaptureService:
             self._current_led_type = None
             self._white_led_continuous = False
 
-    def set_white_continuous(self, enabled: bool):
+    def set_white_continuous(self, enabled: bool, ramp_sec: float = 0.0, power: int = 0):
         """
         Schaltet die White LED dauerhaft an oder aus (für Tagphase-Modus).
 
         Wird von RecordingManager bei Phasenübergängen aufgerufen:
         - enabled=True  → Tagphase beginnt: White LED dauerhaft AN
         - enabled=False → Nachtphase beginnt: White LED AUS
+
+        Mit ramp_sec > 0 blendet der ESP32 die LED per Hardware-Rampe auf
+        power ein bzw. aus (RAMP_CHANNEL); Firmware ohne Rampen schaltet sofort.
         """
         if enabled and not self._white_led_continuous:
             try:
                 self.esp32.select_led_type("white")
-                self.esp32.led_on()
+                if not (ramp_sec > 0 and self._ramp_white(power, ramp_sec)):
+                    self.esp32.led_on()
                 self._white_led_continuous = True
                 logger.info("[WHITE CONTINUOUS] White LED turned ON (day phase start)")
             except Exception as e:
                 logger.warning(f"[WHITE CONTINUOUS] Failed to turn on White LED: {e}")
         elif not enabled and self._white_led_continuous:
             try:
-                self.esp32.led_off("white")
+                if not (ramp_sec > 0 and self._ramp_white(0, ramp_sec)):
+                    self.esp32.led_off("white")
                 self._white_led_continuous = False
                 logger.info("[WHITE CONTINUOUS] White LED turned OFF (night phase start)")
             except Exception as e:
                 logger.warning(f"[WHITE CONTINUOUS] Failed to turn off White LED: {e}")
 
+    def _ramp_white(self, power: int, ramp_sec: float) -> bool:
+        """Startet eine White-Rampe auf dem ESP32, False wenn nicht unterstützt"""
+        ramp_channel = getattr(self.esp32, "ramp_channel", None)
+        if ramp_channel is None or not ramp_channel(LED_CHANNEL_WHITE, power, ramp_sec):
+            return False
+        logger.info(f"[WHITE CONTINUOUS] Ramping White LED to {power}% over {ramp_sec:.0f}s")
+        return True
+
     def query_sensors_if_needed(self) -> bool:
         """
         Query ESP32 sensors (temperature, humidity) if query interval reached.
@@ -1021,7 +1021,7 @@ class RecordingManager(QObject):
             self.frame_capture.esp32.set_led_power(ir_power, "ir")
 
             if use_continuous:
-                self.frame_capture.set_white_continuous(False)
+                self.frame_capture.set_white_continuous(False, ramp_sec=config.white_ramp_sec)
 
         else:
             ir_power = config.light_phase_ir_power
@@ -1039,7 +1039,9 @@ class RecordingManager(QObject):
                 self.frame_capture.esp32.set_led_power(white_power, "white")
 
             if use_continuous:
-                self.frame_capture.set_white_continuous(True)
+                self.frame_capture.set_white_continuous(
+                    True, ramp_sec=config.white_ramp_sec, power=white_power
+                )
                 logger.info(
                     f"[PHASE POWER] Continuous white/dual LED activated "
                     f"({'schedule segment' if _continuous_light_segment else 'phase config'})"
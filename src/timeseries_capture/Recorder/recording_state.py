@@ -51,6 +51,7 @@ class RecordingConfig:
     dual_light_phase: bool = False
     camera_trigger_latency_ms: int = 20
     white_led_continuous: bool = False  # White LED bleibt während Tagphase dauerhaft an
+    white_ramp_sec: int = 0  # Dämmerung: Continuous White ein-/ausblenden (0 = sofort)
 
     # LED Power Config (0-100%)
     # LEGACY: Single power values (for backward compatibility and continuous mode)
@@ -104,6 +105,7 @@ class SegmentConfig:
     start_with_light: bool = True
     dual_light_phase: bool = False
     white_led_continuous: bool = False
+    white_ramp_sec: int = 0
     camera_trigger_latency_ms: int = 20
 
     # --- LED powers ---
@@ -131,6 +133,7 @@ class SegmentConfig:
             "start_with_light": self.start_with_light,
             "dual_light_phase": self.dual_light_phase,
             "white_led_continuous": self.white_led_continuous,
+            "white_ramp_sec": self.white_ramp_sec,
             "camera_trigger_latency_ms": self.camera_trigger_latency_ms,
             "dark_phase_ir_power": self.dark_phase_ir_power,
             "light_phase_ir_power": self.light_phase_ir_power,
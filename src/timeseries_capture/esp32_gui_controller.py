@@ -18,6 +18,7 @@ from typing import Optional
 from qtpy.QtCore import QObject, QTimer
 from qtpy.QtCore import Signal as pyqtSignal
 
+from .ESP32_Controller.esp32_commands import Features, TelemetryFields
 from .ESP32_Controller.esp32_controller import ESP32Controller  # ✅ Correct!
 
 logger = logging.getLogger(__name__)
@@ -174,6 +175,9 @@ class ESP32GUIController(QObject):
                 # Update GUI (must be done in main thread)
                 self.connection_status_changed.emit(True, connected_port)
 
+                # On a framed link the firmware pushes the monitor data itself
+                self._start_telemetry()
+
                 # Query hardware info
                 self._query_hardware_info()
 
@@ -205,14 +209,30 @@ class ESP32GUIController(QObject):
     # HARDWARE INFO QUERIES
     # ========================================================================
 
+    def _start_telemetry(self):
+        """Subscribe to the telemetry stream instead of polling, where supported"""
+        caps = self.esp32.capabilities
+        if self.esp32.comm.framed and caps and caps.has(Features.TELEMETRY):
+            fields = TelemetryFields.SENSOR | TelemetryFields.UPTIME
+            if self.esp32.start_telemetry(self._monitor_interval_ms, fields):
+                logger.info("ESP32 telemetry stream active")
+
     def _query_hardware_info(self):
         """Query hardware information from ESP32"""
         if not self._is_connected or not self.esp32:
             return
 
         try:
-            # Get sensor data (temperature and humidity)
-            sensor_data = self.esp32.get_sensor_data()
+            # Get sensor data (temperature and humidity) - from the latest
+            # telemetry record while streaming, no command on the link
+            sensor_data = None
+            if self.esp32.telemetry_active:
+                self.esp32.read_telemetry()
+                record = self.esp32.latest_telemetry
+                if record and record.temperature is not None:
+                    sensor_data = {"temperature": record.temperature, "humidity": record.humidity}
+            else:
+                sensor_data = self.esp32.get_sensor_data()
 
             # Get connection stats
             stats = self.esp32.get_connection_stats()
@@ -718,6 +718,7 @@ class NematostellaTimelapseCaptureWidget(QWidget):
                 phase_enabled=phase_active,
                 white_led_continuous=phase_active
                 and phase_config.get("white_led_continuous", False),
+                white_ramp_sec=phase_config.get("white_ramp_sec", 0),
                 light_duration_min=phase_config.get("light_duration_min", 30),
                 dark_duration_min=phase_config.get("dark_duration_min", 30),
                 ir_led_power=led_powers["ir"],
@@ -162,6 +162,7 @@ class RecordingController(QObject):
                 output_dir=config_dict["output_dir"],
                 phase_enabled=phase_enabled,
                 white_led_continuous=config_dict.get("white_led_continuous", False),
+                white_ramp_sec=config_dict.get("white_ramp_sec", 0),
                 light_duration_min=config_dict.get("light_duration_min", 30),
                 dark_duration_min=config_dict.get("dark_duration_min", 30),
                 start_with_light=config_dict.get("start_with_light", True),